@@ -0,0 +1,160 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Hand-off of values between the producer and the consumer of a result
+ * identified by an integer, e.g., the completion of a task, where the result
+ * may be produced before or after the consumer starts waiting for it.
+ *
+ * The slab is made of a fixed number of slots, each with its own lock and
+ * condition variable, and a result is stored in the slot selected by the
+ * lowest bits of its identifier. Therefore, operations on different
+ * identifiers never contend with one another, unless they map to the same
+ * slot, which only happens with more results in progress than slots if the
+ * identifiers are assigned sequentially.
+ */
+template <class T>
+class CompletionSlab final
+{
+ public:
+  /**
+   * \param aSize the number of slots, rounded up to the next power of two.
+   */
+  explicit CompletionSlab(const size_t aSize)
+      : theSlots(roundUp(aSize))
+      , theMask(theSlots.size() - 1) {
+    // noop
+  }
+
+  //! \return the number of slots.
+  size_t size() const noexcept {
+    return theSlots.size();
+  }
+
+  //! Make available the result with given identifier.
+  void post(const uint64_t aId, T aValue);
+
+  //! Wait until the result with given identifier is available and return it.
+  T wait(const uint64_t aId);
+
+ private:
+  struct Entry {
+    uint64_t theId;
+    bool     theDone;
+    T        theValue;
+  };
+
+  struct Slot {
+    std::mutex              theMutex;
+    std::condition_variable theCondition;
+    // usually contains at most one element
+    std::vector<Entry> theEntries;
+  };
+
+  static size_t roundUp(const size_t aSize) {
+    size_t ret = 1;
+    while (ret < aSize) {
+      ret *= 2;
+    }
+    return ret;
+  }
+
+  static typename std::vector<Entry>::iterator find(Slot&          aSlot,
+                                                    const uint64_t aId) {
+    return std::find_if(
+        aSlot.theEntries.begin(),
+        aSlot.theEntries.end(),
+        [aId](const Entry& aEntry) { return aEntry.theId == aId; });
+  }
+
+ private:
+  std::vector<Slot> theSlots;
+  const size_t      theMask;
+};
+
+template <class T>
+void CompletionSlab<T>::post(const uint64_t aId, T aValue) {
+  auto&                             mySlot = theSlots[aId & theMask];
+  const std::lock_guard<std::mutex> myLock(mySlot.theMutex);
+  const auto                        it = find(mySlot, aId);
+  if (it == mySlot.theEntries.end()) {
+    // the consumer is not waiting yet
+    mySlot.theEntries.emplace_back(Entry{aId, true, std::move(aValue)});
+    return;
+  }
+  it->theDone  = true;
+  it->theValue = std::move(aValue);
+  if (mySlot.theEntries.size() == 1) {
+    mySlot.theCondition.notify_one();
+  } else {
+    mySlot.theCondition.notify_all();
+  }
+}
+
+template <class T>
+T CompletionSlab<T>::wait(const uint64_t aId) {
+  auto&                        mySlot = theSlots[aId & theMask];
+  std::unique_lock<std::mutex> myLock(mySlot.theMutex);
+  auto                         it = find(mySlot, aId);
+  if (it == mySlot.theEntries.end()) {
+    mySlot.theEntries.emplace_back(Entry{aId, false, T()});
+  }
+  mySlot.theCondition.wait(myLock, [&mySlot, aId, &it]() {
+    // the vector may have been changed by other identifiers in the same slot
+    it = find(mySlot, aId);
+    return it->theDone;
+  });
+  auto ret = std::move(it->theValue);
+  if (it != mySlot.theEntries.end() - 1) {
+    std::swap(*it, mySlot.theEntries.back());
+  }
+  mySlot.theEntries.pop_back();
+  return ret;
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,157 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/fenwicktree.h"
+
+#include <cassert>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+namespace {
+
+size_t lsb(const size_t aIndex) noexcept {
+  return aIndex & (~aIndex + 1);
+}
+
+} // namespace
+
+FenwickTree::FenwickTree()
+    : theValues()
+    , theTree(1, 0.0)
+    , theScratch()
+    , theUpdates(0) {
+  // noop
+}
+
+double FenwickTree::total() const {
+  return prefix(theValues.size());
+}
+
+double FenwickTree::prefix(const size_t aCount) const {
+  assert(aCount <= theValues.size());
+  double ret = 0;
+  for (auto i = aCount; i > 0; i -= lsb(i)) {
+    ret += theTree[i];
+  }
+  return ret;
+}
+
+void FenwickTree::push_back(const double aValue) {
+  assert(aValue >= 0);
+  theValues.emplace_back(aValue);
+  const auto i = theValues.size();
+  theTree.emplace_back(aValue + prefix(i - 1) - prefix(i - lsb(i)));
+}
+
+void FenwickTree::pop_back() {
+  assert(not theValues.empty());
+  // no other node depends on the last one
+  theValues.pop_back();
+  theTree.pop_back();
+}
+
+void FenwickTree::erase(const size_t aIndex) {
+  assert(aIndex < theValues.size());
+  if (aIndex + 1 == theValues.size()) {
+    pop_back();
+    return;
+  }
+  theValues.erase(theValues.begin() + aIndex);
+  rebuild();
+}
+
+void FenwickTree::set(const size_t aIndex, const double aValue) {
+  assert(aIndex < theValues.size());
+  assert(aValue >= 0);
+
+  if (++theUpdates > theValues.size()) {
+    theValues[aIndex] = aValue;
+    rebuild();
+    return;
+  }
+
+  const auto myDelta = aValue - theValues[aIndex];
+  theValues[aIndex]  = aValue;
+  for (auto i = aIndex + 1; i < theTree.size(); i += lsb(i)) {
+    theTree[i] += myDelta;
+  }
+}
+
+void FenwickTree::clear() {
+  theValues.clear();
+  theTree.resize(1);
+  theUpdates = 0;
+}
+
+size_t FenwickTree::find(double aValue) const {
+  assert(not theValues.empty());
+
+  size_t myPos  = 0;
+  size_t myStep = 1;
+  while ((myStep << 1) < theTree.size()) {
+    myStep <<= 1;
+  }
+  for (; myStep > 0; myStep >>= 1) {
+    const auto myNext = myPos + myStep;
+    if (myNext < theTree.size()) {
+      const auto mySum = theTree[myNext].load();
+      if (mySum <= aValue) {
+        myPos = myNext;
+        aValue -= mySum;
+      }
+    }
+  }
+
+  // myPos is the number of elements whose cumulative sum is <= aValue
+  return myPos < theValues.size() ? myPos : (theValues.size() - 1);
+}
+
+void FenwickTree::rebuild() {
+  theUpdates = 0;
+  theScratch.assign(theValues.size() + 1, 0.0);
+  for (size_t i = 1; i < theScratch.size(); i++) {
+    theScratch[i] += theValues[i - 1];
+    const auto myParent = i + lsb(i);
+    if (myParent < theScratch.size()) {
+      theScratch[myParent] += theScratch[i];
+    }
+  }
+  theTree.resize(theScratch.size());
+  for (size_t i = 0; i < theScratch.size(); i++) {
+    theTree[i] = theScratch[i];
+  }
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
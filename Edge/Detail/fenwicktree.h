@@ -0,0 +1,119 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/Detail/relaxedatomic.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Binary indexed tree (aka Fenwick tree) of non-negative values, which
+ * allows to update values, compute prefix sums and find the element
+ * corresponding to a given cumulative value in O(log n).
+ *
+ * Elements can only be added at the end of the sequence. Removing an element
+ * from the middle of the sequence takes O(n).
+ *
+ * The const methods can be called by multiple threads concurrently with a
+ * single thread calling set(), in which case they may return values that do
+ * not correspond exactly to any state of the tree, but find() always returns
+ * a valid index. All the other methods require exclusive access.
+ */
+class FenwickTree final
+{
+ public:
+  //! Create an empty tree.
+  explicit FenwickTree();
+
+  //! \return the number of elements.
+  size_t size() const noexcept {
+    return theValues.size();
+  }
+
+  //! \return the value of the i-th element.
+  double value(const size_t aIndex) const {
+    return theValues[aIndex];
+  }
+
+  //! \return the sum of all the values.
+  double total() const;
+
+  //! \return the sum of the first aCount values.
+  double prefix(const size_t aCount) const;
+
+  //! Add an element at the end.
+  void push_back(const double aValue);
+
+  //! Remove the last element.
+  void pop_back();
+
+  //! Remove the i-th element, the following ones are shifted back by one.
+  void erase(const size_t aIndex);
+
+  //! Change the value of the i-th element.
+  void set(const size_t aIndex, const double aValue);
+
+  //! Remove all the elements.
+  void clear();
+
+  /**
+   * \return the index of the first element such that the sum of the values
+   * up to it, included, is greater than aValue. If aValue is greater than or
+   * equal to the total then the index of the last element is returned.
+   *
+   * \pre the tree is not empty.
+   */
+  size_t find(double aValue) const;
+
+ private:
+  //! Rebuild the tree from the values, in O(n).
+  void rebuild();
+
+ private:
+  std::vector<RelaxedAtomic<double>> theValues;
+  // 1-based: theTree[i] is the sum of the values in (i - lsb(i), i]
+  std::vector<RelaxedAtomic<double>> theTree;
+  // used by rebuild() so that theTree is never partially cleared
+  std::vector<double> theScratch;
+  // number of incremental updates since last rebuild, used to bound
+  // the accumulation of floating point errors
+  size_t theUpdates;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
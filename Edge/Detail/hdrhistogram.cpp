@@ -0,0 +1,277 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/hdrhistogram.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+namespace {
+
+//! \return the number of buckets with a given precision.
+size_t numBuckets(const unsigned int aPrecision) {
+  if (aPrecision < 1 or aPrecision > 16) {
+    throw std::runtime_error("Invalid histogram precision: " +
+                             std::to_string(aPrecision));
+  }
+  return (1u << aPrecision) + (64 - aPrecision) * (1u << (aPrecision - 1));
+}
+
+} // namespace
+
+HdrHistogram::HdrHistogram(const unsigned int aPrecision)
+    : thePrecision(aPrecision)
+    , theSize(numBuckets(aPrecision))
+    , theCounts(new std::atomic<uint64_t>[theSize])
+    , theCount(0)
+    , theSum(0) {
+  clear();
+}
+
+HdrHistogram::HdrHistogram(const HdrHistogram& aOther)
+    : thePrecision(aOther.thePrecision)
+    , theSize(aOther.theSize)
+    , theCounts(new std::atomic<uint64_t>[aOther.theSize])
+    , theCount(0)
+    , theSum(0) {
+  clear();
+  add(aOther);
+}
+
+HdrHistogram& HdrHistogram::operator=(const HdrHistogram& aOther) {
+  if (this != &aOther) {
+    if (thePrecision != aOther.thePrecision) {
+      throw std::runtime_error("Cannot assign histograms with precision " +
+                               std::to_string(aOther.thePrecision) + " to " +
+                               std::to_string(thePrecision));
+    }
+    clear();
+    add(aOther);
+  }
+  return *this;
+}
+
+void HdrHistogram::add(const HdrHistogram& aOther) {
+  if (thePrecision != aOther.thePrecision) {
+    throw std::runtime_error("Cannot add histograms with precision " +
+                             std::to_string(aOther.thePrecision) + " to " +
+                             std::to_string(thePrecision));
+  }
+  for (size_t i = 0; i < theSize; i++) {
+    const auto myCount = aOther.theCounts[i].load(std::memory_order_relaxed);
+    if (myCount > 0) {
+      theCounts[i].fetch_add(myCount, std::memory_order_relaxed);
+    }
+  }
+  theCount.fetch_add(aOther.theCount.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  theSum.fetch_add(aOther.theSum.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+}
+
+void HdrHistogram::subtract(const HdrHistogram& aOther) {
+  if (thePrecision != aOther.thePrecision) {
+    throw std::runtime_error("Cannot subtract histograms with precision " +
+                             std::to_string(aOther.thePrecision) + " from " +
+                             std::to_string(thePrecision));
+  }
+  for (size_t i = 0; i < theSize; i++) {
+    const auto myCount = aOther.theCounts[i].load(std::memory_order_relaxed);
+    if (myCount > 0) {
+      theCounts[i].fetch_sub(myCount, std::memory_order_relaxed);
+    }
+  }
+  theCount.fetch_sub(aOther.theCount.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  theSum.fetch_sub(aOther.theSum.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+}
+
+void HdrHistogram::clear() noexcept {
+  for (size_t i = 0; i < theSize; i++) {
+    theCounts[i].store(0, std::memory_order_relaxed);
+  }
+  theCount.store(0, std::memory_order_relaxed);
+  theSum.store(0, std::memory_order_relaxed);
+}
+
+double HdrHistogram::mean() const noexcept {
+  const auto myCount = count();
+  if (myCount == 0) {
+    return 0;
+  }
+  return static_cast<double>(theSum.load(std::memory_order_relaxed)) / myCount;
+}
+
+uint64_t HdrHistogram::min() const noexcept {
+  for (size_t i = 0; i < theSize; i++) {
+    if (theCounts[i].load(std::memory_order_relaxed) > 0) {
+      return lowest(i);
+    }
+  }
+  return 0;
+}
+
+uint64_t HdrHistogram::max() const noexcept {
+  for (size_t i = theSize; i > 0; i--) {
+    if (theCounts[i - 1].load(std::memory_order_relaxed) > 0) {
+      return highest(i - 1);
+    }
+  }
+  return 0;
+}
+
+uint64_t HdrHistogram::percentile(const double aPercentile) const noexcept {
+  // the total is computed from the buckets, which may be slightly different
+  // from count() while values are being recorded
+  uint64_t myTotal = 0;
+  for (size_t i = 0; i < theSize; i++) {
+    myTotal += theCounts[i].load(std::memory_order_relaxed);
+  }
+  if (myTotal == 0) {
+    return 0;
+  }
+
+  const auto myTarget = std::max<uint64_t>(
+      1,
+      static_cast<uint64_t>(std::ceil(
+          std::min(100.0, std::max(0.0, aPercentile)) / 100.0 * myTotal)));
+  uint64_t myCumulative = 0;
+  for (size_t i = 0; i < theSize; i++) {
+    myCumulative += theCounts[i].load(std::memory_order_relaxed);
+    if (myCumulative >= myTarget) {
+      return highest(i);
+    }
+  }
+  return max();
+}
+
+std::string HdrHistogram::summary() const {
+  std::stringstream ret;
+  ret << "count " << count() << ", mean " << mean() << ", p50 "
+      << percentile(50) << ", p90 " << percentile(90) << ", p99 "
+      << percentile(99) << ", p99.9 " << percentile(99.9) << ", p99.99 "
+      << percentile(99.99) << ", max " << max();
+  return ret.str();
+}
+
+size_t HdrHistogram::index(const uint64_t aValue) const noexcept {
+  const uint64_t mySubBuckets = uint64_t(1) << thePrecision;
+  if (aValue < mySubBuckets) {
+    return aValue;
+  }
+  // aValue >= 2^P hence the shift is at least 1 and the most significant P
+  // bits are in [2^(P-1), 2^P)
+  const auto myMsb   = 63u - static_cast<unsigned>(__builtin_clzll(aValue));
+  const auto myShift = myMsb - thePrecision + 1;
+  const auto myHalf  = mySubBuckets / 2;
+  const auto ret     = mySubBuckets + (myShift - 1) * myHalf +
+                   ((aValue >> myShift) - myHalf);
+  assert(ret < theSize);
+  return ret;
+}
+
+uint64_t HdrHistogram::lowest(const size_t aIndex) const noexcept {
+  const uint64_t mySubBuckets = uint64_t(1) << thePrecision;
+  if (aIndex < mySubBuckets) {
+    return aIndex;
+  }
+  const auto myHalf  = mySubBuckets / 2;
+  const auto myShift = (aIndex - mySubBuckets) / myHalf + 1;
+  return ((aIndex - mySubBuckets) % myHalf + myHalf) << myShift;
+}
+
+uint64_t HdrHistogram::highest(const size_t aIndex) const noexcept {
+  const uint64_t mySubBuckets = uint64_t(1) << thePrecision;
+  if (aIndex < mySubBuckets) {
+    return aIndex;
+  }
+  const auto myShift = (aIndex - mySubBuckets) / (mySubBuckets / 2) + 1;
+  return lowest(aIndex) + ((uint64_t(1) << myShift) - 1);
+}
+
+HdrIntervalReporter::HdrIntervalReporter(const double       aInterval,
+                                         const std::string& aName,
+                                         Snapshot&&         aSnapshot)
+    : theInterval(static_cast<int64_t>(aInterval * 1e6))
+    , theName(aName)
+    , theSnapshot(std::move(aSnapshot))
+    , theMutex()
+    , theCondition()
+    , theStopped(false)
+    , theThread() {
+  if (theInterval.count() <= 0) {
+    throw std::runtime_error("Invalid reporting interval: " +
+                             std::to_string(aInterval));
+  }
+  theThread = std::thread([this]() { run(); });
+}
+
+HdrIntervalReporter::~HdrIntervalReporter() {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theStopped = true;
+  }
+  theCondition.notify_one();
+  theThread.join();
+}
+
+void HdrIntervalReporter::run() {
+  auto myPrevious = theSnapshot();
+  auto myNext     = std::chrono::steady_clock::now() + theInterval;
+  std::unique_lock<std::mutex> myLock(theMutex);
+  while (not theCondition.wait_until(
+      myLock, myNext, [this]() { return theStopped; })) {
+    myLock.unlock();
+    const auto myCurrent  = theSnapshot();
+    auto       myInterval = myCurrent;
+    myInterval.subtract(myPrevious);
+    LOG(INFO) << theName << " in the last "
+              << std::chrono::duration<double>(theInterval).count()
+              << " s: " << myInterval.summary();
+    myPrevious = myCurrent;
+    myNext += theInterval;
+    myLock.lock();
+  }
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,199 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Histogram of non-negative integer values with a bounded relative error,
+ * e.g., latencies in microseconds, in the style of HdrHistogram.
+ *
+ * The values below 2^P are counted exactly, where P is the precision given in
+ * the ctor, while larger values are assigned to buckets whose width doubles at
+ * every power of two, so that the relative error never exceeds 2^-(P-1).
+ * The number of buckets only depends on P, e.g., with P = 7 there are 3776
+ * buckets spanning the whole 64-bit range.
+ *
+ * Recording values and reading the histogram, e.g., to take a snapshot from
+ * another thread, never lock: the counters are updated with relaxed atomic
+ * operations, hence a snapshot taken while values are being recorded may not
+ * include the most recent ones. The intended usage is to have one histogram
+ * per recording thread and merge them when reporting.
+ */
+class HdrHistogram final
+{
+ public:
+  /**
+   * \param aPrecision the number of bits of precision, see above.
+   *
+   * \throw std::runtime_error if aPrecision is not in [1, 16].
+   */
+  explicit HdrHistogram(const unsigned int aPrecision = 7);
+
+  //! Create a snapshot of another histogram.
+  HdrHistogram(const HdrHistogram& aOther);
+
+  /**
+   * Replace the content with a snapshot of another histogram.
+   *
+   * \throw std::runtime_error if the precisions differ.
+   */
+  HdrHistogram& operator=(const HdrHistogram& aOther);
+
+  //! Record a value the given number of times.
+  void record(const uint64_t aValue, const uint64_t aCount = 1) noexcept {
+    theCounts[index(aValue)].fetch_add(aCount, std::memory_order_relaxed);
+    theCount.fetch_add(aCount, std::memory_order_relaxed);
+    theSum.fetch_add(aValue * aCount, std::memory_order_relaxed);
+  }
+
+  /**
+   * Add all the values recorded in another histogram.
+   *
+   * \throw std::runtime_error if the precisions differ.
+   */
+  void add(const HdrHistogram& aOther);
+
+  /**
+   * Remove all the values recorded in another histogram, which must be an
+   * earlier snapshot of this one, e.g., to obtain the values recorded in an
+   * interval of time.
+   *
+   * \throw std::runtime_error if the precisions differ.
+   */
+  void subtract(const HdrHistogram& aOther);
+
+  //! Remove all the values.
+  void clear() noexcept;
+
+  //! \return the number of values recorded.
+  uint64_t count() const noexcept {
+    return theCount.load(std::memory_order_relaxed);
+  }
+
+  //! \return the average of the values recorded, or 0 if empty.
+  double mean() const noexcept;
+
+  //! \return the lowest value recorded, or 0 if empty.
+  uint64_t min() const noexcept;
+
+  //! \return the highest value recorded, or 0 if empty.
+  uint64_t max() const noexcept;
+
+  /**
+   * \param aPercentile the percentile, in [0, 100].
+   *
+   * \return the highest value equivalent to the given percentile of the
+   * values recorded, or 0 if empty.
+   */
+  uint64_t percentile(const double aPercentile) const noexcept;
+
+  //! \return a summary with count, mean, and the main percentiles.
+  std::string summary() const;
+
+ private:
+  //! \return the index of the bucket of a value.
+  size_t index(const uint64_t aValue) const noexcept;
+
+  //! \return the lowest value in a bucket.
+  uint64_t lowest(const size_t aIndex) const noexcept;
+
+  //! \return the highest value in a bucket.
+  uint64_t highest(const size_t aIndex) const noexcept;
+
+ private:
+  const unsigned int                       thePrecision;
+  const size_t                             theSize;
+  std::unique_ptr<std::atomic<uint64_t>[]> theCounts;
+  std::atomic<uint64_t>                    theCount;
+  std::atomic<uint64_t>                    theSum;
+};
+
+/**
+ * Log periodically the summary of the values recorded in the last interval
+ * into histograms that keep growing, e.g., the latencies of clients.
+ */
+class HdrIntervalReporter final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(HdrIntervalReporter);
+
+  //! Function returning a snapshot of all the values recorded so far.
+  using Snapshot = std::function<HdrHistogram()>;
+
+  /**
+   * \param aInterval the reporting interval, in s.
+   *
+   * \param aName the name to be used in the log messages.
+   *
+   * \param aSnapshot the function returning the current snapshot, which is
+   * called from an internal thread.
+   *
+   * \throw std::runtime_error if aInterval is not positive.
+   */
+  explicit HdrIntervalReporter(const double       aInterval,
+                               const std::string& aName,
+                               Snapshot&&         aSnapshot);
+
+  //! Stop reporting.
+  ~HdrIntervalReporter();
+
+ private:
+  void run();
+
+ private:
+  const std::chrono::microseconds theInterval;
+  const std::string               theName;
+  const Snapshot                  theSnapshot;
+  std::mutex                      theMutex;
+  std::condition_variable         theCondition;
+  bool                            theStopped;
+  std::thread                     theThread;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,253 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Binary min-heap of integer identifiers, each with an associated key, which
+ * allows to change the key of or remove any element in O(log n).
+ *
+ * Elements with the same key are ordered by increasing identifier.
+ *
+ * Identifiers are meant to be small integers, e.g., indices in a vector: the
+ * memory used is proportional to the largest identifier ever pushed. Once
+ * the heap has grown, no memory allocation is done by any operation.
+ */
+template <class KEY>
+class IndexedHeap final
+{
+ public:
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  //! Create an empty heap.
+  explicit IndexedHeap()
+      : theHeap()
+      , thePos()
+      , theKeys() {
+    // noop
+  }
+
+  //! \return true if the heap is empty.
+  bool empty() const noexcept {
+    return theHeap.empty();
+  }
+
+  //! \return the number of elements in the heap.
+  size_t size() const noexcept {
+    return theHeap.size();
+  }
+
+  //! \return true if the given identifier is in the heap.
+  bool contains(const size_t aId) const noexcept {
+    return aId < thePos.size() and thePos[aId] != npos;
+  }
+
+  //! \return the identifier with the smallest key. \pre not empty.
+  size_t top() const {
+    assert(not theHeap.empty());
+    return theHeap.front();
+  }
+
+  //! \return the key of an identifier. \pre the identifier is in the heap.
+  const KEY& key(const size_t aId) const {
+    assert(contains(aId));
+    return theKeys[aId];
+  }
+
+  //! \return the identifiers in the heap, in no particular order.
+  const std::vector<size_t>& ids() const noexcept {
+    return theHeap;
+  }
+
+  //! Add an element. \pre the identifier is not in the heap.
+  void push(const size_t aId, const KEY& aKey);
+
+  //! Change the key of an element. \pre the identifier is in the heap.
+  void update(const size_t aId, const KEY& aKey);
+
+  //! Add an element or change its key if already in the heap.
+  void set(const size_t aId, const KEY& aKey);
+
+  //! Remove an element, if present.
+  void erase(const size_t aId);
+
+  /**
+   * Remove an element, if present, and decrement by one all the identifiers
+   * greater than it, in O(n). This keeps the identifiers aligned with the
+   * indices of a vector from which the element is erased.
+   */
+  void shift(const size_t aId);
+
+  //! Remove all the elements.
+  void clear();
+
+ private:
+  bool less(const size_t aLhs, const size_t aRhs) const {
+    return theKeys[aLhs] < theKeys[aRhs] or
+           (not(theKeys[aRhs] < theKeys[aLhs]) and aLhs < aRhs);
+  }
+  void place(const size_t aPos, const size_t aId) {
+    theHeap[aPos] = aId;
+    thePos[aId]   = aPos;
+  }
+  void siftUp(size_t aPos);
+  void siftDown(size_t aPos);
+
+ private:
+  // the heap of identifiers
+  std::vector<size_t> theHeap;
+  // for each identifier, its position in theHeap or npos if not present
+  std::vector<size_t> thePos;
+  // for each identifier, its key (meaningful only if present)
+  std::vector<KEY> theKeys;
+};
+
+template <class KEY>
+void IndexedHeap<KEY>::push(const size_t aId, const KEY& aKey) {
+  assert(aId != npos);
+  assert(not contains(aId));
+  if (aId >= thePos.size()) {
+    thePos.resize(aId + 1, npos);
+    theKeys.resize(aId + 1);
+  }
+  theKeys[aId] = aKey;
+  theHeap.emplace_back(aId);
+  thePos[aId] = theHeap.size() - 1;
+  siftUp(theHeap.size() - 1);
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::update(const size_t aId, const KEY& aKey) {
+  assert(contains(aId));
+  theKeys[aId] = aKey;
+  siftUp(thePos[aId]);
+  siftDown(thePos[aId]);
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::set(const size_t aId, const KEY& aKey) {
+  if (contains(aId)) {
+    update(aId, aKey);
+  } else {
+    push(aId, aKey);
+  }
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::erase(const size_t aId) {
+  if (not contains(aId)) {
+    return;
+  }
+  const auto myPos  = thePos[aId];
+  const auto myLast = theHeap.back();
+  theHeap.pop_back();
+  thePos[aId] = npos;
+  if (myLast != aId) {
+    place(myPos, myLast);
+    siftUp(myPos);
+    siftDown(thePos[myLast]);
+  }
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::shift(const size_t aId) {
+  erase(aId);
+  if (aId >= thePos.size()) {
+    return;
+  }
+  // the relative order of the remaining identifiers does not change, hence
+  // neither does that of elements with the same key
+  for (auto& myId : theHeap) {
+    if (myId > aId) {
+      --myId;
+    }
+  }
+  thePos.erase(thePos.begin() + aId);
+  theKeys.erase(theKeys.begin() + aId);
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::clear() {
+  for (const auto myId : theHeap) {
+    thePos[myId] = npos;
+  }
+  theHeap.clear();
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::siftUp(size_t aPos) {
+  const auto myId = theHeap[aPos];
+  while (aPos > 0) {
+    const auto myParent = (aPos - 1) / 2;
+    if (not less(myId, theHeap[myParent])) {
+      break;
+    }
+    place(aPos, theHeap[myParent]);
+    aPos = myParent;
+  }
+  place(aPos, myId);
+}
+
+template <class KEY>
+void IndexedHeap<KEY>::siftDown(size_t aPos) {
+  const auto myId = theHeap[aPos];
+  while (true) {
+    auto       myChild = 2 * aPos + 1;
+    const auto mySize  = theHeap.size();
+    if (myChild >= mySize) {
+      break;
+    }
+    if ((myChild + 1) < mySize and
+        less(theHeap[myChild + 1], theHeap[myChild])) {
+      ++myChild;
+    }
+    if (not less(theHeap[myChild], myId)) {
+      break;
+    }
+    place(aPos, theHeap[myChild]);
+    aPos = myChild;
+  }
+  place(aPos, myId);
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,96 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Atomic value accessed with relaxed memory ordering, which can be copied
+ * and stored in a std::vector.
+ *
+ * Meant for containers whose values are read by multiple threads while a
+ * single thread changes them: the container must not be resized while the
+ * values are being read, and modifying a value is not atomic as a whole, e.g.,
+ * operator+=() is a load followed by a store.
+ */
+template <class T>
+class RelaxedAtomic final
+{
+ public:
+  RelaxedAtomic(const T aValue = T()) noexcept
+      : theValue(aValue) {
+    // noop
+  }
+
+  RelaxedAtomic(const RelaxedAtomic& aOther) noexcept
+      : theValue(aOther.load()) {
+    // noop
+  }
+
+  RelaxedAtomic& operator=(const RelaxedAtomic& aOther) noexcept {
+    store(aOther.load());
+    return *this;
+  }
+
+  RelaxedAtomic& operator=(const T aValue) noexcept {
+    store(aValue);
+    return *this;
+  }
+
+  RelaxedAtomic& operator+=(const T aValue) noexcept {
+    store(load() + aValue);
+    return *this;
+  }
+
+  operator T() const noexcept {
+    return load();
+  }
+
+  T load() const noexcept {
+    return theValue.load(std::memory_order_relaxed);
+  }
+
+  void store(const T aValue) noexcept {
+    theValue.store(aValue, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<T> theValue;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
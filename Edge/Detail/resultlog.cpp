@@ -0,0 +1,198 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/resultlog.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+namespace {
+
+struct Header {
+  char     theMagic[8];
+  uint32_t theVersion;
+  uint32_t theRecordSize;
+};
+
+const char     MAGIC[8] = {'S', 'O', 'E', 'R', 'E', 'S', 'L', 'T'};
+const uint32_t VERSION  = 1;
+
+//! \return the given time, in s, as a saturated number of us.
+uint32_t toMicro(const double aTime) {
+  return static_cast<uint32_t>(std::min(
+      std::max(0.0, std::round(aTime * 1e6)),
+      static_cast<double>(std::numeric_limits<uint32_t>::max())));
+}
+
+std::string namesPath(const std::string& aPath) {
+  return aPath + ".names";
+}
+
+} // namespace
+
+ResultLog::ResultLog(const std::string& aPath, const size_t aBufferSize)
+    : thePath(aPath)
+    , theBufferSize(std::max<size_t>(1, aBufferSize))
+    , theStart(std::chrono::steady_clock::now())
+    , theMutex()
+    , theStream(aPath, std::ios::binary | std::ios::trunc)
+    , theBuffer()
+    , theSize(0)
+    , theIndices()
+    , theNames() {
+  if (not theStream) {
+    throw std::runtime_error("Could not create result log " + aPath + ": " +
+                             std::strerror(errno));
+  }
+  Header myHeader;
+  std::memcpy(myHeader.theMagic, MAGIC, sizeof(MAGIC));
+  myHeader.theVersion    = VERSION;
+  myHeader.theRecordSize = sizeof(Record);
+  theStream.write(reinterpret_cast<const char*>(&myHeader), sizeof(myHeader));
+  theBuffer.reserve(theBufferSize);
+}
+
+ResultLog::~ResultLog() {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  write();
+  theStream.close();
+
+  std::ofstream myNames(namesPath(thePath), std::ios::trunc);
+  for (const auto& myName : theNames) {
+    myNames << myName << '\n';
+  }
+  LOG_IF(ERROR, not theStream or not myNames)
+      << "Error while saving the result log " << thePath;
+}
+
+void ResultLog::operator()(const double       aLatency,
+                           const unsigned int aLoad1,
+                           const std::string& aResponder,
+                           const std::string& aName,
+                           const unsigned int aHops,
+                           const double       aProcessing,
+                           const double       aSlip) {
+  const auto myNow = std::chrono::steady_clock::now();
+
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  theBuffer.emplace_back(Record{
+      static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(myNow -
+                                                                theStart)
+              .count()),
+      toMicro(aLatency),
+      toMicro(aProcessing),
+      intern(aResponder),
+      intern(aName),
+      static_cast<uint16_t>(std::min(aHops, 0xFFFFu)),
+      static_cast<uint16_t>(std::min(aLoad1, 0xFFFFu)),
+      toMicro(aSlip)});
+  theSize++;
+  if (theBuffer.size() >= theBufferSize) {
+    write();
+  }
+}
+
+void ResultLog::flush() {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  write();
+  theStream.flush();
+}
+
+size_t ResultLog::size() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theSize;
+}
+
+std::vector<ResultLog::Record>
+ResultLog::read(const std::string& aPath, std::vector<std::string>& aNames) {
+  std::ifstream myStream(aPath, std::ios::binary);
+  if (not myStream) {
+    throw std::runtime_error("Could not open result log " + aPath);
+  }
+  Header myHeader;
+  myStream.read(reinterpret_cast<char*>(&myHeader), sizeof(myHeader));
+  if (not myStream or std::memcmp(myHeader.theMagic, MAGIC, sizeof(MAGIC)) or
+      myHeader.theVersion != VERSION or
+      myHeader.theRecordSize != sizeof(Record)) {
+    throw std::runtime_error("Invalid result log header in " + aPath);
+  }
+
+  std::vector<Record> ret;
+  Record              myRecord;
+  while (myStream.read(reinterpret_cast<char*>(&myRecord), sizeof(myRecord))) {
+    ret.emplace_back(myRecord);
+  }
+
+  aNames.clear();
+  std::ifstream myNames(namesPath(aPath));
+  if (not myNames) {
+    throw std::runtime_error("Could not open result log names " +
+                             namesPath(aPath));
+  }
+  for (std::string myLine; std::getline(myNames, myLine);) {
+    aNames.emplace_back(myLine);
+  }
+
+  return ret;
+}
+
+uint32_t ResultLog::intern(const std::string& aName) {
+  const auto myNext = static_cast<uint32_t>(theNames.size());
+  const auto ret    = theIndices.emplace(aName, myNext);
+  if (ret.second) {
+    theNames.emplace_back(aName);
+  }
+  return ret.first->second;
+}
+
+void ResultLog::write() {
+  if (theBuffer.empty()) {
+    return;
+  }
+  theStream.write(reinterpret_cast<const char*>(theBuffer.data()),
+                  theBuffer.size() * sizeof(Record));
+  theBuffer.clear();
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,154 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Binary log of the responses received by clients, with one fixed-size
+ * record per response, as a compact alternative to text output.
+ *
+ * The file begins with a header (magic, version, and record size) followed by
+ * the records, in host byte order. The names of the responders and of the
+ * lambda functions are not stored in the records but replaced by their
+ * indices in a table, which is saved when the log is destroyed as a text
+ * file, with one name per line, whose path is that of the log with the suffix
+ * ".names". Both can be loaded with read().
+ *
+ * The records are buffered and written in blocks. Thread-safe.
+ */
+class ResultLog final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(ResultLog);
+
+  //! A single response.
+  struct Record {
+    uint64_t theTime;       //!< since the log was created, in us
+    uint32_t theLatency;    //!< in us
+    uint32_t theProcessing; //!< in us
+    uint32_t theResponder;  //!< index of the responder name
+    uint32_t theName;       //!< index of the lambda function name
+    uint16_t theHops;
+    uint16_t theLoad1;
+    uint32_t theSlip; //!< delay of the request wrt schedule, in us
+  };
+  static_assert(sizeof(Record) == 32, "unexpected record size");
+
+  /**
+   * \param aPath the path of the log, which is truncated if existing.
+   *
+   * \param aBufferSize the number of records buffered before writing.
+   *
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  explicit ResultLog(const std::string& aPath,
+                     const size_t       aBufferSize = 32768);
+
+  //! Write the records buffered and save the names.
+  ~ResultLog();
+
+  /**
+   * Add a record, with the same arguments as the text output of clients.
+   *
+   * \param aLatency the latency, in s.
+   * \param aLoad1 the 1-second load of the responder.
+   * \param aResponder the responder end-point.
+   * \param aName the lambda function name.
+   * \param aHops the number of hops.
+   * \param aProcessing the processing time, in s.
+   * \param aSlip the delay between the time the request was sent and the
+   * time it was scheduled, in s, if applicable.
+   */
+  void operator()(const double       aLatency,
+                  const unsigned int aLoad1,
+                  const std::string& aResponder,
+                  const std::string& aName,
+                  const unsigned int aHops,
+                  const double       aProcessing,
+                  const double       aSlip = 0);
+
+  //! Write the records buffered.
+  void flush();
+
+  //! \return the number of records added.
+  size_t size() const;
+
+  /**
+   * Load a log from file.
+   *
+   * \param aPath the path of the log.
+   *
+   * \param aNames the names referred to by the records, on output.
+   *
+   * \return the records.
+   *
+   * \throw std::runtime_error if the files cannot be read or the header of
+   * the log is invalid.
+   */
+  static std::vector<Record> read(const std::string&        aPath,
+                                  std::vector<std::string>& aNames);
+
+ private:
+  //! \return the index of a name, added to the table if new.
+  uint32_t intern(const std::string& aName);
+
+  //! Write the records buffered. Must be called with the lock held.
+  void write();
+
+ private:
+  const std::string                           thePath;
+  const size_t                                theBufferSize;
+  const std::chrono::steady_clock::time_point theStart;
+  mutable std::mutex                          theMutex;
+  std::ofstream                               theStream;
+  std::vector<Record>                         theBuffer;
+  size_t                                      theSize;
+  std::unordered_map<std::string, uint32_t>   theIndices;
+  std::vector<std::string>                    theNames;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,170 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Double-ended queue of elements stored contiguously in a circular buffer,
+ * which grows geometrically when full and never shrinks.
+ *
+ * Insertion at the back and removal from the front are O(1), while insertion
+ * at an arbitrary position is linear in the number of elements that follow.
+ *
+ * Elements need only be move-constructible, i.e., they are never assigned.
+ */
+template <class T>
+class RingBuffer final
+{
+ public:
+  //! Create an empty buffer.
+  explicit RingBuffer()
+      : theSlots()
+      , theHead(0)
+      , theSize(0) {
+    // noop
+  }
+
+  //! \return true if the buffer is empty.
+  bool empty() const noexcept {
+    return theSize == 0;
+  }
+
+  //! \return the number of elements in the buffer.
+  size_t size() const noexcept {
+    return theSize;
+  }
+
+  //! \return the i-th element from the front. \pre i < size().
+  T& operator[](const size_t aIndex) {
+    assert(aIndex < theSize);
+    return *theSlots[slot(aIndex)];
+  }
+
+  //! \return the i-th element from the front. \pre i < size().
+  const T& operator[](const size_t aIndex) const {
+    assert(aIndex < theSize);
+    return *theSlots[slot(aIndex)];
+  }
+
+  //! \return the first element. \pre not empty.
+  T& front() {
+    return operator[](0);
+  }
+
+  //! \return the first element. \pre not empty.
+  const T& front() const {
+    return operator[](0);
+  }
+
+  //! Add an element at the back.
+  void push_back(T&& aElem) {
+    insert(theSize, std::move(aElem));
+  }
+
+  //! Add an element before the i-th one. \pre i <= size().
+  void insert(const size_t aIndex, T&& aElem);
+
+  //! Remove the first element. \pre not empty.
+  void pop_front();
+
+  //! Remove all the elements.
+  void clear();
+
+ private:
+  size_t slot(const size_t aIndex) const noexcept {
+    // the capacity is always a power of two
+    return (theHead + aIndex) & (theSlots.size() - 1);
+  }
+  void grow();
+
+ private:
+  std::vector<std::optional<T>> theSlots;
+  size_t                        theHead;
+  size_t                        theSize;
+};
+
+template <class T>
+void RingBuffer<T>::insert(const size_t aIndex, T&& aElem) {
+  assert(aIndex <= theSize);
+  if (theSize == theSlots.size()) {
+    grow();
+  }
+  // shift by one position all the elements following aIndex
+  for (auto i = theSize; i > aIndex; i--) {
+    auto& myDst = theSlots[slot(i)];
+    auto& mySrc = theSlots[slot(i - 1)];
+    myDst.emplace(std::move(*mySrc));
+    mySrc.reset();
+  }
+  theSlots[slot(aIndex)].emplace(std::move(aElem));
+  theSize++;
+}
+
+template <class T>
+void RingBuffer<T>::pop_front() {
+  assert(theSize > 0);
+  theSlots[theHead].reset();
+  theHead = slot(1);
+  theSize--;
+}
+
+template <class T>
+void RingBuffer<T>::clear() {
+  while (theSize > 0) {
+    pop_front();
+  }
+  theHead = 0;
+}
+
+template <class T>
+void RingBuffer<T>::grow() {
+  std::vector<std::optional<T>> mySlots(
+      theSlots.empty() ? 4 : (2 * theSlots.size()));
+  for (size_t i = 0; i < theSize; i++) {
+    mySlots[i].emplace(std::move(*theSlots[slot(i)]));
+  }
+  theSlots.swap(mySlots);
+  theHead = 0;
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
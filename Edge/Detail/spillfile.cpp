@@ -0,0 +1,185 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/spillfile.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+SpillFile::SpillFile(const std::string& aPath)
+    : thePath(aPath)
+    , theMutex()
+    , theFd(::open(aPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600))
+    , theMap(nullptr)
+    , theSize(0)
+    , theUsed(0)
+    , theFree() {
+  if (theFd < 0) {
+    throw std::runtime_error("Could not create spill file " + aPath + ": " +
+                             std::strerror(errno));
+  }
+  LOG(INFO) << "Created spill file " << aPath;
+}
+
+SpillFile::~SpillFile() {
+  if (theMap != nullptr) {
+    ::munmap(theMap, theSize);
+  }
+  ::close(theFd);
+  ::unlink(thePath.c_str());
+}
+
+SpillFile::Extent SpillFile::write(const std::string& aData) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+
+  const Extent ret{aData.empty() ? 0 : allocate(aData.size()), aData.size()};
+  if (not aData.empty()) {
+    std::memcpy(theMap + ret.theOffset, aData.data(), aData.size());
+  }
+  theUsed += aData.size();
+  return ret;
+}
+
+std::string SpillFile::read(const Extent& aExtent) const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  assert((aExtent.theOffset + aExtent.theSize) <= theSize);
+  return std::string(theMap + aExtent.theOffset, aExtent.theSize);
+}
+
+void SpillFile::free(const Extent& aExtent) {
+  if (aExtent.theSize == 0) {
+    return;
+  }
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  assert(theUsed >= aExtent.theSize);
+  theUsed -= aExtent.theSize;
+  release(aExtent.theOffset, aExtent.theSize);
+}
+
+uint64_t SpillFile::size() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theSize;
+}
+
+uint64_t SpillFile::used() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theUsed;
+}
+
+uint64_t SpillFile::allocate(const uint64_t aSize) {
+  assert(aSize > 0);
+  for (auto it = theFree.begin(); it != theFree.end(); ++it) {
+    if (it->second >= aSize) {
+      const auto ret = it->first;
+      if (it->second > aSize) {
+        theFree.emplace(it->first + aSize, it->second - aSize);
+      }
+      theFree.erase(it);
+      return ret;
+    }
+  }
+
+  // no free extent large enough: grow the file and try again, which
+  // succeeds because the free space at the end of the file is merged with
+  // the new space
+  grow(theSize + aSize);
+  return allocate(aSize);
+}
+
+void SpillFile::release(const uint64_t aOffset, const uint64_t aSize) {
+  auto myOffset = aOffset;
+  auto mySize   = aSize;
+
+  // merge with the next extent
+  const auto myNext = theFree.find(aOffset + aSize);
+  if (myNext != theFree.end()) {
+    mySize += myNext->second;
+    theFree.erase(myNext);
+  }
+
+  // merge with the previous extent
+  auto it = theFree.lower_bound(aOffset);
+  if (it != theFree.begin()) {
+    --it;
+    assert((it->first + it->second) <= aOffset);
+    if ((it->first + it->second) == aOffset) {
+      myOffset = it->first;
+      mySize += it->second;
+      theFree.erase(it);
+    }
+  }
+
+  theFree.emplace(myOffset, mySize);
+}
+
+void SpillFile::grow(const uint64_t aMinSize) {
+  static const uint64_t myMinSize = 1 << 20;
+  const auto mySize = std::max(std::max(aMinSize, 2 * theSize), myMinSize);
+
+  if (::ftruncate(theFd, mySize) != 0) {
+    throw std::runtime_error("Could not grow spill file " + thePath + " to " +
+                             std::to_string(mySize) +
+                             " bytes: " + std::strerror(errno));
+  }
+  auto myMap = static_cast<char*>(
+      ::mmap(nullptr, mySize, PROT_READ | PROT_WRITE, MAP_SHARED, theFd, 0));
+  if (myMap == MAP_FAILED) {
+    throw std::runtime_error("Could not map spill file " + thePath + ": " +
+                             std::strerror(errno));
+  }
+  if (theMap != nullptr) {
+    ::munmap(theMap, theSize);
+  }
+  VLOG(2) << "spill file " << thePath << " grown from " << theSize << " to "
+          << mySize << " bytes";
+
+  const auto myOldSize = theSize;
+  theMap               = myMap;
+  theSize              = mySize;
+  release(myOldSize, mySize - myOldSize);
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,121 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * A scratch file, memory-mapped, storing byte sequences in extents that
+ * can be freed and reused.
+ *
+ * Extents are allocated with a first-fit policy and adjacent free extents
+ * are merged. When there is no free extent large enough, the file grows
+ * geometrically and it is mapped again.
+ *
+ * The file is created, or truncated, in the ctor and removed in the dtor.
+ *
+ * Thread-safe.
+ */
+class SpillFile final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(SpillFile);
+
+  //! A region of the file.
+  struct Extent {
+    uint64_t theOffset;
+    uint64_t theSize;
+  };
+
+  /**
+   * \param aPath the path of the file.
+   *
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  explicit SpillFile(const std::string& aPath);
+
+  ~SpillFile();
+
+  /**
+   * Store a byte sequence.
+   *
+   * \return the extent where it has been stored.
+   *
+   * \throw std::runtime_error if the file cannot be grown.
+   */
+  Extent write(const std::string& aData);
+
+  //! \return a copy of the bytes in the given extent.
+  std::string read(const Extent& aExtent) const;
+
+  //! Release the given extent, which can be reused by later writes.
+  void free(const Extent& aExtent);
+
+  //! \return the size of the file, in bytes.
+  uint64_t size() const;
+
+  //! \return the bytes currently stored.
+  uint64_t used() const;
+
+ private:
+  //! \return the offset of a new extent of the given size.
+  uint64_t allocate(const uint64_t aSize);
+
+  //! Add a free extent, merging it with the adjacent ones.
+  void release(const uint64_t aOffset, const uint64_t aSize);
+
+  //! Grow the file so that it is at least aMinSize bytes.
+  void grow(const uint64_t aMinSize);
+
+ private:
+  const std::string  thePath;
+  mutable std::mutex theMutex;
+  int                theFd;
+  char*              theMap;
+  uint64_t           theSize;
+  uint64_t           theUsed;
+  // key: offset, value: size
+  std::map<uint64_t, uint64_t> theFree;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,253 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/tracefile.h"
+
+#include <glog/logging.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+namespace {
+
+struct Header {
+  char     theMagic[8];
+  uint32_t theVersion;
+  uint32_t theEventSize;
+  uint64_t theNumEvents;
+  uint64_t theNamesOffset;
+};
+
+const char     MAGIC[8] = {'S', 'O', 'E', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t VERSION  = 1;
+
+} // namespace
+
+TraceWriter::TraceWriter(const std::string& aPath)
+    : thePath(aPath)
+    , theStream(aPath, std::ios::binary | std::ios::trunc)
+    , theClosed(false)
+    , theNumEvents(0)
+    , theLastTime(0)
+    , theIndices()
+    , theNames() {
+  if (not theStream) {
+    throw std::runtime_error("Could not create trace " + aPath + ": " +
+                             std::strerror(errno));
+  }
+  // the header is overwritten in close()
+  const Header myHeader{};
+  theStream.write(reinterpret_cast<const char*>(&myHeader), sizeof(myHeader));
+}
+
+TraceWriter::~TraceWriter() {
+  try {
+    close();
+  } catch (const std::exception& aErr) {
+    LOG(ERROR) << aErr.what();
+  }
+}
+
+void TraceWriter::add(const double       aTime,
+                      const std::string& aLambda,
+                      const std::string& aServer,
+                      const size_t       aSize,
+                      const uint32_t     aClient) {
+  if (theClosed) {
+    throw std::runtime_error("Cannot add events to closed trace " + thePath);
+  }
+  if (aTime < 0) {
+    throw std::runtime_error("Invalid negative event time in trace: " +
+                             std::to_string(aTime));
+  }
+  const auto myTime = static_cast<uint64_t>(std::llround(aTime * 1e6));
+  if (myTime < theLastTime) {
+    throw std::runtime_error("Events not sorted by time in trace: " +
+                             std::to_string(aTime) + " after " +
+                             std::to_string(theLastTime * 1e-6));
+  }
+  const TraceEvent myEvent{myTime,
+                           intern(aLambda),
+                           intern(aServer),
+                           static_cast<uint32_t>(aSize),
+                           aClient};
+  theStream.write(reinterpret_cast<const char*>(&myEvent), sizeof(myEvent));
+  theLastTime = myTime;
+  theNumEvents++;
+}
+
+void TraceWriter::close() {
+  if (theClosed) {
+    return;
+  }
+  theClosed = true;
+
+  const auto myNumNames = static_cast<uint32_t>(theNames.size());
+  theStream.write(reinterpret_cast<const char*>(&myNumNames),
+                  sizeof(myNumNames));
+  for (const auto& myName : theNames) {
+    const auto myLength = static_cast<uint32_t>(myName.size());
+    theStream.write(reinterpret_cast<const char*>(&myLength), sizeof(myLength));
+    theStream.write(myName.data(), myLength);
+  }
+
+  Header myHeader;
+  std::memcpy(myHeader.theMagic, MAGIC, sizeof(MAGIC));
+  myHeader.theVersion     = VERSION;
+  myHeader.theEventSize   = sizeof(TraceEvent);
+  myHeader.theNumEvents   = theNumEvents;
+  myHeader.theNamesOffset = sizeof(Header) + theNumEvents * sizeof(TraceEvent);
+  theStream.seekp(0);
+  theStream.write(reinterpret_cast<const char*>(&myHeader), sizeof(myHeader));
+  theStream.close();
+
+  if (not theStream) {
+    throw std::runtime_error("Could not write trace " + thePath);
+  }
+  VLOG(1) << "written " << theNumEvents << " events to trace " << thePath;
+}
+
+uint32_t TraceWriter::intern(const std::string& aName) {
+  const auto myNext = static_cast<uint32_t>(theNames.size());
+  const auto ret    = theIndices.emplace(aName, myNext);
+  if (ret.second) {
+    theNames.emplace_back(aName);
+  }
+  return ret.first->second;
+}
+
+TraceFile::TraceFile(const std::string& aPath)
+    : thePath(aPath)
+    , theFd(::open(aPath.c_str(), O_RDONLY))
+    , theMap(nullptr)
+    , theSize(0)
+    , theEvents(nullptr)
+    , theNumEvents(0)
+    , theNames() {
+  if (theFd < 0) {
+    throw std::runtime_error("Could not open trace " + aPath + ": " +
+                             std::strerror(errno));
+  }
+
+  // release the resources before throwing, since the dtor is not called
+  const auto myFail = [this](const std::string& aReason) {
+    if (theMap != nullptr) {
+      ::munmap(theMap, theSize);
+    }
+    ::close(theFd);
+    throw std::runtime_error("Invalid trace " + thePath + ": " + aReason);
+  };
+
+  struct stat myStat;
+  if (::fstat(theFd, &myStat) != 0) {
+    myFail(std::strerror(errno));
+  }
+  theSize = static_cast<uint64_t>(myStat.st_size);
+  if (theSize < sizeof(Header)) {
+    myFail("too short");
+  }
+  theMap = static_cast<char*>(
+      ::mmap(nullptr, theSize, PROT_READ, MAP_PRIVATE, theFd, 0));
+  if (theMap == MAP_FAILED) {
+    theMap = nullptr;
+    myFail(std::strerror(errno));
+  }
+
+  Header myHeader;
+  std::memcpy(&myHeader, theMap, sizeof(myHeader));
+  if (std::memcmp(myHeader.theMagic, MAGIC, sizeof(MAGIC)) != 0 or
+      myHeader.theVersion != VERSION or
+      myHeader.theEventSize != sizeof(TraceEvent)) {
+    myFail("unsupported header");
+  }
+  if (myHeader.theNumEvents > (theSize - sizeof(Header)) / sizeof(TraceEvent) or
+      myHeader.theNamesOffset !=
+          sizeof(Header) + myHeader.theNumEvents * sizeof(TraceEvent)) {
+    myFail("inconsistent number of events");
+  }
+  theNumEvents = myHeader.theNumEvents;
+  theEvents    = reinterpret_cast<const TraceEvent*>(theMap + sizeof(Header));
+
+  // load the names
+  auto       myOffset  = myHeader.theNamesOffset;
+  const auto myReadU32 = [this, &myOffset, &myFail]() {
+    uint32_t ret;
+    if (theSize - myOffset < sizeof(ret)) {
+      myFail("truncated names");
+    }
+    std::memcpy(&ret, theMap + myOffset, sizeof(ret));
+    myOffset += sizeof(ret);
+    return ret;
+  };
+  const auto myNumNames = myReadU32();
+  theNames.reserve(myNumNames);
+  for (uint32_t i = 0; i < myNumNames; i++) {
+    const auto myLength = myReadU32();
+    if (theSize - myOffset < myLength) {
+      myFail("truncated names");
+    }
+    theNames.emplace_back(theMap + myOffset, myLength);
+    myOffset += myLength;
+  }
+
+  // the events are expected to be read sequentially
+  ::madvise(theMap, theSize, MADV_SEQUENTIAL);
+
+  LOG(INFO) << "opened trace " << aPath << " with " << theNumEvents
+            << " events and " << theNames.size() << " names";
+}
+
+TraceFile::~TraceFile() {
+  ::munmap(theMap, theSize);
+  ::close(theFd);
+}
+
+bool TraceFile::isTrace(const std::string& aPath) {
+  std::ifstream myStream(aPath, std::ios::binary);
+  char          myMagic[sizeof(MAGIC)];
+  return myStream.read(myMagic, sizeof(myMagic)) and
+         std::memcmp(myMagic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
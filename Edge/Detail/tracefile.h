@@ -0,0 +1,175 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Support/macros.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+/**
+ * Binary trace of lambda requests, with one fixed-size record per event,
+ * which is written by TraceWriter and read by TraceFile.
+ *
+ * The file consists of a header (magic, version, event size, number of
+ * events, and offset of the names), followed by the events sorted by time,
+ * in host byte order, followed by the table of the names of the lambda
+ * functions and of the edge servers referred to by the events, each
+ * preceded by its length.
+ */
+struct TraceEvent {
+  uint64_t theTime;   //!< since the beginning of the trace, in us
+  uint32_t theLambda; //!< index of the lambda function name
+  uint32_t theServer; //!< index of the edge server end-point
+  uint32_t theSize;   //!< size of the input, in bytes
+  uint32_t theClient; //!< identifier of the client issuing the request
+};
+static_assert(sizeof(TraceEvent) == 24, "unexpected event size");
+
+//! Write a binary trace of lambda requests, see TraceEvent.
+class TraceWriter final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(TraceWriter);
+
+  /**
+   * \param aPath the path of the trace, which is truncated if existing.
+   *
+   * \throw std::runtime_error if the file cannot be created.
+   */
+  explicit TraceWriter(const std::string& aPath);
+
+  //! Call close(), unless already done, logging errors.
+  ~TraceWriter();
+
+  /**
+   * Add an event.
+   *
+   * \param aTime the time of the event, in s.
+   * \param aLambda the lambda function name.
+   * \param aServer the edge server end-point.
+   * \param aSize the size of the input, in bytes.
+   * \param aClient the identifier of the client issuing the request.
+   *
+   * \throw std::runtime_error if aTime is negative or smaller than that of
+   * the previous event, or if the trace has been closed.
+   */
+  void add(const double       aTime,
+           const std::string& aLambda,
+           const std::string& aServer,
+           const size_t       aSize,
+           const uint32_t     aClient);
+
+  /**
+   * Write the names and finalize the header. No-op if already closed.
+   *
+   * \throw std::runtime_error if the file cannot be written.
+   */
+  void close();
+
+ private:
+  uint32_t intern(const std::string& aName);
+
+ private:
+  const std::string                         thePath;
+  std::ofstream                             theStream;
+  bool                                      theClosed;
+  uint64_t                                  theNumEvents;
+  uint64_t                                  theLastTime;
+  std::unordered_map<std::string, uint32_t> theIndices;
+  std::vector<std::string>                  theNames;
+};
+
+/**
+ * Read-only binary trace of lambda requests, see TraceEvent, which is
+ * memory-mapped so that opening even large traces is immediate and the
+ * events are loaded on demand.
+ *
+ * Thread-safe.
+ */
+class TraceFile final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(TraceFile);
+
+  /**
+   * \param aPath the path of the trace.
+   *
+   * \throw std::runtime_error if the file cannot be opened or it is not a
+   * valid trace.
+   */
+  explicit TraceFile(const std::string& aPath);
+
+  ~TraceFile();
+
+  //! \return true if the given file begins like a binary trace.
+  static bool isTrace(const std::string& aPath);
+
+  //! \return the number of events.
+  size_t size() const noexcept {
+    return theNumEvents;
+  }
+
+  //! \return the i-th event. \pre i < size().
+  const TraceEvent& operator[](const size_t aIndex) const noexcept {
+    return theEvents[aIndex];
+  }
+
+  /**
+   * \return the name with the given index.
+   *
+   * \throw std::out_of_range if the index is invalid.
+   */
+  const std::string& name(const uint32_t aIndex) const {
+    return theNames.at(aIndex);
+  }
+
+ private:
+  const std::string        thePath;
+  int                      theFd;
+  char*                    theMap;
+  uint64_t                 theSize;
+  const TraceEvent*        theEvents;
+  uint64_t                 theNumEvents;
+  std::vector<std::string> theNames;
+};
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
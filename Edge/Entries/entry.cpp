@@ -32,16 +32,20 @@ SOFTWARE.
 #include "entry.h"
 
 #include "Edge/forwardingtableexceptions.h"
-#include <glog/logging.h>
 
-#include <algorithm>
+#include <cassert>
 
 namespace uiiit {
 namespace edge {
 namespace entries {
 
 Entry::Entry()
-    : theDestinations() {
+    : theDestinations()
+    , theIndex() {
+}
+
+bool Entry::contains(const std::string& aDest) const {
+  return theIndex.count(aDest) > 0;
 }
 
 void Entry::change(const std::string& aDest,
@@ -52,20 +56,18 @@ void Entry::change(const std::string& aDest,
     throw InvalidDestination(aDest, aWeight);
   }
 
-  auto it = std::find_if(
-      theDestinations.begin(),
-      theDestinations.end(),
-      [&aDest](const auto& aElem) { return aElem.theDestination == aDest; });
+  const auto ret = theIndex.emplace(aDest, theDestinations.size());
 
-  if (it != theDestinations.end()) {
-    const auto myOldWeight = it->theWeight;
-    it->theWeight          = aWeight;
-    it->theFinal           = aFinal;
+  if (not ret.second) {
+    auto&      myElem      = theDestinations[ret.first->second];
+    const auto myOldWeight = myElem.theWeight;
+    myElem.theWeight       = aWeight;
+    myElem.theFinal        = aFinal;
 
-    updateWeight(aDest, myOldWeight, aWeight);
+    updateWeight(ret.first->second, myOldWeight);
   } else {
     theDestinations.emplace_back(Element{aDest, aWeight, aFinal});
-    updateAddDest(aDest, aWeight);
+    updateAddDest(ret.first->second);
   }
 }
 
@@ -78,19 +80,16 @@ void Entry::change(const std::string& aDest, const float aWeight) {
     throw InvalidDestination(aDest, aWeight);
   }
 
-  auto it = std::find_if(
-      theDestinations.begin(),
-      theDestinations.end(),
-      [&aDest](const auto& aElem) { return aElem.theDestination == aDest; });
-
-  if (it == theDestinations.end()) {
+  const auto it = theIndex.find(aDest);
+  if (it == theIndex.end()) {
     throw NoDestinations(aDest);
   }
 
-  const auto myOldWeight = it->theWeight;
-  it->theWeight          = aWeight;
+  auto&      myElem      = theDestinations[it->second];
+  const auto myOldWeight = myElem.theWeight;
+  myElem.theWeight       = aWeight;
 
-  updateWeight(aDest, myOldWeight, aWeight);
+  updateWeight(it->second, myOldWeight);
 }
 
 float Entry::weight(const std::string& aDest) const {
@@ -98,28 +97,28 @@ float Entry::weight(const std::string& aDest) const {
     throw NoDestinations();
   }
 
-  auto it = std::find_if(
-      theDestinations.begin(),
-      theDestinations.end(),
-      [&aDest](const auto& aElem) { return aElem.theDestination == aDest; });
-
-  if (it == theDestinations.end()) {
+  const auto it = theIndex.find(aDest);
+  if (it == theIndex.end()) {
     throw NoDestinations(aDest);
   }
-  return it->theWeight;
+  return theDestinations[it->second].theWeight;
 }
 
 bool Entry::remove(const std::string& aDest) {
-  for (auto it = theDestinations.begin(); it != theDestinations.end(); ++it) {
-    if (it->theDestination == aDest) {
-      const auto myDestination = it->theDestination;
-      const auto myWeight      = it->theWeight;
-      theDestinations.erase(it);
-      updateDelDest(myDestination, myWeight);
-      return true;
-    }
+  const auto it = theIndex.find(aDest);
+  if (it == theIndex.end()) {
+    return false;
   }
-  return false;
+  const auto myPos    = it->second;
+  const auto myWeight = theDestinations[myPos].theWeight;
+  theIndex.erase(it);
+  theDestinations.erase(theDestinations.begin() + myPos);
+  for (auto i = myPos; i < theDestinations.size(); i++) {
+    theIndex[theDestinations[i].theDestination] = i;
+  }
+  assert(theIndex.size() == theDestinations.size());
+  updateDelDest(myPos, myWeight);
+  return true;
 }
 
 std::map<std::string, std::pair<float, bool>> Entry::destinations() const {
@@ -131,14 +130,6 @@ std::map<std::string, std::pair<float, bool>> Entry::destinations() const {
   return myDestinations;
 }
 
-void Entry::printPFstats() {
-  LOG(INFO) << "thePFStats = " << '\n';
-  for (auto it = thePFstats.begin(); it != thePFstats.end(); ++it) {
-    LOG(INFO) << "[" << (*it).first << "] [" << (*it).second.first << "] ["
-              << (*it).second.second << "]\n";
-  }
-}
-
 } // namespace entries
 } // namespace edge
 } // namespace uiiit
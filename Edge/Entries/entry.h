@@ -31,9 +31,13 @@ SOFTWARE.
 
 #pragma once
 
-#include <list>
+#include "Edge/Detail/relaxedatomic.h"
+
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -41,16 +45,32 @@ namespace entries {
 
 /**
  * Generic entry of an edge router forwarding table.
+ *
+ * The destinations are stored contiguously, in order of insertion, and are
+ * identified by their position, which is also used by the derived classes to
+ * index their per-destination state: when a destination is removed the
+ * following ones are shifted back by one position, in the base class as well
+ * as in the derived classes, see updateDelDest(). The only structure keyed by
+ * name is the index used to resolve the destinations passed to the public
+ * methods.
+ *
+ * Lookups never block: operator() can be called concurrently from multiple
+ * threads, also while another thread changes the weight or final flag of an
+ * existing destination, which are stored as atomic values (the same holds
+ * for the state of the derived classes that depends on the weights). All
+ * the other modifications, i.e., adding or removing destinations, must not
+ * be concurrent with any other method, while clone() and the const methods
+ * can be called concurrently with lookups but not with modifications.
  */
 class Entry
 {
  protected:
   struct Element final {
-    std::string theDestination;
-    float       theWeight;
-    bool        theFinal;
-    bool        operator<(const Element& aOther) const noexcept {
-      return theWeight < aOther.theWeight;
+    std::string                  theDestination;
+    detail::RelaxedAtomic<float> theWeight;
+    detail::RelaxedAtomic<bool>  theFinal;
+    bool operator<(const Element& aOther) const noexcept {
+      return theWeight.load() < aOther.theWeight.load();
     }
   };
 
@@ -61,14 +81,27 @@ class Entry
   virtual ~Entry() {
   }
 
+  /**
+   * \return a deep copy of this entry.
+   *
+   * Used by ForwardingTable to add or remove destinations without blocking
+   * the lookups on the published entry.
+   */
+  virtual std::unique_ptr<Entry> clone() const = 0;
+
   //! \return True if there are no destinations.
   bool empty() const noexcept {
     return theDestinations.empty();
   }
 
+  //! \return True if the given destination exists.
+  bool contains(const std::string& aDest) const;
+
   /**
    * Return a random destination according to the weights.
    *
+   * Can be called concurrently from multiple threads.
+   *
    * \throw NoDestinations if the current entry is empty.
    */
   virtual std::string operator()() = 0;
@@ -104,7 +137,7 @@ class Entry
   void change(const std::string& aDest, const float aWeight);
 
   /**
-   * Remove a destination
+   * Remove a destination, in O(n).
    *
    * \return True if the destination has been actually removed.
    */
@@ -121,29 +154,30 @@ class Entry
   //! \return All the destinations, weights, and final flags.
   std::map<std::string, std::pair<float, bool>> destinations() const;
 
-  //! print content of thePFstats (used for testing)
-  void printPFstats();
+ protected:
+  //! Copy the destinations from another entry.
+  Entry(const Entry& aOther) = default;
 
  private:
-  virtual void updateWeight(const std::string& aDest,
-                            const float        aOldWeight,
-                            const float        aNewWeight)                         = 0;
-  virtual void updateAddDest(const std::string& aDest, const float aWeight) = 0;
-  virtual void updateDelDest(const std::string& aDest, const float aWeight) = 0;
+  //! Called after the weight of the i-th destination has been changed.
+  virtual void updateWeight(const size_t aIndex, const float aOldWeight) = 0;
 
- protected:
-  std::list<Element> theDestinations;
+  //! Called after a destination has been added as the i-th, i.e., the last.
+  virtual void updateAddDest(const size_t aIndex) = 0;
 
   /**
-   * data structure used only if the scheduling policy is PF:
-   * - the string is the destination (field theDestination in datastructure
-   *   Element);
-   * - pair.first is theLambdaServedCount related to the destination,
-   *   datastructure
-   * - pair.second is theTimestamp in which the destination joined the system
-   *   or has served the last Lambda Request
+   * Called after the i-th destination, with the given weight, has been
+   * removed and the following ones have been shifted back by one position.
    */
-  std::map<std::string, std::pair<int, double>> thePFstats;
+  virtual void updateDelDest(const size_t aIndex, const float aWeight) = 0;
+
+ protected:
+  // the destinations, by position
+  std::vector<Element> theDestinations;
+
+ private:
+  // the position of every destination in theDestinations
+  std::unordered_map<std::string, size_t> theIndex;
 };
 
 } // namespace entries
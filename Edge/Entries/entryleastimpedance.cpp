@@ -35,6 +35,8 @@ SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
+#include <tuple>
 
 namespace uiiit {
 namespace edge {
@@ -42,45 +44,52 @@ namespace entries {
 
 EntryLeastImpedance::EntryLeastImpedance()
     : Entry()
-    , theMinElement(theDestinations.end()) {
+    , theMin(0) {
+}
+
+std::unique_ptr<Entry> EntryLeastImpedance::clone() const {
+  return std::unique_ptr<Entry>(new EntryLeastImpedance(*this));
 }
 
 std::string EntryLeastImpedance::operator()() {
   if (theDestinations.empty()) {
     throw NoDestinations();
   }
-  return theMinElement->theDestination;
+  const size_t myMin = theMin;
+  assert(myMin < theDestinations.size());
+  return theDestinations[myMin].theDestination;
 }
 
-void EntryLeastImpedance::updateWeight(const std::string& aDest,
-                                       const float        aOldWeight,
-                                       const float        aNewWeight) {
-  assert(theMinElement != theDestinations.end());
-  if (aNewWeight <= theMinElement->theWeight or
-      aOldWeight == theMinElement->theWeight) {
+void EntryLeastImpedance::updateWeight(const size_t aIndex,
+                                       const float  aOldWeight) {
+  std::ignore = aOldWeight;
+  assert(theMin < theDestinations.size());
+  if (aIndex == theMin or
+      theDestinations[aIndex].theWeight <= theDestinations[theMin].theWeight) {
     update();
   }
 }
 
-void EntryLeastImpedance::updateAddDest(const std::string& aDest,
-                                        const float        aWeight) {
-  if (theMinElement == theDestinations.end()) {
-    theMinElement = theDestinations.begin();
-  } else if (aWeight < theMinElement->theWeight) {
-    update();
+void EntryLeastImpedance::updateAddDest(const size_t aIndex) {
+  if (aIndex == 0 or
+      theDestinations[aIndex].theWeight < theDestinations[theMin].theWeight) {
+    theMin = aIndex;
   }
 }
 
-void EntryLeastImpedance::updateDelDest(const std::string& aDest,
-                                        const float        aWeight) {
-  if (theMinElement->theWeight == aWeight) {
+void EntryLeastImpedance::updateDelDest(const size_t                 aIndex,
+                                        [[maybe_unused]] const float aWeight) {
+  if (aIndex == theMin) {
     update();
+  } else if (aIndex < theMin) {
+    theMin = theMin - 1;
   }
 }
 
 void EntryLeastImpedance::update() {
-  theMinElement =
-      std::min_element(theDestinations.begin(), theDestinations.end());
+  theMin = std::distance(
+      theDestinations.begin(),
+      std::min_element(theDestinations.begin(), theDestinations.end()));
 }
 
 } // namespace entries
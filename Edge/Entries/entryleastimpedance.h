@@ -31,9 +31,10 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/relaxedatomic.h"
 #include "entry.h"
 
-#include <list>
+#include <cstddef>
 #include <string>
 
 namespace uiiit {
@@ -42,24 +43,28 @@ namespace entries {
 
 /**
  * If the are multiple options available, take the one with smallest weight.
+ * Ties are broken in favor of the destination that has been added first.
  */
 class EntryLeastImpedance final : public Entry
 {
  public:
   explicit EntryLeastImpedance();
 
+  std::unique_ptr<Entry> clone() const override;
+
  private:
   std::string operator()() override;
 
-  void updateWeight(const std::string& aDest,
-                    const float        aOldWeight,
-                    const float        aNewWeight) override;
-  void updateAddDest(const std::string& aDest, const float aWeight) override;
-  void updateDelDest(const std::string& aDest, const float aWeight) override;
+  void updateWeight(const size_t aIndex, const float aOldWeight) override;
+  void updateAddDest(const size_t aIndex) override;
+  void updateDelDest(const size_t aIndex, const float aWeight) override;
+
+  //! Find the destination with smallest weight, in O(n).
   void update();
 
  private:
-  std::list<Element>::iterator theMinElement;
+  // position of the destination with smallest weight, read without locking
+  detail::RelaxedAtomic<size_t> theMin;
 };
 
 } // namespace entries
@@ -33,7 +33,8 @@ SOFTWARE.
 
 #include "Edge/forwardingtableexceptions.h"
 
-#include <algorithm>
+#include <glog/logging.h>
+
 #include <cassert>
 
 namespace uiiit {
@@ -45,92 +46,116 @@ EntryProportionalFairness::EntryProportionalFairness(double aAlpha,
     : Entry()
     , theChrono(true)
     , theAlpha(aAlpha)
-    , theBeta(aBeta) {
+    , theBeta(aBeta)
+    , theCounts()
+    , theTimestamps()
+    , theFactors() {
+}
+
+std::unique_ptr<Entry> EntryProportionalFairness::clone() const {
+  return std::unique_ptr<Entry>(new EntryProportionalFairness(*this));
 }
 
 /**
- * The Entry functional operator must compute all the prioritarization
- * coefficients and return the maximum one.
+ * The Entry functional operator must find the destination with maximum
+ * prioritarization coefficient: ties are broken in favor of the destination
+ * that has been added first.
  */
 std::string EntryProportionalFairness::operator()() {
   if (theDestinations.empty()) {
     throw NoDestinations();
   }
+  assert(theFactors.size() == theDestinations.size());
+
+  size_t ret = 0;
+  if (theBeta == 0) {
+    for (size_t i = 1; i < theFactors.size(); i++) {
+      if (theFactors[i] > theFactors[ret]) {
+        ret = i;
+      }
+    }
 
-  std::string ret;
-  float       myMaxWeight = 0;
-  const auto  myNow = theChrono.time();
-
-  for (auto it = theDestinations.begin(); it != theDestinations.end(); ++it) {
-    auto destinationStatsIt = thePFstats.find((*it).theDestination);
-    assert(destinationStatsIt != thePFstats.end());
-
-    const auto myCurWeight = computeWeight((*it).theWeight,
-                                           (*destinationStatsIt).second.first,
-                                           (*destinationStatsIt).second.second,
-                                           myNow);
-    if (ret.empty() or myCurWeight > myMaxWeight) {
-      myMaxWeight = myCurWeight;
-      ret         = (*it).theDestination;
+  } else {
+    const auto myNow  = theChrono.time();
+    double     myBest = theFactors[0] * (myNow - theTimestamps[0]);
+    for (size_t i = 1; i < theFactors.size(); i++) {
+      const double myCur = theFactors[i] * (myNow - theTimestamps[i]);
+      if (theBeta > 0 ? myCur > myBest : myCur < myBest) {
+        myBest = myCur;
+        ret    = i;
+      }
     }
   }
 
-  return ret;
+  return theDestinations[ret].theDestination;
 }
 
 /**
- * experiencedLatency is the latency experienced and stored in theWeight field
+ * The latency is the one experienced and stored in theWeight field
  * by the LocalOptimizer during the processSuccess or 1  if the entry is "fresh"
  * (just inserted by the controller)
  */
-float EntryProportionalFairness::computeWeight(float  experiencedLatency,
-                                               int    theLambdaServedCount,
-                                               double theDestinationTimestamp,
-                                               double curTimestamp) {
-  return pow((1 / experiencedLatency), theAlpha) /
-         pow((theLambdaServedCount / (curTimestamp - theDestinationTimestamp)),
-             theBeta);
+double EntryProportionalFairness::factor(const size_t aIndex) const {
+  const float myLatency = theDestinations[aIndex].theWeight;
+  if (theBeta == 0) {
+    return std::pow(1.0 / myLatency, theAlpha);
+  }
+  return std::pow(1.0 / myLatency, theAlpha / theBeta) / theCounts[aIndex];
 }
 
 /**
- * this function only updates thePFstats (theLambdaServedCount and the
+ * this function only updates the PF statistics (theLambdaServedCount and the
  * Timestamp) of the destination which has served the LambdaRequest
  */
 void EntryProportionalFairness::updateWeight(
-    const std::string&           aDest,
-    [[maybe_unused]] const float aOldWeight,
-    [[maybe_unused]] const float aNewWeight) {
-  const auto myNow = theChrono.time();
-  auto       it    = thePFstats.find(aDest);
-  assert(it != thePFstats.end());
-  it->second = {it->second.first + 1, myNow};
+    const size_t aIndex, [[maybe_unused]] const float aOldWeight) {
+  assert(aIndex < theFactors.size());
+  theTimestamps[aIndex] = theChrono.time();
+  theCounts[aIndex] += 1;
+  theFactors[aIndex] = factor(aIndex);
   printPFstats();
 }
 
 /**
- * this function only updates thePFstats data structure inserting a new
- * destination as key and a pair in which theLambdaServedCount is set to 1
+ * this function only updates the PF statistics inserting a new
+ * destination in which theLambdaServedCount is set to 1
  * otherwise a "division by 0" exception is thrown during the computation of its
  * weight in the functional operator (invoked by the EdgeRouter.destination).
  */
-void EntryProportionalFairness::updateAddDest(
-    const std::string& aDest, [[maybe_unused]] const float aWeight) {
-  thePFstats.insert({aDest, std::make_pair(1, theChrono.time())});
+void EntryProportionalFairness::updateAddDest(const size_t aIndex) {
+  assert(aIndex == theFactors.size());
+  theCounts.emplace_back(1);
+  theTimestamps.emplace_back(theChrono.time());
+  theFactors.emplace_back(factor(aIndex));
   printPFstats();
 }
 
 /**
- * this function only updates thePFstats data structure deleting the detination
- * removed in theDestination data structure.
+ * this function only updates the PF statistics deleting the destination
+ * removed in theDestination data structure, while preserving the order of
+ * the remaining ones.
  */
 void EntryProportionalFairness::updateDelDest(
-    const std::string& aDest, [[maybe_unused]] const float aWeight) {
-  auto it = thePFstats.find(aDest);
-  assert(it != thePFstats.end());
-  thePFstats.erase(it);
+    const size_t aIndex, [[maybe_unused]] const float aWeight) {
+  assert(aIndex < theFactors.size());
+  theCounts.erase(theCounts.begin() + aIndex);
+  theTimestamps.erase(theTimestamps.begin() + aIndex);
+  theFactors.erase(theFactors.begin() + aIndex);
   printPFstats();
 }
 
+void EntryProportionalFairness::printPFstats() const {
+  if (not VLOG_IS_ON(2)) {
+    return;
+  }
+  LOG(INFO) << "thePFStats = " << '\n';
+  for (size_t i = 0; i < theDestinations.size(); i++) {
+    LOG(INFO) << "[" << theDestinations[i].theDestination << "] ["
+              << theCounts[i].load() << "] [" << theTimestamps[i].load()
+              << "]\n";
+  }
+}
+
 } // namespace entries
 } // namespace edge
 } // namespace uiiit
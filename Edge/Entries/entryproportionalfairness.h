@@ -31,12 +31,13 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/relaxedatomic.h"
 #include "Edge/Entries/entry.h"
 #include "Support/chrono.h"
 
 #include <cmath>
-#include <list>
 #include <string>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -61,30 +62,50 @@ namespace entries {
  *    - alpha = 0, beta = 1 => Round Robin
  *    - alpha = 1, beta = 0 => max unfairness, max throughput
  *    - alpha ~= 1, beta ~= 1 => 3G scheduling algorithm
+ *
+ * Since PC = ((T^(alpha/beta) / theLambdaServedCount) * dt)^beta, where dt is
+ * the time elapsed since theTimestamp, for beta > 0 the destination with
+ * maximum PC is also that with maximum F * dt, where F does not depend on
+ * time and is cached for every destination when its weight is updated
+ * (for beta < 0 the minimum must be taken instead, for beta = 0 the
+ * coefficient PC = T^alpha does not depend on time). This way the selection
+ * only requires one multiplication per destination.
  */
 class EntryProportionalFairness final : public Entry
 {
  public:
   explicit EntryProportionalFairness(double aAlpha, double aBeta);
 
+  std::unique_ptr<Entry> clone() const override;
+
  private:
   std::string operator()() override;
 
-  void updateWeight(const std::string& aDest,
-                    const float        aOldWeight,
-                    const float        aNewWeight) override;
-  void updateAddDest(const std::string& aDest, const float aWeight) override;
-  void updateDelDest(const std::string& aDest, const float aWeight) override;
+  void updateWeight(const size_t aIndex, const float aOldWeight) override;
+  void updateAddDest(const size_t aIndex) override;
+  void updateDelDest(const size_t aIndex, const float aWeight) override;
 
-  float computeWeight(float  experiencedLatency,
-                      int    theLambdaServedCount,
-                      double theDestinationTimestamp,
-                      double curTimestamp);
+  //! \return the time-invariant factor F of the i-th destination.
+  double factor(const size_t aIndex) const;
+
+  //! print the PF statistics (used for testing)
+  void printPFstats() const;
 
  private:
   support::Chrono theChrono;
   const double    theAlpha;
   const double    theBeta;
+
+  // per-destination statistics, in the same order as theDestinations, whose
+  // weight is the last latency experienced:
+  // - theCounts: the number of lambda requests served (initially 1);
+  // - theTimestamps: the time when the destination joined the system or it
+  //   has served the last lambda request
+  // - theFactors: the cached time-invariant factor F
+  // they are changed with the weights, hence they are read without locking
+  std::vector<detail::RelaxedAtomic<int>>    theCounts;
+  std::vector<detail::RelaxedAtomic<double>> theTimestamps;
+  std::vector<detail::RelaxedAtomic<double>> theFactors;
 };
 
 } // namespace entries
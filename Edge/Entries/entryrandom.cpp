@@ -42,51 +42,43 @@ namespace entries {
 
 EntryRandom::EntryRandom()
     : Entry()
-    , theInvSum(0) {
+    , theTree() {
+}
+
+std::unique_ptr<Entry> EntryRandom::clone() const {
+  return std::unique_ptr<Entry>(new EntryRandom(*this));
 }
 
 std::string EntryRandom::operator()() {
   if (theDestinations.empty()) {
     throw NoDestinations();
   }
+  assert(theTree.size() == theDestinations.size());
 
   // if there is a single destination then we can skip the logic for selection
   if (theDestinations.size() == 1) {
     return theDestinations.front().theDestination;
   }
 
-  const auto myRand = support::random() * theInvSum; // [0, theSum)
-
-  float mySum{0.0f};
-  for (auto it = theDestinations.begin();
-       it != std::prev(theDestinations.end());
-       ++it) {
-    assert(it->theWeight != 0.0f);
-    mySum += 1.0f / it->theWeight;
-    if (myRand <= mySum) {
-      return it->theDestination;
-    }
-  }
-
-  return theDestinations.back().theDestination;
+  return theDestinations[theTree.find(support::random() * theTree.total())]
+      .theDestination;
 }
 
-void EntryRandom::updateWeight(const std::string& aDest,
-                               const float        aOldWeight,
-                               const float        aNewWeight) {
-  assert(aNewWeight != 0);
-  assert(aOldWeight != 0);
-  theInvSum += (1.0f / aNewWeight) - (1.0f / aOldWeight);
+void EntryRandom::updateWeight(const size_t                 aIndex,
+                               [[maybe_unused]] const float aOldWeight) {
+  assert(theDestinations[aIndex].theWeight != 0);
+  theTree.set(aIndex, 1.0 / theDestinations[aIndex].theWeight);
 }
 
-void EntryRandom::updateAddDest(const std::string& aDest, const float aWeight) {
-  assert(aWeight != 0);
-  theInvSum += 1.0f / aWeight;
+void EntryRandom::updateAddDest(const size_t aIndex) {
+  assert(aIndex == theTree.size());
+  assert(theDestinations[aIndex].theWeight != 0);
+  theTree.push_back(1.0 / theDestinations[aIndex].theWeight);
 }
 
-void EntryRandom::updateDelDest(const std::string& aDest, const float aWeight) {
-  assert(aWeight != 0);
-  theInvSum -= 1.0f / aWeight;
+void EntryRandom::updateDelDest(const size_t                 aIndex,
+                                [[maybe_unused]] const float aWeight) {
+  theTree.erase(aIndex);
 }
 
 } // namespace entries
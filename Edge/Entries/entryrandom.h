@@ -31,6 +31,7 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/fenwicktree.h"
 #include "entry.h"
 
 #include <string>
@@ -42,25 +43,29 @@ namespace entries {
 /**
  * If the are multiple options available, one at random is
  * returned according to the associated weights.
+ *
+ * The probability to select a destination is proportional to the inverse of
+ * its weight. The inverse weights are kept in a Fenwick tree, in the same
+ * order as the destinations, so that both the selection and the updates of
+ * the weights take O(log n) time.
  */
 class EntryRandom final : public Entry
 {
  public:
   explicit EntryRandom();
 
+  std::unique_ptr<Entry> clone() const override;
+
  private:
   std::string operator()() override;
 
-  void updateWeight(const std::string& aDest,
-                    const float        aOldWeight,
-                    const float        aNewWeight) override;
-  void updateAddDest(const std::string& aDest, const float aWeight) override;
-  void updateDelDest(const std::string& aDest, const float aWeight) override;
-
-  static float random();
+  void updateWeight(const size_t aIndex, const float aOldWeight) override;
+  void updateAddDest(const size_t aIndex) override;
+  void updateDelDest(const size_t aIndex, const float aWeight) override;
 
  private:
-  float theInvSum;
+  // inverse of the weights of the destinations
+  detail::FenwickTree theTree;
 };
 
 } // namespace entries
@@ -33,9 +33,8 @@ SOFTWARE.
 
 #include "Edge/forwardingtableexceptions.h"
 
-#include <algorithm>
 #include <cassert>
-#include <limits>
+#include <map>
 #include <sstream>
 
 #include <glog/logging.h>
@@ -44,221 +43,377 @@ namespace uiiit {
 namespace edge {
 namespace entries {
 
+namespace {
+
+// used for both the identifiers and the versions, which are never reused
+uint64_t nextEntryRoundRobinId() {
+  static std::atomic<uint64_t> myNext(1);
+  return myNext++;
+}
+
+} // namespace
+
 EntryRoundRobin::EntryRoundRobin()
-    : theCache()
-    , theQueue()
+    : Entry()
+    , theNodes()
+    , theFlags()
+    , theWeights()
+    , theEvictable()
+    , theWaiting()
+    , theExpiring()
+    , theLastEval(0)
     , theChrono(true)
-    , theStat() {
+    , theId(nextEntryRoundRobinId())
+    , theLifetime(std::make_shared<const int>(0))
+    , theVersion(nextEntryRoundRobinId())
+    , theChange()
+    , theGeneration(nextEntryRoundRobinId())
+    , theFlagsChanged(false) {
+}
+
+EntryRoundRobin::EntryRoundRobin(const EntryRoundRobin& aOther)
+    : Entry(aOther)
+    , theNodes(aOther.theNodes)
+    , theFlags(aOther.theFlags)
+    , theWeights(aOther.theWeights)
+    , theEvictable(aOther.theEvictable)
+    , theWaiting(aOther.theWaiting)
+    , theExpiring(aOther.theExpiring)
+    , theLastEval(aOther.theLastEval)
+    , theChrono(aOther.theChrono)
+    , theId(aOther.theId)
+    , theLifetime(aOther.theLifetime)
+    , theVersion(aOther.theVersion)
+    , theChange(aOther.theChange)
+    , theGeneration(aOther.theGeneration.load())
+    , theFlagsChanged(false) {
+}
+
+std::unique_ptr<Entry> EntryRoundRobin::clone() const {
+  return std::unique_ptr<Entry>(new EntryRoundRobin(*this));
 }
 
 std::string EntryRoundRobin::operator()() {
-  if (theQueue.empty()) {
-    assert(theDestinations.empty());
+  if (theDestinations.empty()) {
     throw NoDestinations();
   }
 
-  // save the current destination for return, mark timestamp and update deficit
-  auto myElem = theQueue.top();
-  theQueue.pop();
-  const auto myDestination = myElem.theElem->first;
-  myElem.theElem->second.theDeficit += myElem.theElem->second.theWeight;
-  theQueue.push(myElem);
+  auto& myDeficits = deficits();
+  if (myDeficits.theActive.empty()) {
+    // the active set is being changed, take any destination and retry the
+    // synchronization at the next lookup
+    myDeficits.theGeneration = 0;
+    return theDestinations.front().theDestination;
+  }
+
+  // return the current destination and update its deficit
+  const auto myIndex   = myDeficits.theActive.top();
+  auto&      myDeficit = myDeficits.theDeficits[myIndex];
+  myDeficit += theDestinations[myIndex].theWeight;
+  myDeficits.theActive.update(myIndex, myDeficit);
+  normalize(myDeficits);
 
-  return myDestination;
+  return theDestinations[myIndex].theDestination;
 }
 
-bool EntryRoundRobin::good(const double aWeight) {
-  assert(theStat.count() > 0);
-  if (theStat.count() == 1 or aWeight <= (theStat.min() * 2)) {
+bool EntryRoundRobin::good(const float aWeight) const {
+  assert(not theWeights.empty());
+  if (theWeights.size() == 1 or
+      aWeight <= (theWeights.key(theWeights.top()) * 2)) {
     return true;
   }
   return false;
 }
 
-void EntryRoundRobin::updateWeight(const std::string& aDest,
-                                   const float        aOldWeight,
-                                   const float        aNewWeight) {
+void EntryRoundRobin::updateWeight(const size_t aIndex,
+                                   const float  aOldWeight) {
   std::ignore = aOldWeight;
-  updateWeight(aDest, aNewWeight);
+  assert(aIndex < theNodes.size());
+
+  theWeights.update(aIndex, theDestinations[aIndex].theWeight);
+  theNodes[aIndex].theLastUpdated = theChrono.time();
+
+  updateActiveSet(aIndex);
+
+  debugPrintActiveSet();
 }
 
-void EntryRoundRobin::updateAddDest(const std::string& aDest,
-                                    const float        aWeight) {
-  std::ignore = aDest;
-  std::ignore = aWeight;
-  updateList();
+void EntryRoundRobin::updateAddDest(const size_t aIndex) {
+  assert(aIndex == theNodes.size());
+
+  record(aIndex, true);
+  theNodes.emplace_back();
+  theFlags.emplace_back(false);
+  theWeights.push(aIndex, theDestinations[aIndex].theWeight);
+
+  updateActiveSet(aIndex);
+
+  debugPrintActiveSet();
 }
 
-void EntryRoundRobin::updateDelDest(const std::string& aDest,
-                                    const float        aWeight) {
-  std::ignore = aDest;
+void EntryRoundRobin::updateDelDest(const size_t aIndex, const float aWeight) {
   std::ignore = aWeight;
-  updateList();
-}
+  assert(aIndex < theNodes.size());
 
-void EntryRoundRobin::updateWeight(const std::string& aDest,
-                                   const float        aWeight) {
-  auto it = theCache.find(aDest);
-  assert(it != theCache.end());
-  it->second.theWeight      = aWeight;
-  it->second.theLastUpdated = theChrono.time();
-
-  // force the element with the smallest deficit to have 0 deficit
-  const auto myMinDeficit = minDeficit();
-  for (auto& myElem : theCache) {
-    myElem.second.theDeficit -= myMinDeficit;
+  record(aIndex, false);
+  if (theDestinations.empty()) {
+    theNodes.clear();
+    theFlags.clear();
+    theWeights.clear();
+    theEvictable.clear();
+    theWaiting.clear();
+    theExpiring.clear();
+    return;
   }
 
-  // update the active set
-  updateActiveSet();
+  // the destinations following the one removed are shifted back by one
+  theNodes.erase(theNodes.begin() + aIndex);
+  theFlags.erase(theFlags.begin() + aIndex);
+  theWeights.shift(aIndex);
+  theEvictable.shift(aIndex);
+  theWaiting.shift(aIndex);
+  theExpiring.shift(aIndex);
+
+  updateActiveSet(noIndex());
 
   debugPrintActiveSet();
 }
 
-float EntryRoundRobin::minDeficit() {
-  float myMinDeficit = std::numeric_limits<float>::max();
-  auto  myDup        = theQueue;
-  while (not myDup.empty()) {
-    const auto myElem = myDup.top();
-    myDup.pop();
-    myMinDeficit = std::min(myMinDeficit, myElem.theElem->second.theDeficit);
+void EntryRoundRobin::updateActiveSet(const size_t aChanged) {
+  theLastEval = theChrono.time();
+
+  // the destination changed may enter or leave the active set
+  if (aChanged != noIndex()) {
+    evaluate(aChanged);
   }
-  return myMinDeficit;
-}
 
-void EntryRoundRobin::updateList() {
-  if (theDestinations.empty()) {
-    theCache.clear();
-    std::priority_queue<QueueElement> myEmptyQueue;
-    theQueue.swap(myEmptyQueue);
-    return;
+  // the minimum weight may have grown, which admits more destinations
+  while (not theWaiting.empty() and
+         good(theWaiting.key(theWaiting.top()))) {
+    activate(theWaiting.top());
   }
 
-  // mark all cache elements to be removed, then uncheck those that are still
-  // there also, add new entries to the cache
-  for (auto& myPair : theCache) {
-    myPair.second.theRemoved = true;
+  // destinations whose stale timer has expired are admitted for probing
+  while (not theExpiring.empty() and
+         theExpiring.key(theExpiring.top()) <= theLastEval) {
+    probe(theExpiring.top());
   }
 
-  const auto myMinDeficit = minDeficit();
-  for (const auto& myDestination : theDestinations) {
-    const auto ret =
-        theCache.insert({myDestination.theDestination,
-                         CacheElement(myDestination.theWeight, myMinDeficit)});
-    if (not ret.second) {
-      // update weight and mark as non-vanishing
-      ret.first->second.theRemoved = false;
-      ret.first->second.theWeight  = myDestination.theWeight;
-    }
+  // the minimum weight may have decreased, which evicts destinations
+  settle();
+
+  // make the changes visible to the lookups
+  if (theFlagsChanged) {
+    theFlagsChanged = false;
+    theGeneration.store(nextEntryRoundRobinId(), std::memory_order_release);
   }
+}
 
-  // remove all vanishing elements
-  for (auto it = theCache.begin(); it != theCache.end();) {
-    if (it->second.theRemoved) {
-      it = theCache.erase(it);
+void EntryRoundRobin::evaluate(const size_t aIndex) {
+  auto&      myNode        = theNodes[aIndex];
+  const auto myLastUpdated = myNode.theLastUpdated;
+
+  if (good(theDestinations[aIndex].theWeight)) {
+    // the destination is admitted to the active set
+    // if it was under probing then its stale period duration is reset to the
+    // initial minimum value
+    if (myNode.theProbing) {
+      myNode.theProbing = false;
+      myNode.resetStalePeriod();
+    }
+    activate(aIndex);
+
+  } else if (myLastUpdated < 0) {
+    // the destination is either brand new or its stale timer has expired:
+    // we keep it in the active list waiting for its fate to be decided
+    // after it has been used
+    activate(aIndex);
+
+  } else {
+    // the destination has been recently used (myLastUpdated >= 0) but its
+    // weight is not good enough to make it to the active set: if the
+    // destination was under probing then we increase the stale period
+    // duration
+    if (myNode.theProbing) {
+      myNode.theProbing = false;
+      myNode.updateStalePeriod();
+    }
+
+    if ((theLastEval - myLastUpdated) >= myNode.theStalePeriod) {
+      // stale timer expired: mark the destination as probing
+      probe(aIndex);
     } else {
-      ++it;
+      deactivate(aIndex);
     }
   }
+}
+
+void EntryRoundRobin::activate(const size_t aIndex) {
+  theWaiting.erase(aIndex);
+  theExpiring.erase(aIndex);
+  if (theNodes[aIndex].theLastUpdated >= 0) {
+    theEvictable.set(aIndex, -theDestinations[aIndex].theWeight);
+  } else {
+    theEvictable.erase(aIndex);
+  }
+  flag(aIndex, true);
+}
 
-  // update the active set
-  updateActiveSet();
+void EntryRoundRobin::deactivate(const size_t aIndex) {
+  theEvictable.erase(aIndex);
+  theWaiting.set(aIndex, theDestinations[aIndex].theWeight);
+  theExpiring.set(aIndex, theNodes[aIndex].expiration());
+  flag(aIndex, false);
+}
 
-  debugPrintActiveSet();
+void EntryRoundRobin::probe(const size_t aIndex) {
+  auto& myNode          = theNodes[aIndex];
+  myNode.theLastUpdated = -1.0;
+  myNode.theProbing     = true;
+  activate(aIndex);
 }
 
-void EntryRoundRobin::updateStat() {
-  theStat.reset();
-  for (const auto& elem : theCache) {
-    if (elem.second.theRemoved) {
-      continue;
+void EntryRoundRobin::settle() {
+  // the destination with maximum weight is checked first: the one with
+  // minimum weight is always admissible, hence the active set never becomes
+  // empty
+  while (not theEvictable.empty()) {
+    const auto myIndex = theEvictable.top();
+    auto&      myNode  = theNodes[myIndex];
+    assert(myNode.theLastUpdated >= 0);
+    if (good(theDestinations[myIndex].theWeight)) {
+      return;
+    }
+    // same as in evaluate(): a destination under probing that is not good
+    // enough has its stale period duration increased
+    if (myNode.theProbing) {
+      myNode.theProbing = false;
+      myNode.updateStalePeriod();
+    }
+    if ((theLastEval - myNode.theLastUpdated) >= myNode.theStalePeriod) {
+      // stale timer expired: keep it for probing
+      probe(myIndex);
+    } else {
+      deactivate(myIndex);
     }
-    theStat(elem.second.theWeight);
   }
-  assert(theStat.count() > 0);
 }
 
-void EntryRoundRobin::updateActiveSet() {
-  // compute the mean and standard deviation of the weights
-  updateStat();
-
-  std::priority_queue<QueueElement> myNewQueue;
-  const auto                        myNow        = theChrono.time();
-  const auto                        myMinDeficit = minDeficit();
-  for (auto it = theCache.begin(); it != theCache.end(); ++it) {
-    const auto myLastUpdated = it->second.theLastUpdated;
-    auto       myActive      = false;
-
-    if (good(it->second.theWeight)) {
-      // the destination is admitted to the active set
-      // if it was under probing then its stale period duration is reset to the
-      // initial minimum value
-      if (it->second.theProbing) {
-        it->second.theProbing = false;
-        it->second.resetStalePeriod();
-      }
-      myActive = true;
+void EntryRoundRobin::flag(const size_t aIndex, const bool aActive) {
+  if (theFlags[aIndex] != aActive) {
+    theFlags[aIndex] = aActive;
+    theFlagsChanged  = true;
+  }
+}
 
-    } else if (myLastUpdated < 0) {
-      // the destination is either brand new or its stale timer has expired:
-      // we keep it in the active list waiting for its fate to be decided
-      // after it has been used
-      myActive = true;
+void EntryRoundRobin::record(const size_t aIndex, const bool aAdded) {
+  theChange.theParent = theVersion;
+  theChange.theIndex  = aIndex;
+  theChange.theAdded  = aAdded;
+  theVersion          = nextEntryRoundRobinId();
+  theFlagsChanged     = true;
+}
 
-    } else {
-      // the destination has been recently used (myLastUpdated >= 0) but its
-      // weight is not good enough to make it to the active set: if the
-      // destination was under probing then we increase the stale period
-      // duration
-      if (it->second.theProbing) {
-        it->second.theProbing = false;
-        it->second.updateStalePeriod();
+EntryRoundRobin::Deficits& EntryRoundRobin::deficits() {
+  // indexed by the entry identifier, which is never reused
+  thread_local std::map<uint64_t, Deficits> myAllDeficits;
+
+  auto it = myAllDeficits.find(theId);
+  if (it == myAllDeficits.end()) {
+    // release the deficit counters of the entries destroyed
+    for (auto jt = myAllDeficits.begin(); jt != myAllDeficits.end();) {
+      if (jt->second.theOwner.expired()) {
+        jt = myAllDeficits.erase(jt);
+      } else {
+        ++jt;
       }
+    }
+    it                  = myAllDeficits.emplace(theId, Deficits()).first;
+    it->second.theOwner = theLifetime;
+  }
+  auto& myDeficits = it->second;
+  auto& myActive   = myDeficits.theActive;
+
+  if (myDeficits.theVersion != theVersion) {
+    // follow the change of the destinations, if it is the only one missed
+    const auto myFollow = myDeficits.theVersion != 0 and
+                          myDeficits.theVersion == theChange.theParent;
+    if (myFollow and theChange.theAdded) {
+      myDeficits.theDeficits.emplace_back(0);
+    } else if (myFollow) {
+      myDeficits.theDeficits.erase(myDeficits.theDeficits.begin() +
+                                   theChange.theIndex);
+      myActive.shift(theChange.theIndex);
+    } else {
+      myDeficits.theDeficits.assign(theDestinations.size(), 0);
+      myActive.clear();
+    }
+    myDeficits.theVersion    = theVersion;
+    myDeficits.theGeneration = 0;
+  }
+  assert(myDeficits.theDeficits.size() == theDestinations.size());
 
-      if ((myNow - myLastUpdated) >= it->second.theStalePeriod) {
-        // stale timer expired: mark the destination as probing
-        it->second.theLastUpdated = -1.0;
-        it->second.theDeficit     = myMinDeficit;
-        it->second.theProbing     = true;
-        myActive                  = true;
-      }
+  const auto myGeneration = theGeneration.load(std::memory_order_acquire);
+  if (myDeficits.theGeneration == myGeneration) {
+    return myDeficits;
+  }
+
+  // synchronize the active set with the flags: the destinations entering
+  // start from the minimum deficit counter
+  const auto myMinDeficit =
+      myActive.empty() ? 0.0 : myActive.key(myActive.top());
+  for (size_t i = 0; i < theFlags.size(); i++) {
+    if (not theFlags[i]) {
+      myActive.erase(i);
+    } else if (not myActive.contains(i)) {
+      myDeficits.theDeficits[i] = myMinDeficit;
+      myActive.push(i, myMinDeficit);
     }
+  }
+  myDeficits.theGeneration = myGeneration;
 
-    if (myActive) {
-      // add the element to the active set
-      myNewQueue.push(QueueElement{it});
+  return myDeficits;
+}
+
+void EntryRoundRobin::normalize(Deficits& aDeficits) {
+  auto& myActive = aDeficits.theActive;
+  if (myActive.empty()) {
+    return;
+  }
+  const auto myMinDeficit = myActive.key(myActive.top());
+  if (myMinDeficit < maximumDeficit()) {
+    return;
+  }
+  for (auto& myDeficit : aDeficits.theDeficits) {
+    myDeficit -= myMinDeficit;
+  }
+  for (size_t i = 0; i < aDeficits.theDeficits.size(); i++) {
+    if (myActive.contains(i)) {
+      myActive.update(i, aDeficits.theDeficits[i]);
     }
   }
-  theQueue.swap(myNewQueue);
 }
 
 void EntryRoundRobin::debugPrintActiveSet() {
   if (VLOG_IS_ON(2)) {
     std::stringstream myStream;
     const auto        myNow = theChrono.time();
-    for (auto it = theCache.begin(); it != theCache.end(); ++it) {
+    for (size_t i = 0; i < theNodes.size(); i++) {
+      const auto& myNode = theNodes[i];
       myStream << '\n'
-               << it->first << " weight " << it->second.theWeight
-               << " last-updated " << it->second.theLastUpdated << " deficit "
-               << it->second.theDeficit << " stale-period "
-               << it->second.theStalePeriod << " ("
-               << (it->second.theLastUpdated >= 0 ?
-                       (it->second.theStalePeriod -
-                        (myNow - it->second.theLastUpdated)) :
+               << theDestinations[i].theDestination << " weight "
+               << theDestinations[i].theWeight << " last-updated "
+               << myNode.theLastUpdated << " stale-period "
+               << myNode.theStalePeriod << " ("
+               << (myNode.theLastUpdated >= 0 ?
+                       (myNode.theStalePeriod -
+                        (myNow - myNode.theLastUpdated)) :
                        -1)
-               << " remaining)" << (it->second.theRemoved ? " R" : "")
-               << (it->second.theProbing ? " P" : "");
-    }
-    LOG(INFO) << "destinations " << theCache.size() << ", active set ("
-              << theQueue.size() << "), current "
-              << theQueue.top().theElem->first << myStream.str();
-    auto myDup = theQueue;
-    while (not myDup.empty()) {
-      const auto myElem = myDup.top();
-      myDup.pop();
-      LOG(INFO) << myElem.theElem->first << ' '
-                << myElem.theElem->second.theDeficit;
+               << " remaining)" << (myNode.theProbing ? " P" : "")
+               << (theFlags[i] ? " A" : "");
     }
+    LOG(INFO) << "destinations " << theNodes.size() << ", active set "
+              << theWeights.size() - theWaiting.size() << myStream.str();
   }
 }
 
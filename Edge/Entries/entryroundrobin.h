@@ -33,13 +33,17 @@ SOFTWARE.
 
 #include "entry.h"
 
+#include "Edge/Detail/indexedheap.h"
+#include "Edge/Detail/relaxedatomic.h"
 #include "Support/chrono.h"
-#include "Support/stat.h"
 
-#include <list>
-#include <map>
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -58,19 +62,37 @@ namespace entries {
  * The stale period id doubled every time a destination is moved away from the
  * active set and it is reset to the initial value if its weight eventually
  * matches the active set admission condition.
+ *
+ * The active set is maintained incrementally when the weights change: a
+ * destination is re-evaluated when its weight changes, when the minimum weight
+ * grows enough to admit it, or when its stale period expires, and the
+ * destinations that do not satisfy the admission condition anymore because
+ * the minimum weight has decreased are found by means of a heap of the active
+ * destinations by weight. All these operations take O(log n) and, once the
+ * destinations have been added, do not allocate memory.
+ *
+ * The active set is published to the lookups as a flag per destination, which
+ * is read without locking, with a generation number changed whenever any flag
+ * changes. Instead, the deficit counters are owned by the thread doing the
+ * lookup, which keeps them in a heap that is synchronized with the flags, in
+ * O(n), only when the generation changes: the weighted round robin is then
+ * achieved among the lookups done by each thread. A destination entering the
+ * active set starts from the minimum deficit counter in the active set. The
+ * deficit counters only grow, hence they are all decreased by the minimum one
+ * when the latter becomes too large, which is rare enough to be done in O(n).
+ * The deficit counters survive the copies made with clone() and adding or
+ * removing a single destination from the copy, but they are reset if a thread
+ * misses more than one such change.
  */
 class EntryRoundRobin final : public Entry
 {
-  struct CacheElement final {
+  struct Node final {
     /**
-     * Create a cache element with given weight and deficit, marked as "never
-     * used before" and with an initial stale period duration equal to 1 s.
+     * Create a node marked as "never used before" and with an initial stale
+     * period duration equal to 1 s.
      */
-    CacheElement(const float aWeight, const float aDeficit)
-        : theWeight(aWeight)
-        , theLastUpdated(-1.0)
-        , theRemoved(false)
-        , theDeficit(aDeficit)
+    explicit Node()
+        : theLastUpdated(-1.0)
         , theStalePeriod(initialStalePeriod())
         , theProbing(false) {
     }
@@ -84,59 +106,141 @@ class EntryRoundRobin final : public Entry
           std::min(maximumStalePeriod(), backoffCoefficient() * theStalePeriod);
     }
 
-    float  theWeight;
+    //! \return the time when the stale period expires.
+    double expiration() const noexcept {
+      return theLastUpdated + theStalePeriod;
+    }
+
     double theLastUpdated; // in seconds, negative means never
-    bool   theRemoved;
-    float  theDeficit;
     double theStalePeriod; // in seconds
     bool   theProbing;
   };
-  using Cache = std::map<std::string, CacheElement>;
 
-  struct QueueElement final {
-    Cache::iterator theElem;
+  //! Per-thread deficit counters of the destinations.
+  struct Deficits final {
+    std::weak_ptr<const void>   theOwner; // expires with the entries
+    uint64_t                    theVersion    = 0;
+    uint64_t                    theGeneration = 0;
+    std::vector<double>         theDeficits;
+    detail::IndexedHeap<double> theActive;
+  };
 
-    bool operator<(const QueueElement& aOther) const noexcept {
-      return theElem->second.theDeficit > aOther.theElem->second.theDeficit;
-    }
+  //! Last change of the destinations, see Deficits.
+  struct Change final {
+    uint64_t theParent = 0; // version before the change, 0 if unknown
+    size_t   theIndex  = 0; // position of the destination added or removed
+    bool     theAdded  = false;
   };
 
  public:
   explicit EntryRoundRobin();
 
+  std::unique_ptr<Entry> clone() const override;
+
  private:
+  //! Copy ctor: the copy shares the deficit counters of aOther.
+  explicit EntryRoundRobin(const EntryRoundRobin& aOther);
+
   std::string operator()() override;
 
-  void updateWeight(const std::string& aDest,
-                    const float        aOldWeight,
-                    const float        aNewWeight) override;
-  void updateAddDest(const std::string& aDest, const float aWeight) override;
-  void updateDelDest(const std::string& aDest, const float aWeight) override;
+  void updateWeight(const size_t aIndex, const float aOldWeight) override;
+  void updateAddDest(const size_t aIndex) override;
+  void updateDelDest(const size_t aIndex, const float aWeight) override;
+
+  /**
+   * Update the active set after a change.
+   *
+   * \param aChanged the position of the destination changed, if any.
+   */
+  void updateActiveSet(const size_t aChanged);
+
+  //! Add or remove a destination from the active set based on its state.
+  void evaluate(const size_t aIndex);
+
+  //! Move a destination into the active set.
+  void activate(const size_t aIndex);
+
+  //! Move a destination out of the active set.
+  void deactivate(const size_t aIndex);
+
+  //! Move into the active set a destination whose stale period has expired.
+  void probe(const size_t aIndex);
+
+  //! Remove from the active set non-admissible destinations.
+  void settle();
 
-  void  updateWeight(const std::string& aDest, const float aWeight);
-  void  updateList();
-  void  updateStat();
-  void  updateActiveSet();
-  float minDeficit();
+  //! Change the active flag of a destination.
+  void flag(const size_t aIndex, const bool aActive);
+
+  //! Record the addition or removal of a destination.
+  void record(const size_t aIndex, const bool aAdded);
+
+  /**
+   * \return the deficit counters of the calling thread, synchronized with
+   * the current active set.
+   */
+  Deficits& deficits();
+
+  //! Subtract the minimum from all the deficit counters, if too large.
+  static void normalize(Deficits& aDeficits);
 
   //! \return true if a weight is good enough.
-  bool good(const double aWeight);
+  bool good(const float aWeight) const;
 
   void debugPrintActiveSet();
 
  private:
+  // per-destination state, in the same order as theDestinations, whose
+  // positions are also the identifiers in the heaps below
+  std::vector<Node> theNodes;
+
   // the active set consists of all the elements with similar weight
-  // and all the elements that have not been used for too long
-  Cache                             theCache;
-  std::priority_queue<QueueElement> theQueue;
-  support::Chrono                   theChrono;
-  support::SummaryStat              theStat;
+  // and all the elements that have not been used for too long, with the
+  // same positions as theNodes; these are the only per-destination values
+  // read by the lookups
+  std::vector<detail::RelaxedAtomic<bool>> theFlags;
+
+  // all the destinations, by weight
+  detail::IndexedHeap<float> theWeights;
+
+  // destinations in the active set that have been used, by opposite weight
+  detail::IndexedHeap<float> theEvictable;
+
+  // destinations out of the active set, by weight
+  detail::IndexedHeap<float> theWaiting;
+
+  // destinations out of the active set, by stale period expiration time
+  detail::IndexedHeap<double> theExpiring;
+
+  // time of the last update of the active set
+  double theLastEval;
+
+  support::Chrono theChrono;
+
+  // identifies the per-thread deficit counters, shared with the copies
+  const uint64_t                    theId;
+  const std::shared_ptr<const void> theLifetime; // see Deficits
+
+  // identifies the current destinations: changes whenever one is added or
+  // removed, which is never concurrent with lookups
+  uint64_t theVersion;
+  Change   theChange;
+
+  // changes whenever any of theFlags changes
+  std::atomic<uint64_t> theGeneration;
+  bool                  theFlagsChanged;
+
+  //! Position of no destination.
+  static constexpr size_t noIndex() {
+    return std::numeric_limits<size_t>::max();
+  }
 
   // static configuration
   // clang-format off
   static constexpr double initialStalePeriod() { return 1.0 ; } 
   static constexpr double backoffCoefficient() { return 2.0 ; }
   static constexpr double maximumStalePeriod() { return 30.0; }
+  static constexpr double maximumDeficit()     { return 1e12; }
   // clang-format on
 };
 
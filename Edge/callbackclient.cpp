@@ -35,20 +35,64 @@ SOFTWARE.
 
 #include <grpc++/grpc++.h>
 
+#include <chrono>
+
 namespace uiiit {
 namespace edge {
 
+namespace {
+
+//! Set the deadline of a call, if aTimeout is positive.
+void setDeadline(grpc::ClientContext& aContext, const unsigned int aTimeout) {
+  if (aTimeout > 0) {
+    aContext.set_deadline(std::chrono::system_clock::now() +
+                          std::chrono::milliseconds(aTimeout));
+  }
+}
+
+} // namespace
+
 CallbackClient::CallbackClient(const std::string& aServerEndpoint)
     : SimpleClient(aServerEndpoint) {
   // nihil
 }
 
-void CallbackClient::ReceiveResponse(const LambdaResponse& aResponse) {
+void CallbackClient::ReceiveResponse(const LambdaResponse& aResponse,
+                                     const unsigned int    aTimeout) {
   rpc::Void           myVoid;
   grpc::ClientContext myContext;
-  auto                myResponse = aResponse.toProtobuf();
+  setDeadline(myContext, aTimeout);
+  auto myResponse = aResponse.toProtobuf();
   rpc::checkStatus(theStub->ReceiveResponse(&myContext, myResponse, &myVoid));
 }
 
+void CallbackClient::ReceiveResponses(
+    const std::vector<LambdaResponse>& aResponses,
+    const size_t                       aBatchSize,
+    const unsigned int                 aTimeout) {
+  rpc::Void           myVoid;
+  grpc::ClientContext myContext;
+  setDeadline(myContext, aTimeout);
+
+  const auto myWriter = theStub->ReceiveResponses(&myContext, &myVoid);
+
+  rpc::LambdaResponses myBatch;
+  for (const auto& myResponse : aResponses) {
+    *myBatch.add_responses() = myResponse.toProtobuf();
+    if (aBatchSize > 0 and
+        static_cast<size_t>(myBatch.responses_size()) == aBatchSize) {
+      if (not myWriter->Write(myBatch)) {
+        break; // the error is returned by Finish()
+      }
+      myBatch.Clear();
+    }
+  }
+  if (myBatch.responses_size() > 0) {
+    myWriter->Write(myBatch);
+  }
+  myWriter->WritesDone();
+  rpc::checkStatus(myWriter->Finish());
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -35,6 +35,7 @@ SOFTWARE.
 #include "RpcSupport/simpleclient.h"
 
 #include <string>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -47,7 +48,30 @@ class CallbackClient final : public rpc::SimpleClient<rpc::CallbackServer>
    */
   explicit CallbackClient(const std::string& aServerEndpoint);
 
-  void ReceiveResponse(const LambdaResponse& aResponse);
+  /**
+   * Send a response.
+   *
+   * \param aResponse the response to be sent.
+   *
+   * \param aTimeout the deadline of the call, in ms; 0 means no deadline.
+   */
+  void ReceiveResponse(const LambdaResponse& aResponse,
+                       const unsigned int    aTimeout = 0);
+
+  /**
+   * Send multiple responses in a single streaming call.
+   *
+   * \param aResponses the responses to be sent, in order.
+   *
+   * \param aBatchSize the maximum number of responses per message sent on
+   * the stream; 0 means that all the responses are sent in one message.
+   *
+   * \param aTimeout the deadline of the whole call, in ms; 0 means no
+   * deadline.
+   */
+  void ReceiveResponses(const std::vector<LambdaResponse>& aResponses,
+                        const size_t                       aBatchSize = 0,
+                        const unsigned int                 aTimeout   = 0);
 };
 
 } // end namespace edge
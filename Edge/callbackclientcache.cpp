@@ -0,0 +1,89 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/callbackclientcache.h"
+
+#include "Edge/callbackclient.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+
+CallbackClientCache::CallbackClientCache(const size_t aSize)
+    : theSize(aSize)
+    , theMutex()
+    , theEntries()
+    , theIndex() {
+  if (aSize == 0) {
+    throw std::runtime_error("Invalid zero size of the callback client cache");
+  }
+}
+
+CallbackClientCache::~CallbackClientCache() {
+  // noop
+}
+
+std::shared_ptr<CallbackClient>
+CallbackClientCache::operator()(const std::string& aEndpoint) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+
+  const auto it = theIndex.find(aEndpoint);
+  if (it != theIndex.end()) {
+    // move to the front of the list, without invalidating the iterator
+    theEntries.splice(theEntries.begin(), theEntries, it->second);
+    return theEntries.front().second;
+  }
+
+  if (theEntries.size() == theSize) {
+    VLOG(2) << "evicting callback client towards " << theEntries.back().first;
+    theIndex.erase(theEntries.back().first);
+    theEntries.pop_back();
+  }
+
+  VLOG(2) << "creating callback client towards " << aEndpoint;
+  theEntries.emplace_front(aEndpoint,
+                           std::make_shared<CallbackClient>(aEndpoint));
+  theIndex.emplace(aEndpoint, theEntries.begin());
+  assert(theEntries.size() == theIndex.size());
+  return theEntries.front().second;
+}
+
+size_t CallbackClientCache::size() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theEntries.size();
+}
+
+} // namespace edge
+} // namespace uiiit
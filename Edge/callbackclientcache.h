@@ -0,0 +1,86 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace uiiit {
+namespace edge {
+
+class CallbackClient;
+
+/**
+ * A thread-safe cache of callback clients, each with its own channel, indexed
+ * by the end-point of the callback server.
+ *
+ * When the maximum size is reached, the least recently used client is
+ * evicted: the clients returned are shared pointers, hence an evicted client
+ * remains valid until all its users release it.
+ */
+class CallbackClientCache final
+{
+ public:
+  /**
+   * \param aSize the maximum number of clients kept.
+   *
+   * \throw std::runtime_error if aSize is zero.
+   */
+  explicit CallbackClientCache(const size_t aSize);
+
+  ~CallbackClientCache();
+
+  //! \return the client towards the given end-point, created if needed.
+  std::shared_ptr<CallbackClient> operator()(const std::string& aEndpoint);
+
+  //! \return the number of clients currently in the cache.
+  size_t size() const;
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<CallbackClient>>;
+
+  const size_t theSize;
+
+  mutable std::mutex theMutex;
+  // most recently used first
+  std::list<Entry> theEntries;
+  // key: end-point, value: position in theEntries
+  std::unordered_map<std::string, std::list<Entry>::iterator> theIndex;
+};
+
+} // end namespace edge
+} // end namespace uiiit
@@ -0,0 +1,180 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/callbacksender.h"
+
+#include "Edge/callbackclient.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+
+CallbackSender::CallbackSender(const size_t       aCacheSize,
+                               const size_t       aMaxBatch,
+                               const unsigned int aTimeout,
+                               const size_t       aMaxPending,
+                               const size_t       aNumThreads)
+    : theMaxBatch(aMaxBatch)
+    , theTimeout(aTimeout)
+    , theMaxPending(aMaxPending)
+    , theClients(aCacheSize)
+    , theMutex()
+    , theCondition()
+    , theEndpoints()
+    , theReady()
+    , thePending(0)
+    , theDropped(0)
+    , theTerminating(false)
+    , theThreads() {
+  if (batching()) {
+    if (aNumThreads == 0) {
+      throw std::runtime_error(
+          "at least one thread is needed to send batches of responses");
+    }
+    for (size_t i = 0; i < aNumThreads; i++) {
+      theThreads.emplace_back([this]() { loop(); });
+    }
+  }
+}
+
+CallbackSender::~CallbackSender() {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theTerminating = true;
+  }
+  theCondition.notify_all();
+  for (auto& myThread : theThreads) {
+    myThread.join();
+  }
+}
+
+void CallbackSender::operator()(const std::string&    aEndpoint,
+                                const LambdaResponse& aResp) {
+  if (not batching()) {
+    theClients(aEndpoint)->ReceiveResponse(aResp, theTimeout);
+    return;
+  }
+
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    if (theMaxPending > 0 and thePending >= theMaxPending) {
+      theDropped++;
+      LOG_EVERY_N(WARNING, 1000)
+          << "callback queue full (" << theMaxPending
+          << " responses), dropping the response to " << aEndpoint
+          << ", dropped so far: " << theDropped;
+      return;
+    }
+    auto& myEndpoint = theEndpoints[aEndpoint];
+    if (myEndpoint.theResponses.empty() and not myEndpoint.theBusy) {
+      theReady.emplace_back(aEndpoint);
+    }
+    myEndpoint.theResponses.emplace_back(aResp);
+    thePending++;
+  }
+  theCondition.notify_one();
+}
+
+size_t CallbackSender::dropped() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theDropped;
+}
+
+void CallbackSender::loop() {
+  std::vector<LambdaResponse>  myResponses;
+  std::unique_lock<std::mutex> myLock(theMutex);
+  while (true) {
+    theCondition.wait(
+        myLock, [this]() { return theTerminating or not theReady.empty(); });
+    if (theReady.empty()) {
+      // the other threads may still be delivering, but no end-point can
+      // become ready without new responses
+      assert(theTerminating);
+      break;
+    }
+
+    // take all the responses towards the first end-point ready
+    const auto myName = std::move(theReady.front());
+    theReady.pop_front();
+    auto it = theEndpoints.find(myName);
+    assert(it != theEndpoints.end());
+    assert(not it->second.theBusy);
+    assert(not it->second.theResponses.empty());
+    for (auto& myResponse : it->second.theResponses) {
+      myResponses.emplace_back(std::move(myResponse));
+    }
+    it->second.theResponses.clear();
+    it->second.theBusy = true;
+    myLock.unlock();
+
+    deliver(myName, myResponses);
+
+    myLock.lock();
+    assert(thePending >= myResponses.size());
+    thePending -= myResponses.size();
+    myResponses.clear();
+
+    // the element cannot have been removed while busy
+    it = theEndpoints.find(myName);
+    assert(it != theEndpoints.end());
+    it->second.theBusy = false;
+    if (it->second.theResponses.empty()) {
+      theEndpoints.erase(it);
+    } else {
+      // queued at the back, for fairness towards the other end-points
+      theReady.emplace_back(myName);
+      theCondition.notify_one();
+    }
+  }
+}
+
+void CallbackSender::deliver(const std::string&                 aEndpoint,
+                             const std::vector<LambdaResponse>& aResponses) {
+  VLOG(3) << "sending " << aResponses.size() << " responses to " << aEndpoint;
+  try {
+    const auto myClient = theClients(aEndpoint);
+    if (aResponses.size() == 1) {
+      myClient->ReceiveResponse(aResponses.front(), theTimeout);
+    } else {
+      myClient->ReceiveResponses(aResponses, theMaxBatch, theTimeout);
+    }
+  } catch (const std::exception& aErr) {
+    LOG(ERROR) << "could not send " << aResponses.size() << " responses to "
+               << aEndpoint << ": " << aErr.what();
+  }
+}
+
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,149 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/callbackclientcache.h"
+#include "Edge/edgemessages.h"
+#include "Support/macros.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+
+/**
+ * Delivers the responses of asynchronous lambda invocations to their
+ * callback servers, through clients cached by end-point.
+ *
+ * If batching is enabled, the responses are queued per end-point and sent
+ * by a pool of background threads, each serving one end-point at a time:
+ * all the responses towards the same end-point that are queued while a
+ * thread is busy sending the previous ones are delivered in a single
+ * streaming call, which amortizes the cost of the call under high load
+ * without adding any delay under low load. A slow or unreachable end-point
+ * only holds the thread serving it, up to the deadline of the call.
+ *
+ * The number of responses queued is bounded: when the limit is reached the
+ * new responses are dropped, since the older ones are closer to be
+ * delivered, and the drop is logged.
+ */
+class CallbackSender final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(CallbackSender);
+
+  /**
+   * \param aCacheSize the maximum number of callback clients cached.
+   *
+   * \param aMaxBatch if greater than 1 then batching is enabled, with at most
+   * aMaxBatch responses per message; otherwise responses are sent
+   * immediately by the caller, one per call.
+   *
+   * \param aTimeout the deadline of every call, in ms; 0 means no deadline.
+   *
+   * \param aMaxPending with batching, the maximum number of responses queued;
+   * 0 means unlimited.
+   *
+   * \param aNumThreads with batching, the number of threads delivering the
+   * responses.
+   *
+   * \throw std::runtime_error if aCacheSize is zero or batching is enabled
+   * with no threads.
+   */
+  explicit CallbackSender(const size_t       aCacheSize,
+                          const size_t       aMaxBatch,
+                          const unsigned int aTimeout,
+                          const size_t       aMaxPending,
+                          const size_t       aNumThreads);
+
+  //! Deliver all the responses queued, if any, and stop the threads.
+  ~CallbackSender();
+
+  /**
+   * Send a response to the given callback end-point.
+   *
+   * \throw std::runtime_error if batching is disabled and the delivery
+   * fails; with batching, errors and drops are only logged.
+   */
+  void operator()(const std::string& aEndpoint, const LambdaResponse& aResp);
+
+  //! \return true if batching is enabled.
+  bool batching() const noexcept {
+    return theMaxBatch > 1;
+  }
+
+  //! \return the number of responses dropped because the queue was full.
+  size_t dropped() const;
+
+ private:
+  //! The responses queued towards an end-point.
+  struct Endpoint {
+    explicit Endpoint()
+        : theResponses()
+        , theBusy(false) {
+    }
+
+    std::deque<LambdaResponse> theResponses;
+    bool                       theBusy; // a thread is sending
+  };
+
+  //! Thread execution body.
+  void loop();
+
+  //! Send the given responses to an end-point.
+  void deliver(const std::string&                 aEndpoint,
+               const std::vector<LambdaResponse>& aResponses);
+
+ private:
+  const size_t        theMaxBatch;
+  const unsigned int  theTimeout;
+  const size_t        theMaxPending;
+  CallbackClientCache theClients;
+
+  mutable std::mutex                        theMutex;
+  std::condition_variable                   theCondition;
+  std::unordered_map<std::string, Endpoint> theEndpoints;
+  std::deque<std::string>                   theReady; // not busy, non-empty
+  size_t                                    thePending;
+  size_t                                    theDropped;
+  bool                                      theTerminating;
+  std::vector<std::thread>                  theThreads;
+};
+
+} // end namespace edge
+} // end namespace uiiit
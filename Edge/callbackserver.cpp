@@ -56,6 +56,22 @@ grpc::Status CallbackServer::CallbackServerImpl::ReceiveResponse(
   return grpc::Status::OK;
 }
 
+grpc::Status CallbackServer::CallbackServerImpl::ReceiveResponses(
+    [[maybe_unused]] grpc::ServerContext*     aContext,
+    grpc::ServerReader<rpc::LambdaResponses>* aReader,
+    [[maybe_unused]] rpc::Void*               aVoid) {
+  assert(aReader);
+
+  rpc::LambdaResponses myBatch;
+  while (aReader->Read(&myBatch)) {
+    for (const auto& myResponse : myBatch.responses()) {
+      theQueue.push(LambdaResponse(myResponse));
+    }
+  }
+
+  return grpc::Status::OK;
+}
+
 CallbackServer::CallbackServer(const std::string& aEndpoint, Queue& aQueue)
     : SimpleServer(aEndpoint)
     , theServerImpl(aQueue) {
@@ -57,6 +57,11 @@ class CallbackServer final : public rpc::SimpleServer
                                  const rpc::LambdaResponse* aResponse,
                                  rpc::Void*                 aVoid) override;
 
+    grpc::Status
+    ReceiveResponses(grpc::ServerContext*                      aContext,
+                     grpc::ServerReader<rpc::LambdaResponses>* aReader,
+                     rpc::Void*                                aVoid) override;
+
     Queue& theQueue;
   };
 
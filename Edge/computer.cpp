@@ -39,6 +39,7 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -59,11 +60,15 @@ Computer::Computer(const std::string&  aName,
     , theNewTask(false)
     , theNextId(0)
     , theChrono(false)
+    , theNow(0)
     , theDispatcher()
     , theUtilCollector()
     , theProcessors()
     , theContainerNames()
-    , theContainers() {
+    , theContainers()
+    , theSlots()
+    , theClocks()
+    , theCompletions() {
   if (not aCallback) {
     throw std::runtime_error("Call of computer " + aName + " not callable");
   }
@@ -96,8 +101,9 @@ void Computer::addProcessor(const std::string&  aName,
   }
 
   // everything is fine: add this processor
-  theProcessors[aName] =
-      std::make_unique<Processor>(aName, aType, aSpeed, aCores, aMem);
+  auto& myProcessor = theProcessors[aName];
+  myProcessor = std::make_unique<Processor>(aName, aType, aSpeed, aCores, aMem);
+  theClocks.emplace_back(*myProcessor);
 }
 
 void Computer::addContainer(const std::string& aName,
@@ -118,9 +124,21 @@ void Computer::addContainer(const std::string& aName,
   }
 
   // everything is fine: add this container
+  const auto myClock = static_cast<size_t>(
+      std::find_if(theClocks.begin(),
+                   theClocks.end(),
+                   [&myIt](const Clock& aClock) {
+                     return aClock.theProcessor == myIt->second.get();
+                   }) -
+      theClocks.begin());
+  assert(myClock < theClocks.size());
   theContainerNames.insert(aName);
-  theContainers[aLambda.name()] =
-      std::make_unique<Container>(aName, *myIt->second, aLambda, aNumWorkers);
+  theContainers[aLambda.name()] = theSlots.size();
+  theClocks[myClock].theSlots.emplace_back(theSlots.size());
+  theSlots.emplace_back(
+      std::make_unique<Container>(aName, *myIt->second, aLambda, aNumWorkers),
+      myClock,
+      theClocks[myClock].theSlots.size() - 1);
 }
 
 uint64_t Computer::addTask(const LambdaRequest& aRequest) {
@@ -154,9 +172,13 @@ uint64_t Computer::addTask(const LambdaRequest& aRequest) {
   // pause execution of the computer
   pause();
 
-  // add the new task to the container
-  assert(myIt->second);
-  myIt->second->push(aRequest, myId);
+  // add the new task to the container, which changes the speed of all the
+  // tasks on the same processor: the containers of the other processors are
+  // not affected, and the targets of those on the same processor do not
+  // change, hence this is the only container that must be advanced
+  syncContainer(myIt->second);
+  theSlots[myIt->second].theContainer->push(aRequest, myId);
+  reschedule(myIt->second);
   theNewTask = true;
   theCondition.notify_one();
 
@@ -178,18 +200,27 @@ double Computer::simTask(const LambdaRequest&   aRequest,
   LOG_IF(WARNING, not theInitDone)
       << "requested simulation of a task on a computer not yet started";
 
-  aLastUtils = myIt->second->lastUtils();
+  auto& myContainer = *theSlots[myIt->second].theContainer;
+  aLastUtils        = myContainer.lastUtils();
 
-  return myIt->second->simulate(aRequest);
+  // bring the container up to date, this does not change its next completion
+  if (theInitDone) {
+    pause();
+    syncContainer(myIt->second);
+    resume();
+  }
+
+  return myContainer.simulate(aRequest);
 }
 
 std::shared_ptr<ContainerList> Computer::containerList() const {
   std::shared_ptr<ContainerList> myRet(new ContainerList());
-  for (const auto& myContainer : theContainers) {
+  for (const auto& myPair : theContainers) {
+    auto& myContainer = *theSlots[myPair.second].theContainer;
     myRet->theContainers.push_back(
-        ContainerList::Container{myContainer.second->name(),
-                                 myContainer.second->processor().name(),
-                                 myContainer.second->lambda().name()});
+        ContainerList::Container{myContainer.name(),
+                                 myContainer.processor().name(),
+                                 myContainer.lambda().name()});
   }
   return myRet;
 }
@@ -204,9 +235,9 @@ void Computer::printProcessors(std::ostream& aStream) const {
 
 void Computer::printContainers(std::ostream& aStream) const {
   const std::lock_guard<std::mutex> myLock(theMutex);
-  for (const auto& myContainer : theContainers) {
-    assert(myContainer.second);
-    aStream << "container " << *myContainer.second << '\n';
+  for (const auto& myPair : theContainers) {
+    assert(theSlots[myPair.second].theContainer);
+    aStream << "container " << *theSlots[myPair.second].theContainer << '\n';
   }
 }
 
@@ -219,13 +250,7 @@ void Computer::throwIfInitDone() const {
 void Computer::pause() {
   if (theChrono) {
     // this is the time since the last pause, in s
-    const auto myElapsed = theChrono.stop();
-
-    // adjust the virtual clock on all processors:
-    for (const auto& myPair : theContainers) {
-      assert(myPair.second);
-      myPair.second->advance(myElapsed);
-    }
+    theNow += theChrono.stop();
   }
 }
 
@@ -240,20 +265,18 @@ void Computer::dispatcher() {
   while (true) {
     std::unique_lock<std::mutex> myLock(theMutex);
     int64_t                      mySleepTime = 1000000000; // in ns
-    for (const auto& myPair : theContainers) {
-      assert(myPair.second);
-      auto& myContainer = *myPair.second;
-      if (myContainer.active() == 0) {
-        continue;
-      }
-      mySleepTime =
-          std::min(mySleepTime,
-                   static_cast<int64_t>(round(myContainer.nearest() * 1e9)));
+    if (not theCompletions.empty()) {
+      // the virtual clock has not been advanced since the last resume()
+      const auto myNext = theCompletions.key(theCompletions.top()) - theNow -
+                          (theChrono ? theChrono.time() : 0.0);
+      mySleepTime       = std::min(
+          mySleepTime,
+          std::max<int64_t>(0, static_cast<int64_t>(round(myNext * 1e9))));
     }
 
     theCondition.wait_for(
         myLock, std::chrono::nanoseconds(mySleepTime), [this]() {
-          return theNewTask or someReady() or theTerminating;
+          return theNewTask or theTerminating;
         });
 
     if (theTerminating) {
@@ -289,35 +312,101 @@ void Computer::utilCollector() {
 
 bool Computer::someActive() const {
   assert(theInitDone);
-  for (const auto& myPair : theContainers) {
-    assert(myPair.second);
-    if (myPair.second->active() > 0) {
-      return true;
+  return not theCompletions.empty();
+}
+
+void Computer::dispatchCompletedTasks() {
+  while (not theCompletions.empty() and
+         theCompletions.key(theCompletions.top()) <= theNow) {
+    const auto myClockId = theCompletions.top();
+    auto&      myClock   = theClocks[myClockId];
+    syncProcessor(myClockId);
+
+    while (not myClock.theTargets.empty() and
+           myClock.theTargets.key(myClock.theTargets.top()) <=
+               myClock.theWork) {
+      const auto mySlotId = myClock.theSlots[myClock.theTargets.top()];
+      syncContainer(mySlotId);
+      auto& myContainer = *theSlots[mySlotId].theContainer;
+      while (myContainer.active() > 0 and myContainer.residual() == 0) {
+        auto myCompletedTask = myContainer.pop();
+        theCallback(myCompletedTask.theId, myCompletedTask.theResp);
+      }
+      reschedule(mySlotId);
     }
+
+    // needed also if no task was completed because of rounding errors, which
+    // moves the next completion after the current virtual time
+    rescheduleProcessor(myClockId);
   }
-  return false;
 }
 
-bool Computer::someReady() const {
-  assert(theInitDone);
-  for (const auto& myPair : theContainers) {
-    assert(myPair.second);
-    if (myPair.second->active() > 0 and myPair.second->nearest() == 0) {
-      return true;
-    }
+void Computer::syncProcessor(const size_t aClock) {
+  assert(aClock < theClocks.size());
+  auto& myClock = theClocks[aClock];
+  if (not myClock.theProcessor->idle()) {
+    myClock.theWork +=
+        myClock.theProcessor->timeToOps(theNow - myClock.theLast);
   }
-  return false;
+  myClock.theLast = theNow;
 }
 
-void Computer::dispatchCompletedTasks() {
-  for (const auto& myPair : theContainers) {
-    assert(myPair.second);
-    auto& myContainer = *myPair.second;
-    while (myContainer.active() > 0 and myContainer.nearest() == 0) {
-      auto myCompletedTask = myContainer.pop();
-      theCallback(myCompletedTask.theId, myCompletedTask.theResp);
-    }
+void Computer::syncContainer(const size_t aSlot) {
+  assert(aSlot < theSlots.size());
+  auto& mySlot = theSlots[aSlot];
+  syncProcessor(mySlot.theClock);
+  const auto myWork = theClocks[mySlot.theClock].theWork;
+  assert(myWork >= mySlot.theSynced);
+  mySlot.theContainer->advanceOps(myWork - mySlot.theSynced);
+  mySlot.theSynced = myWork;
+}
+
+void Computer::reschedule(const size_t aSlot) {
+  assert(aSlot < theSlots.size());
+  const auto& mySlot  = theSlots[aSlot];
+  auto&       myClock = theClocks[mySlot.theClock];
+  assert(mySlot.theSynced == myClock.theWork);
+  if (mySlot.theContainer->active() > 0) {
+    myClock.theTargets.set(mySlot.theLocal,
+                           myClock.theWork + mySlot.theContainer->residual());
+  } else {
+    myClock.theTargets.erase(mySlot.theLocal);
   }
+  rescheduleProcessor(mySlot.theClock);
+}
+
+void Computer::rescheduleProcessor(const size_t aClock) {
+  assert(aClock < theClocks.size());
+  const auto& myClock = theClocks[aClock];
+  if (myClock.theTargets.empty()) {
+    theCompletions.erase(aClock);
+    return;
+  }
+  assert(myClock.theLast == theNow);
+  const auto myTarget = myClock.theTargets.key(myClock.theTargets.top());
+  const auto myLeft =
+      myTarget > myClock.theWork ? myTarget - myClock.theWork : 0;
+  theCompletions.set(aClock,
+                     theNow + myClock.theProcessor->opsToTime(myLeft));
+}
+
+Computer::Slot::Slot(std::unique_ptr<Container>&& aContainer,
+                     const size_t                 aClock,
+                     const size_t                 aLocal)
+    : theContainer(std::move(aContainer))
+    , theClock(aClock)
+    , theLocal(aLocal)
+    , theSynced(0) {
+  // noop
+}
+
+Computer::Clock::Clock(Processor& aProcessor)
+    : theProcessor(&aProcessor)
+    , theWork(0)
+    , theLast(0)
+    , theSlots()
+    , theTargets() {
+  // noop
 }
 
 } // namespace edge
@@ -31,6 +31,7 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/indexedheap.h"
 #include "Support/chrono.h"
 #include "Support/macros.h"
 
@@ -44,6 +45,7 @@ SOFTWARE.
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -189,7 +191,8 @@ class Computer final
    * task for execution. When the task execution is complete, the callback
    * specified in the ctor will be called.
    *
-   * \param aRequest The lambda request to be executed.
+   * \param aRequest The lambda request to be executed, which is not retained
+   * after the call returns; however, the response may share its payloads.
    *
    * \return The identifier of the request, that will allow the recipient of the
    * callback to identify which task has been actually completed.
@@ -231,16 +234,58 @@ class Computer final
 
   //! \throw InitDone if addTask() has been already called.
   void throwIfInitDone() const;
-  //! Advance clocks of all containers and stop the system timer.
+  //! Advance the virtual clock and stop the system timer.
   void pause();
   //! Restart the system timer if there are active tasks.
   void resume();
   //! \return true if there is at least one task active.
   bool someActive() const;
-  //! \return true if there is at least one task completed.
-  bool someReady() const;
   //! Dispatch all tasks whose execution is finished.
   void dispatchCompletedTasks();
+  //! Add the work done on a processor since its last update.
+  void syncProcessor(const size_t aClock);
+  //! Apply to a container the work done since its last update.
+  void syncContainer(const size_t aSlot);
+  //! Update the next completion of a container, after syncContainer().
+  void reschedule(const size_t aSlot);
+  //! Update the next completion of a processor, after syncProcessor().
+  void rescheduleProcessor(const size_t aClock);
+
+  //! A container, advanced only when a task is added or completed.
+  struct Slot {
+    explicit Slot(std::unique_ptr<Container>&& aContainer,
+                  const size_t                 aClock,
+                  const size_t                 aLocal);
+
+    std::unique_ptr<Container> theContainer;
+    // index of the processor in theClocks
+    size_t theClock;
+    // index of the container in the processor's theSlots
+    size_t theLocal;
+    // work of the processor when the container was last advanced
+    uint64_t theSynced;
+  };
+
+  /**
+   * The work done by a processor, i.e., the number of operations executed by
+   * every task running on it, which all share the processor evenly. The work
+   * at which a container will complete its next task does not change when
+   * other tasks start or finish on the same processor, only the time does.
+   */
+  struct Clock {
+    explicit Clock(Processor& aProcessor);
+
+    Processor* theProcessor;
+    // operations executed by every running task so far
+    uint64_t theWork;
+    // virtual time of the last update of theWork, in s
+    double theLast;
+    // indices of the containers hosted in theSlots
+    std::vector<size_t> theSlots;
+    // containers with active tasks (index in theSlots above) by work at which
+    // their nearest-to-completion task will be finished
+    detail::IndexedHeap<uint64_t> theTargets;
+  };
 
  private:
   const std::string  theName;
@@ -255,12 +300,19 @@ class Computer final
   bool                    theNewTask;
   uint64_t                theNextId;
   support::Chrono         theChrono;
+  double                  theNow; // virtual clock, stopped when idle, in s
   std::thread             theDispatcher;
   std::thread             theUtilCollector;
 
   std::map<std::string, std::unique_ptr<Processor>> theProcessors;
   std::set<std::string>                             theContainerNames;
-  std::map<std::string, std::unique_ptr<Container>> theContainers;
+  // index in theSlots of the container of every lambda
+  std::map<std::string, size_t> theContainers;
+  std::vector<Slot>             theSlots;
+  std::vector<Clock>            theClocks;
+  // processors with active tasks (index in theClocks) by the virtual time
+  // of their next task completion
+  detail::IndexedHeap<double> theCompletions;
 };
 
 } // namespace edge
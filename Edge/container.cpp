@@ -37,7 +37,6 @@ SOFTWARE.
 #include <glog/logging.h>
 
 #include <cassert>
-#include <numeric>
 
 namespace uiiit {
 namespace edge {
@@ -60,7 +59,8 @@ Container::Container(const std::string& aName,
     , theLambda(aLambda)
     , theNumWorkers(aNumWorkers)
     , theActive()
-    , thePending() {
+    , thePending()
+    , thePendingOps(0) {
   if (aNumWorkers == 0) {
     throw std::runtime_error("Zero workers used for container " + aName);
   }
@@ -75,7 +75,8 @@ void Container::push(const LambdaRequest& aReq, uint64_t aId) {
   // the current task becomes pending
   if (theActive.size() == theNumWorkers or
       theProcessor.memAvailable() < myRequirements.theMemory) {
-    thePending.emplace_back(std::move(myTask));
+    thePendingOps += myTask.theResidualOps;
+    thePending.push_back(std::move(myTask));
 
   } else {
     // the task becomes active
@@ -96,14 +97,7 @@ double Container::simulate(const LambdaRequest& aReq) const {
   const auto myOneMoreTask = theActive.size() < theNumWorkers;
 
   // simulate the dispatch of all the pending tasks
-  auto myElapsed = // return value, in seconds
-      std::accumulate(thePending.cbegin(),
-                      thePending.cend(),
-                      0.0,
-                      [this](const double sum, const Task& aTask) {
-                        return sum +
-                               theProcessor.opsToTime(aTask.theResidualOps);
-                      });
+  auto myElapsed = theProcessor.opsToTime(thePendingOps); // in seconds
 
   // if all the workers are busy, then dispatch the one that will finish first
   if (theActive.size() == theNumWorkers) {
@@ -127,7 +121,7 @@ Task Container::pop() {
   throwIfEmpty();
 
   // remove the nearest-to-completion task from the active list
-  auto myRet = theActive.front();
+  auto myRet = std::move(theActive.front());
   theActive.pop_front();
 
   // free the memory of the nearest-to-completion task
@@ -136,17 +130,18 @@ Task Container::pop() {
   // add as many pending tasks as possible provided that
   // 1. there are workers available in the container
   // 2. there is sufficient memory available on the processor
-  for (auto myIt = thePending.begin(); myIt != thePending.end();) {
+  while (not thePending.empty()) {
     if (theActive.size() == theNumWorkers or
-        theProcessor.memAvailable() < myIt->theMemory) {
+        theProcessor.memAvailable() < thePending.front().theMemory) {
       break;
     }
 
-    auto myTask = *myIt;
+    auto myTask = std::move(thePending.front());
+    thePending.pop_front();
+    assert(thePendingOps >= myTask.theResidualOps);
+    thePendingOps -= myTask.theResidualOps;
     theProcessor.allocate(myTask.theMemory);
     makeActive(std::move(myTask));
-
-    myIt = thePending.erase(myIt);
   }
 
   return myRet;
@@ -162,16 +157,22 @@ void Container::advance(const double aElapsed) {
     return;
   }
 
-  const auto myOperations = theProcessor.timeToOps(aElapsed);
+  advanceOps(theProcessor.timeToOps(aElapsed));
+}
+
+void Container::advanceOps(const uint64_t aOperations) {
+  if (theActive.empty()) {
+    return;
+  }
+
   const auto myActualOperations =
-      std::min(theActive.front().theResidualOps, myOperations);
-  VLOG_IF(2, myActualOperations != myOperations)
-      << "Could not run " << myOperations << " operations on container "
+      std::min(theActive.front().theResidualOps, aOperations);
+  VLOG_IF(2, myActualOperations != aOperations)
+      << "Could not run " << aOperations << " operations on container "
       << theName << " hosted by processor " << theProcessor.name()
       << ", advancing by " << myActualOperations << " instead";
-  VLOG(2) << theProcessor << ' ' << ", elapsed " << aElapsed << ", nearest "
-          << nearest() << ", operations " << myOperations << '/'
-          << myActualOperations;
+  VLOG(2) << theProcessor << ' ' << ", nearest " << nearest()
+          << ", operations " << aOperations << '/' << myActualOperations;
 
   if (myActualOperations == 0) {
     return;
@@ -187,6 +188,11 @@ double Container::nearest() const {
   return theProcessor.opsToTime(theActive.front().theResidualOps); // in s
 }
 
+uint64_t Container::residual() const {
+  throwIfEmpty();
+  return theActive.front().theResidualOps;
+}
+
 void Container::throwIfEmpty() const {
   if (theActive.empty()) {
     throw std::runtime_error("No active tasks");
@@ -198,21 +204,21 @@ void Container::makeActive(Task&& aTask) {
 
   // add the task to the active list, which is kept updated with only the
   // differences between a task and its subsequent elements
-  auto     myIt  = theActive.begin();
+  size_t   myPos = 0;
   uint64_t mySum = 0;
-  for (; myIt != theActive.end(); ++myIt) {
-    if (mySum + myIt->theResidualOps > aTask.theResidualOps) {
+  for (; myPos < theActive.size(); ++myPos) {
+    if (mySum + theActive[myPos].theResidualOps > aTask.theResidualOps) {
       break;
     }
-    mySum += myIt->theResidualOps;
+    mySum += theActive[myPos].theResidualOps;
   }
 
   aTask.theResidualOps -= mySum;
-  if (myIt != theActive.end()) {
-    assert(myIt->theResidualOps > aTask.theResidualOps);
-    myIt->theResidualOps -= aTask.theResidualOps;
+  if (myPos < theActive.size()) {
+    assert(theActive[myPos].theResidualOps > aTask.theResidualOps);
+    theActive[myPos].theResidualOps -= aTask.theResidualOps;
   }
-  theActive.emplace(myIt, aTask);
+  theActive.insert(myPos, std::move(aTask));
 }
 
 LambdaRequirements Container::requirements(const LambdaRequest& aReq) const {
@@ -31,10 +31,10 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/ringbuffer.h"
 #include "lambda.h"
 
 #include <iostream>
-#include <list>
 #include <memory>
 
 namespace uiiit {
@@ -99,6 +99,8 @@ class Container final
    * The memory requirements are ignored (it would be very complex to handle
    * them since memory on the processor is reserved also by other containers).
    *
+   * The complexity does not depend on the number of tasks in the container.
+   *
    * \return the simulated time required for completion.
    */
   double simulate(const LambdaRequest& aReq) const;
@@ -128,6 +130,14 @@ class Container final
    */
   void advance(const double aElapsed);
 
+  /**
+   * Same as advance() but with the number of operations performed by the task
+   * nearest to completion specified directly.
+   *
+   * \param aOperations the number of operations performed.
+   */
+  void advanceOps(const uint64_t aOperations);
+
   //! \return the number of active tasks.
   size_t active() const noexcept {
     return theActive.size();
@@ -145,6 +155,14 @@ class Container final
    */
   double nearest() const;
 
+  /**
+   * \return the residual number of operations of the task nearest to
+   * completion.
+   *
+   * \throw std::runtime_error if there are no active tasks.
+   */
+  uint64_t residual() const;
+
   // accessors
   const std::string& name() const noexcept {
     return theName;
@@ -170,8 +188,13 @@ class Container final
   const Lambda      theLambda;
   const size_t      theNumWorkers;
 
-  std::list<Task> theActive;
-  std::list<Task> thePending;
+  // active tasks, sorted by increasing residual operations, each stored as
+  // the difference with the previous task
+  detail::RingBuffer<Task> theActive;
+  // pending tasks, in order of arrival
+  detail::RingBuffer<Task> thePending;
+  // sum of the residual operations of the pending tasks
+  uint64_t thePendingOps;
 };
 
 } // namespace edge
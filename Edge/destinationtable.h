@@ -33,12 +33,15 @@ SOFTWARE.
 
 #include "forwardingtableexceptions.h"
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #ifndef NDEBUG
 #include <glog/logging.h>
@@ -73,6 +76,57 @@ struct Printer {
 namespace uiiit {
 namespace edge {
 
+/**
+ * Dense integer identifiers of destination names, which are never reused.
+ *
+ * It can be shared by multiple DestinationTable objects, so that the same
+ * destination has the same identifier in all of them. Like the tables, it
+ * is not thread-safe.
+ */
+class DestinationIds final
+{
+ public:
+  using Id = size_t;
+
+  explicit DestinationIds()
+      : theIds()
+      , theNames() {
+  }
+
+  //! \return the identifier of a destination, which is added if new.
+  Id intern(const std::string& aName) {
+    const auto it = theIds.emplace(aName, theNames.size()).first;
+    if (it->second == theNames.size()) {
+      theNames.emplace_back(aName);
+    }
+    return it->second;
+  }
+
+  //! \return the name of the destination with given identifier.
+  const std::string& name(const Id aId) const {
+    assert(aId < theNames.size());
+    return theNames[aId];
+  }
+
+ private:
+  std::unordered_map<std::string, Id> theIds;
+  std::vector<std::string>            theNames; // index: Id
+};
+
+/**
+ * Table of descriptors, one per pair lambda, destination.
+ *
+ * Lambda and destination names are interned to dense integer identifiers when
+ * first added, see DestinationIds. The destinations of a lambda and their
+ * descriptors are kept in contiguous arrays sorted by destination name, hence
+ * selecting a destination is a linear scan that does not require any memory
+ * allocation or string comparison, while a destination is found by name with
+ * a binary search.
+ *
+ * The order by name does not depend on the order of additions and removals,
+ * hence two tables with the same pairs have the same order, and ties in
+ * best() are broken in favor of the destination whose name comes first.
+ */
 template <class TYPE>
 class DestinationTable final
 {
@@ -81,9 +135,23 @@ class DestinationTable final
   using ObjFunc  = std::function<float(TYPE&)>;
 
  public:
-  explicit DestinationTable(const CtorFunc& aCtorFunc)
+  //! Identifier of a destination, see name().
+  using Id = DestinationIds::Id;
+
+  /**
+   * \param aCtorFunc the function creating the descriptor of a new pair.
+   *
+   * \param aIds the identifiers of the destinations, which can be shared
+   * with other tables.
+   */
+  explicit DestinationTable(const CtorFunc&                        aCtorFunc,
+                            const std::shared_ptr<DestinationIds>& aIds =
+                                std::make_shared<DestinationIds>())
       : theCtorFunc(aCtorFunc)
-      , theDescriptors() {
+      , theIds(aIds)
+      , theLambdaIds()
+      , theRows() {
+    assert(theIds);
   }
 
   /**
@@ -93,9 +161,14 @@ class DestinationTable final
    */
   TYPE& find(const std::string& aLambda, const std::string& aDestination);
 
+  //! \return true if the given lambda has the given destination.
+  bool contains(const std::string& aLambda,
+                const std::string& aDestination) const;
+
   /**
    * \return the destination having the biggest objection function value and the
-   * destination corresponding to that value, for a given lambda
+   * destination corresponding to that value, for a given lambda; with ties,
+   * the destination whose name comes first.
    *
    * \throw NoDestinations if there are no destinations for the lambda
    */
@@ -110,6 +183,33 @@ class DestinationTable final
   std::map<std::string, float> all(const std::string& aLambda,
                                    const ObjFunc&     aObjFunc);
 
+  /**
+   * Evaluate the objective function for all the destinations of a lambda.
+   *
+   * \param aLambda the lambda function name.
+   *
+   * \param aObjFunc the objective function.
+   *
+   * \param aValues on output, the values in the same order as
+   * destinations(); its capacity is reused, if sufficient.
+   *
+   * \throw NoDestinations if there are no destinations for the lambda
+   */
+  void values(const std::string&  aLambda,
+              const ObjFunc&      aObjFunc,
+              std::vector<float>& aValues);
+
+  /**
+   * \return the identifiers of the destinations of a lambda, sorted by
+   * destination name.
+   *
+   * \throw NoDestinations if there are no destinations for the lambda
+   */
+  const std::vector<Id>& destinations(const std::string& aLambda) const;
+
+  //! \return the name of the destination with given identifier.
+  const std::string& name(const Id aDestination) const;
+
   /**
    * Add a pair lambda, destination.
    *
@@ -125,69 +225,93 @@ class DestinationTable final
   bool remove(const std::string& aLambda, const std::string& aDestination);
 
  private:
-  // map of:
-  // - key: lambda function name
-  // - value: map of:
-  //   - key: destination
-  //   - value: unique pointer to the mapped TYPE
-  using Descriptors =
-      std::map<std::string, std::map<std::string, std::unique_ptr<TYPE>>>;
-
-  const CtorFunc theCtorFunc;
-  Descriptors    theDescriptors;
+  //! The destinations of a lambda and their descriptors, in the same order.
+  struct Row {
+    std::vector<Id>                    theDestinations;
+    std::vector<std::unique_ptr<TYPE>> theDescriptors;
+  };
+
+  //! \return the row of a lambda with at least one destination.
+  const Row& row(const std::string& aLambda) const;
+
+  /**
+   * \return the position of a destination in the row of a lambda, if found,
+   * or otherwise the position where it would be inserted.
+   */
+  size_t position(const Row& aRow, const std::string& aDestination) const;
+
+  //! \return true if the destination at a given position has the given name.
+  bool
+  found(const Row& aRow, const size_t aPos, const std::string& aName) const {
+    return aPos < aRow.theDestinations.size() and
+           theIds->name(aRow.theDestinations[aPos]) == aName;
+  }
+
+  const CtorFunc                        theCtorFunc;
+  const std::shared_ptr<DestinationIds> theIds;
+
+  std::unordered_map<std::string, size_t> theLambdaIds; // value: row
+  std::vector<Row>                        theRows;
 };
 
 template <class TYPE>
 TYPE& DestinationTable<TYPE>::find(const std::string& aLambda,
                                    const std::string& aDestination) {
-  const auto it = theDescriptors.find(aLambda);
-  if (it != theDescriptors.end()) {
-    const auto jt = it->second.find(aDestination);
-    if (jt != it->second.end()) {
-      return *jt->second;
+  const auto it = theLambdaIds.find(aLambda);
+  if (it != theLambdaIds.end()) {
+    auto&      myRow = theRows[it->second];
+    const auto myPos = position(myRow, aDestination);
+    if (found(myRow, myPos, aDestination)) {
+      return *myRow.theDescriptors[myPos];
     }
   }
   throw InvalidDestination(aLambda, aDestination);
 }
 
+template <class TYPE>
+bool DestinationTable<TYPE>::contains(const std::string& aLambda,
+                                      const std::string& aDestination) const {
+  const auto it = theLambdaIds.find(aLambda);
+  if (it == theLambdaIds.end()) {
+    return false;
+  }
+  const auto& myRow = theRows[it->second];
+  return found(myRow, position(myRow, aDestination), aDestination);
+}
+
 template <class TYPE>
 std::pair<std::string, float>
 DestinationTable<TYPE>::best(const std::string& aLambda,
                              const ObjFunc&     aObjFunc) {
-  const auto it = theDescriptors.find(aLambda);
-  if (it == theDescriptors.end()) {
-    throw NoDestinations();
-  }
+  const auto& myRow = row(aLambda);
 
   float            myMaxRtt = std::numeric_limits<float>::lowest();
-  std::string      myMaxDest;
+  size_t           myMaxPos = myRow.theDescriptors.size();
   details::Printer myPrinter;
-  for (const auto& myDest : it->second) {
-    const auto myCurRtt = aObjFunc(*myDest.second);
-    myPrinter(myDest.first, myCurRtt);
+  for (size_t i = 0; i < myRow.theDescriptors.size(); i++) {
+    const auto myCurRtt = aObjFunc(*myRow.theDescriptors[i]);
+    myPrinter(theIds->name(myRow.theDestinations[i]), myCurRtt);
     if (myCurRtt > myMaxRtt) {
-      myMaxDest = myDest.first;
-      myMaxRtt  = myCurRtt;
+      myMaxPos = i;
+      myMaxRtt = myCurRtt;
     }
   }
   myPrinter.debugPrint();
-  assert(not myMaxDest.empty());
-  return std::make_pair(myMaxDest, myMaxRtt);
+  assert(myMaxPos < myRow.theDescriptors.size());
+  return std::make_pair(theIds->name(myRow.theDestinations[myMaxPos]),
+                        myMaxRtt);
 }
 
 template <class TYPE>
 std::map<std::string, float>
 DestinationTable<TYPE>::all(const std::string& aLambda,
                             const ObjFunc&     aObjFunc) {
-
-  const auto it = theDescriptors.find(aLambda);
-  if (it == theDescriptors.end()) {
-    throw NoDestinations();
-  }
+  const auto& myRow = row(aLambda);
 
   std::map<std::string, float> ret;
-  for (const auto& myDest : it->second) {
-    ret.emplace(myDest.first, aObjFunc(*myDest.second));
+  for (size_t i = 0; i < myRow.theDescriptors.size(); i++) {
+    ret.emplace(theIds->name(myRow.theDestinations[i]),
+                aObjFunc(*myRow.theDescriptors[i]));
   }
 
   assert(not ret.empty());
@@ -195,54 +319,94 @@ DestinationTable<TYPE>::all(const std::string& aLambda,
 }
 
 template <class TYPE>
-bool DestinationTable<TYPE>::add(const std::string& aLambda,
-                                 const std::string& aDestination) {
-  auto it = theDescriptors.find(aLambda);
-  if (it == theDescriptors.end()) {
-    const auto ret =
-        theDescriptors.emplace(aLambda, typename Descriptors::mapped_type());
-    assert(ret.second);
-    it = ret.first;
+void DestinationTable<TYPE>::values(const std::string&  aLambda,
+                                    const ObjFunc&      aObjFunc,
+                                    std::vector<float>& aValues) {
+  const auto& myRow = row(aLambda);
+
+  aValues.resize(myRow.theDescriptors.size());
+  for (size_t i = 0; i < myRow.theDescriptors.size(); i++) {
+    aValues[i] = aObjFunc(*myRow.theDescriptors[i]);
   }
+}
+
+template <class TYPE>
+const std::vector<typename DestinationTable<TYPE>::Id>&
+DestinationTable<TYPE>::destinations(const std::string& aLambda) const {
+  return row(aLambda).theDestinations;
+}
 
-  assert(it != theDescriptors.end());
+template <class TYPE>
+const std::string& DestinationTable<TYPE>::name(const Id aDestination) const {
+  return theIds->name(aDestination);
+}
 
-  [[maybe_unused]] auto jt = it->second.find(aDestination);
-  if (jt == it->second.end()) {
-    const auto ret = it->second.emplace(
-        std::make_pair(aDestination, theCtorFunc(aLambda, aDestination)));
-    assert(ret.second);
-    jt = ret.first;
+template <class TYPE>
+bool DestinationTable<TYPE>::add(const std::string& aLambda,
+                                 const std::string& aDestination) {
+  const auto it = theLambdaIds.emplace(aLambda, theRows.size()).first;
+  if (it->second == theRows.size()) {
+    theRows.emplace_back();
+  }
+  auto& myRow = theRows[it->second];
 
-    return true;
+  const auto myPos = position(myRow, aDestination);
+  if (found(myRow, myPos, aDestination)) {
+    return false;
   }
 
-  assert(jt != it->second.end());
-  assert(jt->second);
+  // keep the destinations sorted by name
+  myRow.theDescriptors.insert(myRow.theDescriptors.begin() + myPos,
+                              theCtorFunc(aLambda, aDestination));
+  myRow.theDestinations.insert(myRow.theDestinations.begin() + myPos,
+                               theIds->intern(aDestination));
+  assert(myRow.theDestinations.size() == myRow.theDescriptors.size());
 
-  return false;
+  return true;
 }
 
 template <class TYPE>
 bool DestinationTable<TYPE>::remove(const std::string& aLambda,
                                     const std::string& aDestination) {
-  auto it = theDescriptors.find(aLambda);
-  if (it == theDescriptors.end()) {
+  const auto it = theLambdaIds.find(aLambda);
+  if (it == theLambdaIds.end()) {
     return false;
   }
 
-  auto jt = it->second.find(aDestination);
-  if (jt == it->second.end()) {
+  auto&      myRow = theRows[it->second];
+  const auto myPos = position(myRow, aDestination);
+  if (not found(myRow, myPos, aDestination)) {
     return false;
   }
 
-  it->second.erase(jt);
-  if (it->second.empty()) {
-    theDescriptors.erase(it);
-  }
+  // preserve the order of the remaining destinations
+  myRow.theDestinations.erase(myRow.theDestinations.begin() + myPos);
+  myRow.theDescriptors.erase(myRow.theDescriptors.begin() + myPos);
 
   return true;
 }
 
+template <class TYPE>
+const typename DestinationTable<TYPE>::Row&
+DestinationTable<TYPE>::row(const std::string& aLambda) const {
+  const auto it = theLambdaIds.find(aLambda);
+  if (it == theLambdaIds.end() or theRows[it->second].theDescriptors.empty()) {
+    throw NoDestinations();
+  }
+  return theRows[it->second];
+}
+
+template <class TYPE>
+size_t DestinationTable<TYPE>::position(const Row&         aRow,
+                                        const std::string& aDestination) const {
+  return std::lower_bound(aRow.theDestinations.begin(),
+                          aRow.theDestinations.end(),
+                          aDestination,
+                          [this](const Id aId, const std::string& aName) {
+                            return theIds->name(aId) < aName;
+                          }) -
+         aRow.theDestinations.begin();
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -31,32 +31,105 @@ SOFTWARE.
 
 #include "edgeclientgrpc.h"
 
+#include "Edge/lambdaforward.h"
+
 #include "RpcSupport/utils.h"
 
 #include <glog/logging.h>
 #include <grpc++/grpc++.h>
 
+#include <chrono>
+
 namespace uiiit {
 namespace edge {
 
 EdgeClientGrpc::EdgeClientGrpc(const std::string& aServerEndpoint,
-                               const bool         aSecure)
+                               const bool         aSecure,
+                               const bool         aDedicated)
     : EdgeClientInterface()
-    , SimpleClient(aServerEndpoint, aSecure) {
-  // noop
+    , SimpleClient(aServerEndpoint, aSecure)
+    , theEndpoint(aServerEndpoint)
+    , theSecure(aSecure)
+    , theProtocol()
+    , theAsyncFlag()
+    , theAsyncClient() {
+  if (aDedicated) {
+    // replace the channel created by SimpleClient with one that uses its own
+    // subchannel pool, hence its own TCP connection
+    grpc::ChannelArguments myArgs;
+    myArgs.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    theStub = rpc::EdgeServer::NewStub(grpc::CreateCustomChannel(
+        aServerEndpoint,
+        aSecure ? grpc::SslCredentials(grpc::SslCredentialsOptions()) :
+                  grpc::InsecureChannelCredentials(),
+        myArgs));
+  }
 }
 
 LambdaResponse EdgeClientGrpc::RunLambda(const LambdaRequest& aReq,
                                          const bool           aDry) {
   VLOG(3) << aReq;
 
+  auto myReq = aReq.toProtobuf();
+  myReq.set_dry(aDry);
+  theProtocol.encode(myReq);
+  auto myRep = call(myReq, aReq.theTimeout);
+  if (not theProtocol.decode(aReq.theName, myRep)) {
+    // the lambda identifier is not valid anymore, e.g., server restarted
+    myReq.set_name(aReq.theName);
+    myReq.clear_lambdaid();
+    myRep = call(myReq, aReq.theTimeout);
+    theProtocol.decode(aReq.theName, myRep);
+  }
+  return LambdaResponse(myRep);
+}
+
+void EdgeClientGrpc::RunLambdaAsync(const LambdaRequest& aReq,
+                                    const bool           aDry,
+                                    Callback&&           aCallback) {
+  VLOG(3) << aReq;
+
+  std::call_once(theAsyncFlag, [this]() {
+    theAsyncClient = EdgeClientGrpcAsync::shared(theSecure);
+  });
+
+  auto myReq = aReq.toProtobuf();
+  myReq.set_dry(aDry);
+  auto myCallback = std::make_shared<Callback>(std::move(aCallback));
+  try {
+    theAsyncClient->RunLambda(
+        theEndpoint, myReq, [myCallback](LambdaResponse&& aRep, const double) {
+          (*myCallback)(std::move(aRep));
+        });
+  } catch (const std::exception& aErr) {
+    (*myCallback)(LambdaResponse(aErr.what(), ""));
+  }
+}
+
+LambdaResponse EdgeClientGrpc::Forward(const rpc::LambdaRequest& aReq,
+                                       const unsigned int        aTimeout) {
   rpc::LambdaResponse myRep;
   grpc::ClientContext myContext;
-  auto                myReq = aReq.toProtobuf();
-  myReq.set_dry(aDry);
-  rpc::checkStatus(theStub->RunLambda(&myContext, myReq, &myRep));
+  if (aTimeout > 0) {
+    myContext.set_deadline(std::chrono::system_clock::now() +
+                           std::chrono::milliseconds(aTimeout));
+  }
+  LambdaForward::add(myContext, aReq, aTimeout);
+  rpc::checkStatus(theStub->RunLambda(&myContext, aReq, &myRep));
   return LambdaResponse(myRep);
 }
 
+rpc::LambdaResponse EdgeClientGrpc::call(const rpc::LambdaRequest& aReq,
+                                         const unsigned int        aTimeout) {
+  rpc::LambdaResponse myRep;
+  grpc::ClientContext myContext;
+  if (aTimeout > 0) {
+    myContext.set_deadline(std::chrono::system_clock::now() +
+                           std::chrono::milliseconds(aTimeout));
+  }
+  rpc::checkStatus(theStub->RunLambda(&myContext, aReq, &myRep));
+  return myRep;
+}
+
 } // namespace edge
 } // namespace uiiit
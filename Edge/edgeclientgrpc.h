@@ -31,10 +31,14 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/edgeclientgrpcasync.h"
 #include "Edge/edgeclientinterface.h"
 #include "Edge/edgemessages.h"
+#include "Edge/lambdaprotocol.h"
 #include "RpcSupport/simpleclient.h"
 
+#include <memory>
+#include <mutex>
 #include <string>
 
 namespace uiiit {
@@ -47,11 +51,39 @@ class EdgeClientGrpc final : public EdgeClientInterface,
   /**
    * \param aServerEndpoint the edge server's end-point.
    * \param aSecure If true then use SSL/TLS authentication.
+   * \param aDedicated If true then the channel does not share its
+   * connection with the other channels towards the same end-point, which
+   * gRPC does by default for channels created with the same arguments.
    */
   explicit EdgeClientGrpc(const std::string& aServerEndpoint,
-                          const bool         aSecure);
+                          const bool         aSecure,
+                          const bool         aDedicated = false);
 
   LambdaResponse RunLambda(const LambdaRequest& aReq, const bool aDry) override;
+
+  /**
+   * Execute a lambda through the EdgeClientGrpcAsync shared by all the
+   * clients in this process, which is created on first use.
+   */
+  void RunLambdaAsync(const LambdaRequest& aReq,
+                      const bool           aDry,
+                      Callback&&           aCallback) override;
+
+  //! Send the request received as it is, see LambdaForward.
+  LambdaResponse Forward(const rpc::LambdaRequest& aReq,
+                         const unsigned int        aTimeout) override;
+
+ private:
+  //! Execute a lambda with the given timeout, in ms, 0 means no deadline.
+  rpc::LambdaResponse call(const rpc::LambdaRequest& aReq,
+                           const unsigned int        aTimeout);
+
+ private:
+  const std::string                    theEndpoint;
+  const bool                           theSecure;
+  LambdaProtocolClient                 theProtocol;
+  std::once_flag                       theAsyncFlag;
+  std::shared_ptr<EdgeClientGrpcAsync> theAsyncClient;
 }; // end class EdgeClientGrpc
 
 } // end namespace edge
@@ -0,0 +1,265 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "edgeclientgrpcasync.h"
+
+#include "Edge/lambdaforward.h"
+
+#include "Support/chrono.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+
+struct EdgeClientGrpcAsync::Call {
+  explicit Call(const std::string& aDestination, Callback&& aCallback)
+      : theId(0)
+      , theDestination(aDestination)
+      , theCallback(std::move(aCallback))
+      , theChrono(true)
+      , theContext()
+      , theResponse()
+      , theStatus()
+      , theReader() {
+    // noop
+  }
+
+  Id                  theId; // assigned when started
+  const std::string   theDestination;
+  const Callback      theCallback;
+  support::Chrono     theChrono;
+  grpc::ClientContext theContext;
+  rpc::LambdaResponse theResponse;
+  grpc::Status        theStatus;
+  std::unique_ptr<grpc::ClientAsyncResponseReader<rpc::LambdaResponse>>
+      theReader;
+};
+
+EdgeClientGrpcAsync::Destination::Destination(
+    const std::string& aServerEndpoint, const bool aSecure)
+    : SimpleClient(aServerEndpoint, aSecure) {
+  // noop
+}
+
+EdgeClientGrpcAsync::EdgeClientGrpcAsync(const bool aSecure)
+    : theSecure(aSecure)
+    , theMutex()
+    , theStopped(false)
+    , theDestinations()
+    , theNextId(0)
+    , theCalls()
+    , theCq()
+    , theThread() {
+  theThread = std::thread([this]() { handle(); });
+}
+
+EdgeClientGrpcAsync::~EdgeClientGrpcAsync() {
+  stop();
+}
+
+void EdgeClientGrpcAsync::stop() {
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    if (theStopped) {
+      return;
+    }
+    theStopped = true;
+    LOG_IF(INFO, not theCalls.empty())
+        << "cancelling " << theCalls.size() << " pending calls";
+    for (const auto& myCall : theCalls) {
+      myCall.second->theContext.TryCancel();
+    }
+  }
+  theCq.Shutdown();
+  theThread.join();
+}
+
+std::shared_ptr<EdgeClientGrpcAsync>
+EdgeClientGrpcAsync::shared(const bool aSecure) {
+  static std::mutex                         myMutex;
+  static std::weak_ptr<EdgeClientGrpcAsync> myInstances[2];
+
+  const std::lock_guard<std::mutex> myLock(myMutex);
+  auto&                             myInstance = myInstances[aSecure ? 1 : 0];
+  auto                              ret        = myInstance.lock();
+  if (not ret) {
+    ret        = std::make_shared<EdgeClientGrpcAsync>(aSecure);
+    myInstance = ret;
+  }
+  return ret;
+}
+
+EdgeClientGrpcAsync::Id
+EdgeClientGrpcAsync::RunLambda(const std::string&   aDestination,
+                               const LambdaRequest& aReq,
+                               const bool           aDry,
+                               Callback&&           aCallback,
+                               const double         aTimeout) {
+  VLOG(3) << aReq;
+
+  auto myReq = aReq.makeOneMoreHop().toProtobuf();
+  myReq.set_dry(aDry);
+  return RunLambda(aDestination, myReq, std::move(aCallback), aTimeout);
+}
+
+EdgeClientGrpcAsync::Id
+EdgeClientGrpcAsync::RunLambda(const std::string&        aDestination,
+                               const rpc::LambdaRequest& aReq,
+                               Callback&&                aCallback,
+                               const double              aTimeout) {
+  auto myCall = std::make_unique<Call>(aDestination, std::move(aCallback));
+
+  // the deadline is the earliest between the timeout and that of the lambda
+  auto myTimeout = aTimeout;
+  if (aReq.timeout() > 0 and
+      (myTimeout <= 0 or aReq.timeout() < myTimeout * 1e3)) {
+    myTimeout = aReq.timeout() / 1e3;
+  }
+  if (myTimeout > 0) {
+    myCall->theContext.set_deadline(
+        std::chrono::system_clock::now() +
+        std::chrono::microseconds(static_cast<int64_t>(myTimeout * 1e6)));
+  }
+
+  return start(std::move(myCall), aReq);
+}
+
+EdgeClientGrpcAsync::Id
+EdgeClientGrpcAsync::Forward(const std::string&        aDestination,
+                             const rpc::LambdaRequest& aReq,
+                             const unsigned int        aTimeout,
+                             Callback&&                aCallback) {
+  auto myCall = std::make_unique<Call>(aDestination, std::move(aCallback));
+  if (aTimeout > 0) {
+    myCall->theContext.set_deadline(std::chrono::system_clock::now() +
+                                    std::chrono::milliseconds(aTimeout));
+  }
+  LambdaForward::add(myCall->theContext, aReq, aTimeout);
+
+  return start(std::move(myCall), aReq);
+}
+
+void EdgeClientGrpcAsync::cancel(const Id aId) {
+  // the call cannot complete while the lock is held, see handle()
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto                        it = theCalls.find(aId);
+  if (it != theCalls.end()) {
+    it->second->theContext.TryCancel();
+  }
+}
+
+EdgeClientGrpcAsync::Id
+EdgeClientGrpcAsync::start(std::unique_ptr<Call>&&   aCall,
+                           const rpc::LambdaRequest& aReq) {
+  // the call is started while holding the lock so that no new operation can
+  // be added to the completion queue after it has been shut down; the
+  // request is serialized immediately, hence it needs not outlive the call
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  if (theStopped) {
+    throw std::runtime_error("Cannot run lambda on " + aCall->theDestination +
+                             ": the client has been stopped");
+  }
+  aCall->theId     = theNextId++;
+  aCall->theReader = stub(aCall->theDestination)
+                         .AsyncRunLambda(&aCall->theContext, aReq, &theCq);
+  aCall->theReader->Finish(
+      &aCall->theResponse, &aCall->theStatus, aCall.get());
+  const auto ret = aCall->theId;
+  theCalls.emplace(ret, aCall.release());
+  return ret;
+}
+
+size_t EdgeClientGrpcAsync::pending() const {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theCalls.size();
+}
+
+void EdgeClientGrpcAsync::handle() {
+  void* myTag;
+  bool  myOk;
+  while (theCq.Next(&myTag, &myOk)) {
+    std::unique_ptr<Call> myCall(static_cast<Call*>(myTag));
+    {
+      const std::lock_guard<std::mutex> myLock(theMutex);
+      [[maybe_unused]] const auto myErased = theCalls.erase(myCall->theId);
+      assert(myErased == 1);
+    }
+    const auto myElapsed = myCall->theChrono.stop();
+
+    const auto mySuccess = myOk and myCall->theStatus.ok();
+    LambdaResponse myResp =
+        mySuccess ?
+            LambdaResponse(myCall->theResponse) :
+            LambdaResponse("RPC to " + myCall->theDestination +
+                               " failed: " + myCall->theStatus.error_message(),
+                           "");
+
+    // if the lambda does not include the actual responder then we set it to
+    // the destination
+    if (mySuccess and myResp.theResponder.empty()) {
+      myResp.theResponder = myCall->theDestination;
+    }
+
+    try {
+      myCall->theCallback(std::move(myResp), myElapsed);
+    } catch (const std::exception& aErr) {
+      LOG(ERROR) << "exception raised by the callback of a lambda executed on "
+                 << myCall->theDestination << ": " << aErr.what();
+    } catch (...) {
+      LOG(ERROR) << "unknown exception raised by the callback of a lambda "
+                    "executed on "
+                 << myCall->theDestination;
+    }
+  }
+  VLOG(1) << "terminating asynchronous edge client thread";
+}
+
+rpc::EdgeServer::Stub&
+EdgeClientGrpcAsync::stub(const std::string& aDestination) {
+  ASSERT_IS_LOCKED(theMutex);
+  auto it = theDestinations.find(aDestination);
+  if (it == theDestinations.end()) {
+    it = theDestinations
+             .emplace(aDestination,
+                      std::make_unique<Destination>(aDestination, theSecure))
+             .first;
+  }
+  assert(it->second);
+  return it->second->stub();
+}
+
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,204 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/edgemessages.h"
+#include "RpcSupport/simpleclient.h"
+#include "Support/macros.h"
+
+#include <grpc++/grpc++.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "edgeserver.grpc.pb.h"
+
+namespace uiiit {
+namespace edge {
+
+/**
+ * Edge client executing lambda functions on remote destinations through
+ * asynchronous gRPC stubs.
+ *
+ * All the calls are multiplexed on a single completion queue, which is served
+ * by a dedicated thread that invokes the user callback upon completion.
+ * There is a single channel per destination, created lazily on first use.
+ *
+ * Thread-safe.
+ */
+class EdgeClientGrpcAsync final
+{
+  struct Call;
+
+  //! Channel and stub towards a single destination.
+  class Destination final : public rpc::SimpleClient<rpc::EdgeServer>
+  {
+   public:
+    explicit Destination(const std::string& aServerEndpoint,
+                         const bool         aSecure);
+
+    rpc::EdgeServer::Stub& stub() {
+      return *theStub;
+    }
+  };
+
+ public:
+  /**
+   * Callback invoked upon completion of a lambda function, with the
+   * response and the time elapsed, in fractional seconds, since the call.
+   *
+   * If the RPC failed then the return code of the response contains the
+   * error message.
+   *
+   * The callback is invoked from the internal thread serving the completion
+   * queue, hence it should not block for long.
+   */
+  using Callback = std::function<void(LambdaResponse&&, const double)>;
+
+  //! Identifier of a call, which can be used to cancel it.
+  using Id = uint64_t;
+
+  NONCOPYABLE_NONMOVABLE(EdgeClientGrpcAsync);
+
+  /**
+   * \param aSecure If true then use SSL/TLS authentication.
+   */
+  explicit EdgeClientGrpcAsync(const bool aSecure);
+
+  //! Call stop().
+  ~EdgeClientGrpcAsync();
+
+  /**
+   * Cancel all the pending calls and wait for their callbacks to return.
+   * After this method returns new calls are rejected. No-op if already
+   * stopped. Must not be called from within a callback.
+   */
+  void stop();
+
+  /**
+   * \return an instance shared by all the callers with the same SSL/TLS
+   * setting, created on first use and destroyed when the last reference is
+   * released, which must not happen from within a callback.
+   */
+  static std::shared_ptr<EdgeClientGrpcAsync> shared(const bool aSecure);
+
+  /**
+   * Start the execution of a lambda function on a given destination.
+   * Return immediately.
+   *
+   * \param aDestination The edge computer end-point.
+   * \param aReq The lambda request, which is sent with one more hop.
+   * \param aDry If true do not actually execute the lambda function.
+   * \param aCallback The function called when the execution is complete.
+   * \param aTimeout If positive, the call fails if not complete within
+   * this time, in fractional seconds. The timeout of the lambda request, if
+   * any, is also enforced.
+   *
+   * \return the identifier of the call.
+   *
+   * \throw std::runtime_error if the client has been stopped.
+   */
+  Id RunLambda(const std::string&   aDestination,
+               const LambdaRequest& aReq,
+               const bool           aDry,
+               Callback&&           aCallback,
+               const double         aTimeout = 0);
+
+  /**
+   * Start the execution of a lambda function on a given destination, with the
+   * request sent as it is, e.g., without adding one more hop.
+   * Return immediately.
+   *
+   * Same parameters as above.
+   */
+  Id RunLambda(const std::string&        aDestination,
+               const rpc::LambdaRequest& aReq,
+               Callback&&                aCallback,
+               const double              aTimeout = 0);
+
+  /**
+   * Start forwarding a lambda request received to a given destination,
+   * without copying it, see LambdaForward. Return immediately.
+   *
+   * \param aDestination The edge computer end-point.
+   * \param aReq The lambda request received.
+   * \param aTimeout The time left to complete the execution of the lambda,
+   * in ms; 0 means no deadline.
+   * \param aCallback The function called when the execution is complete.
+   *
+   * \return the identifier of the call.
+   *
+   * \throw std::runtime_error if the client has been stopped.
+   */
+  Id Forward(const std::string&        aDestination,
+             const rpc::LambdaRequest& aReq,
+             const unsigned int        aTimeout,
+             Callback&&                aCallback);
+
+  /**
+   * Cancel a call in progress, whose callback is then invoked with a failed
+   * response, unless it has completed meanwhile. No-op if the call is not in
+   * progress anymore.
+   */
+  void cancel(const Id aId);
+
+  //! \return the number of calls in progress.
+  size_t pending() const;
+
+ private:
+  //! Start a call whose context has been already prepared.
+  Id start(std::unique_ptr<Call>&& aCall, const rpc::LambdaRequest& aReq);
+
+  //! Thread execution body.
+  void handle();
+
+  //! \return the stub towards the given destination, created if needed.
+  rpc::EdgeServer::Stub& stub(const std::string& aDestination);
+
+ private:
+  const bool                                          theSecure;
+  mutable std::mutex                                  theMutex;
+  bool                                                theStopped;
+  std::map<std::string, std::unique_ptr<Destination>> theDestinations;
+  Id                                                  theNextId;
+  std::map<Id, Call*>                                 theCalls;
+  grpc::CompletionQueue                               theCq;
+  std::thread                                         theThread;
+};
+
+} // end namespace edge
+} // end namespace uiiit
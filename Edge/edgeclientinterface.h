@@ -34,6 +34,10 @@ SOFTWARE.
 #include "Support/macros.h"
 #include "edgemessages.h"
 
+#include <exception>
+#include <functional>
+#include <memory>
+
 namespace uiiit {
 namespace edge {
 
@@ -46,6 +50,9 @@ class EdgeClientInterface
   NONCOPYABLE_NONMOVABLE(EdgeClientInterface);
 
  public:
+  //! Callback invoked upon completion of an asynchronous lambda execution.
+  using Callback = std::function<void(LambdaResponse&&)>;
+
   explicit EdgeClientInterface() {
   }
   virtual ~EdgeClientInterface() {
@@ -57,6 +64,50 @@ class EdgeClientInterface
    */
   virtual LambdaResponse RunLambda(const LambdaRequest& aReq,
                                    const bool           aDry) = 0;
+
+  /**
+   * Forward a lambda request received, with one more hop and the forward
+   * flag set. The lambda is never dry.
+   *
+   * The default implementation copies the request and calls RunLambda().
+   *
+   * \param aReq The lambda function request received.
+   * \param aTimeout The time left to complete the execution of the lambda,
+   * in ms; 0 means no deadline.
+   */
+  virtual LambdaResponse Forward(const rpc::LambdaRequest& aReq,
+                                 const unsigned int        aTimeout) {
+    auto myReq       = LambdaRequest::view(aReq).makeOneMoreHop();
+    myReq.theTimeout = aTimeout;
+    return RunLambda(myReq, false);
+  }
+
+  /**
+   * Execute a lambda function without waiting for its completion.
+   *
+   * The callback is invoked exactly once, possibly from another thread,
+   * and it should not block for long. Errors are reported through the
+   * return code of the response.
+   *
+   * The default implementation calls RunLambda() and then the callback from
+   * the calling thread.
+   *
+   * \param aReq The lambda function request, which needs not outlive the
+   * call.
+   * \param aDry if true do not actually execute the lambda
+   * \param aCallback The function called with the lambda response.
+   */
+  virtual void RunLambdaAsync(const LambdaRequest& aReq,
+                              const bool           aDry,
+                              Callback&&           aCallback) {
+    std::unique_ptr<LambdaResponse> myResp;
+    try {
+      myResp = std::make_unique<LambdaResponse>(RunLambda(aReq, aDry));
+    } catch (const std::exception& aErr) {
+      myResp = std::make_unique<LambdaResponse>(aErr.what(), "");
+    }
+    aCallback(std::move(*myResp));
+  }
 }; // end class EdgeClientInterface
 
 } // end namespace edge
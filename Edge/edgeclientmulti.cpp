@@ -32,7 +32,6 @@ SOFTWARE.
 #include "edgeclientmulti.h"
 
 #include "Edge/edgeclientfactory.h"
-#include "Edge/edgeclientgrpc.h"
 #include "Support/random.h"
 #include "Support/tostring.h"
 
@@ -41,6 +40,7 @@ SOFTWARE.
 #endif
 
 #include <cassert>
+#include <future>
 #include <stdexcept>
 
 #include <glog/logging.h>
@@ -48,17 +48,29 @@ SOFTWARE.
 namespace uiiit {
 namespace edge {
 
+EdgeClientMulti::Race::Race(const size_t aPending, Callback&& aCallback)
+    : theCallback(std::move(aCallback))
+    , theMutex()
+    , thePending(aPending)
+    , theOver(false)
+    , theStarted(false)
+    , theWinner(0)
+    , theResponse()
+    , theCalls()
+    , theRequest()
+    , theDry(false) {
+  // noop
+}
+
 EdgeClientMulti::EdgeClientMulti(const std::set<std::string>& aServerEndpoints,
                                  const bool                   aSecure,
                                  const support::Conf&         aClientConf)
     : EdgeClientInterface()
     , thePersistenceProb(aClientConf.getDouble("persistence"))
     , theDesc(aServerEndpoints.size())
-    , theConsumer()
-    , theConsumerQueue()
-    , theQueueOut()
-    , thePendingRequest(nullptr)
-    , thePrimary(0) {
+    , theMutex()
+    , thePrimary(0)
+    , theAsyncClient() {
   if (aClientConf.getDouble("persistence") < 0 or
       aClientConf.getDouble("persistence") > 1) {
     throw std::runtime_error(
@@ -74,13 +86,17 @@ EdgeClientMulti::EdgeClientMulti(const std::set<std::string>& aServerEndpoints,
   // start executors
   size_t     i            = 0;
   const auto myClientType = aClientConf("type");
+  if (myClientType == "grpc") {
+    theAsyncClient = std::make_unique<EdgeClientGrpcAsync>(aSecure);
+  }
   for (const auto& myEndpoint : aServerEndpoints) {
     auto& myDesc       = theDesc[i];
     myDesc.theIndex    = i;
     myDesc.theEndpoint = myEndpoint;
+    i++;
 
     if (myClientType == "grpc") {
-      myDesc.theClient.reset(new EdgeClientGrpc(myEndpoint, aSecure));
+      continue;
 #ifdef WITH_QUIC
     } else if (myClientType == "quic") {
       myDesc.theClient.reset(new EdgeClientQuic(
@@ -95,20 +111,9 @@ EdgeClientMulti::EdgeClientMulti(const std::set<std::string>& aServerEndpoints,
         // do nothing
       }
     });
-    i++;
   }
   assert(theDesc.size() == aServerEndpoints.size());
 
-  // start consumer
-  theConsumer = std::thread([this]() {
-    while (consume()) {
-      // do nothing
-    }
-  });
-
-  // unblock the calling thread upon first lambda call
-  theCallingQueue.push(true);
-
   LOG(INFO) << "starting an edge multi-client towards ["
             << toString(aServerEndpoints, ",")
             << "] with persistence probability "
@@ -116,75 +121,48 @@ EdgeClientMulti::EdgeClientMulti(const std::set<std::string>& aServerEndpoints,
 }
 
 EdgeClientMulti::~EdgeClientMulti() {
-  // force termination of the consumer thread
-  theConsumerQueue.push({});
-
-  // force termination of the calling thread
-  theCallingQueue.push(false);
+  // cancel the pending calls and wait for their callbacks to return
+  theAsyncClient.reset();
 
   // force termination of the executors
   for (auto& myDesc : theDesc) {
-    myDesc.theQueueIn.push(MessageIn());
-  }
-
-  // join threads
-  assert(theConsumer.joinable());
-  theConsumer.join();
-  for (auto& myDesc : theDesc) {
-    assert(myDesc.theThread.joinable());
-    myDesc.theThread.join();
-  }
-}
-
-bool EdgeClientMulti::consume() {
-  // get the set of pending clients
-  auto myPending = theConsumerQueue.pop();
-
-  // empty set means we are terminating
-  if (myPending.empty()) {
-    return false;
-  }
-
-  // wait for all edge clients to return
-  while (not myPending.empty()) {
-    auto myResponse = theQueueOut.pop();
-
-    VLOG_IF(2, myResponse) << "non-fastest executor "
-                           << theDesc[myResponse.theIndex].theEndpoint
-                           << " replied with "
-                           << myResponse.theResponse->toString();
-
-    assert(myPending.count(myResponse.theIndex) == 1);
-    myPending.erase(myResponse.theIndex);
+    if (myDesc.theThread.joinable()) {
+      myDesc.theQueueIn.push(nullptr);
+      myDesc.theThread.join();
+    }
   }
-
-  // unblock the calling thread when done
-  theCallingQueue.push(true);
-
-  return true; // go on buddy
 }
 
 bool EdgeClientMulti::execLambda(Desc& aDesc) {
   try {
     // wait for a new lambda request to arrive
-    const auto myMessageIn = aDesc.theQueueIn.pop();
+    const auto myRace = aDesc.theQueueIn.pop();
 
     // if the lambda request is empty then we are terminating
-    if (not myMessageIn) {
+    if (not myRace) {
       return false;
     }
 
-    // execute the lambda request and push the message
+    // skip the request if another destination has already won the race
+    bool myOver;
+    {
+      const std::lock_guard<std::mutex> myLock(myRace->theMutex);
+      myOver = myRace->theOver;
+    }
+    if (myOver) {
+      done(*myRace, aDesc.theIndex, nullptr);
+      return true;
+    }
+
+    // execute the lambda request, an error yields an empty response
+    std::unique_ptr<LambdaResponse> myResponse;
     try {
-      theQueueOut.push(MessageOut(
-          aDesc.theIndex,
-          std::make_unique<LambdaResponse>(aDesc.theClient->RunLambda(
-              *myMessageIn.theRequest, myMessageIn.theDry))));
+      myResponse = std::make_unique<LambdaResponse>(
+          aDesc.theClient->RunLambda(*myRace->theRequest, myRace->theDry));
     } catch (...) {
-      // an error occurred, we push an empty response
-      // to be handled by the other threads in this object
-      theQueueOut.push(MessageOut(aDesc.theIndex));
+      // noop
     }
+    done(*myRace, aDesc.theIndex, std::move(myResponse));
 
   } catch (const support::QueueClosed&) {
     // communication channel has been closed, we must terminate
@@ -193,81 +171,144 @@ bool EdgeClientMulti::execLambda(Desc& aDesc) {
   return true;
 }
 
-LambdaResponse EdgeClientMulti::RunLambda(const LambdaRequest& aReq,
-                                          const bool           aDry) {
-  // wait until the consumer is done
-  const auto myGoAhead = theCallingQueue.pop();
-  if (not myGoAhead) {
-    return LambdaResponse("terminating", "");
-  }
+void EdgeClientMulti::done(Race&                             aRace,
+                           const size_t                      aIndex,
+                           std::unique_ptr<LambdaResponse>&& aResponse) {
+  Race::Calls myCalls;
+  {
+    const std::lock_guard<std::mutex> myLock(aRace.theMutex);
+    assert(aRace.thePending > 0);
+    aRace.thePending--;
+
+    if (aRace.theOver) {
+      VLOG_IF(2, aResponse)
+          << "non-fastest executor " << theDesc[aIndex].theEndpoint
+          << " replied with " << aResponse->toString();
+      return;
+    }
 
-  // find which clients should be reached in addition to the primary
-  // destination
-  auto myPending = secondary();
+    if (aResponse and aResponse->ok()) {
+      // good response, we may proceed after recording who responded
+      aResponse->theResponder = theDesc[aIndex].theEndpoint;
+      aRace.theOver           = true;
+      aRace.theWinner         = aIndex;
+      aRace.theResponse       = std::move(aResponse);
+    } else {
+      // keep the latest error, returned if all the destinations fail
+      if (aResponse) {
+        aRace.theResponse = std::move(aResponse);
+      }
+      aRace.theOver = aRace.thePending == 0;
+    }
 
-  // reach out for the primary, too
-  myPending.insert(thePrimary);
+    if (not aRace.theOver) {
+      return;
+    }
 
-  // create a local copy of the lambda request, which may not survive
-  // when this function returns (but some threads may still use it)
-  thePendingRequest = std::make_unique<LambdaRequest>(aReq.copy());
+    // otherwise the calls are cancelled once they have been all issued
+    if (aRace.theStarted) {
+      myCalls.swap(aRace.theCalls);
+    }
+  }
 
-  // unblock the selected clients
-  assert(not myPending.empty());
-  for (const auto ndx : myPending) {
-    assert(thePendingRequest.get() != nullptr);
-    theDesc[ndx].theQueueIn.push(MessageIn(thePendingRequest.get(), aDry));
+  // once the race is over the response is not modified anymore
+  cancel(aRace, myCalls);
+
+  if (not aRace.theResponse) {
+    // none of the destinations worked out
+    aRace.theCallback(
+        LambdaResponse("none of the destinations responded correctly", ""));
+    return;
   }
 
-  // wait for the fastest client
-  MessageOut myFastest(thePrimary);
-  while (not myPending.empty()) {
-    myFastest = theQueueOut.pop();
-    assert(myPending.count(myFastest.theIndex) == 1);
-    myPending.erase(myFastest.theIndex);
-    if (myFastest and myFastest.theResponse->theRetCode == "OK") {
-      // good response, we may proceed after recording who responded
-      myFastest.theResponse->theResponder =
-          theDesc[myFastest.theIndex].theEndpoint;
-      break;
+  if (aRace.theResponse->ok()) {
+    // the fastest executor becomes the new primary
+    {
+      const std::lock_guard<std::mutex> myLock(theMutex);
+      thePrimary = aRace.theWinner;
     }
+    VLOG(2) << "fastest executor " << theDesc[aRace.theWinner].theEndpoint
+            << " replied with " << aRace.theResponse->toString();
   }
 
-  // none of the destinations worked out
-  if (not myFastest) {
-    assert(myPending.empty());
-    theCallingQueue.push(true);
-    return LambdaResponse("none of the destinations responded correctly", "");
-  }
+  aRace.theCallback(LambdaResponse(*aRace.theResponse));
+}
 
-  // only non-OK responses
-  if (myFastest.theResponse->theRetCode != "OK") {
-    assert(myPending.empty());
-    theCallingQueue.push(true);
-    return *myFastest.theResponse;
+void EdgeClientMulti::cancel(const Race& aRace, const Race::Calls& aCalls) {
+  for (const auto& myCall : aCalls) {
+    if (myCall.first != aRace.theWinner) {
+      theAsyncClient->cancel(myCall.second);
+    }
   }
+}
 
-  // pass the pending set to the consumer only if it is non-empty
-  if (myPending.empty()) {
-    // do not wait at all
-    theCallingQueue.push(true);
-  } else {
-    theConsumerQueue.push(myPending);
-  }
+LambdaResponse EdgeClientMulti::RunLambda(const LambdaRequest& aReq,
+                                          const bool           aDry) {
+  // the callback may be invoked after this function has returned, but not
+  // after the future has become ready
+  auto myPromise = std::make_shared<std::promise<LambdaResponse>>();
+  auto myFuture  = myPromise->get_future();
+  RunLambdaAsync(aReq, aDry, [myPromise](LambdaResponse&& aRep) {
+    myPromise->set_value(std::move(aRep));
+  });
+  return myFuture.get();
+}
 
-  // the fastest executor becomes the new primary
-  thePrimary = myFastest.theIndex;
+void EdgeClientMulti::RunLambdaAsync(const LambdaRequest& aReq,
+                                     const bool           aDry,
+                                     Callback&&           aCallback) {
+  // find which clients should be reached, including the primary destination
+  const auto myDestinations = destinations();
+  assert(not myDestinations.empty());
+  const auto myRace =
+      std::make_shared<Race>(myDestinations.size(), std::move(aCallback));
+
+  if (theAsyncClient) {
+    // the request is serialized only once for all the destinations
+    auto myReq = aReq.toProtobuf();
+    myReq.set_dry(aDry);
+    for (const auto ndx : myDestinations) {
+      try {
+        const auto myId = theAsyncClient->RunLambda(
+            theDesc[ndx].theEndpoint,
+            myReq,
+            [this, myRace, ndx](LambdaResponse&& aRep, const double) {
+              done(*myRace,
+                   ndx,
+                   std::make_unique<LambdaResponse>(std::move(aRep)));
+            });
+        const std::lock_guard<std::mutex> myLock(myRace->theMutex);
+        myRace->theCalls.emplace_back(ndx, myId);
+      } catch (...) {
+        done(*myRace, ndx, nullptr);
+      }
+    }
 
-  VLOG(2) << "fastest executor " << theDesc[myFastest.theIndex].theEndpoint
-          << " replied with " << myFastest.theResponse->toString();
+    // cancel the calls still in progress if the race is already over
+    Race::Calls myCalls;
+    {
+      const std::lock_guard<std::mutex> myLock(myRace->theMutex);
+      myRace->theStarted = true;
+      if (myRace->theOver) {
+        myCalls.swap(myRace->theCalls);
+      }
+    }
+    cancel(*myRace, myCalls);
 
-  // return the response while there may be other threads working
-  assert(myFastest.theResponse);
-  return *myFastest.theResponse;
+  } else {
+    // the executors may still use the request after this function returns,
+    // the copy shares the payloads with the original
+    myRace->theRequest = std::make_unique<LambdaRequest>(aReq.copy());
+    myRace->theDry     = aDry;
+    for (const auto ndx : myDestinations) {
+      theDesc[ndx].theQueueIn.push(myRace);
+    }
+  }
 }
 
-std::set<size_t> EdgeClientMulti::secondary() {
-  std::set<size_t> ret;
+std::set<size_t> EdgeClientMulti::destinations() {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  std::set<size_t>                  ret({thePrimary});
   for (size_t i = 0; i < theDesc.size(); i++) {
     if (i == thePrimary) {
       continue;
@@ -29,110 +29,73 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+
 #pragma once
 
+#include "Edge/edgeclientgrpcasync.h"
 #include "Edge/edgeclientinterface.h"
 #include "Edge/edgemessages.h"
-#include "RpcSupport/simpleclient.h"
 #include "Support/conf.h"
 #include "Support/queue.h"
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace uiiit {
 namespace edge {
 
-// forward declaration
-class EdgeClient;
-
 /**
  * An edge client that has multiple possible destinations.
  *
- * Objects of this class spawn N+1 threads, where N is the number of
- * destinations.
- *
- * Each of the N threads contains an EdgeClient that performs lambda requests
- * as dispatched by the calling thread.
+ * Every lambda request is a race among the primary destination and the
+ * secondary ones selected with the persistence probability: the first
+ * successful response is returned to the caller without waiting for the
+ * others, which are cancelled, if still in progress, or drained in the
+ * background. Therefore a slow destination never delays the following
+ * requests and RunLambda() can be called concurrently by multiple threads;
+ * RunLambdaAsync() does not wait for the race to be over.
  *
- * The +1 thread does the clean-up after the first EdgeClient has returned,
- * which makes the calling thread move on. The calling thread blocks if this
- * thread is still waiting for still-pending previous lambda requests.
+ * With gRPC all the destinations are served by a single EdgeClientGrpcAsync
+ * and the losing calls are cancelled. With other transports each destination
+ * has a thread with a synchronous EdgeClient, which skips the requests whose
+ * race is already over when they are dequeued.
  */
 class EdgeClientMulti final : public EdgeClientInterface
 {
-  //! Message-passing structure from main thread to client threads.
-  struct MessageIn {
-    MOVEONLY(MessageIn);
-
-    //! Empty message for terminating.
-    explicit MessageIn()
-        : theRequest(nullptr)
-        , theDry(false) {
-      // nihil
-    }
-
-    /**
-     * \param aRequest pointer to the lambda request.
-     * \param aDry true if the lambda is not to be actually executed.
-     *
-     * \pre aRequest is not null.
-     */
-    explicit MessageIn(const LambdaRequest* aRequest, const bool aDry)
-        : theRequest(aRequest)
-        , theDry(aDry) {
-      assert(aRequest != nullptr);
-    }
-
-    operator bool() const noexcept {
-      return theRequest != nullptr;
-    }
-
-    const LambdaRequest* theRequest; // nullptr means terminating
-    bool                 theDry;
-  };
-
-  //! Message-passing structure from client threads to main thread.
-  struct MessageOut {
-    MOVEONLY(MessageOut);
-
-    //! Empty message for terminating.
-    explicit MessageOut(const size_t aIndex)
-        : theIndex(aIndex)
-        , theResponse(nullptr) {
-    }
-
-    /**
-     * \param aIndex The index of the client returning the response.
-     * \param aResponse The response returned.
-     *
-     * \pre aResponse is not null.
-     */
-    explicit MessageOut(const size_t                      aIndex,
-                        std::unique_ptr<LambdaResponse>&& aResponse)
-        : theIndex(aIndex)
-        , theResponse(std::move(aResponse)) {
-      assert(theResponse);
-    }
-
-    operator bool() const noexcept {
-      return theResponse.get() != nullptr;
-    }
-
-    size_t                          theIndex;
-    std::unique_ptr<LambdaResponse> theResponse; // nullptr means terminating
+  //! A lambda request sent to one or more destinations.
+  struct Race {
+    explicit Race(const size_t aPending, Callback&& aCallback);
+
+    const Callback theCallback; // invoked when the race is over
+    std::mutex     theMutex;
+    size_t         thePending;
+    bool           theOver;
+    bool           theStarted; // true when all the calls have been issued
+    size_t         theWinner;
+    // the winning response, or the last error if all the destinations failed
+    std::unique_ptr<LambdaResponse> theResponse;
+    // gRPC only: the destinations reached and the identifiers of the calls
+    using Calls = std::vector<std::pair<size_t, EdgeClientGrpcAsync::Id>>;
+    Calls theCalls;
+    // other transports only: the request to be executed
+    std::unique_ptr<const LambdaRequest> theRequest;
+    bool                                 theDry;
   };
 
   //! One per client connected.
   struct Desc {
-    size_t                               theIndex;
-    std::string                          theEndpoint;
-    std::unique_ptr<EdgeClientInterface> theClient;
-    support::Queue<MessageIn>            theQueueIn;
-    std::thread                          theThread;
+    size_t      theIndex;
+    std::string theEndpoint;
+    // other transports only
+    std::unique_ptr<EdgeClientInterface>  theClient;
+    support::Queue<std::shared_ptr<Race>> theQueueIn;
+    std::thread                           theThread;
   };
 
  public:
@@ -157,9 +120,8 @@ class EdgeClientMulti final : public EdgeClientInterface
    * destination. Additionaly, depending on the policy used, it may also be sent
    * to other secondary executors.
    *
-   * This function returns after the first of the lambda responses is
-   * received. However, if the same function is called again, it blocks
-   * until the last of the lambda responses is received.
+   * This function returns after the first successful lambda response is
+   * received, without waiting for the other destinations.
    *
    * If a connection error occurs or the executor replies with an
    * error code, the response is discarded if there are other pending
@@ -167,46 +129,56 @@ class EdgeClientMulti final : public EdgeClientInterface
    * selected destinations, in addition to the primary, fail.
    *
    * Failed destinations are not removed from the pool.
+   *
+   * Thread-safe.
    */
   LambdaResponse RunLambda(const LambdaRequest& aReq, const bool aDry) override;
 
- private:
-  //! \return the smoothing factor for delay computation
-  static constexpr float alpha() {
-    return 0.05;
-  }
-
-  //! Consumer body. When terminating returns false.
-  bool consume();
+  //! Same as RunLambda() but the response is passed to a callback.
+  void RunLambdaAsync(const LambdaRequest& aReq,
+                      const bool           aDry,
+                      Callback&&           aCallback) override;
 
+ private:
   /**
-   * Lambda execution body.
-   *
-   * If waits for an incoming message in the Desc::theQueueIn, then try
-   * to execute the lambda via Desc::theClient; if something fails it
-   * pushes to Desc::theQueueOut an empty pointer, otherwise a newly
-   * created LambdaResponse object.
+   * Lambda execution body, for transports other than gRPC.
    *
    * \param aDesc The descriptor to be used by this thread.
    *
-   * \return False when terminating, ie. Desc::theQueueIn is closed.
+   * \return False when terminating.
    */
   bool execLambda(Desc& aDesc);
 
-  //! \return the set of other destinations to be reached.
-  std::set<size_t> secondary();
+  /**
+   * Record the response of a destination in a race.
+   *
+   * \param aRace the race.
+   *
+   * \param aIndex the index of the destination.
+   *
+   * \param aResponse the response, null if the destination did not respond.
+   */
+  void done(Race&                             aRace,
+            const size_t                      aIndex,
+            std::unique_ptr<LambdaResponse>&& aResponse);
+
+  //! Cancel the calls of a race that is over, except the winner's.
+  void cancel(const Race& aRace, const Race::Calls& aCalls);
+
+  //! \return the primary and secondary destinations of a new race.
+  std::set<size_t> destinations();
 
  private:
   const float thePersistenceProb;
 
-  std::vector<Desc>                    theDesc; // never modified after ctor
-  std::thread                          theConsumer;
-  support::Queue<std::set<size_t>>     theConsumerQueue;
-  support::Queue<bool>                 theCallingQueue;
-  support::Queue<MessageOut>           theQueueOut;
-  std::unique_ptr<const LambdaRequest> thePendingRequest;
-  size_t                               thePrimary;
+  std::vector<Desc> theDesc; // never modified after ctor
+
+  std::mutex theMutex; // protects thePrimary and the random generator
+  size_t     thePrimary;
+
+  // gRPC only, must be destroyed first since its callbacks use this object
+  std::unique_ptr<EdgeClientGrpcAsync> theAsyncClient;
 }; // end class EdgeClientMulti
 
 } // end namespace edge
-} // end namespace uiiit
\ No newline at end of file
+} // end namespace uiiit
@@ -32,6 +32,7 @@ SOFTWARE.
 #include "edgeclientpool.h"
 
 #include "Edge/edgeclientfactory.h"
+#include "Edge/edgeclientgrpc.h"
 #include "Support/chrono.h"
 #include "Support/conf.h"
 
@@ -47,28 +48,69 @@ EdgeClientPool::EdgeClientPool(const bool           aSecure,
                                const support::Conf& aConf,
                                const size_t         aMaxClients)
     : theMaxClients(aMaxClients)
+    , theChannels(aConf.count("channels") > 0 ? aConf.getUint("channels") : 0)
     , theMutex()
     , theSecure(aSecure)
     , theConf(aConf)
-    , thePool() {
-  // noop
+    , thePool()
+    , theShared() {
+  if (theChannels > 0 and aConf("type") != "grpc") {
+    throw std::runtime_error("Shared clients not supported with type: " +
+                             aConf("type"));
+  }
 }
 
 std::pair<LambdaResponse, double>
 EdgeClientPool::operator()(const std::string&   aDestination,
                            const LambdaRequest& aReq,
                            const bool           aDry) {
+  return run(aDestination, [&aReq, aDry](EdgeClientInterface& aClient) {
+    return aClient.RunLambda(aReq.makeOneMoreHop(), aDry);
+  });
+}
+
+std::pair<LambdaResponse, double>
+EdgeClientPool::forward(const std::string&        aDestination,
+                        const rpc::LambdaRequest& aReq,
+                        const unsigned int        aTimeout) {
+  return run(aDestination, [&aReq, aTimeout](EdgeClientInterface& aClient) {
+    return aClient.Forward(aReq, aTimeout);
+  });
+}
+
+std::pair<LambdaResponse, double> EdgeClientPool::run(
+    const std::string&                                         aDestination,
+    const std::function<LambdaResponse(EdgeClientInterface&)>& aCall) {
   debugPrintPool();
 
   support::Chrono myChrono(true);
 
+  if (theChannels > 0) {
+    // reserve one slot or bail out immediately
+    auto& myShared = acquire(aDestination);
+    struct Releaser {
+      ~Releaser() {
+        theInFlight--;
+      }
+      std::atomic<size_t>& theInFlight;
+    } myReleaser{myShared.theInFlight};
+
+    // execute the lambda function on the next client, round robin
+    auto& myClient = *myShared.theClients[myShared.theNext++ %
+                                          myShared.theClients.size()];
+    auto  myResp   = aCall(myClient);
+    if (myResp.theResponder.empty()) {
+      myResp.theResponder = aDestination;
+    }
+    return std::make_pair(myResp, myChrono.stop());
+  }
+
   // obtain a client from the pool
   std::unique_ptr<EdgeClientInterface> myClient = getClient(aDestination);
   assert(myClient);
 
   // execute the lambda function
-  const auto myReq  = aReq.makeOneMoreHop();
-  auto       myResp = myClient->RunLambda(myReq, aDry);
+  auto myResp = aCall(*myClient);
 
   // if the lambda does not include the actual responder then we set it to
   // the destination
@@ -82,6 +124,15 @@ EdgeClientPool::operator()(const std::string&   aDestination,
   return std::make_pair(myResp, myChrono.stop());
 }
 
+EdgeClientPool::Reservation
+EdgeClientPool::reserve(const std::string& aDestination) {
+  if (theChannels == 0) {
+    return nullptr;
+  }
+  auto& myInFlight = acquire(aDestination).theInFlight;
+  return Reservation(nullptr, [&myInFlight](void*) { myInFlight--; });
+}
+
 std::unique_ptr<EdgeClientInterface>
 EdgeClientPool::getClient(const std::string& aDestination) {
   std::unique_lock<std::mutex> myLock(theMutex);
@@ -115,6 +166,31 @@ void EdgeClientPool::releaseClient(
   myDesc.theAvailableCond.notify_one();
 }
 
+EdgeClientPool::SharedDescriptor&
+EdgeClientPool::sharedClients(const std::string& aDestination) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  auto&                             myDesc = theShared[aDestination];
+  if (not myDesc) {
+    myDesc = std::make_unique<SharedDescriptor>();
+    for (size_t i = 0; i < theChannels; i++) {
+      myDesc->theClients.emplace_back(
+          std::make_unique<EdgeClientGrpc>(aDestination, theSecure, true));
+    }
+  }
+  return *myDesc;
+}
+
+EdgeClientPool::SharedDescriptor&
+EdgeClientPool::acquire(const std::string& aDestination) {
+  auto&      myShared   = sharedClients(aDestination);
+  const auto myInFlight = myShared.theInFlight.fetch_add(1);
+  if (theMaxClients > 0 and myInFlight >= theMaxClients) {
+    myShared.theInFlight--;
+    throw TooManyPendingRequests(aDestination, theMaxClients);
+  }
+  return myShared;
+}
+
 void EdgeClientPool::debugPrintPool() {
   if (VLOG_IS_ON(2)) {
     const std::lock_guard<std::mutex> myLock(theMutex);
@@ -125,6 +201,12 @@ void EdgeClientPool::debugPrintPool() {
             << ", free " << myDesc.second.theFree.size();
       myCur += myDesc.second.theFree.size();
     }
+    for (const auto& myDesc : theShared) {
+      myStr << "\ndest " << myDesc.first << ", in-flight "
+            << myDesc.second->theInFlight << ", shared "
+            << myDesc.second->theClients.size();
+      myCur += myDesc.second->theClients.size();
+    }
     LOG(INFO) << "pool total size " << myCur << ", max " << theMaxClients
               << myStr.str();
   }
@@ -36,19 +36,46 @@ SOFTWARE.
 #include "Support/conf.h"
 #include "Support/macros.h"
 
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
 
+//! Raised when too many requests are in progress towards a destination.
+struct TooManyPendingRequests : public std::runtime_error {
+  explicit TooManyPendingRequests(const std::string& aDestination,
+                                  const size_t       aLimit)
+      : std::runtime_error("Too many pending requests towards " +
+                           aDestination + " (limit " + std::to_string(aLimit) +
+                           ")") {
+  }
+};
+
 /**
  * A thread-safe pool of edge clients.
+ *
+ * By default, a client is used by a single lambda request at a time and
+ * a new one is created when all the existing clients towards the destination
+ * are busy. If the maximum number of clients is reached then the caller
+ * waits for one to become free.
+ *
+ * In shared mode, instead, a fixed number of clients is created for each
+ * destination, each with its own channel and TCP connection, which are used
+ * concurrently by all the callers. If the maximum number of requests in
+ * progress towards a destination is reached then the new requests are
+ * rejected immediately. The requests sent to a destination without using
+ * the clients of the pool, e.g., asynchronously, can be accounted for with
+ * reserve().
  */
 class EdgeClientPool
 {
@@ -64,6 +91,19 @@ class EdgeClientPool
     std::condition_variable                         theAvailableCond;
   };
 
+  //! Clients shared among all the callers towards a destination.
+  struct SharedDescriptor {
+    explicit SharedDescriptor()
+        : theClients()
+        , theNext(0)
+        , theInFlight(0) {
+    }
+
+    std::vector<std::unique_ptr<EdgeClientInterface>> theClients;
+    std::atomic<size_t>                               theNext;
+    std::atomic<size_t>                               theInFlight;
+  };
+
  public:
   NONCOPYABLE_NONMOVABLE(EdgeClientPool);
 
@@ -72,10 +112,16 @@ class EdgeClientPool
    *
    * \param aSecure If true then use SSL/TLS authentication.
    *
-   * \param aConf The edge client configuration.
+   * \param aConf The edge client configuration. If it contains the key
+   * channels=N, with N > 0, then the pool works in shared mode with N
+   * clients per destination, which is only supported with gRPC clients.
    *
-   * \param aMaxClients The maximum number of clients per destination. 0 means
+   * \param aMaxClients The maximum number of clients per destination or,
+   * in shared mode, of requests in progress per destination. 0 means
    * unlimited.
+   *
+   * \throw std::runtime_error if the shared mode is requested with a client
+   * type other than gRPC.
    */
   explicit EdgeClientPool(const bool           aSecure,
                           const support::Conf& aConf,
@@ -92,26 +138,86 @@ class EdgeClientPool
    * \param aDry If true do not actually execute the lambda function.
    *
    * \return the lambda response and the execution time.
+   *
+   * \throw TooManyPendingRequests in shared mode, if the maximum number of
+   * requests in progress towards the destination has been reached.
    */
   std::pair<LambdaResponse, double> operator()(const std::string& aDestination,
                                                const LambdaRequest& aReq,
                                                const bool           aDry);
 
+  /**
+   * Forward a lambda request received to a given edge computer, with one
+   * more hop. Same as above, but the request is not copied if the
+   * clients support it, see EdgeClientInterface::Forward().
+   *
+   * \param aDestination The edge computer end-point.
+   * \param aReq The lambda request received.
+   * \param aTimeout The time left to complete the execution of the lambda,
+   * in ms; 0 means no deadline.
+   *
+   * \return the lambda response and the execution time.
+   *
+   * \throw TooManyPendingRequests in shared mode, if the maximum number of
+   * requests in progress towards the destination has been reached.
+   */
+  std::pair<LambdaResponse, double> forward(const std::string& aDestination,
+                                            const rpc::LambdaRequest& aReq,
+                                            const unsigned int aTimeout);
+
+  //! Released when the last copy is destroyed.
+  using Reservation = std::shared_ptr<void>;
+
+  /**
+   * Reserve a request in progress towards a destination, for a lambda that
+   * is executed without using the clients of the pool.
+   *
+   * \param aDestination The edge computer end-point.
+   *
+   * \return the reservation, which must be kept until the lambda execution
+   * completes. In non-shared mode nothing is reserved.
+   *
+   * \throw TooManyPendingRequests in shared mode, if the maximum number of
+   * requests in progress towards the destination has been reached.
+   */
+  Reservation reserve(const std::string& aDestination);
+
  private:
+  //! Execute a lambda with a client towards the given destination.
+  std::pair<LambdaResponse, double>
+  run(const std::string&                                        aDestination,
+      const std::function<LambdaResponse(EdgeClientInterface&)>& aCall);
+
   std::unique_ptr<EdgeClientInterface>
   getClient(const std::string& aDestination);
 
   void releaseClient(const std::string&                     aDestination,
                      std::unique_ptr<EdgeClientInterface>&& aClient);
 
+  //! \return the shared clients towards a destination, created if needed.
+  SharedDescriptor& sharedClients(const std::string& aDestination);
+
+  /**
+   * Increment the number of requests in progress towards a destination.
+   *
+   * \return the shared clients towards the destination.
+   *
+   * \throw TooManyPendingRequests if the maximum has been reached.
+   */
+  SharedDescriptor& acquire(const std::string& aDestination);
+
   void debugPrintPool();
 
  private:
   const size_t                      theMaxClients;
+  const size_t                      theChannels;
   mutable std::mutex                theMutex;
   const bool                        theSecure;
   const support::Conf               theConf;
   std::map<std::string, Descriptor> thePool;
+
+  // shared mode only, elements are never removed
+  std::map<std::string, std::unique_ptr<SharedDescriptor>> theShared;
 };
 
 } // namespace edge
@@ -33,8 +33,8 @@ SOFTWARE.
 
 #include "Edge/Model/chain.h"
 #include "Edge/Model/dag.h"
-#include "Edge/callbackclient.h"
-#include "Edge/edgeclientgrpc.h"
+#include "Edge/callbacksender.h"
+#include "Edge/edgeclientgrpcasync.h"
 #include "Edge/edgemessages.h"
 #include "Edge/stateclient.h"
 #include "Support/threadpool.h"
@@ -47,8 +47,8 @@ SOFTWARE.
 namespace uiiit {
 namespace edge {
 
-EdgeComputer::AsyncWorker::AsyncWorker(
-    EdgeComputer& aParent, support::Queue<rpc::LambdaRequest>& aQueue)
+EdgeComputer::AsyncWorker::AsyncWorker(EdgeComputer&         aParent,
+                                       support::Queue<Task>& aQueue)
     : theParent(aParent)
     , theQueue(aQueue) {
   // noop
@@ -58,10 +58,11 @@ void EdgeComputer::AsyncWorker::operator()() {
   while (true) {
     try {
       // retrieve one of the pending function requests
-      auto myRequest = theQueue.pop();
+      const auto  myTask    = theQueue.pop();
+      const auto& myRequest = myTask.theRequest;
 
       // executes the lambda function (blocks)
-      auto myResp = theParent.blockingExecution(myRequest);
+      auto myResp = theParent.blockingExecution(myRequest, myTask.thePrefetch);
 
       // what follows depends on whether this is the last function
       // to be executed in the chain or not
@@ -69,6 +70,7 @@ void EdgeComputer::AsyncWorker::operator()() {
       // - exception thrown: do not proceed with execution, ignore invocation
       // - last function: send final response to callback
       // - non-last function: invoke next function in the chain via companion
+      //   (if the companion is not set, send an error response to callback)
 
       if (lastFunction(myRequest)) {
         myResp.set_responder(theParent.serverEndpoint());
@@ -76,12 +78,11 @@ void EdgeComputer::AsyncWorker::operator()() {
         myResp.set_retcode("OK");
 
         // send the response to the callback server indicated in the request
-        CallbackClient myClient(myRequest.callback());
         LambdaResponse myResponse(myResp);
         myResponse.removePtimeLoad();
         VLOG(3) << "sending response to " << myRequest.callback() << ", "
                 << myResponse;
-        myClient.ReceiveResponse(myResponse);
+        (*theParent.callbackSender())(myRequest.callback(), myResponse);
 
       } else {
         // functions to be invoked
@@ -117,15 +118,25 @@ void EdgeComputer::AsyncWorker::operator()() {
           }
         }
 
-        const std::lock_guard<std::mutex> myLock(theParent.theCompanionMutex);
-        if (theParent.theCompanionClient.get() == nullptr) {
+        std::string myCompanionEndpoint;
+        {
+          const std::lock_guard<std::mutex> myLock(
+              theParent.theCompanionMutex);
+          myCompanionEndpoint = theParent.theCompanionEndpoint;
+        }
+        if (myCompanionEndpoint.empty()) {
+          // the next functions cannot be invoked: notify the callback server
+          // so that the caller does not wait for a response that never comes
           LOG(ERROR) << "companion not set for " << theParent.serverEndpoint();
           myFunctions.clear(); // do not invoke functions
+          LambdaResponse myResponse("companion not set", "");
+          myResponse.theResponder = theParent.serverEndpoint();
+          myResponse.theHops      = myRequest.hops() + 1;
+          (*theParent.callbackSender())(myRequest.callback(), myResponse);
         }
-        const auto myCompanionEndpoint =
-            theParent.theCompanionClient->serverEndpoint();
 
-        // invoke all functions
+        // invoke all functions concurrently, without waiting for the
+        // immediate responses, which are checked upon reception
         for (const auto& elem : myFunctions) {
           const auto myNewRequest = LambdaRequest(myRequest).regenerate(
               elem.second, elem.first, myResp);
@@ -133,15 +144,21 @@ void EdgeComputer::AsyncWorker::operator()() {
           // send the next request, we expect immediate async response
           VLOG(3) << "invoking next function on " << myCompanionEndpoint << ", "
                   << myNewRequest;
-          const auto myImmediateResp =
-              theParent.theCompanionClient->RunLambda(myNewRequest, false);
-          LOG_IF(ERROR, myImmediateResp.theRetCode != "OK")
-              << "error when executing the next function in the chain via "
-              << myCompanionEndpoint << ": " << myImmediateResp.theRetCode;
-          LOG_IF(ERROR, not myImmediateResp.theAsynchronous)
-              << "received a synchronous response when executing the next "
-                 "function in the chain via "
-              << myCompanionEndpoint << ": result ignored";
+          theParent.theCompanionClient->RunLambda(
+              myCompanionEndpoint,
+              myNewRequest.toProtobuf(),
+              [myCompanionEndpoint](LambdaResponse&& aImmediateResp,
+                                    const double) {
+                LOG_IF(ERROR, not aImmediateResp.ok())
+                    << "error when executing the next function in the chain "
+                       "via "
+                    << myCompanionEndpoint << ": "
+                    << aImmediateResp.theRetCode;
+                LOG_IF(ERROR, not aImmediateResp.theAsynchronous)
+                    << "received a synchronous response when executing the "
+                       "next function in the chain via "
+                    << myCompanionEndpoint << ": result ignored";
+              });
         }
       }
     } catch (const support::QueueClosed&) {
@@ -168,17 +185,24 @@ EdgeComputer::EdgeComputer(const size_t       aNumThreads,
                            const std::string& aServerEndpoint,
                            const bool         aSecure)
     : EdgeServer(aServerEndpoint)
-    , theSecure(aSecure)
-    , theDescriptorsCv()
-    , theDescriptors()
+    , theCompletions(theCompletionSlots)
     , theAsyncWorkers(aNumThreads == 0 ? nullptr :
                                          std::make_unique<WorkersPool>())
     , theAsyncQueue(aNumThreads == 0 ?
                         nullptr :
-                        std::make_unique<support::Queue<rpc::LambdaRequest>>())
-    , theCompanionClient()
+                        std::make_unique<support::Queue<Task>>())
+    , theCallbackSender(
+          aNumThreads == 0 ?
+              nullptr :
+              std::make_shared<CallbackSender>(100, 1, 5000, 0, 0))
+    , theCompanionClient(aNumThreads == 0 ?
+                             nullptr :
+                             std::make_unique<EdgeClientGrpcAsync>(aSecure))
+    , theCompanionEndpoint()
     , theCompanionMutex()
     , theStateClient()
+    , theMigrations()
+    , theMigrators()
     , theInvocations() {
   if (aNumThreads > 0) {
     assert(theAsyncWorkers.get() != nullptr);
@@ -203,6 +227,14 @@ EdgeComputer::~EdgeComputer() {
     theAsyncWorkers->stop();
     theAsyncWorkers->wait();
   }
+
+  // the migrations already queued are completed
+  for (size_t i = 0; i < theMigrators.size(); i++) {
+    theMigrations.push(std::function<void()>());
+  }
+  for (auto& myMigrator : theMigrators) {
+    myMigrator.join();
+  }
 }
 
 void EdgeComputer::companion(const std::string& aCompanionEndpoint) {
@@ -217,20 +249,19 @@ void EdgeComputer::companion(const std::string& aCompanionEndpoint) {
   const std::lock_guard<std::mutex> myLock(theCompanionMutex);
   if (aCompanionEndpoint.empty()) {
     LOG(WARNING) << "clearing the companion end-point of " << serverEndpoint();
-    theCompanionClient.reset();
+    theCompanionEndpoint.clear();
     return;
   }
-  if (theCompanionClient.get() == nullptr) {
+  if (theCompanionEndpoint.empty()) {
     LOG(INFO) << "setting the companion end-point of " << serverEndpoint()
               << " to " << aCompanionEndpoint;
 
   } else {
     LOG(WARNING) << "changing the companion end-point of " << serverEndpoint()
-                 << " from " << theCompanionClient->serverEndpoint() << " to "
+                 << " from " << theCompanionEndpoint << " to "
                  << aCompanionEndpoint;
   }
-  theCompanionClient =
-      std::make_unique<EdgeClientGrpc>(aCompanionEndpoint, theSecure);
+  theCompanionEndpoint = aCompanionEndpoint;
 }
 
 void EdgeComputer::state(const std::string& aStateEndpoint) {
@@ -249,7 +280,34 @@ void EdgeComputer::state(const std::string& aStateEndpoint) {
                  << " from " << theStateClient->serverEndpoint() << " to "
                  << aStateEndpoint;
   }
-  theStateClient = std::make_unique<StateClient>(aStateEndpoint);
+  // the previous client, if in use, is destroyed by the last migration
+  theStateClient = std::make_shared<StateClient>(
+      aStateEndpoint, StateClient::theMaxChunkSize, theStateTimeout);
+
+  if (theMigrators.empty()) {
+    for (size_t i = 0; i < theMigrationThreads; i++) {
+      theMigrators.emplace_back([this]() { migrationLoop(); });
+    }
+  }
+}
+
+void EdgeComputer::callback(const size_t       aCacheSize,
+                            const size_t       aMaxBatch,
+                            const unsigned int aTimeout,
+                            const size_t       aMaxPending,
+                            const size_t       aNumThreads) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  if (theAsyncWorkers.get() == nullptr) {
+    throw std::runtime_error(
+        "cannot configure the callbacks of a synchronous edge computer");
+  }
+  LOG(INFO) << "callbacks of " << serverEndpoint() << ": cache size "
+            << aCacheSize << ", max batch " << aMaxBatch << ", timeout "
+            << aTimeout << " ms, max pending " << aMaxPending << ", threads "
+            << aNumThreads;
+  // the previous sender, if in use, is destroyed by the last worker using it
+  theCallbackSender = std::make_shared<CallbackSender>(
+      aCacheSize, aMaxBatch, aTimeout, aMaxPending, aNumThreads);
 }
 
 rpc::LambdaResponse EdgeComputer::process(const rpc::LambdaRequest& aReq) {
@@ -305,13 +363,13 @@ rpc::LambdaResponse EdgeComputer::process(const rpc::LambdaRequest& aReq) {
       } else {
         myResp.set_asynchronous(true);
         if (checkPreconditions(aReq)) {
-          theAsyncQueue->push(aReq);
+          theAsyncQueue->push(Task{aReq, prefetch(aReq)});
         }
       }
 
     } else {
       // actual execution of the lambda function
-      myResp    = blockingExecution(aReq);
+      myResp    = blockingExecution(aReq, prefetch(aReq));
       myRetCode = myResp.retcode();
     }
   } catch (const std::exception& aErr) {
@@ -326,37 +384,36 @@ rpc::LambdaResponse EdgeComputer::process(const rpc::LambdaRequest& aReq) {
 }
 
 rpc::LambdaResponse
-EdgeComputer::blockingExecution(const rpc::LambdaRequest& aReq) {
-  // the task must be added outside the critical section below
-  // to avoid deadlock due to a race condition on tasks
-  // that are very short (and become completed before
-  // a new descriptor is added to theDescriptors)
-  const auto myId = realExecution(aReq);
-
-  std::unique_lock<std::mutex> myLock(theMutex);
-
-  auto myNewDesc = std::make_unique<Descriptor>();
-
-  const auto myIt = theDescriptors.insert(std::make_pair(myId, nullptr));
-  assert(myIt.second);
-  myIt.first->second = std::move(myNewDesc);
-  theDescriptorsCv.notify_one();
-  auto& myDescriptor = *myIt.first->second;
+EdgeComputer::blockingExecution(const rpc::LambdaRequest&        aReq,
+                                const std::shared_ptr<Prefetch>& aPrefetch) {
+  rpc::LambdaResponse myResp;
+  try {
+    const auto      myId = realExecution(aReq);
+    support::Chrono myChrono(true);
 
-  // wait until we get a response
-  myDescriptor.theCondition.wait(
-      myLock, [&myDescriptor]() { return myDescriptor.theDone; });
+    // wait until we get a response, which may have been already received
+    // if the task is very short
+    const auto myResponse = theCompletions.wait(myId);
 
-  assert(myDescriptor.theResponse);
-  auto myResp = myDescriptor.theResponse->toProtobuf();
-  myResp.set_ptime(myDescriptor.theChrono.stop() * 1e3 + 0.5); // to ms
+    assert(myResponse);
+    myResp = myResponse->toProtobuf();
+    myResp.set_ptime(myChrono.stop() * 1e3 + 0.5); // to ms
 
-  if (not handleRemoteStates(aReq, myResp)) {
-    throw std::runtime_error("could not handle all the remote states");
+  } catch (...) {
+    if (aPrefetch) {
+      restoreRemoteStates(*aPrefetch);
+    }
+    throw;
   }
 
-  VLOG(2) << "number of busy descriptors " << theDescriptors.size();
-  theDescriptors.erase(myIt.first);
+  // the states are left where they were if the function has failed
+  if (aPrefetch) {
+    if (myResp.retcode() != "OK") {
+      restoreRemoteStates(*aPrefetch);
+    } else if (not handleRemoteStates(*aPrefetch, myResp)) {
+      throw std::runtime_error("could not handle all the remote states");
+    }
+  }
 
   return myResp;
 }
@@ -419,16 +476,22 @@ std::string EdgeComputer::makeHash(const rpc::LambdaRequest& aRequest) {
   return std::to_string(aRequest.nextfunctionindex()) + "-" + aRequest.uuid();
 }
 
-bool EdgeComputer::handleRemoteStates(const rpc::LambdaRequest& aRequest,
-                                      rpc::LambdaResponse& aResponse) const {
+std::shared_ptr<EdgeComputer::Prefetch>
+EdgeComputer::prefetch(const rpc::LambdaRequest& aRequest) {
+  std::shared_ptr<Prefetch>    ret;
+  std::shared_ptr<StateClient> myStateClient;
   for (const auto& elem : aRequest.states()) {
     // the state is embedded in the message
     if (elem.second.location().empty()) {
       continue;
     }
 
+    if (not myStateClient) {
+      myStateClient = stateClient();
+    }
+
     // the state is stored on the local state server
-    if (elem.second.location() == stateClient().serverEndpoint()) {
+    if (elem.second.location() == myStateClient->serverEndpoint()) {
       continue;
     }
 
@@ -450,39 +513,115 @@ bool EdgeComputer::handleRemoteStates(const rpc::LambdaRequest& aRequest,
       continue;
     }
 
-    // retrieve from remote server
-    StateClient myStateClient(elem.second.location());
-    std::string myContent;
-    if (not myStateClient.Get(elem.first, myContent)) {
-      throw std::runtime_error("could not find state in " +
-                               elem.second.location() + ": " + elem.first);
+    if (not ret) {
+      ret              = std::make_shared<Prefetch>();
+      ret->theEndpoint = myStateClient->serverEndpoint();
+    }
+
+    // move from the remote server to the local one, which also deletes
+    // the state from the remote server
+    ret->theStates.emplace_back(
+        elem.first,
+        elem.second.location(),
+        migrate(myStateClient, elem.first, elem.second.location()));
+  }
+  return ret;
+}
+
+bool EdgeComputer::handleRemoteStates(Prefetch&            aPrefetch,
+                                      rpc::LambdaResponse& aResponse) {
+  // wait for all the migrations, even if one has failed
+  auto ret = true;
+  for (auto& elem : aPrefetch.theStates) {
+    if (not elem.wait()) {
+      LOG(ERROR) << "could not migrate state to " << aPrefetch.theEndpoint
+                 << ": " << elem.theName;
+      ret = false;
     }
+  }
 
-    // copy into local server
-    stateClient().Put(elem.first, myContent);
-    // delete from remote server
-    const auto ret = myStateClient.Del(elem.first);
-    LOG_IF(WARNING, ret == false)
-        << "state removed during access on " << elem.second.location() << ": "
-        << elem.first;
+  if (not ret) {
+    restoreRemoteStates(aPrefetch);
+    return false;
+  }
 
-    // update location of the state on the response
-    auto it = aResponse.mutable_states()->find(elem.first);
+  // update location of the states on the response
+  for (const auto& elem : aPrefetch.theStates) {
+    auto it = aResponse.mutable_states()->find(elem.theName);
     if (it == aResponse.mutable_states()->end()) {
       throw std::runtime_error("could not find state in the response: " +
-                               elem.first);
+                               elem.theName);
     }
-    it->second.set_location(stateClient().serverEndpoint());
+    it->second.set_location(aPrefetch.theEndpoint);
   }
   return true;
 }
 
-StateClient& EdgeComputer::stateClient() const {
+void EdgeComputer::restoreRemoteStates(Prefetch& aPrefetch) {
+  std::list<Migration> myRestores;
+  for (auto& elem : aPrefetch.theStates) {
+    if (not elem.wait()) {
+      continue; // the state has not moved
+    }
+    auto myClient = std::make_shared<StateClient>(
+        elem.theLocation, StateClient::theMaxChunkSize, theStateTimeout);
+    myRestores.emplace_back(
+        elem.theName,
+        elem.theLocation,
+        migrate(myClient, elem.theName, aPrefetch.theEndpoint));
+  }
+
+  for (auto& elem : myRestores) {
+    LOG_IF(ERROR, not elem.wait())
+        << "could not move state back from " << aPrefetch.theEndpoint
+        << " to " << elem.theLocation << ": " << elem.theName;
+  }
+}
+
+std::future<bool>
+EdgeComputer::migrate(const std::shared_ptr<StateClient>& aClient,
+                      const std::string&                  aName,
+                      const std::string&                  aLocation) {
+  auto myTask = std::make_shared<std::packaged_task<bool()>>(
+      [aClient, aName, aLocation]() {
+        try {
+          return aClient->Migrate(aName, aLocation);
+        } catch (const std::exception& aErr) {
+          LOG(ERROR) << "exception raised when migrating state " << aName
+                     << " from " << aLocation << " to "
+                     << aClient->serverEndpoint() << ": " << aErr.what();
+        }
+        return false;
+      });
+  auto ret = myTask->get_future();
+  theMigrations.push([myTask]() { (*myTask)(); });
+  return ret;
+}
+
+void EdgeComputer::migrationLoop() {
+  while (true) {
+    const auto myMigration = theMigrations.pop();
+    if (not myMigration) {
+      break;
+    }
+    myMigration();
+  }
+}
+
+std::shared_ptr<CallbackSender> EdgeComputer::callbackSender() {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  assert(theCallbackSender);
+  return theCallbackSender;
+}
+
+std::shared_ptr<StateClient> EdgeComputer::stateClient() const {
+  // the state client can be changed at run-time via state()
+  const std::lock_guard<std::mutex> myLock(theMutex);
   if (theStateClient.get() == nullptr) {
     throw std::runtime_error(
         "cannot handle remote states without a state server");
   }
-  return *theStateClient;
+  return theStateClient;
 }
 
 void EdgeComputer::taskDone(
@@ -490,21 +629,7 @@ void EdgeComputer::taskDone(
     const std::shared_ptr<const LambdaResponse>& aResponse) {
   VLOG(2) << "task " << aId << " done: " << aResponse->theRetCode;
 
-  std::unique_lock<std::mutex> myLock(theMutex);
-
-  // wait until the descriptor has been inserted into the map
-  // this wait should be null in most cases and always very short:
-  // consider a spinlock instead of a condition variable
-  theDescriptorsCv.wait(
-      myLock, [this, aId]() { return theDescriptors.count(aId) == 1; });
-
-  const auto myIt = theDescriptors.find(aId);
-  assert(myIt != theDescriptors.end());
-
-  assert(static_cast<bool>(myIt->second));
-  myIt->second->theResponse = aResponse;
-  myIt->second->theDone     = true;
-  myIt->second->theCondition.notify_one();
+  theCompletions.post(aId, aResponse);
 }
 
 } // namespace edge
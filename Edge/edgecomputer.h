@@ -31,11 +31,20 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/completionslab.h"
 #include "Edge/edgeserver.h"
 #include "Support/chrono.h"
 #include "Support/queue.h"
 
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace uiiit {
 
@@ -46,7 +55,8 @@ class ThreadPool;
 
 namespace edge {
 
-class EdgeClientGrpc;
+class CallbackSender;
+class EdgeClientGrpcAsync;
 class StateClient;
 
 /**
@@ -91,37 +101,68 @@ class StateClient;
  */
 class EdgeComputer : public EdgeServer
 {
-  /**
-   * Descriptor for a pending lambda request.
-   *
-   * Created as a new lambda request arrives, destroyed immediately after the
-   * lambda response is generated. A chronometer is started automatically upon
-   * creation.
-   */
-  struct Descriptor {
-    explicit Descriptor()
-        : theCondition()
-        , theResponse()
-        , theDone(false)
-        , theChrono(true) {
+  //! Number of slots used to hand off the responses of the tasks completed.
+  static constexpr size_t theCompletionSlots = 1024;
+
+  //! Number of threads migrating states between state servers.
+  static constexpr size_t theMigrationThreads = 4;
+
+  //! Deadline of the calls to the state servers, in ms.
+  static constexpr unsigned int theStateTimeout = 10000;
+
+  //! Migration of a remote state to the local state server.
+  struct Migration {
+    explicit Migration(const std::string&  aName,
+                       const std::string&  aLocation,
+                       std::future<bool>&& aDone)
+        : theName(aName)
+        , theLocation(aLocation)
+        , theDone(std::move(aDone))
+        , theMigrated(false) {
+      // noop
     }
-    std::condition_variable               theCondition;
-    std::shared_ptr<const LambdaResponse> theResponse;
-    bool                                  theDone;
-    support::Chrono                       theChrono;
+
+    //! Wait for the migration to complete. \return true if successful.
+    bool wait() {
+      if (theDone.valid()) {
+        theMigrated = theDone.get();
+      }
+      return theMigrated;
+    }
+
+    // name of the state
+    std::string theName;
+    // end-point of the state server where the state was
+    std::string theLocation;
+    // outcome of the migration, until waited for
+    std::future<bool> theDone;
+    bool              theMigrated;
+  };
+
+  //! Remote states being migrated to the local state server.
+  struct Prefetch {
+    // end-point of the local state server
+    std::string theEndpoint;
+    // migrations in progress
+    std::list<Migration> theStates;
+  };
+
+  //! Asynchronous function request waiting for execution.
+  struct Task {
+    rpc::LambdaRequest        theRequest;
+    std::shared_ptr<Prefetch> thePrefetch;
   };
 
   class AsyncWorker final
   {
    public:
-    explicit AsyncWorker(EdgeComputer&                       aParent,
-                         support::Queue<rpc::LambdaRequest>& aQueue);
+    explicit AsyncWorker(EdgeComputer& aParent, support::Queue<Task>& aQueue);
     void operator()();
     void stop();
 
    private:
-    EdgeComputer&                       theParent;
-    support::Queue<rpc::LambdaRequest>& theQueue;
+    EdgeComputer&         theParent;
+    support::Queue<Task>& theQueue;
   };
 
  public:
@@ -173,6 +214,33 @@ class EdgeComputer : public EdgeServer
    */
   void state(const std::string& aStateEndpoint);
 
+  /**
+   * @brief Configure the delivery of the responses to the callback servers.
+   *
+   * By default, up to 100 callback clients are cached and the responses
+   * are sent one at a time, with a deadline of 5 s.
+   *
+   * @param aCacheSize the maximum number of callback clients cached.
+   *
+   * @param aMaxBatch if greater than 1, then responses are sent in batches
+   * of up to this size via streaming calls, see CallbackSender.
+   *
+   * @param aTimeout the deadline of every call, in ms; 0 means no deadline.
+   *
+   * @param aMaxPending with batches, the maximum number of responses queued,
+   * beyond which they are dropped; 0 means unlimited.
+   *
+   * @param aNumThreads with batches, the number of threads sending them.
+   *
+   * @throw std::runtime_error if this edge computer is synchronous only,
+   * the cache size is zero, or batches are enabled with no threads.
+   */
+  void callback(const size_t       aCacheSize,
+                const size_t       aMaxBatch,
+                const unsigned int aTimeout,
+                const size_t       aMaxPending,
+                const size_t       aNumThreads);
+
  protected:
   //! Callback invoked by the computer once a task is complete.
   void taskDone(const uint64_t                               aId,
@@ -182,8 +250,17 @@ class EdgeComputer : public EdgeServer
   //! Perform actual processing of a lambda request.
   rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override;
 
-  //! Execute a lambda function (blocks until done).
-  rpc::LambdaResponse blockingExecution(const rpc::LambdaRequest& aReq);
+  /**
+   * Execute a lambda function (blocks until done).
+   *
+   * \param aReq the lambda request.
+   *
+   * \param aPrefetch the remote states needed, which are being migrated to
+   * the local state server, see prefetch(). Can be null.
+   */
+  rpc::LambdaResponse
+  blockingExecution(const rpc::LambdaRequest&        aReq,
+                    const std::shared_ptr<Prefetch>& aPrefetch);
 
   /**
    * Starts the execution of a lambda function.
@@ -198,29 +275,76 @@ class EdgeComputer : public EdgeServer
                               std::array<double, 3>&    aLastUtils) = 0;
 
   //! Return a client to access the local state server or throw.
-  StateClient& stateClient() const;
+  std::shared_ptr<StateClient> stateClient() const;
+
+  //! Return the object used to send responses to callback servers.
+  std::shared_ptr<CallbackSender> callbackSender();
 
   /**
-   * @brief Handle remote states.
-   *
-   * Retrieve the remote states from the requests.
-   * If the request contains a chain or DAG, then we only retrieve those
-   * neeed by the current function. Otherwise, we retrieve all the
-   * remote states.
+   * @brief Start migrating the remote states to the local state server.
    *
-   * The remote states retrieved are then deleted from the original
-   * location and the location is updated in the response.
+   * Only the states on which the current function depends are migrated,
+   * concurrently by a fixed pool of threads, through direct transfers
+   * between the state servers, which overlap with the queueing and execution
+   * of the function. If the function fails the states are moved back, see
+   * restoreRemoteStates().
    *
-   * Embedded states are left unchanged.
+   * Embedded states and those already on the local state server are left
+   * unchanged.
    *
    * @param aRequest the lambda request.
+   *
+   * @return the migrations in progress, or a null pointer if there are no
+   * remote states to migrate.
+   *
+   * @throw std::runtime_error if there are remote states but no local
+   * state server.
+   */
+  std::shared_ptr<Prefetch> prefetch(const rpc::LambdaRequest& aRequest);
+
+  /**
+   * @brief Handle remote states after a successful execution.
+   *
+   * Wait for the migrations started by prefetch() to complete, then
+   * update the location of the states migrated in the response.
+   *
+   * If any migration has failed, the states migrated are moved back to
+   * where they were and the response is left unchanged.
+   *
+   * @param aPrefetch the migrations in progress.
    * @param aResponse the lamba response with modified states.
    *
    * @return true if all the states were retrieved with success.
    * @return false otherwise.
    */
-  bool handleRemoteStates(const rpc::LambdaRequest& aRequest,
-                          rpc::LambdaResponse&      aResponse) const;
+  bool handleRemoteStates(Prefetch& aPrefetch, rpc::LambdaResponse& aResponse);
+
+  /**
+   * @brief Move the states migrated by prefetch() back to where they were.
+   *
+   * Wait for all the migrations to complete, then start the reverse
+   * migrations of the successful ones and wait for them, too.
+   *
+   * @param aPrefetch the migrations in progress.
+   */
+  void restoreRemoteStates(Prefetch& aPrefetch);
+
+  /**
+   * @brief Queue the migration of a state to the pool of threads.
+   *
+   * @param aClient the client of the state server of destination.
+   * @param aName the state name.
+   * @param aLocation the end-point of the server that has the state now.
+   *
+   * @return the outcome of the migration, which is false also if an
+   * exception is thrown.
+   */
+  std::future<bool> migrate(const std::shared_ptr<StateClient>& aClient,
+                            const std::string&                  aName,
+                            const std::string&                  aLocation);
+
+  //! Body of the threads running migrations, until an empty one is found.
+  void migrationLoop();
 
   /**
    * @brief Check if the preconditions for running this request are satisfied.
@@ -257,22 +381,33 @@ class EdgeComputer : public EdgeServer
   static std::string makeHash(const rpc::LambdaRequest& aRequest);
 
  private:
-  const bool theSecure;
-
-  std::condition_variable                         theDescriptorsCv;
-  std::map<uint64_t, std::unique_ptr<Descriptor>> theDescriptors;
+  // responses of the tasks completed, indexed by task identifier, which are
+  // handed off to blockingExecution() without acquiring theMutex
+  detail::CompletionSlab<std::shared_ptr<const LambdaResponse>> theCompletions;
 
   // only for asynchronous responses (if num threads > 1)
   using WorkersPool = support::ThreadPool<std::unique_ptr<AsyncWorker>>;
-  const std::unique_ptr<WorkersPool>                        theAsyncWorkers;
-  const std::unique_ptr<support::Queue<rpc::LambdaRequest>> theAsyncQueue;
+  const std::unique_ptr<WorkersPool>          theAsyncWorkers;
+  const std::unique_ptr<support::Queue<Task>> theAsyncQueue;
 
-  // only for function chains and DAGs, which are asynchronous by default
-  std::unique_ptr<EdgeClientGrpc> theCompanionClient;
-  std::mutex                      theCompanionMutex;
+  // only for asynchronous responses, protected by theMutex
+  std::shared_ptr<CallbackSender> theCallbackSender;
 
-  // only for remote states
-  std::unique_ptr<StateClient> theStateClient;
+  // only for function chains and DAGs, which are asynchronous by default
+  // the client is shared by all the workers, which invoke the next functions
+  // concurrently, while the mutex only protects the end-point
+  std::unique_ptr<EdgeClientGrpcAsync> theCompanionClient;
+  std::string                          theCompanionEndpoint;
+  std::mutex                           theCompanionMutex;
+
+  // only for remote states, protected by theMutex
+  // the client is shared by the migrations in progress
+  std::shared_ptr<StateClient> theStateClient;
+
+  // only for remote states, the threads are started with the first state
+  // end-point and protected by theMutex
+  support::Queue<std::function<void()>> theMigrations;
+  std::vector<std::thread>              theMigrators;
 
   // only for DAGs
   // key:   a hash of the request
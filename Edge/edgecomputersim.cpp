@@ -62,12 +62,15 @@ EdgeComputerSim::EdgeComputerSim(const std::string&  aServerEndpoint,
 }
 
 uint64_t EdgeComputerSim::realExecution(const rpc::LambdaRequest& aRequest) {
-  return theComputer.addTask(LambdaRequest(aRequest));
+  // the payloads of the request are not copied: this is safe because
+  // the response, which may share the states, is serialized by
+  // blockingExecution() before aRequest goes out of scope
+  return theComputer.addTask(LambdaRequest::view(aRequest));
 }
 
 double EdgeComputerSim::dryExecution(const rpc::LambdaRequest& aRequest,
                                      std::array<double, 3>&    aLastUtils) {
-  return theComputer.simTask(LambdaRequest(aRequest), aLastUtils);
+  return theComputer.simTask(LambdaRequest::view(aRequest), aLastUtils);
 }
 
 } // namespace edge
@@ -38,6 +38,8 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <stdexcept>
+
 namespace uiiit {
 namespace edge {
 
@@ -56,7 +58,14 @@ EdgeDispatcher::EdgeDispatcher(const std::string&   aLambdaEndpoint,
                           aClientConf)
     , thePtimeEstimator(
           PtimeEstimatorFactory::make(aSecure, aPtimeEstimatorConf)) {
-  // noop
+  // the processing time estimators expect one destination per lambda request
+  if (hedging()) {
+    throw std::runtime_error("Hedged requests not supported by dispatchers");
+  }
+}
+
+EdgeDispatcher::~EdgeDispatcher() {
+  stop();
 }
 
 std::vector<ForwardingTableInterface*> EdgeDispatcher::tables() {
@@ -65,15 +74,17 @@ std::vector<ForwardingTableInterface*> EdgeDispatcher::tables() {
   return myRet;
 }
 
-std::string EdgeDispatcher::destination(const rpc::LambdaRequest& aReq) {
-  return (*thePtimeEstimator)(aReq);
+std::string EdgeDispatcher::destination(const rpc::LambdaRequest& aReq,
+                                        Token&                    aToken) {
+  return (*thePtimeEstimator)(aReq, aToken);
 }
 
 void EdgeDispatcher::processSuccess(const rpc::LambdaRequest& aReq,
+                                    const Token               aToken,
                                     const std::string&        aDestination,
                                     const LambdaResponse&     aRep,
                                     const double              aTime) {
-  thePtimeEstimator->processSuccess(aReq, aDestination, aRep, aTime);
+  thePtimeEstimator->processSuccess(aReq, aToken, aDestination, aRep, aTime);
 }
 
 void EdgeDispatcher::processFailure(const rpc::LambdaRequest& aReq,
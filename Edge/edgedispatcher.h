@@ -86,14 +86,19 @@ class EdgeDispatcher final : public EdgeLambdaProcessor
                           const support::Conf& aPtimeEstimatorConf,
                           const support::Conf& aClientConf);
 
+  //! Stop the asynchronous forwards before destroying the estimator.
+  ~EdgeDispatcher() override;
+
   std::vector<ForwardingTableInterface*> tables() override;
 
  private:
   //! \return the destination associated to the given lambda request.
-  std::string destination(const rpc::LambdaRequest& aReq) override;
+  std::string destination(const rpc::LambdaRequest& aReq,
+                          Token&                    aToken) override;
 
   //! Called upon successful execution of a lambda function on a computer.
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override;
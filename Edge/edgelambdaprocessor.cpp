@@ -31,6 +31,7 @@ SOFTWARE.
 
 #include "edgelambdaprocessor.h"
 
+#include "Support/chrono.h"
 #include "Support/conf.h"
 #include "Support/random.h"
 #include "edgecontrollerclient.h"
@@ -40,12 +41,58 @@ SOFTWARE.
 
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <stdexcept>
 #include <thread>
 
 namespace uiiit {
 namespace edge {
 
+namespace {
+
+//! State shared by the calls of a hedged lambda request.
+struct HedgedRound {
+  HedgedRound()
+      : theMutex()
+      , theCond()
+      , thePending(0)
+      , theSuccess(false)
+      , theResponse()
+      , theResponder()
+      , theTime(0)
+      , theFailed() {
+    // noop
+  }
+
+  std::mutex              theMutex;
+  std::condition_variable theCond;
+  size_t                  thePending;
+  bool                    theSuccess;
+  // first successful response, or the latest failure if none succeeded
+  std::unique_ptr<LambdaResponse> theResponse;
+  std::string                     theResponder;
+  double                          theTime;
+  // destinations that have answered with a failure
+  std::vector<std::string> theFailed;
+};
+
+//! Wait on a condition until a deadline, which can be max() for no deadline.
+template <class PREDICATE>
+bool waitUntil(std::unique_lock<std::mutex>&                aLock,
+               std::condition_variable&                     aCond,
+               const std::chrono::steady_clock::time_point& aDeadline,
+               PREDICATE                                    aPredicate) {
+  if (aDeadline == std::chrono::steady_clock::time_point::max()) {
+    aCond.wait(aLock, aPredicate);
+    return true;
+  }
+  return aCond.wait_until(aLock, aDeadline, aPredicate);
+}
+
+} // namespace
+
 EdgeLambdaProcessor::EdgeLambdaProcessor(const std::string& aLambdaEndpoint,
                                          const std::string& aCommandsEndpoint,
                                          const std::string& aControllerEndpoint,
@@ -57,13 +104,38 @@ EdgeLambdaProcessor::EdgeLambdaProcessor(const std::string& aLambdaEndpoint,
     , theControllerEndpoint(aControllerEndpoint)
     , theFakeProcessor(aRouterConf.count("fake") > 0 and
                        aRouterConf.getBool("fake"))
+    , theAsync(aRouterConf.count("async") > 0 and aRouterConf.getBool("async"))
+    , theTimeout(aRouterConf.count("timeout") > 0 ?
+                     static_cast<unsigned int>(
+                         0.5 + aRouterConf.getDouble("timeout") * 1e3) :
+                     0)
+    , theMaxPending(aRouterConf.count("max-pending") > 0 ?
+                        aRouterConf.getUint("max-pending") :
+                        0)
+    , thePending(0)
+    , theStopped(false)
     , theClientPool(
           aSecure, aClientConf, aRouterConf.getUint("max-pending-clients"))
+    , theHedgingDelay(
+          aRouterConf.count("hedge-percentile") > 0 and
+                  aRouterConf.getDouble("hedge-percentile") > 0 ?
+              std::make_unique<HedgingDelay>(
+                  aRouterConf.getDouble("hedge-percentile"),
+                  aRouterConf.count("hedge-window") > 0 ?
+                      aRouterConf.getUint("hedge-window") :
+                      100) :
+              nullptr)
+    , theAsyncClient(theAsync or theHedgingDelay ?
+                         std::make_unique<EdgeClientGrpcAsync>(aSecure) :
+                         nullptr)
     , theControllerClient(aControllerEndpoint.empty() ?
                               nullptr :
                               new EdgeControllerClient(aControllerEndpoint))
     , theRandomWaiter(aRouterConf.getDouble("min-forward-time"),
-                      aRouterConf.getDouble("max-forward-time")) {
+                      aRouterConf.getDouble("max-forward-time"))
+    , theRetryMutex()
+    , theRetries()
+    , theRetryThread() {
   LOG(INFO) << "Created an EdgeLambdaProcessor with max-pending-clients "
             << aRouterConf.getUint("max-pending-clients") << ", forward-time ["
             << (aRouterConf.getDouble("min-forward-time") * 1e3) << ","
@@ -73,6 +145,29 @@ EdgeLambdaProcessor::EdgeLambdaProcessor(const std::string& aLambdaEndpoint,
   LOG_IF(INFO, aControllerEndpoint.empty())
       << "No controller specified: announce disabled";
   LOG_IF(INFO, theFakeProcessor) << "FAKE edge lambda processor configuration";
+  LOG_IF(INFO, theAsync) << "Asynchronous forwarding of lambdas enabled";
+  LOG_IF(INFO, theTimeout > 0)
+      << "Default deadline of lambdas " << theTimeout << " ms";
+  LOG_IF(INFO, theMaxPending > 0)
+      << "Maximum number of lambdas in progress " << theMaxPending;
+  LOG_IF(INFO, theHedgingDelay)
+      << "Hedged requests enabled at percentile "
+      << aRouterConf.getDouble("hedge-percentile");
+
+  if (theAsyncClient and aClientConf.count("type") > 0 and
+      aClientConf("type") != "grpc") {
+    throw std::runtime_error("Asynchronous forwarding and hedged requests not "
+                             "supported with client type: " +
+                             aClientConf("type"));
+  }
+  if (theAsync and theHedgingDelay) {
+    throw std::runtime_error(
+        "Hedged requests not supported with asynchronous forwarding");
+  }
+
+  if (theAsync) {
+    theRetryThread = std::thread([this]() { retryLoop(); });
+  }
 }
 
 void EdgeLambdaProcessor::init([
@@ -86,6 +181,27 @@ void EdgeLambdaProcessor::init([
 }
 
 EdgeLambdaProcessor::~EdgeLambdaProcessor() {
+  stop();
+}
+
+void EdgeLambdaProcessor::stop() {
+  {
+    const std::lock_guard<std::mutex> myLock(theRetryMutex);
+    if (theStopped) {
+      return;
+    }
+    theStopped = true;
+  }
+
+  // no retry can be added after the termination of the retry thread, and
+  // the forwards cancelled are not retried
+  if (theRetryThread.joinable()) {
+    theRetries.push(std::function<void()>());
+    theRetryThread.join();
+  }
+  if (theAsyncClient) {
+    theAsyncClient->stop();
+  }
 }
 
 std::string EdgeLambdaProcessor::defaultConf() {
@@ -94,6 +210,25 @@ std::string EdgeLambdaProcessor::defaultConf() {
 
 rpc::LambdaResponse
 EdgeLambdaProcessor::process(const rpc::LambdaRequest& aReq) {
+  if (not admit()) {
+    rpc::LambdaResponse myResp;
+    myResp.set_retcode("overloaded");
+    return myResp;
+  }
+
+  try {
+    auto ret = forwardSync(aReq, deadline(aReq));
+    release();
+    return ret;
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+rpc::LambdaResponse
+EdgeLambdaProcessor::forwardSync(const rpc::LambdaRequest& aReq,
+                                 const Deadline&           aDeadline) {
   std::string myRetCode        = "OK";
   auto        myNoDestinations = false;
 
@@ -103,42 +238,63 @@ EdgeLambdaProcessor::process(const rpc::LambdaRequest& aReq) {
       myRetCode = "loop detected";
       break;
     }
+    if (expired(aDeadline)) {
+      myRetCode = "deadline exceeded";
+      break;
+    }
     std::string myDestination;
+    Token       myToken = 0;
     try {
-      myDestination = destination(aReq);
+      myDestination = destination(aReq, myToken);
 
       theRandomWaiter();
 
+      // the request is forwarded as it is, with the time left until deadline
+      const auto myTimeout = timeLeft(aDeadline);
+
       // if this is fake processor then we do not contact the next
       // destination, but rather return immediately a fake OK response
       const auto ret =
           theFakeProcessor ?
               std::make_pair(LambdaResponse("OK", ""), 0.001 + random()) :
-              theClientPool(myDestination, LambdaRequest(aReq), false);
+              theHedgingDelay ?
+              hedged(aReq, aDeadline, myDestination, myToken) :
+              theClientPool.forward(myDestination, aReq, myTimeout);
 
       myRetCode = ret.first.theRetCode;
 
-      if (myRetCode == "OK") {
-        processSuccess(aReq, myDestination, ret.first, ret.second);
+      if (ret.first.ok()) {
+        if (theHedgingDelay) {
+          theHedgingDelay->add(aReq.name(), ret.second);
+        }
+        processSuccess(aReq, myToken, myDestination, ret.first, ret.second);
         return ret.first.toProtobuf();
       } else {
         VLOG(3) << "error received, " << ret.first;
       }
 
+    } catch (const TooManyPendingRequests& aErr) {
+      // the destination is busy, not faulty: do not purge it
+      myRetCode = aErr.what();
+      break;
     } catch (const std::exception& aErr) {
       myRetCode = aErr.what();
     } catch (...) {
       myRetCode = "Unknown error";
     }
 
+    // the destination may be only slow, and in any case there is no time left
+    // to try another one
+    assert(myRetCode != "OK");
+    if (expired(aDeadline)) {
+      myRetCode = "deadline exceeded";
+      break;
+    }
+
     // purge this entry from both the local table and the controller if there
     // have been errors
-    assert(myRetCode != "OK");
     if (not myDestination.empty()) {
-      processFailure(aReq, myDestination);
-      controllerCommand([&myDestination](EdgeControllerClient& aClient) {
-        aClient.removeComputer(myDestination);
-      });
+      purgeDestination(aReq, myDestination);
     } else {
       myNoDestinations = true;
     }
@@ -149,6 +305,405 @@ EdgeLambdaProcessor::process(const rpc::LambdaRequest& aReq) {
   return myResp;
 }
 
+std::pair<LambdaResponse, double>
+EdgeLambdaProcessor::hedged(const rpc::LambdaRequest& aReq,
+                            const Deadline&           aDeadline,
+                            std::string&              aDestination,
+                            Token&                    aToken) {
+  assert(theAsyncClient);
+  assert(theHedgingDelay);
+
+  const auto myRound = std::make_shared<HedgedRound>();
+  const auto myDone  = [&myRound]() {
+    return myRound->theSuccess or myRound->thePending == 0;
+  };
+  const auto mySend = [this, &aReq, &aDeadline, &myRound](
+                          const std::string& aDest) {
+    const auto myReservation = theClientPool.reserve(aDest);
+    {
+      const std::lock_guard<std::mutex> myLock(myRound->theMutex);
+      myRound->thePending++;
+    }
+    try {
+      return theAsyncClient->Forward(
+          aDest,
+          aReq,
+          timeLeft(aDeadline),
+          [myRound, aDest, myReservation](LambdaResponse&& aRep,
+                                          const double     aTime) {
+            const std::lock_guard<std::mutex> myLock(myRound->theMutex);
+            assert(myRound->thePending > 0);
+            myRound->thePending--;
+            if (not aRep.ok()) {
+              myRound->theFailed.emplace_back(aDest);
+            }
+            if (not myRound->theSuccess) {
+              myRound->theSuccess = aRep.ok();
+              if (aRep.theResponder.empty()) {
+                aRep.theResponder = aDest;
+              }
+              myRound->theResponse =
+                  std::make_unique<LambdaResponse>(std::move(aRep));
+              myRound->theResponder = aDest;
+              myRound->theTime      = aTime;
+            }
+            myRound->theCond.notify_one();
+          });
+    } catch (...) {
+      const std::lock_guard<std::mutex> myLock(myRound->theMutex);
+      myRound->thePending--;
+      throw;
+    }
+  };
+
+  support::Chrono myChrono(true);
+  const auto      myPrimaryId = mySend(aDestination);
+
+  const auto myDelay = (*theHedgingDelay)(aReq.name());
+
+  std::string                  mySecondary;
+  Token                        mySecondaryToken = 0;
+  EdgeClientGrpcAsync::Id      mySecondaryId    = 0;
+  std::unique_lock<std::mutex> myLock(myRound->theMutex);
+  if (myDelay >= 0 and
+      not waitUntil(myLock,
+                    myRound->theCond,
+                    std::min(aDeadline,
+                             std::chrono::steady_clock::now() +
+                                 std::chrono::microseconds(
+                                     static_cast<long>(myDelay * 1e6))),
+                    myDone) and
+      not expired(aDeadline)) {
+    // the primary destination is late, but there is still time left: send a
+    // copy of the lambda to another destination, if there is one
+    myLock.unlock();
+    for (auto i = 0; i < 3 and mySecondary.empty(); i++) {
+      try {
+        mySecondary = destination(aReq, mySecondaryToken);
+      } catch (...) {
+        break;
+      }
+      if (mySecondary == aDestination) {
+        mySecondary.clear();
+      }
+    }
+    if (not mySecondary.empty()) {
+      VLOG(2) << "hedging " << aReq.name() << " to " << mySecondary
+              << " after " << (myDelay * 1e3) << " ms";
+      try {
+        mySecondaryId = mySend(mySecondary);
+      } catch (const std::exception& aErr) {
+        VLOG(2) << "could not send hedged request to " << mySecondary << ": "
+                << aErr.what();
+        mySecondary.clear();
+      }
+    }
+    myLock.lock();
+  }
+
+  const auto myCompleted =
+      waitUntil(myLock, myRound->theCond, aDeadline, myDone);
+
+  // the call that has not answered yet, if any, is not needed anymore: its
+  // callback only releases the resources of the round
+  theAsyncClient->cancel(myPrimaryId);
+  if (not mySecondary.empty()) {
+    theAsyncClient->cancel(mySecondaryId);
+  }
+
+  if (not myCompleted or not myRound->theResponse) {
+    return std::make_pair(LambdaResponse("deadline exceeded", ""),
+                          myChrono.stop());
+  }
+
+  if (myRound->theResponder != aDestination) {
+    assert(myRound->theResponder == mySecondary);
+    aDestination = myRound->theResponder;
+    aToken       = mySecondaryToken;
+  }
+
+  // all the calls have completed, hence the round cannot change anymore
+  auto       myResponse = std::move(*myRound->theResponse);
+  const auto myTime     = myRound->theTime;
+  const auto myFailed   = myRound->theFailed;
+  myLock.unlock();
+
+  // if both destinations have failed then the caller purges the one that
+  // provided the response and we purge the other one here, unless the
+  // deadline has expired since it may be only slow
+  if (not myResponse.ok() and not expired(aDeadline)) {
+    for (const auto& myDestination : myFailed) {
+      if (myDestination != aDestination) {
+        purgeDestination(aReq, myDestination);
+      }
+    }
+  }
+
+  return std::make_pair(std::move(myResponse), myTime);
+}
+
+void EdgeLambdaProcessor::processAsync(const rpc::LambdaRequest& aReq,
+                                       const AsyncCallback&      aCallback) {
+  // the fake processor does not block on the network
+  if (not theAsync or theFakeProcessor) {
+    EdgeServer::processAsync(aReq, aCallback);
+    return;
+  }
+
+  if (not admit()) {
+    rpc::LambdaResponse myResp;
+    myResp.set_retcode("overloaded");
+    aCallback(std::move(myResp));
+    return;
+  }
+
+  const AsyncCallback myCallback = [this,
+                                    aCallback](rpc::LambdaResponse&& aResp) {
+    release();
+    aCallback(std::move(aResp));
+  };
+
+  // purging a destination may throw, in which case the response must still
+  // be delivered, otherwise the call never finishes and its slot is leaked
+  std::string myRetCode;
+  try {
+    forwardAsync(aReq, myCallback, deadline(aReq));
+    return;
+  } catch (const std::exception& aErr) {
+    myRetCode = aErr.what();
+  } catch (...) {
+    myRetCode = "Unknown error";
+  }
+
+  rpc::LambdaResponse myResp;
+  myResp.set_retcode(myRetCode);
+  myCallback(std::move(myResp));
+}
+
+void EdgeLambdaProcessor::forwardAsync(const rpc::LambdaRequest& aReq,
+                                       const AsyncCallback&      aCallback,
+                                       const Deadline&           aDeadline) {
+  assert(theAsyncClient);
+
+  // same logic as process(), but this method returns as soon as the lambda
+  // request has been forwarded to a destination, then the continuation is
+  // executed in forwardAsyncDone()
+  std::string myRetCode;
+  while (true) {
+    VLOG(3) << LambdaRequest(aReq).toString();
+    if (theStopped) {
+      myRetCode = "shutting down";
+      break;
+    }
+    if (aReq.hops() > 254) { // loop detection
+      myRetCode = "loop detected";
+      break;
+    }
+    if (expired(aDeadline)) {
+      myRetCode = "deadline exceeded";
+      break;
+    }
+    std::string myDestination;
+    Token       myToken = 0;
+    try {
+      myDestination = destination(aReq, myToken);
+
+      theRandomWaiter();
+
+      // released when the callback is destroyed, i.e., after it is invoked
+      const auto myReservation = theClientPool.reserve(myDestination);
+
+      theAsyncClient->Forward(
+          myDestination,
+          aReq,
+          timeLeft(aDeadline),
+          [this,
+           &aReq,
+           aCallback,
+           aDeadline,
+           myDestination,
+           myToken,
+           myReservation](LambdaResponse&& aRep, const double aTime) {
+            forwardAsyncDone(aReq,
+                             aCallback,
+                             aDeadline,
+                             myDestination,
+                             myToken,
+                             aRep,
+                             aTime);
+          });
+      return;
+
+    } catch (const TooManyPendingRequests& aErr) {
+      // the destination is busy, not faulty: do not purge it
+      myRetCode = aErr.what();
+      break;
+    } catch (const std::exception& aErr) {
+      myRetCode = aErr.what();
+    } catch (...) {
+      myRetCode = "Unknown error";
+    }
+
+    // the client rejects new calls when stopped, which does not mean that
+    // the destination is faulty
+    if (myDestination.empty() or theStopped) {
+      break;
+    }
+    purgeDestination(aReq, myDestination);
+  }
+
+  rpc::LambdaResponse myResp;
+  myResp.set_retcode(myRetCode);
+  aCallback(std::move(myResp));
+}
+
+void EdgeLambdaProcessor::forwardAsyncDone(const rpc::LambdaRequest& aReq,
+                                           const AsyncCallback& aCallback,
+                                           const Deadline&      aDeadline,
+                                           const std::string&   aDestination,
+                                           const Token          aToken,
+                                           const LambdaResponse& aRep,
+                                           const double          aTime) {
+  // when stopped the response is delivered as it is, without updating the
+  // derived classes, which may be under destruction, or retrying
+  if (theStopped) {
+    aCallback(aRep.toProtobuf());
+    return;
+  }
+
+  auto mySuccess = false;
+  try {
+    if (aRep.ok()) {
+      processSuccess(aReq, aToken, aDestination, aRep, aTime);
+      mySuccess = true;
+    } else {
+      VLOG(3) << "error received, " << aRep;
+    }
+  } catch (const std::exception& aErr) {
+    VLOG(3) << "error received, " << aErr.what();
+  } catch (...) {
+    VLOG(3) << "unknown error received";
+  }
+
+  if (mySuccess) {
+    aCallback(aRep.toProtobuf());
+    return;
+  }
+
+  // the destination may be only slow, do not purge it after the deadline
+  if (expired(aDeadline)) {
+    rpc::LambdaResponse myResp;
+    myResp.set_retcode("deadline exceeded");
+    aCallback(std::move(myResp));
+    return;
+  }
+
+  // try again with another destination, if any
+  retryAsync(aReq, aCallback, aDeadline, aDestination);
+}
+
+void EdgeLambdaProcessor::retryAsync(const rpc::LambdaRequest& aReq,
+                                     const AsyncCallback&      aCallback,
+                                     const Deadline&           aDeadline,
+                                     const std::string&        aDestination) {
+  // purging the destination may require a call to the controller and
+  // forwarding the request waits for the artificial forward time, which
+  // would stall all the other forwards if done in the completion queue thread
+  {
+    const std::lock_guard<std::mutex> myLock(theRetryMutex);
+    if (not theStopped) {
+      theRetries.push([this, &aReq, aCallback, aDeadline, aDestination]() {
+        std::string myRetCode;
+        try {
+          purgeDestination(aReq, aDestination);
+          forwardAsync(aReq, aCallback, aDeadline);
+          return;
+        } catch (const std::exception& aErr) {
+          myRetCode = aErr.what();
+        } catch (...) {
+          myRetCode = "Unknown error";
+        }
+        rpc::LambdaResponse myResp;
+        myResp.set_retcode(myRetCode);
+        aCallback(std::move(myResp));
+      });
+      return;
+    }
+  }
+
+  rpc::LambdaResponse myResp;
+  myResp.set_retcode("shutting down");
+  aCallback(std::move(myResp));
+}
+
+void EdgeLambdaProcessor::retryLoop() {
+  while (true) {
+    const auto myRetry = theRetries.pop();
+    if (not myRetry) {
+      break;
+    }
+    try {
+      myRetry();
+    } catch (const std::exception& aErr) {
+      LOG(ERROR) << "exception raised when retrying a lambda: "
+                 << aErr.what();
+    } catch (...) {
+      LOG(ERROR) << "unknown exception raised when retrying a lambda";
+    }
+  }
+  VLOG(1) << "terminating retry thread";
+}
+
+EdgeLambdaProcessor::Deadline
+EdgeLambdaProcessor::deadline(const rpc::LambdaRequest& aReq) const noexcept {
+  const auto myTimeout = aReq.timeout() > 0 ? aReq.timeout() : theTimeout;
+  if (myTimeout == 0) {
+    return Deadline::max();
+  }
+  return std::chrono::steady_clock::now() +
+         std::chrono::milliseconds(myTimeout);
+}
+
+bool EdgeLambdaProcessor::expired(const Deadline& aDeadline) noexcept {
+  return aDeadline != Deadline::max() and
+         std::chrono::steady_clock::now() >= aDeadline;
+}
+
+unsigned int EdgeLambdaProcessor::timeLeft(const Deadline& aDeadline) {
+  if (aDeadline == Deadline::max()) {
+    return 0;
+  }
+  // round up, so that the next hop does not expire before us, and never
+  // forward a zero time left, which would mean no deadline
+  const auto myLeft = std::chrono::duration_cast<std::chrono::microseconds>(
+                          aDeadline - std::chrono::steady_clock::now())
+                          .count();
+  return static_cast<unsigned int>(std::max<long>(1, (myLeft + 999) / 1000));
+}
+
+bool EdgeLambdaProcessor::admit() noexcept {
+  const auto myPending = thePending.fetch_add(1);
+  if (theMaxPending > 0 and myPending >= theMaxPending) {
+    thePending.fetch_sub(1);
+    VLOG(2) << "overloaded, lambdas in progress " << myPending;
+    return false;
+  }
+  return true;
+}
+
+void EdgeLambdaProcessor::release() noexcept {
+  assert(thePending > 0);
+  thePending.fetch_sub(1);
+}
+
+void EdgeLambdaProcessor::purgeDestination(const rpc::LambdaRequest& aReq,
+                                           const std::string& aDestination) {
+  processFailure(aReq, aDestination);
+  controllerCommand([&aDestination](EdgeControllerClient& aClient) {
+    aClient.removeComputer(aDestination);
+  });
+}
+
 void EdgeLambdaProcessor::controllerCommand(
     const std::function<void(EdgeControllerClient&)>& aCommand) noexcept {
   if (not theControllerClient) {
@@ -183,5 +738,52 @@ void EdgeLambdaProcessor::RandomWaiter::operator()() const {
       std::chrono::microseconds(static_cast<long>(0.5 + myRndTime * 1e6)));
 }
 
+EdgeLambdaProcessor::HedgingDelay::HedgingDelay(const double aPercentile,
+                                                const size_t aWindow)
+    : thePercentile(aPercentile)
+    , theWindow(aWindow)
+    , theMutex()
+    , theWindows() {
+  if (aPercentile <= 0 or aPercentile >= 100) {
+    throw std::runtime_error("Invalid hedging percentile: " +
+                             std::to_string(aPercentile));
+  }
+  if (aWindow == 0) {
+    throw std::runtime_error("Invalid null hedging window");
+  }
+}
+
+void EdgeLambdaProcessor::HedgingDelay::add(const std::string& aLambda,
+                                            const double       aTime) {
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  auto& myWindow = theWindows.emplace(aLambda, Window{{}, 0}).first->second;
+  if (myWindow.theSamples.size() < theWindow) {
+    myWindow.theSamples.emplace_back(aTime);
+  } else {
+    myWindow.theSamples[myWindow.theNext] = aTime;
+  }
+  myWindow.theNext = (myWindow.theNext + 1) % theWindow;
+}
+
+double EdgeLambdaProcessor::HedgingDelay::operator()(
+    const std::string& aLambda) const {
+  std::vector<double> mySamples;
+  {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    const auto                        it = theWindows.find(aLambda);
+    if (it == theWindows.end() or
+        it->second.theSamples.size() < std::min<size_t>(10, theWindow)) {
+      return -1;
+    }
+    mySamples = it->second.theSamples;
+  }
+  assert(not mySamples.empty());
+  const auto myPos = static_cast<size_t>(thePercentile / 100 *
+                                         (mySamples.size() - 1));
+  std::nth_element(
+      mySamples.begin(), mySamples.begin() + myPos, mySamples.end());
+  return mySamples[myPos];
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -31,10 +31,22 @@ SOFTWARE.
 
 #pragma once
 
+#include "edgeclientgrpcasync.h"
 #include "edgeclientpool.h"
 #include "edgeserver.h"
 
+#include "Support/queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace uiiit {
@@ -75,13 +87,46 @@ class EdgeLambdaProcessor : public EdgeServer
    *
    * - max-pending-clients=K
    *   Maximum number of client instances created to forward lambdas.
+   *   If the client configuration contains channels=N then N clients per
+   *   destination are shared by all the lambdas and K is the maximum number of
+   *   lambdas in progress per destination, including those forwarded
+   *   asynchronously or hedged: further lambdas are rejected immediately,
+   *   without the destination being considered faulty.
    *
    * - min-forward-time=A
    * - max-forward-time=B
    *   In addition to the real time of selecting the destination of any lambda,
    *   we add an artificial process time randomly drawn from U[A, B].
    *   A and B are in fractional seconds.
-
+   *
+   * - async=true|false (optional, default false)
+   *   If true then lambdas are forwarded using asynchronous gRPC calls, which
+   *   do not hold the server threads for the duration of the remote
+   *   execution. Only valid with gRPC clients. The lambdas whose destination
+   *   fails are retried from a dedicated thread.
+   *
+   * - fake=true|false (optional, default false)
+   *   If true then lambdas are not forwarded and an immediate successful
+   *   response is returned.
+   *
+   * - timeout=T (optional, default 0)
+   *   Deadline, in fractional seconds, assigned to the lambda requests that
+   *   do not carry one; 0 means no deadline. The time left is propagated to
+   *   the next hop and no retries are attempted after the deadline expires.
+   *
+   * - max-pending=N (optional, default 0)
+   *   Maximum number of lambdas in progress: further lambdas are answered
+   *   immediately with an "overloaded" return code; 0 means unlimited.
+   *
+   * - hedge-percentile=P (optional, default 0)
+   * - hedge-window=W (optional, default 100)
+   *   If P is positive then a second copy of a lambda is forwarded to another
+   *   destination if the first one has not answered after the P-th percentile
+   *   of the latest W response times of that lambda; the first successful
+   *   response is used and the other call is cancelled, while if both fail
+   *   both destinations are purged. Only valid with gRPC clients and
+   *   synchronous forwarding.
+   *
    * \param aClientConf the configuration of the clients used to forward lambda
    * requests.
    */
@@ -92,21 +137,56 @@ class EdgeLambdaProcessor : public EdgeServer
                                const support::Conf& aRouterConf,
                                const support::Conf& aClientConf);
 
+  //! Call stop().
   ~EdgeLambdaProcessor() override;
 
   static std::string defaultConf();
 
   virtual std::vector<ForwardingTableInterface*> tables() = 0;
 
+ protected:
+  /**
+   * Opaque per-request data returned by destination(), which is passed back
+   * to processSuccess() for the same request and destination.
+   */
+  using Token = uint64_t;
+
+  //! \return true if hedged requests are enabled.
+  bool hedging() const noexcept {
+    return static_cast<bool>(theHedgingDelay);
+  }
+
+  /**
+   * Stop forwarding lambda requests asynchronously: the forwards in progress
+   * are cancelled and their responses delivered with an error, without
+   * retrying. Return when all of them are complete.
+   *
+   * Must be called by the dtor of derived classes, because the forwards
+   * completing meanwhile call processSuccess() and processFailure(). No-op
+   * if already stopped.
+   */
+  void stop();
+
  private:
-  //! \return the destination associated to the given lambda request.
-  virtual std::string destination(const rpc::LambdaRequest& aReq) = 0;
+  using Deadline = std::chrono::steady_clock::time_point;
+
+  /**
+   * \param aReq the lambda request.
+   *
+   * \param aToken the per-request data, on output.
+   *
+   * \return the destination associated to the given lambda request.
+   */
+  virtual std::string destination(const rpc::LambdaRequest& aReq,
+                                  Token&                    aToken) = 0;
 
   /**
    * Called upon successful execution of a lambda function on a computer.
    *
    * \param aReq the lambda request.
    *
+   * \param aToken the per-request data returned by destination().
+   *
    * \param aDestination the edge computer that executed the lambda.
    *
    * \param aRep the lambda response obtained from the edge computer.
@@ -114,6 +194,7 @@ class EdgeLambdaProcessor : public EdgeServer
    * \param aTime the time required for the execution of the lambda.
    */
   virtual void processSuccess(const rpc::LambdaRequest& aReq,
+                              const Token               aToken,
                               const std::string&        aDestination,
                               const LambdaResponse&     aRep,
                               const double              aTime) = 0;
@@ -131,6 +212,93 @@ class EdgeLambdaProcessor : public EdgeServer
   //! Perform actual processing of a lambda request.
   rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override;
 
+  //! Forward synchronously the request until success or no more destinations.
+  rpc::LambdaResponse forwardSync(const rpc::LambdaRequest& aReq,
+                                  const Deadline&           aDeadline);
+
+  /**
+   * Forward the request to the given destination and, if no response is
+   * received within the hedging delay, also to another destination.
+   *
+   * \param aReq the lambda request received, which is forwarded as it is,
+   * with the time left until deadline at the moment of each call.
+   *
+   * \param aDeadline the deadline of the lambda request: if it expires while
+   * waiting for the primary destination, no copy is sent to another one.
+   *
+   * \param aDestination the primary destination, on input; the destination
+   * that provided the response returned, on output.
+   *
+   * \param aToken the per-request data of the primary destination, on input;
+   * that of the destination that provided the response returned, on output.
+   *
+   * \return the response, as received, and the time required to obtain it.
+   * If the response is a failure, then the other destination, if any, has
+   * already been purged if it has failed too.
+   */
+  std::pair<LambdaResponse, double> hedged(const rpc::LambdaRequest& aReq,
+                                           const Deadline&           aDeadline,
+                                           std::string& aDestination,
+                                           Token&       aToken);
+
+  /**
+   * Perform asynchronous processing of a lambda request, if the async
+   * forwarding has been enabled; otherwise fall back to process().
+   */
+  void processAsync(const rpc::LambdaRequest& aReq,
+                    const AsyncCallback&      aCallback) override;
+
+  //! Forward asynchronously the request to the next destination available.
+  void forwardAsync(const rpc::LambdaRequest& aReq,
+                    const AsyncCallback&      aCallback,
+                    const Deadline&           aDeadline);
+
+  //! Called when an asynchronous forwarding is complete.
+  //! Never blocks, because it is executed by the completion queue thread.
+  void forwardAsyncDone(const rpc::LambdaRequest& aReq,
+                        const AsyncCallback&      aCallback,
+                        const Deadline&           aDeadline,
+                        const std::string&        aDestination,
+                        const Token               aToken,
+                        const LambdaResponse&     aRep,
+                        const double              aTime);
+
+  /**
+   * Purge the given destination and forward again the request from the
+   * retry thread, unless stopped, in which case the callback is invoked
+   * immediately with an error. The callback is also invoked with an error
+   * if the retry throws.
+   */
+  void retryAsync(const rpc::LambdaRequest& aReq,
+                  const AsyncCallback&      aCallback,
+                  const Deadline&           aDeadline,
+                  const std::string&        aDestination);
+
+  //! Execution body of the retry thread.
+  void retryLoop();
+
+  //! \return the deadline of a lambda request received now.
+  Deadline deadline(const rpc::LambdaRequest& aReq) const noexcept;
+
+  //! \return true if the given deadline has expired.
+  static bool expired(const Deadline& aDeadline) noexcept;
+
+  /**
+   * \return the time left until the given deadline, in ms, to be forwarded
+   * with the request, or 0 if there is no deadline.
+   */
+  static unsigned int timeLeft(const Deadline& aDeadline);
+
+  //! \return true if a new lambda can be accepted, false if overloaded.
+  bool admit() noexcept;
+
+  //! Release a lambda admitted with admit().
+  void release() noexcept;
+
+  //! Purge a destination that failed from the local tables and controller.
+  void purgeDestination(const rpc::LambdaRequest& aReq,
+                        const std::string&        aDestination);
+
   /**
    * If the end-point of a controller was specified in the ctor, announce this
    * element to it.
@@ -149,14 +317,50 @@ class EdgeLambdaProcessor : public EdgeServer
     const double theSpan;
   };
 
+  //! Percentile of the latest response times, per lambda.
+  class HedgingDelay final
+  {
+   public:
+    explicit HedgingDelay(const double aPercentile, const size_t aWindow);
+
+    //! Add a response time, in s, of the given lambda.
+    void add(const std::string& aLambda, const double aTime);
+
+    //! \return the hedging delay, in s, or a negative value if unknown.
+    double operator()(const std::string& aLambda) const;
+
+   private:
+    struct Window {
+      std::vector<double> theSamples;
+      size_t              theNext;
+    };
+
+    const double                            thePercentile;
+    const size_t                            theWindow;
+    mutable std::mutex                      theMutex;
+    std::unordered_map<std::string, Window> theWindows;
+  };
+
  private:
-  const std::string theCommandsEndpoint;
-  const std::string theControllerEndpoint;
-  const bool        theFakeProcessor;
+  const std::string   theCommandsEndpoint;
+  const std::string   theControllerEndpoint;
+  const bool          theFakeProcessor;
+  const bool          theAsync;
+  const unsigned int  theTimeout; // in ms, 0 means no deadline
+  const size_t        theMaxPending;
+  std::atomic<size_t> thePending;
+  std::atomic<bool>   theStopped;
 
   EdgeClientPool                        theClientPool;
+  std::unique_ptr<HedgingDelay>         theHedgingDelay;
+  std::unique_ptr<EdgeClientGrpcAsync>  theAsyncClient;
   std::unique_ptr<EdgeControllerClient> theControllerClient;
   RandomWaiter                          theRandomWaiter;
+
+  // asynchronous forwarding only: retries of failed destinations
+  std::mutex                            theRetryMutex;
+  support::Queue<std::function<void()>> theRetries;
+  std::thread                           theRetryThread;
 };
 
 } // end namespace edge
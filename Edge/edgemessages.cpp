@@ -40,20 +40,75 @@ SOFTWARE.
 namespace uiiit {
 namespace edge {
 
+////////////////////////////////////////////////////////////////////////////////
+// Payload
+////////////////////////////////////////////////////////////////////////////////
+
+Payload makePayload(const std::string& aBytes) {
+  return std::make_shared<const std::string>(aBytes);
+}
+
+Payload makePayload(std::string&& aBytes) {
+  return std::make_shared<const std::string>(std::move(aBytes));
+}
+
+Payload viewPayload(const std::string& aBytes) {
+  // aliasing constructor with an empty owner: nothing is released
+  return Payload(Payload(), &aBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LambdaStatus
+////////////////////////////////////////////////////////////////////////////////
+
+rpc::LambdaStatus toStatus(const std::string& aRetCode) {
+  if (aRetCode == "OK") {
+    return rpc::STATUS_OK;
+  } else if (aRetCode == "deadline exceeded") {
+    return rpc::STATUS_DEADLINE_EXCEEDED;
+  } else if (aRetCode == "overloaded") {
+    return rpc::STATUS_OVERLOADED;
+  } else if (aRetCode == "loop detected") {
+    return rpc::STATUS_LOOP_DETECTED;
+  } else if (aRetCode == "unknown lambda id") {
+    return rpc::STATUS_UNKNOWN_LAMBDA_ID;
+  }
+  return rpc::STATUS_ERROR;
+}
+
+std::string toRetCode(const rpc::LambdaStatus aStatus,
+                      const std::string&      aDetail) {
+  switch (aStatus) {
+    case rpc::STATUS_OK:
+      return "OK";
+    case rpc::STATUS_DEADLINE_EXCEEDED:
+      return "deadline exceeded";
+    case rpc::STATUS_OVERLOADED:
+      return "overloaded";
+    case rpc::STATUS_LOOP_DETECTED:
+      return "loop detected";
+    case rpc::STATUS_UNKNOWN_LAMBDA_ID:
+      return "unknown lambda id";
+    default:
+      // generic error or unspecified status (protocol version 0)
+      return aDetail;
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // State
 ////////////////////////////////////////////////////////////////////////////////
 
 State::State(const rpc::State& aState)
     : theLocation(aState.location())
-    , theContent(aState.content()) {
+    , theContent(makePayload(aState.content())) {
   // noop
 }
 
 rpc::State State::toProtobuf() const {
   rpc::State ret;
   ret.set_location(theLocation);
-  ret.set_content(theContent);
+  ret.set_content(*theContent);
   return ret;
 }
 
@@ -63,18 +118,19 @@ std::string State::toString() const {
   if (not theLocation.empty()) {
     ret << "location " << theLocation;
   }
-  if (not theLocation.empty() and not theContent.empty()) {
+  if (not theLocation.empty() and not theContent->empty()) {
     ret << ", ";
   }
-  if (not theContent.empty()) {
-    ret << theContent.size() << " bytes";
+  if (not theContent->empty()) {
+    ret << theContent->size() << " bytes";
   }
   ret << ")";
   return ret.str();
 }
 
 bool State::operator==(const State& aOther) const {
-  return theLocation == aOther.theLocation and theContent == aOther.theContent;
+  return theLocation == aOther.theLocation and
+         (theContent == aOther.theContent or *theContent == *aOther.theContent);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -90,14 +146,18 @@ LambdaRequest::LambdaRequest(const std::string& aName,
 LambdaRequest::LambdaRequest(const std::string& aName,
                              const std::string& aInput,
                              const std::string& aDataIn)
-    : LambdaRequest(
-          aName, aInput, aDataIn, false, 0, support::Uuid().toString()) {
+    : LambdaRequest(aName,
+                    makePayload(aInput),
+                    makePayload(aDataIn),
+                    false,
+                    0,
+                    support::Uuid().toString()) {
   // noop
 }
 
 LambdaRequest::LambdaRequest(const std::string& aName,
-                             const std::string& aInput,
-                             const std::string& aDataIn,
+                             const Payload&     aInput,
+                             const Payload&     aDataIn,
                              const bool         aForward,
                              const unsigned int aHops,
                              const std::string& aUuid)
@@ -111,22 +171,34 @@ LambdaRequest::LambdaRequest(const std::string& aName,
     , theChain(nullptr)
     , theDag(nullptr)
     , theNextFunctionIndex(0)
-    , theUuid(aUuid) {
+    , theUuid(aUuid)
+    , theTimeout(0) {
   // noop
 }
 
 LambdaRequest::LambdaRequest(const rpc::LambdaRequest& aMsg)
+    : LambdaRequest(aMsg, false) {
+  // noop
+}
+
+LambdaRequest LambdaRequest::view(const rpc::LambdaRequest& aMsg) {
+  return LambdaRequest(aMsg, true);
+}
+
+LambdaRequest::LambdaRequest(const rpc::LambdaRequest& aMsg, const bool aView)
     : theName(aMsg.name())
-    , theInput(aMsg.input())
-    , theDataIn(aMsg.datain())
+    , theInput(aView ? viewPayload(aMsg.input()) : makePayload(aMsg.input()))
+    , theDataIn(aView ? viewPayload(aMsg.datain())
+                      : makePayload(aMsg.datain()))
     , theForward(true)
     , theHops(aMsg.hops())
-    , theStates(deserializeStates(aMsg))
+    , theStates(deserializeStates(aMsg, aView))
     , theCallback(aMsg.callback())
     , theChain(nullptr)
     , theDag(nullptr)
     , theNextFunctionIndex(aMsg.nextfunctionindex())
-    , theUuid(aMsg.uuid()) {
+    , theUuid(aMsg.uuid())
+    , theTimeout(aMsg.timeout()) {
   // the serialized message also contains a chain
   if (aMsg.chain_size() > 0) {
     model::Chain::Functions myFunctions;
@@ -179,7 +251,8 @@ LambdaRequest::LambdaRequest(LambdaRequest&& aOther)
     , theChain(std::move(aOther.theChain))
     , theDag(std::move(aOther.theDag))
     , theNextFunctionIndex(aOther.theNextFunctionIndex)
-    , theUuid(aOther.theUuid) {
+    , theUuid(aOther.theUuid)
+    , theTimeout(aOther.theTimeout) {
   // noop
 }
 
@@ -190,8 +263,8 @@ LambdaRequest::~LambdaRequest() {
 rpc::LambdaRequest LambdaRequest::toProtobuf() const {
   rpc::LambdaRequest myRet;
   myRet.set_name(theName);
-  myRet.set_input(theInput);
-  myRet.set_datain(theDataIn);
+  myRet.set_input(*theInput);
+  myRet.set_datain(*theDataIn);
   myRet.set_forward(theForward);
   myRet.set_hops(theHops);
   serializeStates(*myRet.mutable_states(), theStates);
@@ -226,19 +299,22 @@ rpc::LambdaRequest LambdaRequest::toProtobuf() const {
   }
   myRet.set_nextfunctionindex(theNextFunctionIndex);
   myRet.set_uuid(theUuid);
+  myRet.set_timeout(theTimeout);
   return myRet;
 }
 
 bool LambdaRequest::operator==(const LambdaRequest& aOther) const {
-  return theName == aOther.theName and theInput == aOther.theInput and
-         theDataIn == aOther.theDataIn /* and theForward == aOther.theForward */
+  return theName == aOther.theName and *theInput == *aOther.theInput and
+         *theDataIn == *aOther.theDataIn
+         /* and theForward == aOther.theForward */
          and theHops == aOther.theHops and theStates == aOther.theStates and
          theCallback == aOther.theCallback and
          ((theChain.get() == nullptr) == (aOther.theChain.get() == nullptr)) and
          (theChain.get() == nullptr or *theChain == *aOther.theChain) and
          ((theDag.get() == nullptr) == (aOther.theDag.get() == nullptr)) and
          (theDag.get() == nullptr or *theDag == *aOther.theDag) and
-         theNextFunctionIndex == aOther.theNextFunctionIndex
+         theNextFunctionIndex == aOther.theNextFunctionIndex and
+         theTimeout == aOther.theTimeout
       /* and theUuid == aOther.theUuid */;
 }
 
@@ -249,6 +325,7 @@ LambdaRequest LambdaRequest::makeOneMoreHop() const {
 }
 
 LambdaRequest LambdaRequest::copy() const {
+  // the payloads are immutable, hence they are shared with the copy
   LambdaRequest ret(theName, theInput, theDataIn, theForward, theHops, theUuid);
   ret.theStates   = theStates;
   ret.theCallback = theCallback;
@@ -259,6 +336,7 @@ LambdaRequest LambdaRequest::copy() const {
     ret.theDag = std::make_unique<model::Dag>(*theDag);
   }
   ret.theNextFunctionIndex = theNextFunctionIndex;
+  ret.theTimeout           = theTimeout;
   return ret;
 }
 
@@ -266,8 +344,8 @@ LambdaRequest LambdaRequest::regenerate(const std::string& aName,
                                         const size_t       aNextFunctionIndex,
                                         const rpc::LambdaResponse& aResponse) {
   LambdaRequest ret(aName,
-                    aResponse.output(),
-                    aResponse.dataout(),
+                    makePayload(aResponse.output()),
+                    makePayload(aResponse.dataout()),
                     false,
                     theHops + 1,
                     theUuid);
@@ -299,8 +377,12 @@ std::string LambdaRequest::toString() const {
            << theUuid
            << (theCallback.empty() ? std::string() :
                                      (std::string(", callback ") + theCallback))
-           << ", hops: " << theHops << ", input: " << theInput
-           << ", datain size: " << theDataIn.size();
+           << ", hops: " << theHops
+           << (theTimeout == 0 ?
+                   std::string() :
+                   (", timeout " + std::to_string(theTimeout) + " ms"))
+           << ", input: " << *theInput
+           << ", datain size: " << theDataIn->size();
   if (not theStates.empty()) {
     myStream << ", states: [";
     for (auto it = theStates.cbegin(); it != theStates.end(); ++it) {
@@ -353,6 +435,7 @@ LambdaResponse::LambdaResponse(const std::string&           aRetCode,
                                const std::array<double, 3>& aLoads,
                                const bool                   aAsynchronous)
     : theRetCode(aRetCode)
+    , theStatus(toStatus(aRetCode))
     , theOutput(aOutput)
     , theResponder()
     , theProcessingTime(0)
@@ -367,7 +450,10 @@ LambdaResponse::LambdaResponse(const std::string&           aRetCode,
 }
 
 LambdaResponse::LambdaResponse(const rpc::LambdaResponse& aMsg)
-    : theRetCode(aMsg.retcode())
+    : theRetCode(toRetCode(aMsg.status(), aMsg.retcode()))
+    , theStatus(aMsg.status() == rpc::STATUS_UNSPECIFIED ?
+                    toStatus(aMsg.retcode()) :
+                    aMsg.status())
     , theOutput(aMsg.output())
     , theResponder(aMsg.responder())
     , theProcessingTime(aMsg.ptime())
@@ -48,10 +48,44 @@ class Chain;
 class Dag;
 }; // namespace model
 
+/**
+ * Immutable bytes carried by a message, e.g., the input of a lambda request or
+ * the content of a state, which are shared by all the copies of the message.
+ */
+using Payload = std::shared_ptr<const std::string>;
+
+//! \return a payload with a copy of the given bytes.
+Payload makePayload(const std::string& aBytes);
+
+//! \return a payload taking the given bytes, without copying them.
+Payload makePayload(std::string&& aBytes);
+
+/**
+ * \return a payload referring to the given bytes without owning them: the
+ * caller must guarantee that the bytes outlive the payload and all its copies.
+ */
+Payload viewPayload(const std::string& aBytes);
+
+//! \return the status of a lambda execution with the given return code.
+rpc::LambdaStatus toStatus(const std::string& aRetCode);
+
+/**
+ * \return the return code of a lambda execution with the given status, where
+ * aDetail is only used for generic errors, see rpc::LambdaResponse.
+ */
+std::string toRetCode(const rpc::LambdaStatus aStatus,
+                      const std::string&      aDetail);
+
 //! An application's state.
 struct State {
   //! Create with given location and content.
   explicit State(const std::string& aLocation, const std::string& aContent)
+      : State(aLocation, makePayload(aContent)) {
+    // noop
+  }
+
+  //! Create with given location and content, shared with the caller.
+  explicit State(const std::string& aLocation, const Payload& aContent)
       : theLocation(aLocation)
       , theContent(aContent) {
     // noop
@@ -70,6 +104,11 @@ struct State {
   //! Create from protobuf.
   explicit State(const rpc::State& aState);
 
+  //! Create from protobuf, with the content referring to that of aState.
+  static State view(const rpc::State& aState) {
+    return State(aState.location(), viewPayload(aState.content()));
+  }
+
   //! \return a serialized protobuf message.
   rpc::State toProtobuf() const;
 
@@ -84,11 +123,16 @@ struct State {
     return not theLocation.empty();
   }
 
+  //! \return the content of this state.
+  const std::string& content() const noexcept {
+    return *theContent;
+  }
+
   //! The end-point of the server holding this state.
   std::string theLocation;
 
-  //! The content of this state.
-  std::string theContent;
+  //! The content of this state, never null.
+  Payload theContent;
 };
 
 //! A function request, with arguments and possibly also embeddeding states.
@@ -122,6 +166,16 @@ struct LambdaRequest final {
    */
   explicit LambdaRequest(const rpc::LambdaRequest& aMsg);
 
+  /**
+   * Create a lambda request from an underlying protobuf, without copying the
+   * input, data input and states, which refer to those of the message. The
+   * caller must guarantee that the message outlives the request and all the
+   * objects sharing its payloads, e.g., the states of a response.
+   *
+   * The forward flag is automatically set.
+   */
+  static LambdaRequest view(const rpc::LambdaRequest& aMsg);
+
   LambdaRequest(LambdaRequest&& aOther);
 
   LambdaRequest(LambdaRequest&) = delete;
@@ -170,14 +224,24 @@ struct LambdaRequest final {
     return theStates;
   }
 
+  //! \return the function input (text).
+  const std::string& input() const noexcept {
+    return *theInput;
+  }
+
+  //! \return the function input (data).
+  const std::string& dataIn() const noexcept {
+    return *theDataIn;
+  }
+
   //! \return the protobuf-encoded message.
   rpc::LambdaRequest toProtobuf() const;
   //! \return a human-readable representation of the request.
   std::string toString() const;
 
   const std::string             theName;
-  const std::string             theInput;
-  const std::string             theDataIn;
+  const Payload                 theInput;  // never null
+  const Payload                 theDataIn; // never null
   const bool                    theForward;
   unsigned int                  theHops;
   std::map<std::string, State>  theStates;
@@ -186,15 +250,18 @@ struct LambdaRequest final {
   std::unique_ptr<model::Dag>   theDag;
   unsigned int                  theNextFunctionIndex;
   const std::string             theUuid;
+  unsigned int                  theTimeout; // in ms, 0 means no deadline
 
  private:
   explicit LambdaRequest(const std::string& aName,
-                         const std::string& aInput,
-                         const std::string& aDataIn,
+                         const Payload&     aInput,
+                         const Payload&     aDataIn,
                          const bool         aForward,
                          const unsigned int aHops,
                          const std::string& aUuid);
 
+  explicit LambdaRequest(const rpc::LambdaRequest& aMsg, const bool aView);
+
   static model::States::Dependencies
   getDependencies(const rpc::LambdaRequest& aMsg);
 };
@@ -219,6 +286,11 @@ struct LambdaResponse final {
   //! \return true if the messages are identical.
   bool operator==(const LambdaResponse& aOther) const;
 
+  //! \return true if the lambda has been executed with success.
+  bool ok() const noexcept {
+    return theStatus == rpc::STATUS_OK;
+  }
+
   //! \return the processing time, in fractional seconds.
   double processingTimeSeconds() const noexcept;
 
@@ -241,6 +313,7 @@ struct LambdaResponse final {
   std::string toString() const;
 
   const std::string            theRetCode;
+  const rpc::LambdaStatus      theStatus; // consistent with theRetCode
   const std::string            theOutput;
   std::string                  theResponder;
   unsigned int                 theProcessingTime;
@@ -260,11 +333,17 @@ struct LambdaResponse final {
 };
 
 // free functions
+/**
+ * \return the states in a message, whose content refers to that of the
+ * message if aView is true, see LambdaRequest::view().
+ */
 template <class Message>
-std::map<std::string, State> deserializeStates(const Message& aMessage) {
+std::map<std::string, State> deserializeStates(const Message& aMessage,
+                                               const bool     aView = false) {
   std::map<std::string, State> ret;
   for (const auto& elem : aMessage.states()) {
-    ret.emplace(elem.first, State(elem.second));
+    ret.emplace(elem.first,
+                aView ? State::view(elem.second) : State(elem.second));
   }
   return ret;
 }
@@ -62,7 +62,13 @@ EdgeRouter::EdgeRouter(const std::string&   aLambdaEndpoint,
           LocalOptimizerFactory::make(*theFinalTable, aLocalOptimizerConf)) {
 }
 
-std::string EdgeRouter::destination(const rpc::LambdaRequest& aReq) {
+EdgeRouter::~EdgeRouter() {
+  stop();
+}
+
+std::string EdgeRouter::destination(const rpc::LambdaRequest& aReq,
+                                    Token&                    aToken) {
+  aToken = 0; // unused
   if (aReq.forward()) {
     return (*theFinalTable)(aReq.name());
   }
@@ -70,9 +76,11 @@ std::string EdgeRouter::destination(const rpc::LambdaRequest& aReq) {
 }
 
 void EdgeRouter::processSuccess(const rpc::LambdaRequest& aReq,
+                                const Token               aToken,
                                 const std::string&        aDestination,
                                 const LambdaResponse&     aRep,
                                 const double              aTime) {
+  std::ignore = aToken;
   std::ignore = aRep;
   assert(theOverallOptimizer);
   assert(theFinalOptimizer);
@@ -99,15 +99,20 @@ class EdgeRouter final : public EdgeLambdaProcessor
                       const support::Conf& aLocalOptimizerConf,
                       const support::Conf& aClientConf);
 
+  //! Stop the asynchronous forwards before destroying the tables.
+  ~EdgeRouter() override;
+
   //! \return The forwarding tables: 0 is the overall, 1 is the final.
   std::vector<ForwardingTableInterface*> tables() override;
 
  private:
   //! \return the destination associated to the given lambda request.
-  std::string destination(const rpc::LambdaRequest& aReq) override;
+  std::string destination(const rpc::LambdaRequest& aReq,
+                          Token&                    aToken) override;
 
   //! Called upon successful execution of a lambda function on a computer.
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override;
@@ -35,6 +35,7 @@ SOFTWARE.
 
 #include "edgeserver.grpc.pb.h"
 
+#include <functional>
 #include <set>
 #include <thread>
 
@@ -51,6 +52,9 @@ class EdgeServer
 {
 
  public:
+  //! Function called to deliver the response of an asynchronous processing.
+  using AsyncCallback = std::function<void(rpc::LambdaResponse&&)>;
+
   NONCOPYABLE_NONMOVABLE(EdgeServer);
 
   //! Create an edge server with just a mutex and an endpoint
@@ -66,6 +70,25 @@ class EdgeServer
   //! Perform actual processing of a lambda request.
   virtual rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) = 0;
 
+  /**
+   * Perform processing of a lambda request, possibly asynchronously.
+   *
+   * The default implementation calls process() and then invokes the callback
+   * from the caller's thread. Specialized classes may override this method to
+   * return immediately and invoke the callback later from any thread.
+   *
+   * \param aReq The lambda request, which is guaranteed to remain valid until
+   * the callback is invoked.
+   *
+   * \param aCallback The function to be called exactly once with the
+   * response. An exception thrown by this method means that the callback
+   * has not been, and will not be, invoked.
+   */
+  virtual void processAsync(const rpc::LambdaRequest& aReq,
+                            const AsyncCallback&      aCallback) {
+    aCallback(process(aReq));
+  }
+
   /**
    * This method is invoked by the implementation class immediately after the
    * communication interface has been set up. It can be overriden by
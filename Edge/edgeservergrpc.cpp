@@ -32,6 +32,7 @@ SOFTWARE.
 #include "edgeservergrpc.h"
 
 #include "Edge/edgemessages.h"
+#include "Edge/lambdaforward.h"
 #include "RpcSupport/utils.h"
 #include "Support/chrono.h"
 
@@ -39,7 +40,10 @@ SOFTWARE.
 #include <glog/logging.h>
 #include <stdexcept>
 
-// #define TRACE_TASKS
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 GPRAPI void gpr_log(const char*, int, gpr_log_severity, const char*, ...) {
 }
@@ -57,7 +61,11 @@ EdgeServerGrpc::CallData::CallData(rpc::EdgeServer::AsyncService* aService,
     , theRequest()
     , theResponse()
     , theResponder(&theContext)
-    , theStatus(CREATE) {
+    , theStatus(CREATE)
+#ifdef TRACE_TASKS
+    , theChrono(false)
+#endif
+{
   // Invoke the serving logic right away.
   Proceed();
 }
@@ -81,7 +89,7 @@ void EdgeServerGrpc::CallData::Proceed() {
     VLOG(2) << "PROCESS (" << theContext.peer() << ")";
 
 #ifdef TRACE_TASKS
-    support::Chrono myChrono(true);
+    theChrono.start();
 #endif
 
     // Spawn a new CallData instance to serve new clients while we process
@@ -89,28 +97,42 @@ void EdgeServerGrpc::CallData::Proceed() {
     // part of its FINISH state.
     new CallData(theService, theCq, theEdgeServer);
 
-    // The actual processing.
+    // The response may be delivered by another thread, possibly even before
+    // the call below returns, hence we move to the FINISH state right away.
+    theStatus = FINISH;
+
+    // The actual processing: if the edge server processes the request
+    // asynchronously, then this instance is parked until the callback fires,
+    // without holding the thread of the completion queue.
     try {
-      theResponse = theEdgeServer.process(theRequest);
+      // a request forwarded by a router or dispatcher is received unchanged,
+      // with the fields changing at every hop in the metadata
+      LambdaForward::apply(theContext, theRequest);
+
+      // the client may use the identifier assigned to a lambda by this server
+      if (not theEdgeServer.theProtocol.resolve(theRequest)) {
+        rpc::LambdaResponse myResponse;
+        myResponse.set_retcode(toRetCode(rpc::STATUS_UNKNOWN_LAMBDA_ID, ""));
+        finish(std::move(myResponse));
+        return;
+      }
+
+      theEdgeServer.processAsync(
+          theRequest, [this](rpc::LambdaResponse&& aResponse) {
+            finish(std::move(aResponse));
+          });
     } catch (const std::exception& aErr) {
-      theResponse.set_retcode("invalid '" + theRequest.name() +
-                              "' request: " + aErr.what());
+      rpc::LambdaResponse myResponse;
+      myResponse.set_retcode("invalid '" + theRequest.name() +
+                             "' request: " + aErr.what());
+      finish(std::move(myResponse));
     } catch (...) {
-      theResponse.set_retcode("invalid '" + theRequest.name() +
-                              "' request: unknown reasons");
+      rpc::LambdaResponse myResponse;
+      myResponse.set_retcode("invalid '" + theRequest.name() +
+                             "' request: unknown reasons");
+      finish(std::move(myResponse));
     }
 
-#ifdef TRACE_TASKS
-    std::cout << theRequest.name() << " took " << myChrono.stop()
-              << " return-code " << theResponse.retcode() << std::endl;
-#endif
-
-    // And we are done! Let the gRPC runtime know we've finished, using the
-    // memory address of this instance as the uniquely identifying tag for
-    // the event.
-    theStatus = FINISH;
-    theResponder.Finish(theResponse, grpc::Status::OK, this);
-
   } else {
     VLOG(2) << "FINISH";
     assert(theStatus == FINISH);
@@ -120,21 +142,47 @@ void EdgeServerGrpc::CallData::Proceed() {
   }
 }
 
+void EdgeServerGrpc::CallData::finish(rpc::LambdaResponse&& aResponse) {
+  assert(theStatus == FINISH);
+
+#ifdef TRACE_TASKS
+  std::cout << theRequest.name() << " took " << theChrono.stop()
+            << " return-code " << aResponse.retcode() << std::endl;
+#endif
+
+  // And we are done! Let the gRPC runtime know we've finished, using the
+  // memory address of this instance as the uniquely identifying tag for
+  // the event.
+  theEdgeServer.theProtocol.encode(theRequest, aResponse);
+  theResponse = std::move(aResponse);
+  theResponder.Finish(theResponse, grpc::Status::OK, this);
+}
+
 EdgeServerGrpc::EdgeServerGrpc(EdgeServer&  aEdgeServer,
                                const size_t aNumThreads,
-                               const bool   aSecure)
+                               const bool   aSecure,
+                               const bool   aQueuePerThread,
+                               const bool   aAffinity,
+                               const size_t aPreSpawn)
     : EdgeServerImpl(aEdgeServer)
     , theMutex()
     , theServerEndpoint(aEdgeServer.serverEndpoint())
     , theNumThreads(aNumThreads)
     , theSecure(aSecure)
-    , theCq()
+    , theQueuePerThread(aQueuePerThread)
+    , theAffinity(aAffinity)
+    , thePreSpawn(aPreSpawn)
+    , theCqs()
     , theService()
     , theServer()
-    , theHandlers() {
+    , theHandlers()
+    , theProtocol() {
   if (aNumThreads == 0) {
     throw std::runtime_error("Cannot spawn 0 threads");
   }
+  if (aPreSpawn == 0) {
+    throw std::runtime_error("Cannot pre-spawn 0 requests per thread");
+  }
   if (theServerEndpoint.empty()) {
     throw std::runtime_error("Invalid request to bind to an empty end-point");
   }
@@ -161,16 +209,22 @@ void EdgeServerGrpc::run() {
       theSecure ? grpc::SslServerCredentials(rpc::sslServerCredOpts()) :
                   grpc::InsecureServerCredentials());
   myBuilder.RegisterService(&theService);
-  theCq     = myBuilder.AddCompletionQueue();
+  const auto myNumCqs = theQueuePerThread ? theNumThreads : 1;
+  for (size_t i = 0; i < myNumCqs; i++) {
+    theCqs.emplace_back(myBuilder.AddCompletionQueue());
+  }
   theServer = myBuilder.BuildAndStart();
   if (theServer == nullptr) {
     throw std::runtime_error("Could not bind to: " + theServerEndpoint);
   }
   LOG(INFO) << "Server listening on " << theServerEndpoint << " (spawning "
-            << theNumThreads << " threads)";
+            << theNumThreads << " threads, " << theCqs.size()
+            << " completion queues, " << thePreSpawn
+            << " pre-spawned requests per thread"
+            << (theAffinity ? ", with CPU affinity" : "") << ")";
 
   for (size_t i = 0; i < theNumThreads; i++) {
-    theHandlers.emplace_back(std::thread([this]() { handle(); }));
+    theHandlers.emplace_back(std::thread([this, i]() { handle(i); }));
   }
 
   theEdgeServer.init(threadIds());
@@ -187,19 +241,28 @@ void EdgeServerGrpc::wait() {
 
 EdgeServerGrpc::~EdgeServerGrpc() {
   if (theServer) {
-    assert(theCq);
+    assert(not theCqs.empty());
     assert(not theHandlers.empty());
     theServer->Shutdown();
-    theCq->Shutdown();
+    for (auto& myCq : theCqs) {
+      myCq->Shutdown();
+    }
     for (auto& myHandler : theHandlers) {
       myHandler.join();
     }
   }
 }
 
-void EdgeServerGrpc::handle() {
-  // Spawn a new CallData instance to serve new clients.
-  new CallData(&theService, theCq.get(), *this);
+void EdgeServerGrpc::handle(const size_t aIndex) {
+  if (theAffinity) {
+    pin(aIndex);
+  }
+
+  // Spawn new CallData instances to serve new clients.
+  auto& myCq = theCqs[aIndex % theCqs.size()];
+  for (size_t i = 0; i < thePreSpawn; i++) {
+    new CallData(&theService, myCq.get(), *this);
+  }
   void* myTag; // uniquely identifies a request.
   bool  myOk;
   while (true) {
@@ -209,7 +272,7 @@ void EdgeServerGrpc::handle() {
     // The return value of Next should always be checked. This return value
     // tells us whether there is any kind of event or the completion queue is
     // shutting down.
-    if (not theCq->Next(&myTag, &myOk)) {
+    if (not myCq->Next(&myTag, &myOk)) {
       LOG(WARNING) << "terminating (ok = " << myOk << ")";
       break;
     }
@@ -222,10 +285,39 @@ void EdgeServerGrpc::handle() {
   }
 }
 
+void EdgeServerGrpc::pin(const size_t aIndex) {
+#ifdef __linux__
+  const auto myNumCores = std::thread::hardware_concurrency();
+  if (myNumCores == 0) {
+    LOG(WARNING) << "Cannot pin thread: unknown number of cores";
+    return;
+  }
+  const auto mySelected = static_cast<int>(aIndex % myNumCores);
+  cpu_set_t  myCpuSet;
+  CPU_ZERO(&myCpuSet);
+  CPU_SET(mySelected, &myCpuSet);
+  const auto myRet =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &myCpuSet);
+  LOG_IF(WARNING, myRet != 0)
+      << "Cannot pin thread #" << aIndex << " to core " << mySelected
+      << ": error " << myRet;
+  VLOG_IF(1, myRet == 0) << "thread #" << aIndex << " pinned to core "
+                         << mySelected;
+#else
+  LOG(WARNING) << "CPU affinity not supported on this platform, thread #"
+               << aIndex << " not pinned";
+#endif
+}
+
 rpc::LambdaResponse EdgeServerGrpc::process(const rpc::LambdaRequest& aReq) {
   return theEdgeServer.process(aReq);
 }
 
+void EdgeServerGrpc::processAsync(const rpc::LambdaRequest&        aReq,
+                                  const EdgeServer::AsyncCallback& aCallback) {
+  theEdgeServer.processAsync(aReq, aCallback);
+}
+
 std::set<std::thread::id> EdgeServerGrpc::threadIds() const {
   std::set<std::thread::id> ret;
   for (const auto& myThread : theHandlers) {
@@ -31,6 +31,7 @@ SOFTWARE.
 
 #pragma once
 
+#include "Support/chrono.h"
 #include "Support/macros.h"
 
 #include <grpc++/grpc++.h>
@@ -43,9 +44,13 @@ SOFTWARE.
 #include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "edgeserver.grpc.pb.h"
 #include "edgeserverimpl.h"
+#include "lambdaprotocol.h"
+
+// #define TRACE_TASKS
 
 namespace uiiit {
 namespace edge {
@@ -71,6 +76,9 @@ class EdgeServerGrpc final : public EdgeServerImpl
     void Proceed();
 
    private:
+    //! Send back the response to the client.
+    void finish(rpc::LambdaResponse&& aResponse);
+
     // The means of communication with the gRPC runtime for an asynchronous
     // server.
     rpc::EdgeServer::AsyncService* theService;
@@ -94,6 +102,11 @@ class EdgeServerGrpc final : public EdgeServerImpl
 
     // The current serving state.
     CallStatus theStatus;
+
+#ifdef TRACE_TASKS
+    // Measure the time to serve the request.
+    support::Chrono theChrono;
+#endif
   };
 
  public:
@@ -105,10 +118,19 @@ class EdgeServerGrpc final : public EdgeServerImpl
    * @param aEdgeServer The EdgeServer that implements the logic.
    * @param aNumThreads The number of threads to spawn.
    * @param aSecure If true then use server authentication with SSL/TLS.
+   * @param aQueuePerThread If true then each thread has its own completion
+   * queue, otherwise a single completion queue is shared by all threads.
+   * @param aAffinity If true then the i-th thread is pinned to the i-th CPU
+   * core, modulo the number of cores available.
+   * @param aPreSpawn The number of requests that each thread is ready to
+   * accept concurrently from its completion queue before processing starts.
    */
   explicit EdgeServerGrpc(EdgeServer&  aEdgeServer,
                           const size_t aNumThreads,
-                          const bool   aSecure);
+                          const bool   aSecure,
+                          const bool   aQueuePerThread = false,
+                          const bool   aAffinity       = false,
+                          const size_t aPreSpawn       = 1);
 
   virtual ~EdgeServerGrpc();
 
@@ -129,22 +151,33 @@ class EdgeServerGrpc final : public EdgeServerImpl
 
  private:
   //! Thread execution body.
-  void handle();
+  void handle(const size_t aIndex);
+
+  //! Pin the calling thread to the core with given index, if possible.
+  static void pin(const size_t aIndex);
 
   //! Perform actual processing of a lambda request.
   rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override;
 
+  //! Perform processing of a lambda request, possibly asynchronously.
+  void processAsync(const rpc::LambdaRequest&        aReq,
+                    const EdgeServer::AsyncCallback& aCallback);
+
  protected:
   mutable std::mutex theMutex;
   const std::string  theServerEndpoint;
   const size_t       theNumThreads;
   const bool         theSecure;
+  const bool         theQueuePerThread;
+  const bool         theAffinity;
+  const size_t       thePreSpawn;
 
  private:
-  std::unique_ptr<grpc::ServerCompletionQueue> theCq;
-  rpc::EdgeServer::AsyncService                theService;
-  std::unique_ptr<grpc::Server>                theServer;
-  std::list<std::thread>                       theHandlers;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> theCqs;
+  rpc::EdgeServer::AsyncService                             theService;
+  std::unique_ptr<grpc::Server>                             theServer;
+  std::list<std::thread>                                    theHandlers;
+  LambdaProtocolServer                                      theProtocol;
 }; // end class EdgeServer
 
 } // end namespace edge
@@ -50,7 +50,13 @@ EdgeServerImplFactory::make(EdgeServer&          aEdgeServer,
                             const bool           aSecure,
                             const support::Conf& aConf) {
   if (aConf("type") == "grpc") {
-    return std::make_unique<EdgeServerGrpc>(aEdgeServer, aNumThreads, aSecure);
+    return std::make_unique<EdgeServerGrpc>(
+        aEdgeServer,
+        aNumThreads,
+        aSecure,
+        aConf.count("cq-per-thread") > 0 and aConf.getBool("cq-per-thread"),
+        aConf.count("affinity") > 0 and aConf.getBool("affinity"),
+        aConf.count("prespawn") > 0 ? aConf.getUint("prespawn") : 1);
 #ifdef WITH_QUIC
   } else if (aConf("type") == "quic") {
     return std::make_unique<EdgeServerQuic>(
@@ -55,6 +55,13 @@ class EdgeServerImplFactory final
    * @param aNumThreads The number of threads to spawn.
    * @param aSecure If true then use server authentication with SSL/TLS.
    * @param aConf The configuration.
+   *
+   * With type=grpc the following optional parameters are also supported:
+   * - cq-per-thread=true|false: one completion queue per thread (default
+   *   false, i.e., one completion queue shared by all threads)
+   * - affinity=true|false: pin each thread to a CPU core (default false)
+   * - prespawn=N: number of requests pre-spawned per thread (default 1)
+   *
    * @return std::unique_ptr<EdgeServerImpl>
    */
   static std::unique_ptr<EdgeServerImpl> make(EdgeServer&          aEdgeServer,
@@ -39,16 +39,29 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <atomic>
 #include <cassert>
 
 namespace uiiit {
 namespace edge {
 
+namespace {
+
+uint64_t nextForwardingTableId() {
+  static std::atomic<uint64_t> myNext(0);
+  return myNext++;
+}
+
+} // namespace
+
 ForwardingTable::ForwardingTable(const Type aType)
     : ForwardingTableInterface()
     , theType(aType)
+    , theId(nextForwardingTableId())
+    , theLifetime(std::make_shared<const int>(0))
     , theMutex()
-    , theTable()
+    , theTable(std::make_shared<const Table>())
+    , theVersion(1)
     , theAlpha(0)
     , theBeta(0) {
   LOG(INFO) << "Created forwarding table of type " << toString(aType) << '\n';
@@ -59,8 +72,11 @@ ForwardingTable::ForwardingTable(const Type   aType,
                                  const double aBeta)
     : ForwardingTableInterface()
     , theType(aType)
+    , theId(nextForwardingTableId())
+    , theLifetime(std::make_shared<const int>(0))
     , theMutex()
-    , theTable()
+    , theTable(std::make_shared<const Table>())
+    , theVersion(1)
     , theAlpha(aAlpha)
     , theBeta(aBeta) {
   assert(aType == ForwardingTable::Type::ProportionalFairness);
@@ -78,24 +94,25 @@ void ForwardingTable::change(const std::string& aLambda,
 
   const std::lock_guard<std::mutex> myLock(theMutex);
 
-  auto ret = theTable.emplace(aLambda, nullptr);
-  if (ret.second) {
-    if (theType == Type::Random) {
-      ret.first->second.reset(new entries::EntryRandom());
-    } else if (theType == Type::LeastImpedance) {
-      ret.first->second.reset(new entries::EntryLeastImpedance());
-    } else if (theType == Type::RoundRobin) {
-      ret.first->second.reset(new entries::EntryRoundRobin());
-    } else {
-      assert(theType == Type::ProportionalFairness);
-      ret.first->second.reset(
-          new entries::EntryProportionalFairness(theAlpha, theBeta));
+  // the weight of an existing destination is changed in place, without
+  // blocking the lookups
+  const auto it = theTable->find(aLambda);
+  if (it != theTable->end() and it->second->contains(aDest)) {
+    it->second->change(aDest, aWeight, aFinal);
+
+  } else {
+    auto myTable = copy(aLambda);
+    auto ret     = myTable->emplace(aLambda, nullptr);
+    if (ret.second) {
+      ret.first->second = makeEntry();
     }
-  }
 
-  assert(ret.first != theTable.end());
-  assert(static_cast<bool>(ret.first->second));
-  ret.first->second->change(aDest, aWeight, aFinal);
+    assert(ret.first != myTable->end());
+    assert(static_cast<bool>(ret.first->second));
+    ret.first->second->change(aDest, aWeight, aFinal);
+
+    publish(std::move(myTable));
+  }
 
   VLOG(1) << "Changed the weight of destination " << aDest << " for lambda "
           << aLambda << " to " << aWeight << (aFinal ? " (F)" : "");
@@ -114,8 +131,8 @@ void ForwardingTable::change(const std::string& aLambda,
 
   const std::lock_guard<std::mutex> myLock(theMutex);
 
-  const auto it = theTable.find(aLambda);
-  if (it == theTable.end()) {
+  const auto it = theTable->find(aLambda);
+  if (it == theTable->end()) {
     throw NoDestinations();
   }
 
@@ -137,8 +154,8 @@ void ForwardingTable::multiply(const std::string& aLambda,
 
   const std::lock_guard<std::mutex> myLock(theMutex);
 
-  const auto it = theTable.find(aLambda);
-  if (it == theTable.end()) {
+  const auto it = theTable->find(aLambda);
+  if (it == theTable->end()) {
     throw NoDestinations();
   }
 
@@ -153,34 +170,47 @@ void ForwardingTable::remove(const std::string& aLambda,
                              const std::string& aDest) {
   const std::lock_guard<std::mutex> myLock(theMutex);
 
-  auto it = theTable.find(aLambda);
+  const auto jt = theTable->find(aLambda);
+  if (jt == theTable->end() or not jt->second->contains(aDest)) {
+    return;
+  }
 
-  if (it != theTable.end()) {
-    const auto myRemoved = it->second->remove(aDest);
-    LOG_IF(INFO, myRemoved)
-        << "Removed destination " << aDest << " for lambda " << aLambda;
+  auto myTable = copy(aLambda);
+  auto it      = myTable->find(aLambda);
+  assert(it != myTable->end());
 
-    if (it->second->empty()) {
-      LOG(INFO) << "Lambda " << aLambda << " now has no destinations";
-      theTable.erase(it);
-    }
+  [[maybe_unused]] const auto myRemoved = it->second->remove(aDest);
+  assert(myRemoved);
+  LOG(INFO) << "Removed destination " << aDest << " for lambda " << aLambda;
+
+  if (it->second->empty()) {
+    LOG(INFO) << "Lambda " << aLambda << " now has no destinations";
+    myTable->erase(it);
   }
+
+  publish(std::move(myTable));
 }
 
 void ForwardingTable::remove(const std::string& aLambda) {
   const std::lock_guard<std::mutex> myLock(theMutex);
 
-  const auto myErased = theTable.erase(aLambda);
-  LOG_IF(INFO, myErased > 0)
-      << "Removed all destinations for lambda " << aLambda;
+  if (theTable->count(aLambda) == 0) {
+    return;
+  }
+
+  auto myTable = std::make_shared<Table>(*theTable);
+  myTable->erase(aLambda);
+  publish(std::move(myTable));
+
+  LOG(INFO) << "Removed all destinations for lambda " << aLambda;
 }
 
 std::string ForwardingTable::operator()(const std::string& aLambda) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto& myTable = snapshot();
 
-  const auto it = theTable.find(aLambda);
+  const auto it = myTable.find(aLambda);
 
-  if (it != theTable.end()) {
+  if (it != myTable.end()) {
     return (*it->second)();
   }
 
@@ -188,10 +218,10 @@ std::string ForwardingTable::operator()(const std::string& aLambda) {
 }
 
 std::set<std::string> ForwardingTable::lambdas() const {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto myTable = current();
 
   std::set<std::string> myLambdas;
-  for (const auto& myEntry : theTable) {
+  for (const auto& myEntry : *myTable) {
     myLambdas.insert(myEntry.first);
   }
   return myLambdas;
@@ -199,10 +229,10 @@ std::set<std::string> ForwardingTable::lambdas() const {
 
 std::map<std::string, std::pair<float, bool>>
 ForwardingTable::destinations(const std::string& aLambda) const {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto myTable = current();
 
-  const auto it = theTable.find(aLambda);
-  if (it == theTable.end()) {
+  const auto it = myTable->find(aLambda);
+  if (it == myTable->end()) {
     return std::map<std::string, std::pair<float, bool>>();
   }
 
@@ -211,10 +241,10 @@ ForwardingTable::destinations(const std::string& aLambda) const {
 
 std::map<std::string, std::map<std::string, std::pair<float, bool>>>
 ForwardingTable::fullTable() const {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto myTable = current();
 
   std::map<std::string, std::map<std::string, std::pair<float, bool>>> myRet;
-  for (const auto& myEntry : theTable) {
+  for (const auto& myEntry : *myTable) {
     for (const auto& myDestination : myEntry.second->destinations()) {
       myRet[myEntry.first][myDestination.first] = myDestination.second;
     }
@@ -222,6 +252,71 @@ ForwardingTable::fullTable() const {
   return myRet;
 }
 
+std::unique_ptr<entries::Entry> ForwardingTable::makeEntry() const {
+  if (theType == Type::Random) {
+    return std::make_unique<entries::EntryRandom>();
+  } else if (theType == Type::LeastImpedance) {
+    return std::make_unique<entries::EntryLeastImpedance>();
+  } else if (theType == Type::RoundRobin) {
+    return std::make_unique<entries::EntryRoundRobin>();
+  }
+  assert(theType == Type::ProportionalFairness);
+  return std::make_unique<entries::EntryProportionalFairness>(theAlpha,
+                                                               theBeta);
+}
+
+std::shared_ptr<ForwardingTable::Table>
+ForwardingTable::copy(const std::string& aLambda) const {
+  ASSERT_IS_LOCKED(theMutex);
+
+  // only the entry modified is copied, the others are shared
+  auto myTable = std::make_shared<Table>(*theTable);
+  auto it      = myTable->find(aLambda);
+  if (it != myTable->end()) {
+    it->second = it->second->clone();
+  }
+  return myTable;
+}
+
+void ForwardingTable::publish(std::shared_ptr<const Table>&& aTable) {
+  ASSERT_IS_LOCKED(theMutex);
+
+  std::atomic_store(&theTable, std::move(aTable));
+  theVersion.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const ForwardingTable::Table> ForwardingTable::current() const {
+  return std::atomic_load(&theTable);
+}
+
+const ForwardingTable::Table& ForwardingTable::snapshot() const {
+  // indexed by the table identifier, which is never reused
+  thread_local std::map<uint64_t, Snapshot> mySnapshots;
+
+  const auto myVersion = theVersion.load(std::memory_order_acquire);
+  const auto it        = mySnapshots.find(theId);
+  if (it != mySnapshots.end() and it->second.theVersion == myVersion) {
+    assert(it->second.theTable);
+    return *it->second.theTable;
+  }
+
+  // release the snapshots of the tables destroyed, so that the entries are
+  // not kept alive by the threads that used them
+  for (auto jt = mySnapshots.begin(); jt != mySnapshots.end();) {
+    if (jt->second.theOwner.expired()) {
+      jt = mySnapshots.erase(jt);
+    } else {
+      ++jt;
+    }
+  }
+
+  auto& mySnapshot      = mySnapshots[theId];
+  mySnapshot.theOwner   = theLifetime;
+  mySnapshot.theTable   = current();
+  mySnapshot.theVersion = myVersion;
+  return *mySnapshot.theTable;
+}
+
 const std::string& toString(const ForwardingTable::Type aType) {
   static const std::map<ForwardingTable::Type, std::string> myValues(
       {{ForwardingTable::Type::Random, "random"},
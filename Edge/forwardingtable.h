@@ -35,6 +35,8 @@ SOFTWARE.
 #include "Edge/forwardingtableinterface.h"
 #include "Support/macros.h"
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <map>
@@ -49,9 +51,28 @@ namespace edge {
 /**
  * Thread-safe table returning an end-point associated to a given lambda
  * function name.
+ *
+ * The table is optimized for read-mostly access: adding or removing lambdas
+ * or destinations is applied to a copy of the entry affected, then a new
+ * version of the table is published atomically, while lookups use a
+ * per-thread snapshot of the current version and never take the lock used to
+ * serialize modifications. The snapshot is refreshed only when the version
+ * changes. Changing the weight of an existing destination, which is much
+ * more frequent, is instead applied in place to the published entry, whose
+ * weights are atomic values that lookups read without locking, see
+ * entries::Entry.
  */
 class ForwardingTable final : public ForwardingTableInterface
 {
+  using Table = std::map<std::string, std::shared_ptr<entries::Entry>>;
+
+  //! Per-thread snapshot of the table.
+  struct Snapshot {
+    std::weak_ptr<const void>    theOwner; // expires with the table
+    uint64_t                     theVersion = 0;
+    std::shared_ptr<const Table> theTable;
+  };
+
  public:
   enum class Type : int {
     Random               = 0,
@@ -152,9 +173,44 @@ class ForwardingTable final : public ForwardingTableInterface
   fullTable() const override;
 
  private:
-  const Type                                             theType;
-  mutable std::mutex                                     theMutex;
-  std::map<std::string, std::unique_ptr<entries::Entry>> theTable;
+  //! \return a new empty entry of the type of this table.
+  std::unique_ptr<entries::Entry> makeEntry() const;
+
+  /**
+   * \return a modifiable copy of the current table, in which the entry of
+   * the given lambda, if present, is replaced by a copy.
+   *
+   * Must be called with the mutex locked, which guarantees that the entry
+   * copied is not modified until the new table is published.
+   */
+  std::shared_ptr<Table> copy(const std::string& aLambda) const;
+
+  //! Make a new version of the table visible to lookups.
+  void publish(std::shared_ptr<const Table>&& aTable);
+
+  //! \return the current table. Thread-safe.
+  std::shared_ptr<const Table> current() const;
+
+  /**
+   * \return the snapshot of the table owned by the calling thread, which
+   * remains valid until the next call from the same thread.
+   *
+   * The snapshots of the tables destroyed are released by the calling thread
+   * when it refreshes or creates another snapshot.
+   */
+  const Table& snapshot() const;
+
+ private:
+  const Type                        theType;
+  const uint64_t                    theId;
+  const std::shared_ptr<const void> theLifetime; // see Snapshot
+
+  // serialize modifications to the table
+  mutable std::mutex theMutex;
+
+  // only accessed via std::atomic_load/std::atomic_store
+  std::shared_ptr<const Table> theTable;
+  std::atomic<uint64_t>        theVersion;
 
   const double theAlpha;
   const double theBeta;
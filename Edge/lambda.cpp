@@ -56,7 +56,7 @@ LambdaRequirements
 ProportionalRequirements::operator()(const Processor&     aProc,
                                      const LambdaRequest& aReq) const noexcept {
   std::ignore            = aProc;
-  const auto myInputSize = aReq.theInput.size();
+  const auto myInputSize = aReq.input().size();
   return LambdaRequirements{
       static_cast<uint64_t>(
           std::max<int64_t>(0, 0.5 + theOpOffset + theOpCoeff * myInputSize)),
@@ -97,7 +97,7 @@ std::shared_ptr<const LambdaResponse>
 Lambda::execute(const LambdaRequest&         aReq,
                 const std::array<double, 3>& aLoads) const {
   auto ret = std::make_shared<LambdaResponse>(
-      "OK", theCopyInput ? aReq.theInput : theOutput, aLoads);
+      "OK", theCopyInput ? aReq.input() : theOutput, aLoads);
   if (theCopyStates) {
     ret->theStates = aReq.theStates;
   }
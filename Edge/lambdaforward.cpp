@@ -0,0 +1,70 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/lambdaforward.h"
+
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+
+const char* const LambdaForward::theKey = "lambda-forward-bin";
+
+void LambdaForward::add(grpc::ClientContext&      aContext,
+                        const rpc::LambdaRequest& aReq,
+                        const unsigned int        aTimeout) {
+  rpc::LambdaForward myForward;
+  myForward.set_hops(aReq.hops() + 1);
+  myForward.set_timeout(aTimeout);
+  aContext.AddMetadata(theKey, myForward.SerializeAsString());
+}
+
+bool LambdaForward::apply(const grpc::ServerContext& aContext,
+                          rpc::LambdaRequest&        aReq) {
+  const auto& myMetadata = aContext.client_metadata();
+  const auto  it         = myMetadata.find(theKey);
+  if (it == myMetadata.end()) {
+    return false;
+  }
+
+  rpc::LambdaForward myForward;
+  if (not myForward.ParseFromArray(it->second.data(), it->second.size())) {
+    throw std::runtime_error("invalid forwarding metadata");
+  }
+  aReq.set_hops(myForward.hops());
+  aReq.set_timeout(myForward.timeout());
+  aReq.set_forward(true);
+  aReq.set_dry(false);
+  return true;
+}
+
+} // namespace edge
+} // namespace uiiit
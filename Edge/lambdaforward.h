@@ -0,0 +1,85 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "edgeserver.grpc.pb.h"
+
+#include <grpc++/grpc++.h>
+
+namespace uiiit {
+namespace edge {
+
+/**
+ * Forwarding of lambda requests without copying them.
+ *
+ * A router or dispatcher sends the lambda request received as it is, while
+ * the fields that change at every hop are carried by an rpc::LambdaForward
+ * in the metadata of the call, which are applied by the receiver before
+ * processing the request. This way the cost of forwarding a lambda request
+ * does not depend on the size of its input and states.
+ */
+struct LambdaForward final {
+  //! Key of the binary metadata carrying the rpc::LambdaForward.
+  static const char* const theKey;
+
+  /**
+   * Add to the context of a call the metadata to forward a request.
+   *
+   * \param aContext the context of the call.
+   *
+   * \param aReq the lambda request received, to be forwarded with one more
+   * hop.
+   *
+   * \param aTimeout the time left to complete the execution of the lambda,
+   * in ms; 0 means no deadline.
+   */
+  static void add(grpc::ClientContext&      aContext,
+                  const rpc::LambdaRequest& aReq,
+                  const unsigned int        aTimeout);
+
+  /**
+   * Apply to a request received the forwarding metadata, if any.
+   *
+   * \param aContext the context of the call.
+   *
+   * \param aReq the lambda request received.
+   *
+   * \return true if the metadata was found.
+   *
+   * \throw std::runtime_error if the metadata is invalid.
+   */
+  static bool apply(const grpc::ServerContext& aContext,
+                    rpc::LambdaRequest&        aReq);
+};
+
+} // end namespace edge
+} // end namespace uiiit
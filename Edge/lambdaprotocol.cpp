@@ -0,0 +1,173 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "Edge/lambdaprotocol.h"
+
+#include "Edge/edgemessages.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <random>
+
+namespace uiiit {
+namespace edge {
+
+namespace {
+
+uint32_t randomEpoch() {
+  std::random_device myDevice;
+  return std::uniform_int_distribution<uint32_t>(1, 0xffff)(myDevice) << 16;
+}
+
+} // namespace
+
+LambdaProtocolServer::LambdaProtocolServer(const size_t aMaxIds)
+    : theMaxIds(std::min(aMaxIds, static_cast<size_t>(0xffff)))
+    , theEpoch(randomEpoch())
+    , theMutex()
+    , theIds()
+    , theNames() {
+  // noop
+}
+
+bool LambdaProtocolServer::resolve(rpc::LambdaRequest& aReq) const {
+  if (aReq.lambdaid() == 0 or not aReq.name().empty()) {
+    return true;
+  }
+  if ((aReq.lambdaid() & 0xffff0000) != theEpoch) {
+    return false;
+  }
+  const size_t myIndex = (aReq.lambdaid() & 0xffff) - 1;
+
+  const std::shared_lock<std::shared_mutex> myLock(theMutex);
+  if (myIndex >= theNames.size()) {
+    return false;
+  }
+  aReq.set_name(theNames[myIndex]);
+  aReq.clear_lambdaid();
+  return true;
+}
+
+void LambdaProtocolServer::encode(const rpc::LambdaRequest& aReq,
+                                  rpc::LambdaResponse&      aRep) {
+  if (aReq.version() < 1) {
+    return;
+  }
+  if (aRep.status() == rpc::STATUS_UNSPECIFIED) {
+    const auto myStatus = toStatus(aRep.retcode());
+    aRep.set_status(myStatus);
+    if (myStatus != rpc::STATUS_ERROR) {
+      aRep.clear_retcode();
+    }
+  }
+  // unknown or failing lambdas must not take identifiers
+  aRep.set_lambdaid(aReq.name().empty() ?
+                        0 :
+                        id(aReq.name(), aRep.status() == rpc::STATUS_OK));
+}
+
+size_t LambdaProtocolServer::size() const {
+  const std::shared_lock<std::shared_mutex> myLock(theMutex);
+  return theNames.size();
+}
+
+uint32_t LambdaProtocolServer::id(const std::string& aName,
+                                  const bool         aAssign) {
+  {
+    const std::shared_lock<std::shared_mutex> myLock(theMutex);
+    const auto                                it = theIds.find(aName);
+    if (it != theIds.end()) {
+      return it->second;
+    }
+  }
+  if (not aAssign) {
+    return 0;
+  }
+  const std::lock_guard<std::shared_mutex> myLock(theMutex);
+  const auto it = theIds.find(aName); // could have been added meanwhile
+  if (it != theIds.end()) {
+    return it->second;
+  }
+  if (theNames.size() >= theMaxIds) {
+    // the low 16 bits of the identifiers are exhausted, hence the lambdas
+    // from now on are only addressed by name
+    if (theMaxIds > 0) {
+      LOG_FIRST_N(WARNING, 1) << "all the " << theMaxIds
+                              << " lambda identifiers have been assigned, "
+                                 "new lambdas will be addressed by name only";
+    }
+    return 0;
+  }
+  theNames.emplace_back(aName);
+  const uint32_t ret = theEpoch | static_cast<uint32_t>(theNames.size());
+  theIds.emplace(aName, ret);
+  return ret;
+}
+
+LambdaProtocolClient::LambdaProtocolClient()
+    : theMutex()
+    , theIds() {
+  // noop
+}
+
+void LambdaProtocolClient::encode(rpc::LambdaRequest& aReq) const {
+  aReq.set_version(LambdaProtocol::theVersion);
+  if (aReq.name().empty()) {
+    return;
+  }
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  const auto                        it = theIds.find(aReq.name());
+  if (it != theIds.end()) {
+    aReq.set_lambdaid(it->second);
+    aReq.clear_name();
+  }
+}
+
+bool LambdaProtocolClient::decode(const std::string&         aName,
+                                  const rpc::LambdaResponse& aRep) {
+  if (aName.empty()) {
+    return true;
+  }
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  if (aRep.status() == rpc::STATUS_UNKNOWN_LAMBDA_ID) {
+    theIds.erase(aName);
+    return false;
+  }
+  if (aRep.lambdaid() != 0) {
+    theIds[aName] = aRep.lambdaid();
+  }
+  return true;
+}
+
+} // namespace edge
+} // namespace uiiit
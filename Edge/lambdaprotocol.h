@@ -0,0 +1,142 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "edgeserver.grpc.pb.h"
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+
+/**
+ * Versions of the lambda request/response protocol, see rpc::LambdaRequest.
+ *
+ * With version 0 the outcome of a lambda execution is a free-form return code,
+ * which is "OK" on success.
+ *
+ * With version 1 the outcome is an rpc::LambdaStatus, with the return code
+ * only carrying the detail of generic errors. Furthermore, the server assigns
+ * a numeric identifier to every lambda name, which is returned in the
+ * response and can be used by the client instead of the name in the following
+ * requests to the same server. Identifiers are only assigned to lambdas that
+ * have been executed with success, up to a maximum of 65535: beyond that the
+ * server returns no identifier for new lambdas, which are then always
+ * addressed by name. The identifiers are only valid within the
+ * lifetime of a server: a request with an identifier that is unknown is
+ * answered with rpc::STATUS_UNKNOWN_LAMBDA_ID, after which the client sends
+ * again the request with the name.
+ */
+struct LambdaProtocol final {
+  //! Latest version of the protocol.
+  static constexpr uint32_t theVersion = 1;
+};
+
+//! Server side of the lambda protocol.
+class LambdaProtocolServer final
+{
+ public:
+  /**
+   * \param aMaxIds the maximum number of lambda identifiers assigned, which
+   * cannot be greater than 65535; 0 means that identifiers are not used.
+   */
+  explicit LambdaProtocolServer(const size_t aMaxIds = 65535);
+
+  /**
+   * Replace in a request received the lambda identifier with the name.
+   *
+   * \return false if the lambda identifier is unknown.
+   */
+  bool resolve(rpc::LambdaRequest& aReq) const;
+
+  /**
+   * Encode a response according to the version of the request, which must
+   * have been resolved, with the outcome in the legacy return code on input.
+   *
+   * A new identifier is assigned to the lambda only if the outcome is
+   * successful.
+   */
+  void encode(const rpc::LambdaRequest& aReq, rpc::LambdaResponse& aRep);
+
+  //! \return the number of lambda identifiers assigned.
+  size_t size() const;
+
+ private:
+  /**
+   * \param aName the lambda name.
+   * \param aAssign if true, assign an identifier if the lambda has none.
+   *
+   * \return the identifier of a lambda, or 0 if it has none.
+   */
+  uint32_t id(const std::string& aName, const bool aAssign);
+
+ private:
+  const size_t theMaxIds;
+  // random high 16 bits of all the identifiers, to tell apart those that
+  // have been assigned by a previous instance of the server
+  const uint32_t theEpoch;
+
+  mutable std::shared_mutex                 theMutex;
+  std::unordered_map<std::string, uint32_t> theIds;
+  std::vector<std::string>                  theNames; // id-1 is the index
+};
+
+//! Client side of the lambda protocol, with the identifiers of one server.
+class LambdaProtocolClient final
+{
+ public:
+  LambdaProtocolClient();
+
+  //! Prepare a request to be sent, using the lambda identifier if known.
+  void encode(rpc::LambdaRequest& aReq) const;
+
+  /**
+   * Process the response to a request for the given lambda.
+   *
+   * \return false if the server did not recognize the lambda identifier,
+   * in which case the request must be sent again with the name.
+   */
+  bool decode(const std::string& aName, const rpc::LambdaResponse& aRep);
+
+ private:
+  mutable std::mutex                        theMutex;
+  std::unordered_map<std::string, uint32_t> theIds;
+};
+
+} // end namespace edge
+} // end namespace uiiit
@@ -34,6 +34,8 @@ SOFTWARE.
 #include <glog/logging.h>
 
 #include <cassert>
+#include <cstring>
+#include <functional>
 
 namespace uiiit {
 namespace edge {
@@ -42,9 +44,9 @@ PtimeEstimator::PtimeEstimator(const Type aType)
     : ForwardingTableInterface()
     , theType(aType)
     , theMutex()
+    , theLambdaMutexes()
     , theLambdas()
-    , theTable()
-    , theEstimates() {
+    , theTable() {
   LOG(INFO) << "Created a processing time estimator of type "
             << toString(aType);
 }
@@ -55,7 +57,7 @@ void PtimeEstimator::change(const std::string& aLambda,
                             const bool         aFinal) {
   std::ignore = aWeight;
 
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const std::lock_guard<std::shared_mutex> myLock(theMutex);
 
   bool myAdded = false;
   auto it      = theTable.emplace(aLambda,
@@ -91,20 +93,13 @@ void PtimeEstimator::change(const std::string& aLambda,
 
 void PtimeEstimator::processFailure(const rpc::LambdaRequest& aReq,
                                     const std::string&        aDestination) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-
-  // remove the pending estimates from the data structure
-  const auto myRemoved = theEstimates.erase(reinterpret_cast<uint64_t>(&aReq));
-  std::ignore          = myRemoved; // ifdef NDEBUG
-  assert(myRemoved == 1);
-
-  // remove the destination from the edge computer table
+  const std::lock_guard<std::shared_mutex> myLock(theMutex);
   internalRemove(aReq.name(), aDestination);
 }
 
 void PtimeEstimator::remove(const std::string& aLambda,
                             const std::string& aDest) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const std::lock_guard<std::shared_mutex> myLock(theMutex);
   internalRemove(aLambda, aDest);
 }
 
@@ -131,7 +126,7 @@ void PtimeEstimator::internalRemove(const std::string& aLambda,
 }
 
 void PtimeEstimator::remove(const std::string& aLambda) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const std::lock_guard<std::shared_mutex> myLock(theMutex);
   assertConsistency(aLambda);
 
   const auto it = theTable.find(aLambda);
@@ -148,13 +143,13 @@ void PtimeEstimator::remove(const std::string& aLambda) {
 }
 
 std::set<std::string> PtimeEstimator::lambdas() const {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const std::shared_lock<std::shared_mutex> myLock(theMutex);
   return theLambdas;
 }
 
 std::map<std::string, std::map<std::string, std::pair<float, bool>>>
 PtimeEstimator::fullTable() const {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+  const std::shared_lock<std::shared_mutex> myLock(theMutex);
   return theTable;
 }
 
@@ -186,6 +181,33 @@ size_t PtimeEstimator::size(const rpc::LambdaRequest& aReq) {
   return std::max(aReq.datain().size(), aReq.input().size());
 }
 
+PtimeEstimator::Token
+PtimeEstimator::token(const Estimates& aEstimates) noexcept {
+  static_assert(sizeof(Estimates) == sizeof(Token),
+                "estimates do not fit into a token");
+  Token ret;
+  std::memcpy(&ret, &aEstimates, sizeof(ret));
+  return ret;
+}
+
+PtimeEstimator::Estimates
+PtimeEstimator::estimates(const Token aToken) noexcept {
+  Estimates ret;
+  std::memcpy(&ret, &aToken, sizeof(ret));
+  return ret;
+}
+
+PtimeEstimator::LambdaLock
+PtimeEstimator::lambdaLock(const std::string& aLambda) const {
+  // the elements of a braced list are initialized in order: the table lock is
+  // always acquired before the lambda lock
+  return LambdaLock{
+      std::shared_lock<std::shared_mutex>(theMutex),
+      std::unique_lock<std::mutex>(
+          theLambdaMutexes[std::hash<std::string>()(aLambda) %
+                           theLambdaMutexes.size()])};
+}
+
 void PtimeEstimator::assertConsistency(const std::string& aLambda) const {
   [[maybe_unused]] const auto myEmptyLambdas =
       theLambdas.find(aLambda) == theLambdas.end();
@@ -35,13 +35,15 @@ SOFTWARE.
 #include "Edge/forwardingtableinterface.h"
 #include "Support/macros.h"
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
 
 namespace uiiit {
 
@@ -60,6 +62,10 @@ struct InvalidPtimeEstimatorType : public std::runtime_error {
 
 /**
  * Class of objects returning an estimate of the processing time of a lambda.
+ *
+ * The requests of different lambdas are served in parallel, while those of
+ * the same lambda are serialized; changes to the table of destinations are
+ * exclusive.
  */
 class PtimeEstimator : public ForwardingTableInterface
 {
@@ -77,27 +83,39 @@ class PtimeEstimator : public ForwardingTableInterface
     Probe = 3,
   };
 
+  /**
+   * Opaque per-request data returned by operator(), which must be passed back
+   * to processSuccess() for the same request.
+   */
+  using Token = uint64_t;
+
   NONCOPYABLE_NONMOVABLE(PtimeEstimator);
 
   //! Create a processing time estimator of the given type.
   explicit PtimeEstimator(const Type aType);
 
   /**
+   * \param aReq the lambda request.
+   * \param aToken the per-request data, on output.
+   *
    * \return the destination for the given lambda.
    *
    * \throw NoDestinations if the given lambda is not in the table.
    */
-  virtual std::string operator()(const rpc::LambdaRequest& aReq) = 0;
+  virtual std::string operator()(const rpc::LambdaRequest& aReq,
+                                 Token&                    aToken) = 0;
 
   /**
    * Notify that a lambda function has been correctly executed.
    *
    * \param aReq the lambda request.
+   * \param aToken the per-request data returned by operator().
    * \param aDestination the edge computer that executed the function.
    * \param aRep the lambda response.
    * \param aTime the overall execution time, including transport latency.
    */
   virtual void processSuccess(const rpc::LambdaRequest& aReq,
+                              const Token               aToken,
                               const std::string&        aDestination,
                               const LambdaResponse&     aRep,
                               const double              aTime) = 0;
@@ -150,9 +168,28 @@ class PtimeEstimator : public ForwardingTableInterface
   fullTable() const override final;
 
  protected:
+  //! Locks held while serving a request, see lambdaLock().
+  struct LambdaLock {
+    std::shared_lock<std::shared_mutex> theTableLock;
+    std::unique_lock<std::mutex>        theLambdaLock;
+  };
+
   //! \return the input size of the lambda request.
   static size_t size(const rpc::LambdaRequest& aReq);
 
+  //! \return the token carrying the given estimates.
+  static Token token(const Estimates& aEstimates) noexcept;
+
+  //! \return the estimates carried by the given token.
+  static Estimates estimates(const Token aToken) noexcept;
+
+  /**
+   * \return the locks to be held while serving a request of the given lambda,
+   * which prevent changes to the table of destinations and serialize the
+   * requests of the same lambda.
+   */
+  LambdaLock lambdaLock(const std::string& aLambda) const;
+
  private:
   //! Internal function to remove a destination for a given lambda.
   void internalRemove(const std::string& aLambda, const std::string& aDest);
@@ -167,11 +204,11 @@ class PtimeEstimator : public ForwardingTableInterface
   void assertConsistency(const std::string& aLambda) const;
 
  protected:
-  const Type            theType;
-  mutable std::mutex    theMutex;
-  std::set<std::string> theLambdas;
+  const Type                         theType;
+  mutable std::shared_mutex          theMutex;
+  mutable std::array<std::mutex, 64> theLambdaMutexes;
+  std::set<std::string>              theLambdas;
   std::map<std::string, std::map<std::string, std::pair<float, bool>>> theTable;
-  std::unordered_map<uint64_t, Estimates> theEstimates;
 };
 
 const std::string& toString(const PtimeEstimator::Type aType);
@@ -42,6 +42,7 @@ PtimeEstimatorDelay::PtimeEstimatorDelay(const double       aUtilLoadTimeout,
                                          const size_t       aUtilWindowSize,
                                          const std::string& aOutput)
     : PtimeEstimator(Type::Util)
+    , theUtilMutex()
     , theUtilEstimator(aUtilLoadTimeout, aUtilWindowSize)
     // with timestap, with per-line flushing, truncate
     , theSaver(aOutput, true, true, false) {
@@ -49,33 +50,29 @@ PtimeEstimatorDelay::PtimeEstimatorDelay(const double       aUtilLoadTimeout,
       << "saving measurements to output file " << aOutput;
 }
 
-std::string PtimeEstimatorDelay::operator()(const rpc::LambdaRequest& aReq) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  const auto                        mySize = size(aReq);
-  const auto ret = theUtilEstimator.smallestPtime(aReq.name(), mySize);
-  const auto it  = theEstimates.emplace(reinterpret_cast<uint64_t>(&aReq),
-                                       Estimates{0.0, ret.second});
-  std::ignore    = it; // ifdef NDEBUG
-  assert(it.second);
+std::string PtimeEstimatorDelay::operator()(const rpc::LambdaRequest& aReq,
+                                            Token&                    aToken) {
+  const auto myLock = lambdaLock(aReq.name());
+
+  const std::lock_guard<std::mutex> myUtilLock(theUtilMutex);
+  const auto ret = theUtilEstimator.smallestPtime(aReq.name(), size(aReq));
+  aToken         = token(Estimates{0.0f, ret.second});
   return ret.first;
 }
 
 void PtimeEstimatorDelay::processSuccess(const rpc::LambdaRequest& aReq,
+                                         const Token               aToken,
                                          const std::string&        aDestination,
                                          const LambdaResponse&     aRep,
                                          const double              aTime) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  auto it = theEstimates.find(reinterpret_cast<uint64_t>(&aReq));
-  if (it != theEstimates.end()) {
-    theSaver(aReq.name() + " " + aDestination,
-             size(aReq),
-             aRep.theLoad1,
-             it->second.thePtime,
-             aTime);
-    theEstimates.erase(it);
-  } else {
-    assert(false);
-  }
+  const auto myLock = lambdaLock(aReq.name());
+
+  const std::lock_guard<std::mutex> myUtilLock(theUtilMutex);
+  theSaver(aReq.name() + " " + aDestination,
+           size(aReq),
+           aRep.theLoad1,
+           estimates(aToken).thePtime,
+           aTime);
   theUtilEstimator.add(aReq.name(),
                        aDestination,
                        size(aReq),
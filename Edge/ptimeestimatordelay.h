@@ -69,13 +69,15 @@ class PtimeEstimatorDelay final : public PtimeEstimator
    *
    * \throw NoDestinations if the given lambda is not in the table.
    */
-  std::string operator()(const rpc::LambdaRequest& aReq) override;
+  std::string operator()(const rpc::LambdaRequest& aReq,
+                         Token&                    aToken) override;
 
   /**
    * Compute the RTT as the overall execution time minus the processing time in
    * the lambda response and use it to updated the RTT estimator.
    */
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override;
@@ -87,6 +89,8 @@ class PtimeEstimatorDelay final : public PtimeEstimator
                      const std::string& aDestination) override;
 
  private:
+  // the load of the edge computers is shared by all the lambdas
+  std::mutex     theUtilMutex;
   UtilEstimator  theUtilEstimator;
   support::Saver theSaver;
 };
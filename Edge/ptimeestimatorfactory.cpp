@@ -68,7 +68,10 @@ PtimeEstimatorFactory::make(const bool aSecure, const support::Conf& aConf) {
                                           aConf("output")));
     } else if (myType == "probe") {
       myRet.reset(new PtimeEstimatorProbe(
-          aSecure, aConf.getUint("max-clients"), aConf("output")));
+          aSecure,
+          aConf.count("timeout") > 0 ? aConf.getDouble("timeout") : 1.0,
+          aConf.count("cache-ttl") > 0 ? aConf.getDouble("cache-ttl") : 0.0,
+          aConf("output")));
     } else {
       assert(false);
     }
@@ -109,7 +112,7 @@ PtimeEstimatorFactory::defaultConfs() {
        "type=util,rtt-window-size=50,rtt-stale-period=10,"
        "util-load-timeout=10,util-window-size=50,"
        "output=out.dat"},
-      {"probe", "type=probe,max-clients=10,output=out.dat"},
+      {"probe", "type=probe,timeout=1,cache-ttl=0,output=out.dat"},
   });
   return theDefaultConfs;
 }
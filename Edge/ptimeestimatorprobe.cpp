@@ -32,92 +32,181 @@ SOFTWARE.
 #include "ptimeestimatorprobe.h"
 
 #include "Edge/edgemessages.h"
-#include "Support/conf.h"
+#include "Support/random.h"
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <limits>
+#include <memory>
+#include <mutex>
 
 namespace uiiit {
 namespace edge {
 
+struct PtimeEstimatorProbe::Round {
+  explicit Round(const size_t aPending)
+      : theMutex()
+      , theCond()
+      , thePending(aPending)
+      , theBestDestination()
+      , theBestPtime(std::numeric_limits<unsigned int>::max()) {
+    // noop
+  }
+
+  std::mutex              theMutex;
+  std::condition_variable theCond;
+  size_t                  thePending;
+  std::string             theBestDestination;
+  unsigned int            theBestPtime;
+};
+
 PtimeEstimatorProbe::PtimeEstimatorProbe(const bool         aSecure,
-                                         const size_t       aMaxClients,
+                                         const double       aTimeout,
+                                         const double       aCacheTtl,
                                          const std::string& aOutput)
     : PtimeEstimator(Type::Probe)
-    , theClients(aSecure, support::Conf("type=grpc"), aMaxClients)
+    , theTimeout(aTimeout)
+    , theCacheTtl(aCacheTtl)
+    , theClient(aSecure)
     , theDestinations([](const std::string&, const std::string&) {
       return std::make_unique<Descriptor>();
     })
+    , theCacheMutex()
+    , theCache()
+    , theChrono(true)
     , theSaver(aOutput,
                true,
                true,
                false) // with timestap, per-line flushing, truncate
 {
+  if (aTimeout <= 0) {
+    throw std::runtime_error("Invalid non-positive probe timeout: " +
+                             std::to_string(aTimeout));
+  }
   LOG_IF(INFO, not aOutput.empty())
       << "saving measurements to output file " << aOutput;
 }
 
-std::string PtimeEstimatorProbe::operator()(const rpc::LambdaRequest& aReq) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
+std::string PtimeEstimatorProbe::operator()(const rpc::LambdaRequest& aReq,
+                                            Token&                    aToken) {
+  std::vector<std::string> myDestinations;
+  {
+    const auto myLock = lambdaLock(aReq.name());
+
+    // reuse the outcome of a recent probe round, if possible
+    {
+      const std::lock_guard<std::mutex> myCacheLock(theCacheMutex);
+      const auto                        it = theCache.find(aReq.name());
+      if (it != theCache.end() and
+          (theChrono.time() - it->second.theTimestamp) < theCacheTtl) {
+        aToken = token(Estimates{0.0f, it->second.thePtime});
+        return it->second.theDestination;
+      }
+    }
 
-  const auto myAllDestinations =
-      theDestinations.all(aReq.name(), [](Descriptor&) { return 0.0f; });
+    for (const auto myId : theDestinations.destinations(aReq.name())) {
+      myDestinations.emplace_back(theDestinations.name(myId));
+    }
+  }
+  assert(not myDestinations.empty());
+
+  // the destinations are probed without holding the lock
+  auto ret = probe(aReq, myDestinations);
+  if (ret.first.empty()) {
+    ret.first = myDestinations[std::min(
+        myDestinations.size() - 1,
+        static_cast<size_t>(support::random() * myDestinations.size()))];
+    ret.second = static_cast<float>(theTimeout * 1e3);
+    VLOG(1) << "no probe replies for " << aReq.name() << " within "
+            << theTimeout << " s, selected " << ret.first << " at random";
+  }
 
-  std::string  myBestDestination;
-  unsigned int myBestPtime = std::numeric_limits<unsigned int>::max();
-  const auto   myReq       = LambdaRequest(aReq);
-  for (const auto& myDestination : myAllDestinations) {
-    const auto ret = theClients(myDestination.first, myReq, true); // dry
-    VLOG(2) << "destination " << myDestination.first << ", simulated ptime "
-            << ret.first.theProcessingTime << " ms";
+  aToken = token(Estimates{0.0f, ret.second});
 
-    if (ret.first.theRetCode == "OK" and
-        ret.first.theProcessingTime < myBestPtime) {
-      myBestPtime       = ret.first.theProcessingTime;
-      myBestDestination = myDestination.first;
+  if (theCacheTtl > 0) {
+    // the destination may have been removed during the probe round, in
+    // which case it must not be served from the cache
+    const auto myLock = lambdaLock(aReq.name());
+    if (theDestinations.contains(aReq.name(), ret.first)) {
+      const std::lock_guard<std::mutex> myCacheLock(theCacheMutex);
+      theCache[aReq.name()] =
+          CacheEntry{ret.first, ret.second, theChrono.time()};
     }
   }
-  assert(not myBestDestination.empty());
-  assert(myBestPtime < std::numeric_limits<unsigned int>::max());
-
-  // add to the estimates
-  const auto it =
-      theEstimates.emplace(reinterpret_cast<uint64_t>(&aReq),
-                           Estimates{0.0f, static_cast<float>(myBestPtime)});
-  std::ignore = it; // ifdef NDEBUG
-  assert(it.second);
 
-  return myBestDestination;
+  return ret.first;
 }
 
 void PtimeEstimatorProbe::processSuccess(const rpc::LambdaRequest& aReq,
+                                         const Token               aToken,
                                          const std::string&        aDestination,
                                          const LambdaResponse&     aRep,
                                          const double              aTime) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  auto it = theEstimates.find(reinterpret_cast<uint64_t>(&aReq));
-  if (it != theEstimates.end()) {
-    theSaver(aReq.name() + " " + aDestination,
-             size(aReq),
-             it->second.thePtime,
-             aRep.theProcessingTime);
-    theEstimates.erase(it);
-  } else {
-    assert(false);
-  }
+  const std::lock_guard<std::mutex> myLock(theCacheMutex);
+  theSaver(aReq.name() + " " + aDestination,
+           size(aReq),
+           estimates(aToken).thePtime,
+           aRep.theProcessingTime);
 }
 
 void PtimeEstimatorProbe::privateAdd(const std::string& aLambda,
                                      const std::string& aDestination) {
   ASSERT_IS_LOCKED(theMutex);
   theDestinations.add(aLambda, aDestination);
+  theCache.erase(aLambda);
 }
 
 void PtimeEstimatorProbe::privateRemove(const std::string& aLambda,
                                         const std::string& aDestination) {
   ASSERT_IS_LOCKED(theMutex);
-  theDestinations.add(aLambda, aDestination);
+  theDestinations.remove(aLambda, aDestination);
+  theCache.erase(aLambda);
+}
+
+std::pair<std::string, float>
+PtimeEstimatorProbe::probe(const rpc::LambdaRequest&       aReq,
+                           const std::vector<std::string>& aDestinations) {
+  // the round may outlive this function if some responses arrive late
+  const auto myRound = std::make_shared<Round>(aDestinations.size());
+  const auto myReq   = LambdaRequest(aReq);
+  for (const auto& myDestination : aDestinations) {
+    try {
+      theClient.RunLambda(
+          myDestination,
+          myReq,
+          true, // dry
+          [myRound, myDestination](LambdaResponse&& aRep, const double) {
+            VLOG(2) << "destination " << myDestination << ", simulated ptime "
+                    << aRep.theProcessingTime << " ms";
+            const std::lock_guard<std::mutex> myLock(myRound->theMutex);
+            if (aRep.ok() and aRep.theProcessingTime < myRound->theBestPtime) {
+              myRound->theBestPtime       = aRep.theProcessingTime;
+              myRound->theBestDestination = myDestination;
+            }
+            assert(myRound->thePending > 0);
+            if (--myRound->thePending == 0) {
+              myRound->theCond.notify_one();
+            }
+          },
+          theTimeout);
+    } catch (const std::exception& aErr) {
+      LOG(ERROR) << "could not probe " << myDestination << ": " << aErr.what();
+      const std::lock_guard<std::mutex> myLock(myRound->theMutex);
+      myRound->thePending--;
+    }
+  }
+
+  std::unique_lock<std::mutex> myLock(myRound->theMutex);
+  myRound->theCond.wait_for(
+      myLock,
+      std::chrono::microseconds(static_cast<int64_t>(theTimeout * 1e6)),
+      [&myRound]() { return myRound->thePending == 0; });
+  return std::make_pair(myRound->theBestDestination,
+                        static_cast<float>(myRound->theBestPtime));
 }
+
 } // namespace edge
 } // namespace uiiit
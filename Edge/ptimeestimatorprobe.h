@@ -32,10 +32,16 @@ SOFTWARE.
 #pragma once
 
 #include "Edge/destinationtable.h"
-#include "Edge/edgeclientpool.h"
+#include "Edge/edgeclientgrpcasync.h"
 #include "Edge/ptimeestimator.h"
+#include "Support/chrono.h"
 #include "Support/saver.h"
 
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace uiiit {
 
 namespace rpc {
@@ -47,14 +53,43 @@ namespace edge {
 /**
  * Class estimating the lambda execution time by polling all the possible
  * destinations (emulates a centralized approach).
+ *
+ * The dry requests are sent to all the destinations concurrently, without
+ * holding the estimator lock, and the destination with the smallest
+ * processing time among those that reply within a timeout is selected. If
+ * no destination replies in time then one is picked at random.
+ *
+ * Optionally, the outcome of a probe round is reused for the subsequent
+ * requests of the same lambda for a given time-to-live.
  */
 class PtimeEstimatorProbe final : public PtimeEstimator
 {
   struct Descriptor {};
 
+  //! Outcome of the last probe round of a lambda.
+  struct CacheEntry {
+    std::string theDestination;
+    float       thePtime;
+    double      theTimestamp;
+  };
+
+  //! State of a probe round, shared with the response callbacks.
+  struct Round;
+
  public:
+  /**
+   * \param aSecure If true then use SSL/TLS authentication.
+   *
+   * \param aTimeout The maximum time to wait for the probe responses, in s.
+   *
+   * \param aCacheTtl The time for which the outcome of a probe round is
+   * reused for the same lambda, in s. 0 means no caching.
+   *
+   * \param aOutput The file where to save the actual vs. estimated times.
+   */
   explicit PtimeEstimatorProbe(const bool         aSecure,
-                               const size_t       aMaxClients,
+                               const double       aTimeout,
+                               const double       aCacheTtl,
                                const std::string& aOutput);
 
   /**
@@ -62,12 +97,14 @@ class PtimeEstimatorProbe final : public PtimeEstimator
    *
    * \throw NoDestinations if the given lambda is not in the table.
    */
-  std::string operator()(const rpc::LambdaRequest& aReq) override;
+  std::string operator()(const rpc::LambdaRequest& aReq,
+                         Token&                    aToken) override;
 
   /**
    * Simply save the actual vs. estimate time.
    */
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override;
@@ -78,10 +115,26 @@ class PtimeEstimatorProbe final : public PtimeEstimator
   void privateRemove(const std::string& aLambda,
                      const std::string& aDestination) override;
 
+  /**
+   * Send a dry request to all the given destinations and wait for the
+   * responses until the timeout expires. Must be called without the lock.
+   *
+   * \return the destination with the smallest processing time and the
+   * latter, in ms, or an empty string if there were no valid responses.
+   */
+  std::pair<std::string, float>
+  probe(const rpc::LambdaRequest&       aReq,
+        const std::vector<std::string>& aDestinations);
+
  private:
-  EdgeClientPool               theClients;
-  DestinationTable<Descriptor> theDestinations;
-  support::Saver               theSaver;
+  const double                                theTimeout;
+  const double                                theCacheTtl;
+  EdgeClientGrpcAsync                         theClient;
+  DestinationTable<Descriptor>                theDestinations;
+  std::mutex                                  theCacheMutex; // also theSaver
+  std::unordered_map<std::string, CacheEntry> theCache;
+  support::Chrono                             theChrono;
+  support::Saver                              theSaver;
 };
 
 } // namespace edge
@@ -44,32 +44,25 @@ PtimeEstimatorRtt::PtimeEstimatorRtt(const size_t aWindowSize,
     , theRttEstimator(aWindowSize, aStalePeriod) {
 }
 
-std::string PtimeEstimatorRtt::operator()(const rpc::LambdaRequest& aReq) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  const auto ret = theRttEstimator.shortestRtt(aReq.name(), size(aReq));
-  const auto it  = theEstimates.emplace(reinterpret_cast<uint64_t>(&aReq),
-                                       Estimates{ret.second, 0.0f});
-  std::ignore    = it; // ifdef NDEBUG
-  assert(it.second);
+std::string PtimeEstimatorRtt::operator()(const rpc::LambdaRequest& aReq,
+                                          Token&                    aToken) {
+  const auto myLock = lambdaLock(aReq.name());
+  const auto ret    = theRttEstimator.shortestRtt(aReq.name(), size(aReq));
+  aToken            = token(Estimates{ret.second, 0.0f});
   return ret.first;
 }
 
 void PtimeEstimatorRtt::processSuccess(const rpc::LambdaRequest& aReq,
+                                       const Token               aToken,
                                        const std::string&        aDestination,
                                        const LambdaResponse&     aRep,
                                        const double              aTime) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  const auto myRtt = aTime - aRep.processingTimeSeconds();
-  auto       it    = theEstimates.find(reinterpret_cast<uint64_t>(&aReq));
-  if (it != theEstimates.end()) {
-    VLOG(2) << "lambda " << aReq.name() << " with size " << size(aReq)
-            << " towards " << aDestination << ": estimated RTT "
-            << (1e3 * it->second.theRtt) << " ms, measured RTT "
-            << (1e3 * myRtt) << " ms";
-    theEstimates.erase(it);
-  } else {
-    assert(false);
-  }
+  const auto myLock = lambdaLock(aReq.name());
+  const auto myRtt  = aTime - aRep.processingTimeSeconds();
+  VLOG(2) << "lambda " << aReq.name() << " with size " << size(aReq)
+          << " towards " << aDestination << ": estimated RTT "
+          << (1e3 * estimates(aToken).theRtt) << " ms, measured RTT "
+          << (1e3 * myRtt) << " ms";
   theRttEstimator.add(aReq.name(), aDestination, size(aReq), myRtt);
 }
 
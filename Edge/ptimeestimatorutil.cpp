@@ -35,6 +35,8 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <vector>
+
 namespace uiiit {
 namespace edge {
 
@@ -44,54 +46,58 @@ PtimeEstimatorUtil::PtimeEstimatorUtil(const size_t       aRttWindowSize,
                                        const size_t       aUtilWindowSize,
                                        const std::string& aOutput)
     : PtimeEstimator(Type::Util)
-    , theRttEstimator(aRttWindowSize, aRttStalePeriod)
-    , theUtilEstimator(aUtilLoadTimeout, aUtilWindowSize)
+    , theDestinationIds(std::make_shared<DestinationIds>())
+    , theRttEstimator(aRttWindowSize, aRttStalePeriod, theDestinationIds)
+    , theUtilMutex()
+    , theUtilEstimator(aUtilLoadTimeout, aUtilWindowSize, theDestinationIds)
     // with timestap, with per-line flushing, truncate
     , theSaver(aOutput, true, true, false) {
   LOG_IF(INFO, not aOutput.empty())
       << "saving measurements to output file " << aOutput;
 }
 
-std::string PtimeEstimatorUtil::operator()(const rpc::LambdaRequest& aReq) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  const auto                        mySize = size(aReq);
-  const auto                        ret    = theUtilEstimator.best(
-      aReq.name(), mySize, theRttEstimator.rtts(aReq.name(), mySize));
-  const auto it =
-      theEstimates.emplace(reinterpret_cast<uint64_t>(&aReq),
-                           Estimates{std::get<UtilEstimator::BT_RTT>(ret),
-                                     std::get<UtilEstimator::BT_PTIME>(ret)});
-  std::ignore = it; // ifdef NDEBUG
-  assert(it.second);
+std::string PtimeEstimatorUtil::operator()(const rpc::LambdaRequest& aReq,
+                                           Token&                    aToken) {
+  // reused across requests served by the same thread
+  thread_local std::vector<float> myRtts;
+
+  const auto myLock = lambdaLock(aReq.name());
+  const auto mySize = size(aReq);
+  const auto& myDestinations =
+      theRttEstimator.rtts(aReq.name(), mySize, myRtts);
+
+  const std::lock_guard<std::mutex> myUtilLock(theUtilMutex);
+  const auto ret = theUtilEstimator.best(
+      aReq.name(), mySize, myRtts, myDestinations);
+  aToken         = token(Estimates{std::get<UtilEstimator::BT_RTT>(ret),
+                                   std::get<UtilEstimator::BT_PTIME>(ret)});
   return std::get<UtilEstimator::BT_DEST>(ret);
 }
 
 void PtimeEstimatorUtil::processSuccess(const rpc::LambdaRequest& aReq,
+                                        const Token               aToken,
                                         const std::string&        aDestination,
                                         const LambdaResponse&     aRep,
                                         const double              aTime) {
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  const auto myRtt = aTime - aRep.processingTimeSeconds();
-  auto       it    = theEstimates.find(reinterpret_cast<uint64_t>(&aReq));
-  if (it != theEstimates.end()) {
-    theSaver(aReq.name() + " " + aDestination,
-             size(aReq),
-             aRep.theLoad1,
-             it->second.theRtt,
-             myRtt,
-             it->second.thePtime,
-             aRep.processingTimeSeconds());
-    theEstimates.erase(it);
-  } else {
-    assert(false);
-  }
+  const auto myLock      = lambdaLock(aReq.name());
+  const auto myRtt       = aTime - aRep.processingTimeSeconds();
+  const auto myEstimates = estimates(aToken);
+  theRttEstimator.add(aReq.name(), aDestination, size(aReq), myRtt);
+
+  const std::lock_guard<std::mutex> myUtilLock(theUtilMutex);
+  theSaver(aReq.name() + " " + aDestination,
+           size(aReq),
+           aRep.theLoad1,
+           myEstimates.theRtt,
+           myRtt,
+           myEstimates.thePtime,
+           aRep.processingTimeSeconds());
   theUtilEstimator.add(aReq.name(),
                        aDestination,
                        size(aReq),
                        aRep.processingTimeSeconds(),
                        aRep.theLoad1,
                        aRep.theLoad10);
-  theRttEstimator.add(aReq.name(), aDestination, size(aReq), myRtt);
 }
 
 void PtimeEstimatorUtil::privateAdd(const std::string& aLambda,
@@ -78,13 +78,15 @@ class PtimeEstimatorUtil final : public PtimeEstimator
    *
    * \throw NoDestinations if the given lambda is not in the table.
    */
-  std::string operator()(const rpc::LambdaRequest& aReq) override;
+  std::string operator()(const rpc::LambdaRequest& aReq,
+                         Token&                    aToken) override;
 
   /**
    * Compute the RTT as the overall execution time minus the processing time in
    * the lambda response and use it to updated the RTT estimator.
    */
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override;
@@ -96,7 +98,13 @@ class PtimeEstimatorUtil final : public PtimeEstimator
                      const std::string& aDestination) override;
 
  private:
-  RttEstimator   theRttEstimator;
+  // shared by the two estimators, whose destinations are then aligned
+  const std::shared_ptr<DestinationIds> theDestinationIds;
+
+  RttEstimator theRttEstimator;
+
+  // the load of the edge computers is shared by all the lambdas
+  std::mutex     theUtilMutex;
   UtilEstimator  theUtilEstimator;
   support::Saver theSaver;
 };
@@ -64,11 +64,14 @@ void RttEstimator::Descriptor::add(const size_t aInputSize, const float aRtt) {
 ////////////////////////////////////////////////////////////////////////////////
 // class RttEstimator
 
-RttEstimator::RttEstimator(const size_t aWindowSize, const double aStalePeriod)
+RttEstimator::RttEstimator(const size_t                           aWindowSize,
+                           const double                           aStalePeriod,
+                           const std::shared_ptr<DestinationIds>& aIds)
     : theTable(
           [aWindowSize, aStalePeriod](const std::string&, const std::string&) {
             return std::make_unique<Descriptor>(aWindowSize, aStalePeriod);
-          }) {
+          },
+          aIds) {
 }
 
 RttEstimator::~RttEstimator() {
@@ -85,11 +88,17 @@ float RttEstimator::rtt(const std::string& aLambda,
   return 0.0f;
 }
 
-std::map<std::string, float> RttEstimator::rtts(const std::string& aLambda,
-                                                const size_t       aInputSize) {
-  return theTable.all(aLambda, [aInputSize](Descriptor& aDescriptor) {
-    return aDescriptor.rtt(aInputSize);
-  });
+const std::vector<DestinationIds::Id>&
+RttEstimator::rtts(const std::string&  aLambda,
+                   const size_t        aInputSize,
+                   std::vector<float>& aRtts) {
+  theTable.values(
+      aLambda,
+      [aInputSize](Descriptor& aDescriptor) {
+        return aDescriptor.rtt(aInputSize);
+      },
+      aRtts);
+  return theTable.destinations(aLambda);
 }
 
 std::pair<std::string, float>
@@ -35,7 +35,9 @@ SOFTWARE.
 #include "Support/macros.h"
 #include "destinationtable.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -81,8 +83,14 @@ class RttEstimator final
    * estimation of the RTT for each pair lambda,destination.
    *
    * \param aStalePeriod the period after which samples are considered stale.
+   *
+   * \param aIds the identifiers of the destinations, which can be shared
+   * with other estimators.
    */
-  explicit RttEstimator(const size_t aWindowSize, const double aStalePeriod);
+  explicit RttEstimator(const size_t                           aWindowSize,
+                        const double                           aStalePeriod,
+                        const std::shared_ptr<DestinationIds>& aIds =
+                            std::make_shared<DestinationIds>());
 
   ~RttEstimator();
 
@@ -103,10 +111,15 @@ class RttEstimator final
   /**
    * Estimate RTT for a given lambda of a given size for all possible computers.
    *
+   * \param aRtts on output, the estimated RTTs, sorted by destination name.
+   *
+   * \return the identifiers of the destinations, in the same order as aRtts.
+   *
    * \throw NoDestinations if the given lambda cannot be served by any computer.
    */
-  std::map<std::string, float> rtts(const std::string& aLambda,
-                                    const size_t       aInputSize);
+  const std::vector<DestinationIds::Id>& rtts(const std::string&  aLambda,
+                                              const size_t        aInputSize,
+                                              std::vector<float>& aRtts);
 
   /**
    * \return the destination with shortest RTT for a given lambda and size and
@@ -36,21 +36,76 @@ SOFTWARE.
 #include <glog/logging.h>
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
+#include <chrono>
 #include <utility>
 
 namespace uiiit {
 namespace edge {
 
-StateClient::StateClient(const std::string& aServerEndpoint)
-    : SimpleClient(aServerEndpoint) {
+namespace {
+
+/**
+ * Read the content of a state streamed in chunks, the first one with the
+ * return code and the total size.
+ *
+ * \param aReader the stream.
+ * \param aContent the content received.
+ * \param aUntilComplete if true stop reading as soon as all the content
+ * announced has been received, otherwise read until the end of the stream.
+ *
+ * \return the return code, or an error if the content received does not
+ * match the size announced.
+ */
+template <class READER>
+std::string
+receive(READER& aReader, std::string& aContent, const bool aUntilComplete) {
+  rpc::StateResponse myResponse;
+  std::string        myRetCode;
+  size_t             mySize = 0;
+  while ((not aUntilComplete or myRetCode.empty() or
+          (myRetCode == "OK" and aContent.size() < mySize)) and
+         aReader.Read(&myResponse)) {
+    if (myRetCode.empty()) {
+      // first response
+      myRetCode = myResponse.retcode();
+      mySize    = myResponse.size();
+      aContent.reserve(mySize);
+    }
+    aContent.append(myResponse.state().content());
+  }
+
+  if (myRetCode.empty()) {
+    return "no response";
+  }
+  if (myRetCode == "OK" and aContent.size() != mySize) {
+    return "invalid state size received: " + std::to_string(aContent.size()) +
+           " bytes, " + std::to_string(mySize) + " expected";
+  }
+  return myRetCode;
+}
+
+} // namespace
+
+StateClient::StateClient(const std::string& aServerEndpoint,
+                         const size_t       aStreamThreshold,
+                         const unsigned int aTimeout)
+    : SimpleClient(aServerEndpoint)
+    , theStreamThreshold(aStreamThreshold)
+    , theTimeout(aTimeout) {
   // nihil
 }
 
 bool StateClient::Get(const std::string& aName, std::string& aState) {
+  if (theStreamThreshold > 0) {
+    return GetStream(aName, aState);
+  }
+
   rpc::State myRequest;
   myRequest.set_name(aName);
-  rpc::StateResponse                   myResponse;
-  [[maybe_unused]] grpc::ClientContext myContext;
+  rpc::StateResponse  myResponse;
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
 
   rpc::checkStatus(theStub->Get(&myContext, myRequest, &myResponse));
 
@@ -64,11 +119,17 @@ bool StateClient::Get(const std::string& aName, std::string& aState) {
 }
 
 void StateClient::Put(const std::string& aName, const std::string& aState) {
+  if (theStreamThreshold > 0 and aState.size() > theStreamThreshold) {
+    PutStream(aName, aState);
+    return;
+  }
+
   rpc::State myRequest;
   myRequest.set_name(aName);
   myRequest.set_content(aState);
-  rpc::StateResponse                   myResponse;
-  [[maybe_unused]] grpc::ClientContext myContext;
+  rpc::StateResponse  myResponse;
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
 
   rpc::checkStatus(theStub->Put(&myContext, myRequest, &myResponse));
 
@@ -81,8 +142,9 @@ void StateClient::Put(const std::string& aName, const std::string& aState) {
 bool StateClient::Del(const std::string& aName) {
   rpc::State myRequest;
   myRequest.set_name(aName);
-  rpc::StateResponse                   myResponse;
-  [[maybe_unused]] grpc::ClientContext myContext;
+  rpc::StateResponse  myResponse;
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
 
   rpc::checkStatus(theStub->Del(&myContext, myRequest, &myResponse));
 
@@ -94,5 +156,125 @@ bool StateClient::Del(const std::string& aName) {
   return true;
 }
 
+bool StateClient::Pull(const std::string& aName, std::string& aState) {
+  rpc::State myRequest;
+  myRequest.set_name(aName);
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
+
+  const auto myStream = theStub->Pull(&myContext);
+
+  std::string myRetCode("could not send the request");
+  std::string myContent;
+  auto        myAcknowledged = false;
+  if (myStream->Write(myRequest)) {
+    myRetCode = receive(*myStream, myContent, true);
+
+    // the server removes the state only after this message
+    if (myRetCode == "OK") {
+      myAcknowledged = myStream->Write(myRequest);
+      if (not myAcknowledged) {
+        myRetCode = "could not acknowledge the transfer";
+      }
+    }
+  }
+  myStream->WritesDone();
+  const auto myStatus = myStream->Finish();
+
+  if (myAcknowledged) {
+    // the content has been received in full, hence it is returned even if
+    // the server could not remove it, in which case a copy remains there
+    LOG_IF(WARNING, not myStatus.ok())
+        << "state " << aName << " pulled from " << serverEndpoint()
+        << " but maybe not removed there: " << myStatus.error_message();
+    std::swap(aState, myContent);
+    return true;
+  }
+
+  rpc::checkStatus(myStatus);
+  LOG(ERROR) << "error when pulling state " << aName << " from "
+             << serverEndpoint() << ": " << myRetCode;
+  return false;
+}
+
+bool StateClient::Migrate(const std::string& aName,
+                          const std::string& aLocation) {
+  rpc::State myRequest;
+  myRequest.set_name(aName);
+  myRequest.set_location(aLocation);
+  rpc::StateResponse  myResponse;
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
+
+  rpc::checkStatus(theStub->Migrate(&myContext, myRequest, &myResponse));
+
+  if (myResponse.retcode() != "OK") {
+    LOG(ERROR) << "error when migrating state " << aName << " from "
+               << aLocation << " to " << serverEndpoint() << ": "
+               << myResponse.retcode();
+    return false;
+  }
+  return true;
+}
+
+bool StateClient::GetStream(const std::string& aName, std::string& aState) {
+  rpc::State myRequest;
+  myRequest.set_name(aName);
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
+
+  const auto myReader = theStub->GetStream(&myContext, myRequest);
+
+  std::string myContent;
+  const auto  myRetCode = receive(*myReader, myContent, false);
+  rpc::checkStatus(myReader->Finish());
+
+  if (myRetCode != "OK") {
+    LOG(ERROR) << "error when retrieving state " << aName << " from "
+               << serverEndpoint() << ": " << myRetCode;
+    return false;
+  }
+  std::swap(aState, myContent);
+  return true;
+}
+
+void StateClient::PutStream(const std::string& aName,
+                            const std::string& aState) {
+  rpc::StateResponse  myResponse;
+  grpc::ClientContext myContext;
+  setDeadline(myContext);
+
+  const auto myWriter = theStub->PutStream(&myContext, &myResponse);
+
+  const auto myChunkSize = std::min(theStreamThreshold, theMaxChunkSize);
+  rpc::State myChunk;
+  myChunk.set_name(aName);
+  myChunk.set_size(aState.size());
+  for (size_t myOffset = 0; myOffset < aState.size();
+       myOffset += myChunkSize) {
+    myChunk.set_content(aState.data() + myOffset,
+                        std::min(myChunkSize, aState.size() - myOffset));
+    if (not myWriter->Write(myChunk)) {
+      break; // the error is returned by Finish()
+    }
+    myChunk.clear_name();
+    myChunk.clear_size();
+  }
+  myWriter->WritesDone();
+  rpc::checkStatus(myWriter->Finish());
+
+  if (myResponse.retcode() != "OK") {
+    LOG(ERROR) << "error when updating state " << aName << " on "
+               << serverEndpoint() << ": " << myResponse.retcode();
+  }
+}
+
+void StateClient::setDeadline(grpc::ClientContext& aContext) const {
+  if (theTimeout > 0) {
+    aContext.set_deadline(std::chrono::system_clock::now() +
+                          std::chrono::milliseconds(theTimeout));
+  }
+}
+
 } // namespace edge
 } // namespace uiiit
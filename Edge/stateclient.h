@@ -42,10 +42,24 @@ namespace edge {
 class StateClient final : public rpc::SimpleClient<rpc::StateServer>
 {
  public:
+  //! Maximum size of the chunks sent by PutStream, in bytes, which is kept
+  //! well below the default gRPC limit of 4 MiB per message.
+  static constexpr size_t theMaxChunkSize = 1 << 20;
+
   /**
    * \param aServerEndpoint the edge server.
+   *
+   * \param aStreamThreshold the states larger than this size, in bytes, are
+   * put through the streaming RPC in chunks of this size, up to
+   * theMaxChunkSize, while states are always retrieved through the
+   * streaming RPC since their size is not known in advance. If 0 then the
+   * streaming RPCs are not used.
+   *
+   * \param aTimeout the deadline of every call, in ms; 0 means no deadline.
    */
-  explicit StateClient(const std::string& aServerEndpoint);
+  explicit StateClient(const std::string& aServerEndpoint,
+                       const size_t       aStreamThreshold = 1 << 20,
+                       const unsigned int aTimeout         = 0);
 
   /**
    * @brief Get the state from a remote server.
@@ -76,6 +90,45 @@ class StateClient final : public rpc::SimpleClient<rpc::StateServer>
    * @return false otherwise.
    */
   bool Del(const std::string& aName);
+
+  /**
+   * @brief Get the state from a remote server and remove it from there.
+   *
+   * The state is removed only after the client has acknowledged the
+   * reception of all its content, hence it is left on the remote server
+   * if the transfer fails.
+   *
+   * @param aName the state name.
+   * @param aState the state.
+   *
+   * @return true if the state was found.
+   * @return false otherwise.
+   */
+  bool Pull(const std::string& aName, std::string& aState);
+
+  /**
+   * @brief Move a state from another server to the remote server.
+   *
+   * The state is transferred directly between the two servers.
+   *
+   * @param aName the state name.
+   * @param aLocation the end-point of the server that has the state now.
+   *
+   * @return true if the state was moved.
+   * @return false otherwise.
+   */
+  bool Migrate(const std::string& aName, const std::string& aLocation);
+
+ private:
+  bool GetStream(const std::string& aName, std::string& aState);
+  void PutStream(const std::string& aName, const std::string& aState);
+
+  //! Set the deadline of a call, if a timeout is configured.
+  void setDeadline(grpc::ClientContext& aContext) const;
+
+ private:
+  const size_t       theStreamThreshold;
+  const unsigned int theTimeout;
 };
 
 } // end namespace edge
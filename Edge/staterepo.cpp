@@ -0,0 +1,250 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/staterepo.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace uiiit {
+namespace edge {
+
+StateRepo::StateRepo(const size_t       aShards,
+                     const size_t       aMemoryCap,
+                     const std::string& aSpillPath)
+    : theMemoryCap(aMemoryCap)
+    , theSpillFile(aMemoryCap == 0 ?
+                       nullptr :
+                       std::make_unique<detail::SpillFile>(aSpillPath))
+    , theShards(aShards)
+    , theMemory(0)
+    , theClock(0) {
+  if (aShards == 0) {
+    throw std::runtime_error("Invalid zero shards in the state repository");
+  }
+}
+
+StateRepo::~StateRepo() {
+  // noop
+}
+
+Payload StateRepo::get(const std::string& aName) const {
+  uint64_t myVersion = 0;
+  return get(aName, myVersion);
+}
+
+Payload StateRepo::get(const std::string& aName, uint64_t& aVersion) const {
+  auto&                                     myShard = shard(aName);
+  const std::shared_lock<std::shared_mutex> myLock(myShard.theMutex);
+
+  const auto it = myShard.theEntries.find(aName);
+  if (it == myShard.theEntries.end()) {
+    return nullptr;
+  }
+  it->second.theLastAccess = ++theClock;
+  aVersion                 = it->second.theVersion;
+  return content(it->second);
+}
+
+void StateRepo::put(const std::string& aName, std::string&& aContent) {
+  const auto mySize    = aContent.size();
+  auto       myContent = makePayload(std::move(aContent));
+
+  {
+    auto&                                     myShard = shard(aName);
+    const std::unique_lock<std::shared_mutex> myLock(myShard.theMutex);
+
+    auto& myEntry = myShard.theEntries[aName];
+    release(myEntry);
+    myEntry.theContent    = std::move(myContent);
+    myEntry.theVersion    = ++theClock;
+    myEntry.theLastAccess = myEntry.theVersion;
+    theMemory += mySize;
+  }
+
+  enforceCap();
+}
+
+bool StateRepo::del(const std::string& aName) {
+  auto&                                     myShard = shard(aName);
+  const std::unique_lock<std::shared_mutex> myLock(myShard.theMutex);
+
+  const auto it = myShard.theEntries.find(aName);
+  if (it == myShard.theEntries.end()) {
+    return false;
+  }
+  release(it->second);
+  myShard.theEntries.erase(it);
+  return true;
+}
+
+bool StateRepo::del(const std::string& aName, const uint64_t aVersion) {
+  auto&                                     myShard = shard(aName);
+  const std::unique_lock<std::shared_mutex> myLock(myShard.theMutex);
+
+  const auto it = myShard.theEntries.find(aName);
+  if (it == myShard.theEntries.end() or it->second.theVersion != aVersion) {
+    return false;
+  }
+  release(it->second);
+  myShard.theEntries.erase(it);
+  return true;
+}
+
+Payload StateRepo::take(const std::string& aName) {
+  auto&                                     myShard = shard(aName);
+  const std::unique_lock<std::shared_mutex> myLock(myShard.theMutex);
+
+  const auto it = myShard.theEntries.find(aName);
+  if (it == myShard.theEntries.end()) {
+    return nullptr;
+  }
+  auto ret = content(it->second);
+  release(it->second);
+  myShard.theEntries.erase(it);
+  return ret;
+}
+
+size_t StateRepo::size() const {
+  size_t ret = 0;
+  for (const auto& myShard : theShards) {
+    const std::shared_lock<std::shared_mutex> myLock(myShard.theMutex);
+    ret += myShard.theEntries.size();
+  }
+  return ret;
+}
+
+size_t StateRepo::spilled() const {
+  size_t ret = 0;
+  for (const auto& myShard : theShards) {
+    const std::shared_lock<std::shared_mutex> myLock(myShard.theMutex);
+    for (const auto& elem : myShard.theEntries) {
+      if (not elem.second.theContent) {
+        ret++;
+      }
+    }
+  }
+  return ret;
+}
+
+StateRepo::Shard& StateRepo::shard(const std::string& aName) const {
+  return theShards[std::hash<std::string>()(aName) % theShards.size()];
+}
+
+Payload StateRepo::content(const Entry& aEntry) const {
+  if (aEntry.theContent) {
+    return aEntry.theContent;
+  }
+  assert(theSpillFile);
+  return makePayload(theSpillFile->read(aEntry.theSpill));
+}
+
+void StateRepo::release(Entry& aEntry) {
+  if (aEntry.theContent) {
+    assert(theMemory >= aEntry.theContent->size());
+    theMemory -= aEntry.theContent->size();
+    aEntry.theContent.reset();
+  } else {
+    assert(theSpillFile or aEntry.theSpill.theSize == 0);
+    if (theSpillFile) {
+      theSpillFile->free(aEntry.theSpill);
+    }
+  }
+  aEntry.theSpill = detail::SpillFile::Extent{0, 0};
+}
+
+void StateRepo::enforceCap() {
+  if (theMemoryCap == 0) {
+    return;
+  }
+
+  // the victim is searched again if it is accessed, overwritten or removed
+  // between finding it and spilling it
+  Shard*      myShard = nullptr;
+  std::string myName;
+  uint64_t    myLastAccess = 0;
+  while (theMemory > theMemoryCap and
+         oldest(myShard, myName, myLastAccess)) {
+    assert(myShard != nullptr);
+    spill(*myShard, myName, myLastAccess);
+  }
+}
+
+bool StateRepo::oldest(Shard*&      aShard,
+                       std::string& aName,
+                       uint64_t&    aLastAccess) const {
+  auto ret    = false;
+  aLastAccess = std::numeric_limits<uint64_t>::max();
+  for (auto& myShard : theShards) {
+    const std::shared_lock<std::shared_mutex> myLock(myShard.theMutex);
+    for (const auto& elem : myShard.theEntries) {
+      if (elem.second.theContent and
+          elem.second.theLastAccess < aLastAccess) {
+        aShard      = &myShard;
+        aName       = elem.first;
+        aLastAccess = elem.second.theLastAccess;
+        ret         = true;
+      }
+    }
+  }
+  return ret;
+}
+
+bool StateRepo::spill(Shard&             aShard,
+                      const std::string& aName,
+                      const uint64_t     aLastAccess) {
+  const std::unique_lock<std::shared_mutex> myLock(aShard.theMutex);
+
+  const auto it = aShard.theEntries.find(aName);
+  if (it == aShard.theEntries.end() or not it->second.theContent or
+      it->second.theLastAccess != aLastAccess) {
+    return false;
+  }
+
+  assert(theSpillFile);
+  auto&      myVictim = it->second;
+  const auto mySize   = myVictim.theContent->size();
+  myVictim.theSpill   = theSpillFile->write(*myVictim.theContent);
+  myVictim.theContent.reset();
+  assert(theMemory >= mySize);
+  theMemory -= mySize;
+  VLOG(2) << "spilled state " << aName << " of " << mySize
+          << " bytes, in memory " << theMemory << " bytes";
+  return true;
+}
+
+} // namespace edge
+} // namespace uiiit
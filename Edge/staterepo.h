@@ -0,0 +1,191 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/Detail/spillfile.h"
+#include "Edge/edgemessages.h"
+#include "Support/macros.h"
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+
+/**
+ * Thread-safe repository of application states, indexed by name.
+ *
+ * States are partitioned in shards, each protected by a reader/writer lock,
+ * so that operations on states in different shards never contend, and
+ * concurrent reads of states in the same shard do not either.
+ *
+ * The content of a state is returned as a Payload shared with the
+ * repository, hence it is never copied while in memory.
+ *
+ * If a memory cap is set, then whenever the total size of the states in
+ * memory exceeds it the states least recently accessed, across all the
+ * shards, are moved to a memory-mapped spill file, from which they are read
+ * on demand; a spilled state is moved back to memory only when overwritten.
+ * Finding the victim requires a scan of all the states in memory, which
+ * only happens when the cap is exceeded.
+ */
+class StateRepo final
+{
+ public:
+  NONCOPYABLE_NONMOVABLE(StateRepo);
+
+  /**
+   * \param aShards the number of shards.
+   *
+   * \param aMemoryCap the maximum size, in bytes, of the states kept in
+   * memory; 0 means unlimited.
+   *
+   * \param aSpillPath the path of the spill file, only used if aMemoryCap
+   * is positive.
+   *
+   * \throw std::runtime_error if aShards is zero or the spill file cannot be
+   * created.
+   */
+  explicit StateRepo(const size_t       aShards,
+                     const size_t       aMemoryCap,
+                     const std::string& aSpillPath);
+
+  ~StateRepo();
+
+  //! \return the content of a state, or a null pointer if not found.
+  Payload get(const std::string& aName) const;
+
+  /**
+   * \return the content of a state, or a null pointer if not found.
+   *
+   * \param aVersion set to the version of the state found, which changes
+   * every time the state is overwritten.
+   */
+  Payload get(const std::string& aName, uint64_t& aVersion) const;
+
+  //! Add a new state or overwrite an existing one.
+  void put(const std::string& aName, std::string&& aContent);
+
+  //! Remove a state. \return true if the state was found.
+  bool del(const std::string& aName);
+
+  /**
+   * Remove a state only if it has not been overwritten since it was read
+   * with the given version.
+   *
+   * \return true if the state was found with that version.
+   */
+  bool del(const std::string& aName, const uint64_t aVersion);
+
+  //! Remove a state. \return its content or a null pointer if not found.
+  Payload take(const std::string& aName);
+
+  //! \return the total size of the states in memory, in bytes.
+  size_t memory() const noexcept {
+    return theMemory;
+  }
+
+  //! \return the number of states.
+  size_t size() const;
+
+  //! \return the number of states in the spill file.
+  size_t spilled() const;
+
+ private:
+  struct Entry {
+    explicit Entry()
+        : theContent()
+        , theSpill{0, 0}
+        , theVersion(0)
+        , theLastAccess(0) {
+      // noop
+    }
+
+    // null if the state is in the spill file
+    Payload                       theContent;
+    detail::SpillFile::Extent     theSpill;
+    uint64_t                      theVersion; // set when overwritten
+    mutable std::atomic<uint64_t> theLastAccess;
+  };
+
+  struct Shard {
+    mutable std::shared_mutex              theMutex;
+    std::unordered_map<std::string, Entry> theEntries;
+  };
+
+  Shard& shard(const std::string& aName) const;
+
+  //! \return the content of an entry. \pre shard locked.
+  Payload content(const Entry& aEntry) const;
+
+  //! Release the memory or spill extent of an entry. \pre shard locked.
+  void release(Entry& aEntry);
+
+  //! Spill states until the memory cap is respected.
+  void enforceCap();
+
+  /**
+   * Find the least recently accessed state in memory, across all shards.
+   *
+   * \param aShard set to the shard of the state found.
+   * \param aName set to the name of the state found.
+   * \param aLastAccess set to the last access time of the state found.
+   *
+   * \return false if there are no states in memory.
+   */
+  bool oldest(Shard*&      aShard,
+              std::string& aName,
+              uint64_t&    aLastAccess) const;
+
+  /**
+   * Spill a state if it is still in memory and has not been accessed since.
+   *
+   * \return true if the state has been spilled.
+   */
+  bool spill(Shard&             aShard,
+             const std::string& aName,
+             const uint64_t     aLastAccess);
+
+ private:
+  const size_t                       theMemoryCap;
+  std::unique_ptr<detail::SpillFile> theSpillFile;
+  mutable std::vector<Shard>         theShards;
+  std::atomic<size_t>                theMemory;
+  mutable std::atomic<uint64_t>      theClock;
+};
+
+} // end namespace edge
+} // end namespace uiiit
@@ -31,17 +31,23 @@ SOFTWARE.
 
 #include "Edge/stateserver.h"
 
+#include "Edge/stateclient.h"
+
 #include <glog/logging.h>
 #include <grpc++/grpc++.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <limits>
 
 namespace uiiit {
 namespace edge {
 
-StateServer::StateServerImpl::StateServerImpl()
-    : theMutex()
-    , theStateRepo() {
+StateServer::StateServerImpl::StateServerImpl(const size_t       aShards,
+                                              const size_t       aMemoryCap,
+                                              const std::string& aSpillPath)
+    : theStateRepo(aShards, aMemoryCap, aSpillPath) {
   // noop
 }
 
@@ -52,13 +58,11 @@ grpc::Status StateServer::StateServerImpl::Get(
   assert(aState);
   assert(aResponse);
 
-  const std::lock_guard<std::mutex> myLock(theMutex);
-
-  const auto it = theStateRepo.find(aState->name());
-  if (it == theStateRepo.end()) {
+  const auto myContent = theStateRepo.get(aState->name());
+  if (not myContent) {
     aResponse->set_retcode("could not find state: " + aState->name());
   } else {
-    aResponse->mutable_state()->set_content(it->second);
+    aResponse->mutable_state()->set_content(*myContent);
     aResponse->set_retcode("OK");
   }
   return grpc::Status::OK;
@@ -71,8 +75,7 @@ grpc::Status StateServer::StateServerImpl::Put(
   assert(aState);
   assert(aResponse);
 
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  theStateRepo[aState->name()] = aState->content();
+  theStateRepo.put(aState->name(), std::string(aState->content()));
   aResponse->set_retcode("OK");
   return grpc::Status::OK;
 }
@@ -84,8 +87,7 @@ grpc::Status StateServer::StateServerImpl::Del(
   assert(aState);
   assert(aResponse);
 
-  const std::lock_guard<std::mutex> myLock(theMutex);
-  if (theStateRepo.erase(aState->name()) == 1) {
+  if (theStateRepo.del(aState->name())) {
     aResponse->set_retcode("OK");
   } else {
     aResponse->set_retcode("state not found: " + aState->name());
@@ -93,10 +95,184 @@ grpc::Status StateServer::StateServerImpl::Del(
   return grpc::Status::OK;
 }
 
-StateServer::StateServer(const std::string& aEndpoint)
+grpc::Status StateServer::StateServerImpl::GetStream(
+    [[maybe_unused]] grpc::ServerContext*   aContext,
+    const rpc::State*                       aState,
+    grpc::ServerWriter<rpc::StateResponse>* aWriter) {
+  assert(aState);
+  assert(aWriter);
+
+  // the content is shared with the repository, hence it is not copied
+  // other than one chunk at a time into the responses
+  send(aState->name(), theStateRepo.get(aState->name()), *aWriter);
+  return grpc::Status::OK;
+}
+
+grpc::Status StateServer::StateServerImpl::PutStream(
+    grpc::ServerContext*            aContext,
+    grpc::ServerReader<rpc::State>* aReader,
+    rpc::StateResponse*             aResponse) {
+  assert(aContext);
+  assert(aReader);
+  assert(aResponse);
+
+  rpc::State myChunk;
+  if (not aReader->Read(&myChunk)) {
+    aResponse->set_retcode("no state received");
+    return grpc::Status::OK;
+  }
+  const auto  myName = myChunk.name();
+  const auto  mySize = myChunk.size();
+  std::string myContent(std::move(*myChunk.mutable_content()));
+  while (myContent.size() <= mySize and aReader->Read(&myChunk)) {
+    myContent.append(myChunk.content());
+  }
+
+  // a partial state must never overwrite the one in the repository
+  if (aContext->IsCancelled()) {
+    LOG(WARNING) << "state update cancelled by the client: " << myName;
+    return grpc::Status::CANCELLED;
+  }
+  if (myContent.size() != mySize) {
+    aResponse->set_retcode("invalid state size received: " +
+                           std::to_string(myContent.size()) + " bytes, " +
+                           std::to_string(mySize) + " expected: " + myName);
+    return grpc::Status::OK;
+  }
+
+  theStateRepo.put(myName, std::move(myContent));
+  aResponse->set_retcode("OK");
+  return grpc::Status::OK;
+}
+
+grpc::Status StateServer::StateServerImpl::Pull(
+    grpc::ServerContext*                                       aContext,
+    grpc::ServerReaderWriter<rpc::StateResponse, rpc::State>* aStream) {
+  assert(aContext);
+  assert(aStream);
+
+  rpc::State myRequest;
+  if (not aStream->Read(&myRequest)) {
+    return grpc::Status::OK;
+  }
+  const auto& myName = myRequest.name();
+
+  if (not startPull(myName)) {
+    rpc::StateResponse myResponse;
+    myResponse.set_retcode("state already being pulled: " + myName);
+    aStream->Write(myResponse);
+    return grpc::Status::OK;
+  }
+
+  // the state is removed only when the client acknowledges that it has
+  // received all the content, otherwise it is left in the repository; if
+  // the state has been overwritten in the meanwhile then it is kept, since
+  // the new content has not been sent
+  uint64_t   myVersion = 0;
+  const auto myContent = theStateRepo.get(myName, myVersion);
+  rpc::State myAck;
+  if (send(myName, myContent, *aStream) and aStream->Read(&myAck) and
+      myAck.name() == myName and not aContext->IsCancelled()) {
+    LOG_IF(WARNING, not theStateRepo.del(myName, myVersion))
+        << "state changed while being pulled, kept: " << myName;
+  } else {
+    LOG(WARNING) << "state not pulled, kept: " << myName;
+  }
+
+  stopPull(myName);
+  return grpc::Status::OK;
+}
+
+grpc::Status StateServer::StateServerImpl::Migrate(
+    grpc::ServerContext* aContext,
+    const rpc::State*    aState,
+    rpc::StateResponse*  aResponse) {
+  assert(aContext);
+  assert(aState);
+  assert(aResponse);
+
+  try {
+    // the state is pulled within the deadline of this call, if any
+    const auto myRemaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            aContext->deadline() - std::chrono::system_clock::now())
+            .count();
+    if (myRemaining <= 0) {
+      aResponse->set_retcode("deadline expired before pulling state from " +
+                             aState->location() + ": " + aState->name());
+      return grpc::Status::OK;
+    }
+    StateClient myClient(
+        aState->location(),
+        StateClient::theMaxChunkSize,
+        myRemaining > std::numeric_limits<unsigned int>::max() ?
+            0 :
+            static_cast<unsigned int>(myRemaining));
+
+    std::string myContent;
+    if (not myClient.Pull(aState->name(), myContent)) {
+      aResponse->set_retcode("could not pull state from " +
+                             aState->location() + ": " + aState->name());
+      return grpc::Status::OK;
+    }
+    theStateRepo.put(aState->name(), std::move(myContent));
+    aResponse->set_retcode("OK");
+
+  } catch (const std::exception& aErr) {
+    aResponse->set_retcode("could not pull state from " + aState->location() +
+                           ": " + aErr.what());
+  }
+  return grpc::Status::OK;
+}
+
+bool StateServer::StateServerImpl::startPull(const std::string& aName) {
+  const std::lock_guard<std::mutex> myLock(thePullMutex);
+  return thePulling.insert(aName).second;
+}
+
+void StateServer::StateServerImpl::stopPull(const std::string& aName) {
+  const std::lock_guard<std::mutex> myLock(thePullMutex);
+  thePulling.erase(aName);
+}
+
+template <class WRITER>
+bool StateServer::StateServerImpl::send(const std::string& aName,
+                                        const Payload&     aContent,
+                                        WRITER&            aWriter) {
+  rpc::StateResponse myResponse;
+  if (not aContent) {
+    myResponse.set_retcode("could not find state: " + aName);
+    aWriter.Write(myResponse);
+    return false;
+  }
+
+  myResponse.set_retcode("OK");
+  myResponse.set_size(aContent->size());
+  size_t myOffset = 0;
+  do {
+    const auto myLen = std::min(theChunkSize, aContent->size() - myOffset);
+    myResponse.mutable_state()->set_content(aContent->data() + myOffset,
+                                            myLen);
+    if (not aWriter.Write(myResponse)) {
+      return false; // the client has gone
+    }
+    myOffset += myLen;
+    myResponse.Clear();
+  } while (myOffset < aContent->size());
+
+  return true;
+}
+
+StateServer::StateServer(const std::string& aEndpoint,
+                         const size_t       aShards,
+                         const size_t       aMemoryCap,
+                         const std::string& aSpillPath)
     : SimpleServer(aEndpoint)
-    , theServerImpl() {
-  LOG(INFO) << "Creating a state server at endpoint " << aEndpoint;
+    , theServerImpl(aShards, aMemoryCap, aSpillPath) {
+  LOG(INFO) << "Creating a state server at endpoint " << aEndpoint
+            << ", shards " << aShards << ", memory cap "
+            << (aMemoryCap == 0 ? std::string("none") :
+                                  std::to_string(aMemoryCap) + " bytes");
 }
 
 } // namespace edge
@@ -32,22 +32,37 @@ SOFTWARE.
 #pragma once
 
 #include "Edge/edgemessages.h"
+#include "Edge/staterepo.h"
 #include "RpcSupport/simpleserver.h"
 
-#include <map>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 
 namespace uiiit {
 namespace edge {
 
+/**
+ * Server of application states, which are kept in a StateRepo.
+ *
+ * Large states can be retrieved and updated in chunks through the streaming
+ * RPCs GetStream and PutStream, which avoid the allocation of a message as
+ * large as the state.
+ *
+ * A state can be moved between two servers with a single Migrate call to the
+ * destination, which pulls the state from the origin in one streamed
+ * operation that also removes it there, once the destination has
+ * acknowledged the reception of the whole content.
+ */
 class StateServer final : public rpc::SimpleServer
 {
  private:
   class StateServerImpl final : public rpc::StateServer::Service
   {
    public:
-    explicit StateServerImpl();
+    explicit StateServerImpl(const size_t       aShards,
+                             const size_t       aMemoryCap,
+                             const std::string& aSpillPath);
 
    private:
     grpc::Status Get(grpc::ServerContext* aContext,
@@ -62,13 +77,67 @@ class StateServer final : public rpc::SimpleServer
                      const rpc::State*    aState,
                      rpc::StateResponse*  aResponse) override;
 
+    grpc::Status
+    GetStream(grpc::ServerContext*                    aContext,
+              const rpc::State*                       aState,
+              grpc::ServerWriter<rpc::StateResponse>* aWriter) override;
+
+    grpc::Status PutStream(grpc::ServerContext*            aContext,
+                           grpc::ServerReader<rpc::State>* aReader,
+                           rpc::StateResponse*             aResponse) override;
+
+    grpc::Status
+    Pull(grpc::ServerContext*                                       aContext,
+         grpc::ServerReaderWriter<rpc::StateResponse, rpc::State>* aStream)
+        override;
+
+    grpc::Status Migrate(grpc::ServerContext* aContext,
+                         const rpc::State*    aState,
+                         rpc::StateResponse*  aResponse) override;
+
+    /**
+     * Send a state in chunks, the first one with the total size.
+     *
+     * \return false if the client has gone before receiving all of them.
+     */
+    template <class WRITER>
+    static bool
+    send(const std::string& aName, const Payload& aContent, WRITER& aWriter);
+
+    //! Mark a state as being pulled. \return false if it already is.
+    bool startPull(const std::string& aName);
+
+    //! Mark a state as no longer being pulled.
+    void stopPull(const std::string& aName);
+
    private:
-    std::mutex                         theMutex;
-    std::map<std::string, std::string> theStateRepo;
+    StateRepo theStateRepo;
+
+    // names of the states being pulled, which cannot be pulled again until
+    // the transfer is complete
+    std::mutex                      thePullMutex;
+    std::unordered_set<std::string> thePulling;
   };
 
  public:
-  explicit StateServer(const std::string& aEndpoint);
+  //! Size of the chunks sent by GetStream, in bytes.
+  static constexpr size_t theChunkSize = 1 << 20;
+
+  /**
+   * \param aEndpoint the listening end-point of this server.
+   *
+   * \param aShards the number of shards of the state repository.
+   *
+   * \param aMemoryCap the maximum size, in bytes, of the states kept in
+   * memory; 0 means unlimited.
+   *
+   * \param aSpillPath the path of the file where states are moved when
+   * the memory cap is exceeded.
+   */
+  explicit StateServer(const std::string& aEndpoint,
+                       const size_t       aShards    = 16,
+                       const size_t       aMemoryCap = 0,
+                       const std::string& aSpillPath = std::string());
 
  private:
   grpc::Service& service() override {
@@ -38,6 +38,7 @@ SOFTWARE.
 #include <cassert>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
 
 namespace uiiit {
 namespace edge {
@@ -46,25 +47,20 @@ namespace edge {
 // class UtilEstimator::LambdaDescriptor
 
 UtilEstimator::LambdaDescriptor::LambdaDescriptor(
-    UtilEstimator& aParent, const std::string& aDestination)
+    UtilEstimator&      aParent,
+    ComputerDescriptor& aComputer,
+    const std::string&  aDestination)
     : theParent(aParent)
+    , theComputer(aComputer)
     , theDestination(aDestination)
     , theEstimators() {
 }
 
 float UtilEstimator::LambdaDescriptor::ptime(const size_t aInputSize) {
   // find the last available load: if none then it is assumed to be 0
-  auto jt = theParent.theComputers.find(theDestination);
-  assert(jt != theParent.theComputers.end());
-  if (jt == theParent.theComputers.end()) {
-    LOG(WARNING) << "cannot estimate processing time of current lambda because "
-                 << "its destination " << theDestination << " has disappeared";
-    return 0.0f;
-  }
-  assert(jt->second != nullptr);
   unsigned int myLoad;
   double       myDeltaT;
-  std::tie(myLoad, myDeltaT) = jt->second->lastLoad();
+  std::tie(myLoad, myDeltaT) = theComputer.lastLoad();
 
   // find the estimate for the given size: if not found then return 0
   const auto it = theEstimators.find(aInputSize);
@@ -138,14 +134,23 @@ void UtilEstimator::ComputerDescriptor::add(const unsigned int aLoad1) {
 ////////////////////////////////////////////////////////////////////////////////
 // class UtilEstimator
 
-UtilEstimator::UtilEstimator(const double aLoadTimeout,
-                             const size_t aUtilWindowSize)
+UtilEstimator::UtilEstimator(
+    const double                           aLoadTimeout,
+    const size_t                           aUtilWindowSize,
+    const std::shared_ptr<DestinationIds>& aIds)
     : theLoadTimeout(aLoadTimeout)
     , theWindowSize(aUtilWindowSize)
     , theComputers()
-    , theTable([this](const std::string&, const std::string& aDestination) {
-      return std::make_unique<LambdaDescriptor>(*this, aDestination);
-    }) {
+    , theTable(
+          [this](const std::string&, const std::string& aDestination) {
+            // the computer descriptor is always created before the lambda's
+            const auto it = theComputers.find(aDestination);
+            assert(it != theComputers.end() and it->second != nullptr);
+            return std::make_unique<LambdaDescriptor>(
+                *this, *it->second, aDestination);
+          },
+          aIds)
+    , thePtimes() {
 }
 
 UtilEstimator::~UtilEstimator() {
@@ -153,45 +158,49 @@ UtilEstimator::~UtilEstimator() {
 }
 
 std::tuple<std::string, float, float>
-UtilEstimator::best(const std::string&                  aLambda,
-                    const size_t                        aInputSize,
-                    const std::map<std::string, float>& aRtts) {
-  const auto myPtimes =
-      theTable.all(aLambda, [aInputSize](LambdaDescriptor& aLambdaDescriptor) {
-        return aLambdaDescriptor.ptime(aInputSize);
-      });
+UtilEstimator::best(const std::string&                     aLambda,
+                    const size_t                           aInputSize,
+                    const std::vector<float>&              aRtts,
+                    const std::vector<DestinationIds::Id>& aDestinations) {
+  // the two vectors can be navigated together only if they refer to the
+  // same destinations, in the same order, which is the case if the RTT
+  // estimator shares the destination identifiers and has the same pairs
+  const auto& myDestinations = theTable.destinations(aLambda);
+  if (aDestinations != myDestinations or aRtts.size() != aDestinations.size()) {
+    throw std::runtime_error(
+        "mismatching destinations of RTT and processing time estimates: " +
+        aLambda);
+  }
 
-  // the tables pTimes and aRtts should have the same keys, hence they can be
-  // navigated one step at a time together
-  assert(not myPtimes.empty());
-  assert(aRtts.size() == myPtimes.size());
-
-  std::tuple<std::string, float, float> ret;
-  auto myMinTime = std::numeric_limits<float>::max();
-  auto it        = aRtts.begin();
-  auto jt        = myPtimes.begin();
-  for (; it != aRtts.end() and jt != myPtimes.end(); ++it, ++jt) {
-    assert(it->first == jt->first);
-    const auto myCurTime = it->second + jt->second;
-    VLOG(2) << aLambda << ", in_size " << aInputSize << ", destination "
-            << it->first << ", rtt_est " << it->second << " s, ptime_est "
-            << jt->second << " s, tot_est " << myCurTime << " s, candidate "
-            << myMinTime << " s";
-    assert(not std::isnan(it->second));
-    assert(not std::isnan(jt->second));
+  theTable.values(
+      aLambda,
+      [aInputSize](LambdaDescriptor& aLambdaDescriptor) {
+        return aLambdaDescriptor.ptime(aInputSize);
+      },
+      thePtimes);
+  assert(not thePtimes.empty());
+  assert(aRtts.size() == thePtimes.size());
+
+  auto   myMinTime = std::numeric_limits<float>::max();
+  size_t myMinPos  = thePtimes.size();
+  for (size_t i = 0; i < thePtimes.size(); i++) {
+    const auto myCurTime = aRtts[i] + thePtimes[i];
+    assert(not std::isnan(aRtts[i]));
+    assert(not std::isnan(thePtimes[i]));
     if (myCurTime < myMinTime) {
-      std::get<BT_DEST>(ret)  = it->first;
-      std::get<BT_RTT>(ret)   = it->second;
-      std::get<BT_PTIME>(ret) = jt->second;
-      myMinTime               = myCurTime;
+      myMinPos  = i;
+      myMinTime = myCurTime;
     }
   }
 
-  assert(it == aRtts.end());
-  assert(jt == myPtimes.end());
-  assert(myMinTime < std::numeric_limits<float>::max());
+  assert(myMinPos < thePtimes.size());
+  const auto& myDestination = theTable.name(myDestinations[myMinPos]);
+  VLOG(2) << aLambda << ", in_size " << aInputSize << ", destination "
+          << myDestination << ", rtt_est " << aRtts[myMinPos]
+          << " s, ptime_est " << thePtimes[myMinPos] << " s, tot_est "
+          << myMinTime << " s";
 
-  return ret;
+  return std::make_tuple(myDestination, aRtts[myMinPos], thePtimes[myMinPos]);
 }
 
 std::pair<std::string, float>
@@ -44,6 +44,7 @@ SOFTWARE.
 #include <set>
 #include <string>
 #include <tuple>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -52,19 +53,24 @@ class UtilEstimator final
 {
   NONCOPYABLE_NONMOVABLE(UtilEstimator);
 
+  class ComputerDescriptor;
+
   class LambdaDescriptor
   {
     NONCOPYABLE_NONMOVABLE(LambdaDescriptor);
 
    public:
     /**
-     * \param aParent the class containing this one, required to retrieve the
-     * computer loads.
+     * \param aParent the class containing this one.
+     *
+     * \param aComputer the descriptor of the computer serving this lambda
+     * function, which must outlive this object.
      *
      * \param aDestination the computer serving this lambda function.
      */
-    explicit LambdaDescriptor(UtilEstimator&     aParent,
-                              const std::string& aDestination);
+    explicit LambdaDescriptor(UtilEstimator&      aParent,
+                              ComputerDescriptor& aComputer,
+                              const std::string&  aDestination);
 
     //! Estimate the processing time, in s.
     float ptime(const size_t aInputSize);
@@ -81,8 +87,9 @@ class UtilEstimator final
 
    private:
     // ctor configuration
-    UtilEstimator&    theParent;
-    const std::string theDestination;
+    UtilEstimator&      theParent;
+    ComputerDescriptor& theComputer;
+    const std::string   theDestination;
 
     // one linear estimator per input size
     std::map<size_t, std::unique_ptr<support::LinearEstimator>> theEstimators;
@@ -136,9 +143,14 @@ class UtilEstimator final
    *
    * \param aUtilWindowSize the number of samples to keep in the moving window
    * to estimate the variance of the load1 values.
+   *
+   * \param aIds the identifiers of the destinations, which must be shared
+   * with the RTT estimator whose estimates are passed to best().
    */
-  explicit UtilEstimator(const double aLoadTimeout,
-                         const size_t aUtilWindowSize);
+  explicit UtilEstimator(const double                           aLoadTimeout,
+                         const size_t                           aUtilWindowSize,
+                         const std::shared_ptr<DestinationIds>& aIds =
+                             std::make_shared<DestinationIds>());
 
   ~UtilEstimator();
 
@@ -154,14 +166,20 @@ class UtilEstimator final
    * \param aLambda the lambda function name.
    * \param aInputSize the lambda input size.
    * \param aRtts the estimated RTTs for each possible destination.
+   * \param aDestinations the identifiers of the destinations of aRtts, in the
+   * same order, see RttEstimator::rtts().
    *
    * \return a tuple containing: the destination selected, the estimated RTT,
    * the estimated processing time.
+   *
+   * \throw std::runtime_error if the destinations of the RTTs are not those
+   * of the lambda in this estimator, in the same order.
    */
   std::tuple<std::string, float, float>
-  best(const std::string&                  aLambda,
-       const size_t                        aInputSize,
-       const std::map<std::string, float>& aRtts);
+  best(const std::string&                     aLambda,
+       const size_t                           aInputSize,
+       const std::vector<float>&              aRtts,
+       const std::vector<DestinationIds::Id>& aDestinations);
 
   /**
    * \param aInputSize the size of the input lambda function
@@ -210,6 +228,7 @@ class UtilEstimator final
   std::map<std::string, std::unique_ptr<ComputerDescriptor>>
                                      theComputers; // key: dest
   DestinationTable<LambdaDescriptor> theTable;     // key: dest, lambda
+  std::vector<float>                 thePtimes;    // used only in best()
 };
 
 } // namespace edge
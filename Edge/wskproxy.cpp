@@ -89,7 +89,7 @@ void WskProxy::handleInvocation(web::http::http_request aReq) {
           theEndpoint, LambdaRequest(myLambdaName, myBody), false);
       VLOG(1) << res.second << ' ' << res.first;
 
-      if (res.first.theRetCode != "OK") {
+      if (not res.first.ok()) {
         aReq.reply(web::http::status_codes::NotFound,
                    std::string("{\"error\":\"") + res.first.theRetCode + "\"}");
       } else {
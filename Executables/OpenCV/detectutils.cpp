@@ -69,7 +69,7 @@ detect(uiiit::edge::EdgeClientInterface& aClient,
       uiiit::edge::LambdaRequest(aLambdaFaces, "", myImgString), false);
 
   // exit immediately if there were errors
-  if (myRespFaces.theRetCode != "OK") {
+  if (not myRespFaces.ok()) {
     throw std::runtime_error("error: " + myRespFaces.theRetCode);
   }
 
@@ -96,7 +96,7 @@ detect(uiiit::edge::EdgeClientInterface& aClient,
       const auto myRespEyes = aClient.RunLambda(myReq, false);
 
       // exit immediately if there were errors
-      if (myRespEyes.theRetCode != "OK") {
+      if (not myRespEyes.ok()) {
         throw std::runtime_error("error: " + myRespEyes.theRetCode);
       }
 
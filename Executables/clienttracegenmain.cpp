@@ -29,6 +29,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Detail/tracefile.h"
 #include "Support/glograii.h"
 
 #include <boost/program_options.hpp>
@@ -55,6 +56,7 @@ int main(int argc, char* argv[]) {
   double      myStartingTime;
   double      myDuration;
   std::string myOutfile;
+  std::string myFormat;
   size_t      mySeedUser;
 
   po::options_description myDesc("Allowed options");
@@ -88,7 +90,10 @@ int main(int argc, char* argv[]) {
     ("output-file",
      po::value<std::string>(&myOutfile)->default_value("/dev/stdout"),
      "Output filename.")
-    ("append", "Append to output, do not overwrite.")
+    ("format",
+     po::value<std::string>(&myFormat)->default_value("text"),
+     "Output format, one of: text, binary. The binary format is memory-mapped by edgemulticlient and keeps the identifier of the client of every event.")
+    ("append", "Append to output, do not overwrite. Only valid with text format.")
     ("seed",
      po::value<size_t>(&mySeedUser)->default_value(0),
      "Seed generator.")
@@ -123,18 +128,17 @@ int main(int argc, char* argv[]) {
                                " < min size " + std::to_string(myMinSize));
     }
 
-    auto myOutMode = std::ofstream::out;
-    if (myVarMap.count("append")) {
-      myOutMode |= std::ofstream::app;
+    if (myFormat != "text" and myFormat != "binary") {
+      throw std::runtime_error("Invalid output format: " + myFormat);
     }
-    std::ofstream myOut(myOutfile, myOutMode);
-    if (not myOut.is_open()) {
-      throw std::runtime_error("Could not open '" + myOutfile + "'");
+    if (myFormat == "binary" and myVarMap.count("append")) {
+      throw std::runtime_error("Cannot append to a binary trace");
     }
 
     struct Event {
       double theTime;
       size_t theSize;
+      size_t theClient;
       bool   operator<(const Event& aOther) const noexcept {
         return theTime < aOther.theTime;
       }
@@ -151,13 +155,35 @@ int main(int argc, char* argv[]) {
       double myNextTime = myExpRv(myGenerator);
       while (myNextTime < myDuration) {
         myEvents.emplace_back(
-            Event{myStartingTime + myNextTime, myUniRv(myGenerator)});
+            Event{myStartingTime + myNextTime, myUniRv(myGenerator), i});
         myNextTime += myExpRv(myGenerator);
       }
     }
 
     myEvents.sort();
 
+    if (myFormat == "binary") {
+      uiiit::edge::detail::TraceWriter myWriter(myOutfile);
+      for (const auto& myEvent : myEvents) {
+        myWriter.add(myEvent.theTime,
+                     myLambda,
+                     myServerEndpoint,
+                     myEvent.theSize,
+                     static_cast<uint32_t>(myEvent.theClient));
+      }
+      myWriter.close();
+      return EXIT_SUCCESS;
+    }
+
+    auto myOutMode = std::ofstream::out;
+    if (myVarMap.count("append")) {
+      myOutMode |= std::ofstream::app;
+    }
+    std::ofstream myOut(myOutfile, myOutMode);
+    if (not myOut.is_open()) {
+      throw std::runtime_error("Could not open '" + myOutfile + "'");
+    }
+
     for (const auto& myEvent : myEvents) {
       myOut << myEvent.theTime << ' ' << myLambda << ' ' << myServerEndpoint
             << ' ' << myEvent.theSize << '\n';
@@ -29,10 +29,13 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Detail/hdrhistogram.h"
+#include "Edge/Detail/resultlog.h"
 #include "Edge/Model/chainfactory.h"
 #include "Edge/Model/dagfactory.h"
 #include "Edge/callbackserver.h"
 #include "Edge/stateserver.h"
+#include "Simulation/openloopclient.h"
 #include "Simulation/unifclient.h"
 #include "Support/chrono.h"
 #include "Support/glograii.h"
@@ -119,6 +122,8 @@ int main(int argc, char* argv[]) {
   std::string mySizes;
   std::string myContent;
   std::string myOutputFile;
+  std::string myOutputFormat;
+  double      myStatsInterval;
   std::string myChainConf;
   std::string myDagConf;
   std::string myCallback;
@@ -129,6 +134,7 @@ int main(int argc, char* argv[]) {
   double      myInitialDelay;
   double      myInterRequestTime;
   std::string myInterRequestType;
+  size_t      myMaxPending;
   size_t      mySeedUser;
 
   po::options_description myDesc("Allowed options");
@@ -153,6 +159,12 @@ int main(int argc, char* argv[]) {
     ("output-file",
      po::value<std::string>(&myOutputFile)->default_value("/dev/stdout"),
      "Output file name. If specified suppresses normal output.")
+    ("output-format",
+     po::value<std::string>(&myOutputFormat)->default_value("text"),
+     "Output file format, one of: text, binary. The binary format has one fixed-size record per response, see ResultLog.")
+    ("stats-interval",
+     po::value<double>(&myStatsInterval)->default_value(0),
+     "Log the latency percentiles of the last interval with this period, in s. 0 means never.")
     ("duration",
      po::value<size_t>(&myDuration)->default_value(0),
      "Experiment duration, in s. 0 means infinite.")
@@ -171,6 +183,10 @@ int main(int argc, char* argv[]) {
     ("inter-request-type",
      po::value<std::string>(&myInterRequestType)->default_value("constant"),
      "One of: constant, uniform, poisson.")
+    ("open-loop", "Send the requests at the scheduled times without waiting for the previous responses and measure the latency from the intended send time. Requires a positive --inter-request-time and is incompatible with function chains, DAGs, and callbacks.")
+    ("max-pending",
+     po::value<size_t>(&myMaxPending)->default_value(100000),
+     "Maximum number of requests in progress per thread, further arrivals are dropped. Only meaningful with --open-loop.")
     ("chain-conf",
      po::value<std::string>(&myChainConf)->default_value(""),
      "Function chain configuration. Load from file with type=file,filename=CHAINFILE.json. Use type=make-template to generated an example. If present override --lambda.")
@@ -207,6 +223,10 @@ int main(int argc, char* argv[]) {
       throw std::runtime_error("Empty end-points: " + myServerEndpoints);
     }
 
+    if (myOutputFormat != "text" and myOutputFormat != "binary") {
+      throw std::runtime_error("Invalid output format: " + myOutputFormat);
+    }
+
     if (not myChainConf.empty() and not myDagConf.empty()) {
       throw std::runtime_error("Cannot specify both a chain and a DAG");
     }
@@ -235,6 +255,13 @@ int main(int argc, char* argv[]) {
       }
     }
 
+    const auto myOpenLoop = myVarMap.count("open-loop") > 0;
+    if (myOpenLoop and (not myChainConf.empty() or not myDagConf.empty() or
+                        not myCallback.empty())) {
+      throw std::runtime_error("Cannot use --open-loop with function chains, "
+                               "DAGs, or callbacks");
+    }
+
     if (not myCallback.empty() and myNumThreads > 1) {
       throw std::runtime_error(
           "With asynchronous responses it is currently not "
@@ -277,25 +304,60 @@ int main(int argc, char* argv[]) {
     std::this_thread::sleep_for(
         std::chrono::nanoseconds(static_cast<int64_t>(myInitialDelay * 1e9)));
 
+    std::unique_ptr<ec::detail::ResultLog> myResultLog;
+    if (myOutputFormat == "binary") {
+      if (myVarMap.count("append") > 0) {
+        throw std::runtime_error(
+            "Cannot append to an output file in binary format");
+      }
+      myResultLog = std::make_unique<ec::detail::ResultLog>(myOutputFile);
+    }
     const uiiit::support::Saver mySaver(
-        myOutputFile, true, myDuration == 0, myVarMap.count("append") == 1);
-    using ClientPtr = std::unique_ptr<es::UnifClient>;
+        myResultLog ? std::string() : myOutputFile,
+        true,
+        myDuration == 0,
+        myVarMap.count("append") == 1);
+    using ClientPtr = std::unique_ptr<es::Client>;
     uiiit::support::ThreadPool<ClientPtr> myPool;
     std::list<es::Client*>                myClients;
+    std::list<es::OpenLoopClient*>        myOpenLoopClients;
     for (size_t i = 0; i < myNumThreads; i++) {
-      auto myNewClient = ClientPtr(new es::UnifClient(
-          mySizeSet,
-          myInterRequestTime,
-          es::distributionFromString(myInterRequestType),
-          mySeedUser,
-          i,
-          myMaxRequests,
-          uiiit::support::split<std::set<std::string>>(myServerEndpoints, ","),
-          myVarMap.count("secure") == 1,
-          myEdgeClientConf,
-          (myChain.get() == nullptr and myDag.get() == nullptr) ? myLambda : "",
-          mySaver,
-          myVarMap.count("dry") > 0));
+      ClientPtr myNewClient(nullptr);
+      if (myOpenLoop) {
+        auto myOpenLoopClient = new es::OpenLoopClient(
+            mySizeSet,
+            myInterRequestTime,
+            es::distributionFromString(myInterRequestType),
+            myMaxPending,
+            mySeedUser,
+            i,
+            myMaxRequests,
+            uiiit::support::split<std::set<std::string>>(myServerEndpoints,
+                                                         ","),
+            myVarMap.count("secure") == 1,
+            myEdgeClientConf,
+            myLambda,
+            mySaver,
+            myVarMap.count("dry") > 0);
+        myOpenLoopClients.push_back(myOpenLoopClient);
+        myNewClient.reset(myOpenLoopClient);
+      } else {
+        myNewClient.reset(new es::UnifClient(
+            mySizeSet,
+            myInterRequestTime,
+            es::distributionFromString(myInterRequestType),
+            mySeedUser,
+            i,
+            myMaxRequests,
+            uiiit::support::split<std::set<std::string>>(myServerEndpoints,
+                                                         ","),
+            myVarMap.count("secure") == 1,
+            myEdgeClientConf,
+            (myChain.get() == nullptr and myDag.get() == nullptr) ? myLambda :
+                                                                    "",
+            mySaver,
+            myVarMap.count("dry") > 0));
+      }
       myNewClient->setContent(myContent);
       if (not myCallback.empty()) {
         myNewClient->setCallback(myCallback);
@@ -307,6 +369,9 @@ int main(int argc, char* argv[]) {
         myNewClient->setDag(*myDag, myStateSizes);
       }
       myNewClient->setStateServer(myStateEndpoint); // end-point can be empty
+      if (myResultLog) {
+        myNewClient->setResultLog(*myResultLog);
+      }
       myClients.push_back(myNewClient.get());
       myPool.add(std::move(myNewClient));
     }
@@ -325,8 +390,24 @@ int main(int argc, char* argv[]) {
       });
     }
 
+    // merge the per-client histograms
+    const auto myLatencies = [&myClients]() {
+      ec::detail::HdrHistogram ret;
+      for (const auto myClient : myClients) {
+        ret.add(myClient->latencyHistogram());
+      }
+      return ret;
+    };
+
+    std::unique_ptr<ec::detail::HdrIntervalReporter> myReporter;
+    if (myStatsInterval > 0) {
+      myReporter = std::make_unique<ec::detail::HdrIntervalReporter>(
+          myStatsInterval, "latency (us)", myLatencies);
+    }
+
     myPool.start();
     const auto& myErrors = myPool.wait();
+    myReporter.reset();
 
     if (myTerminationThread.joinable()) {
       myTerminationThread.join();
@@ -346,6 +427,16 @@ int main(int argc, char* argv[]) {
           << myClient->processingStat().stddev();
     }
 
+    const auto myLatency = myLatencies();
+    LOG_IF(INFO, myLatency.count() > 0)
+        << "latency (us) " << myLatency.summary();
+
+    for (auto myClient : myOpenLoopClients) {
+      assert(myClient != nullptr);
+      LOG_IF(WARNING, myClient->dropped() > 0)
+          << myClient->dropped() << " arrivals dropped";
+    }
+
     return EXIT_SUCCESS;
   } catch (const std::exception& aErr) {
     LOG(ERROR) << "Exception caught: " << aErr.what();
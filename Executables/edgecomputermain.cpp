@@ -65,6 +65,13 @@ int main(int argc, char* argv[]) {
   std::string myCompanionEndpoint;
   std::string myStateEndpoint;
   std::string myHttpConfStr;
+  size_t      myCallbackCache;
+  double      myCallbackTimeout;
+  size_t      myCallbackQueue;
+  size_t      myCallbackThreads;
+  size_t      myStateMemoryCap;
+  std::string myStateSpillPath;
+  size_t      myCallbackBatch;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -87,6 +94,27 @@ int main(int argc, char* argv[]) {
    po::value<std::string>(&myStateEndpoint)->default_value(""),
    "Use the given end-point to get/set the states. If the --no-state-server option is not specified, then a state server is also created listening at this end-point.")
   ("no-state-server", "Do not create a state server. Only makes sense if --state-endpoint is not empty.")
+  ("state-memory-cap",
+   po::value<size_t>(&myStateMemoryCap)->default_value(0),
+   "Maximum size, in bytes, of the states kept in memory by the state server, the others are moved to the file specified with --state-spill-file. 0 means unlimited.")
+  ("state-spill-file",
+   po::value<std::string>(&myStateSpillPath)->default_value("states.spill"),
+   "File where the state server moves the states exceeding the memory cap.")
+  ("callback-cache",
+   po::value<size_t>(&myCallbackCache)->default_value(100),
+   "Maximum number of clients cached to send responses to callback servers. Only used with asynchronous computers.")
+  ("callback-batch",
+   po::value<size_t>(&myCallbackBatch)->default_value(1),
+   "If greater than 1, send responses to callback servers in batches of up to this size. Only used with asynchronous computers.")
+  ("callback-timeout",
+   po::value<double>(&myCallbackTimeout)->default_value(5),
+   "Deadline, in s, of the calls to callback servers; 0 means no deadline. Only used with asynchronous computers.")
+  ("callback-queue",
+   po::value<size_t>(&myCallbackQueue)->default_value(10000),
+   "Maximum number of responses queued for the callback servers, beyond which they are dropped; 0 means unlimited. Only used with --callback-batch greater than 1.")
+  ("callback-threads",
+   po::value<size_t>(&myCallbackThreads)->default_value(4),
+   "Number of threads sending responses to the callback servers, each serving one end-point at a time. Only used with --callback-batch greater than 1.")
   ("conf",
    po::value<std::string>(&myConf)->default_value(
      "type=raspberry,"
@@ -174,10 +202,20 @@ int main(int argc, char* argv[]) {
       myEdgeComputer->companion(myCompanionEndpoint);
     }
 
+    if (myAsynchronous) {
+      myEdgeComputer->callback(
+          myCallbackCache,
+          myCallbackBatch,
+          static_cast<unsigned int>(0.5 + myCallbackTimeout * 1e3),
+          myCallbackQueue,
+          myCallbackThreads);
+    }
+
     std::unique_ptr<ec::StateServer> myStateServer;
     if (not myStateEndpoint.empty() and
         myCli.varMap().count("no-state-server") == 0) {
-      myStateServer = std::make_unique<ec::StateServer>(myStateEndpoint);
+      myStateServer = std::make_unique<ec::StateServer>(
+          myStateEndpoint, 16, myStateMemoryCap, myStateSpillPath);
       myStateServer->run(false);
     }
     myEdgeComputer->state(myStateEndpoint); // end-point can be empty
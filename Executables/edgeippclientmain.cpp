@@ -29,8 +29,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Detail/hdrhistogram.h"
 #include "Edge/edgeclientgrpc.h"
 #include "Simulation/ippclient.h"
+#include "Simulation/openloopclient.h"
 #include "Simulation/poissonclient.h"
 #include "Support/chrono.h"
 #include "Support/glograii.h"
@@ -68,6 +70,8 @@ int main(int argc, char* argv[]) {
   double      myOffMean;
   double      myPeriodMean;
   double      myBurstSizeMean;
+  double      myRate;
+  size_t      myMaxPending;
   double      mySleepMin;
   double      mySleepMax;
   std::string myContent;
@@ -90,7 +94,7 @@ int main(int argc, char* argv[]) {
      "Lambda function name.")
     ("client-type",
      po::value<std::string>(&myClientType)->default_value("poisson"),
-     "Client type, one of: ipp, poisson.")
+     "Client type, one of: ipp, open-loop, poisson.")
     ("duration",
      po::value<size_t>(&myDuration)->default_value(0),
      "Experiment duration, in s. 0 means infinite.")
@@ -122,6 +126,14 @@ int main(int argc, char* argv[]) {
      po::value<double>(&myBurstSizeMean)->default_value(5),
      "Average duration of the burst size, in lambda requests. "
      "Only meaningful with poisson clients.")
+    ("rate",
+     po::value<double>(&myRate)->default_value(1000),
+     "Average rate of lambda requests, in requests/s, with exponentially "
+     "distributed inter-arrival times. Only meaningful with open-loop clients.")
+    ("max-pending",
+     po::value<size_t>(&myMaxPending)->default_value(100000),
+     "Maximum number of requests in progress per client, further arrivals "
+     "are dropped. Only meaningful with open-loop clients.")
     ("min-sleep",
      po::value<double>(&mySleepMin)->default_value(0),
      "Minimum sleep duration after a response in an ON period, in s.")
@@ -155,7 +167,13 @@ int main(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
-    static const std::set<std::string> myClientTypes({"ipp", "poisson"});
+    static const std::set<std::string> myClientTypes(
+        {"ipp", "open-loop", "poisson"});
+    if (myClientType == "open-loop" and myRate <= 0) {
+      throw std::runtime_error("Invalid --rate value: " +
+                               std::to_string(myRate));
+    }
+
     if (myClientTypes.count(myClientType) == 0) {
       std::cout << "Invalid client type " << myClientType
                 << ", choose one of: ";
@@ -253,6 +271,42 @@ int main(int argc, char* argv[]) {
                                myLambda,
                                mySaver,
                                false));
+      } else if (myClientType == "open-loop") {
+        myClient.reset(mySizes.empty() ?
+                           new es::OpenLoopClient(
+                               mySizeMin,
+                               mySizeMax,
+                               1.0 / myRate,
+                               es::UnifClient::Distribution::EXPONENTIAL,
+                               myMaxPending,
+                               mySeedUser,
+                               i,
+                               myMaxRequests,
+                               uiiit::support::split<std::set<std::string>>(
+                                   myServerEndpoints, ","),
+                               mySecure,
+                               uiiit::support::Conf(myClientConf),
+                               myLambda,
+                               mySaver,
+                               false) :
+                           new es::OpenLoopClient(
+                               mySizeSet,
+                               1.0 / myRate,
+                               es::UnifClient::Distribution::EXPONENTIAL,
+                               myMaxPending,
+                               mySeedUser,
+                               i,
+                               myMaxRequests,
+                               uiiit::support::split<std::set<std::string>>(
+                                   myServerEndpoints, ","),
+                               mySecure,
+                               uiiit::support::Conf(myClientConf),
+                               myLambda,
+                               mySaver,
+                               false));
+        if (myDuration > 0) {
+          myNumRequestsExpected += myClient->simulate(myDuration);
+        }
       }
       assert(myClient != nullptr);
       myClient->setContent(myContent);
@@ -285,9 +339,11 @@ int main(int argc, char* argv[]) {
     LOG_IF(ERROR, not myErrors.empty())
         << "Errors occurred:" << myErrorStr.str();
 
-    size_t myRequestsDone = 0;
+    size_t                            myRequestsDone = 0;
+    uiiit::edge::detail::HdrHistogram myLatency;
     for (auto myClient : myClients) {
       assert(myClient != nullptr);
+      myLatency.add(myClient->latencyHistogram());
       LOG_IF(INFO, myClient->latencyStat().count() >= 1)
           << "latency " << myClient->latencyStat().mean() << " +- "
           << myClient->latencyStat().stddev();
@@ -296,6 +352,8 @@ int main(int argc, char* argv[]) {
           << myClient->processingStat().stddev();
       myRequestsDone += myClient->latencyStat().count();
     }
+    LOG_IF(INFO, myLatency.count() > 0)
+        << "latency (us) " << myLatency.summary();
 
     // save number of lost opportunities to send a lambda request
     if (myNumRequestsExpected > 0) {
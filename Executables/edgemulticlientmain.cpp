@@ -29,7 +29,11 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Detail/hdrhistogram.h"
+#include "Edge/Detail/resultlog.h"
+#include "Edge/Detail/tracefile.h"
 #include "Edge/edgeclientpool.h"
+#include "Simulation/tracereplayer.h"
 #include "Support/chrono.h"
 #include "Support/conf.h"
 #include "Support/glograii.h"
@@ -44,6 +48,7 @@ SOFTWARE.
 #include <atomic>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <thread>
 
 namespace po = boost::program_options;
@@ -73,6 +78,18 @@ void readFromFile(const std::string&            aInputFile,
   }
 }
 
+void readFromTrace(const std::string&            aInputFile,
+                   uiiit::support::Queue<Event>& aEvents) {
+  const ec::detail::TraceFile myTrace(aInputFile);
+  for (size_t i = 0; i < myTrace.size(); i++) {
+    const auto& myEvent = myTrace[i];
+    aEvents.push(Event{static_cast<float>(myEvent.theTime * 1e-6),
+                       myTrace.name(myEvent.theLambda),
+                       myTrace.name(myEvent.theServer),
+                       myEvent.theSize});
+  }
+}
+
 struct Consumer {
   Consumer(uiiit::support::Queue<Event>& aEvents,
            std::atomic<size_t>&          aDispatched,
@@ -80,14 +97,17 @@ struct Consumer {
            uiiit::support::Chrono&       aChrono,
            const uiiit::support::Saver&  aSaver,
            uiiit::support::SummaryStat&  aStat,
-           ec::EdgeClientPool&           aClientPool)
+           ec::EdgeClientPool&           aClientPool,
+           ec::detail::ResultLog*        aResultLog)
       : theEvents(aEvents)
       , theDispatched(aDispatched)
       , theDeadlineMisses(aDeadlineMisses)
       , theChrono(aChrono)
       , theSaver(aSaver)
       , theStat(aStat)
-      , theClientPool(aClientPool) {
+      , theClientPool(aClientPool)
+      , theResultLog(aResultLog)
+      , theHistogram() {
   }
 
   void consume() {
@@ -111,9 +131,19 @@ struct Consumer {
 
     const auto ret = theClientPool(myEvent.theEdgeServer, myReq, false);
 
-    if (ret.first.theRetCode == "OK") {
-      theSaver(ret.second, ret.first.theLoad1, ret.first.theResponder, false);
+    if (ret.first.ok()) {
+      if (theResultLog != nullptr) {
+        (*theResultLog)(ret.second,
+                        ret.first.theLoad1,
+                        ret.first.theResponder,
+                        myEvent.theLambda,
+                        ret.first.theHops,
+                        ret.first.processingTimeSeconds());
+      } else {
+        theSaver(ret.second, ret.first.theLoad1, ret.first.theResponder, false);
+      }
       theStat(ret.second);
+      theHistogram.record(static_cast<uint64_t>(ret.second * 1e6 + 0.5));
       VLOG(1) << "at " << myEvent.theTime << " s, " << myEvent.theLambda
               << ", to " << myEvent.theEdgeServer << ", took "
               << (myEvent.theTime * 1e3 + 0.5) << " ms, deadline "
@@ -133,15 +163,21 @@ struct Consumer {
   const uiiit::support::Saver&  theSaver;
   uiiit::support::SummaryStat&  theStat;
   ec::EdgeClientPool&           theClientPool;
+  ec::detail::ResultLog*        theResultLog; // can be null
+  ec::detail::HdrHistogram      theHistogram; // latencies, in us
 };
 
 int main(int argc, char* argv[]) {
   uiiit::support::GlogRaii myGlogRaii(argv[0]);
 
   std::string myInputFile;
+  std::string myInputFormat;
   std::string myOutputFile;
+  std::string myOutputFormat;
   std::string myClientConf;
   size_t      myNumThreads;
+  size_t      myNumLoops;
+  double      myStatsInterval;
 
   po::options_description myDesc("Allowed options");
   // clang-format off
@@ -153,9 +189,21 @@ int main(int argc, char* argv[]) {
     ("input-file",
      po::value<std::string>(&myInputFile)->default_value("/dev/stdin"),
      "Input file name.")
+    ("input-format",
+     po::value<std::string>(&myInputFormat)->default_value("text"),
+     "Input file format, one of: text, binary. The binary format is produced by clienttracegen --format binary.")
+    ("event-loops",
+     po::value<size_t>(&myNumLoops)->default_value(0),
+     "If positive, replay the trace with one virtual client per trace client, multiplexed on this number of event loops through asynchronous gRPC calls, instead of using --num-threads blocking clients. Requires a binary input; --client-conf is ignored.")
     ("output-file",
      po::value<std::string>(&myOutputFile)->default_value(""),
      "Output file name. Do not save latencies if empty.")
+    ("output-format",
+     po::value<std::string>(&myOutputFormat)->default_value("text"),
+     "Output file format, one of: text, binary. The binary format has one fixed-size record per response, see ResultLog.")
+    ("stats-interval",
+     po::value<double>(&myStatsInterval)->default_value(0),
+     "Log the latency percentiles of the last interval with this period, in s. 0 means never.")
      ("client-conf", 
      po::value<std::string>(&myClientConf)->default_value("type=grpc,persistence=0.05"),
      "Client configuration.")
@@ -173,8 +221,57 @@ int main(int argc, char* argv[]) {
       return EXIT_FAILURE;
     }
 
+    if (myInputFormat != "text" and myInputFormat != "binary") {
+      throw std::runtime_error("Invalid input format: " + myInputFormat);
+    }
+    if (myOutputFormat != "text" and myOutputFormat != "binary") {
+      throw std::runtime_error("Invalid output format: " + myOutputFormat);
+    }
+    if (myNumLoops > 0 and myInputFormat != "binary") {
+      throw std::runtime_error("Event loops require a binary input");
+    }
+
+    std::unique_ptr<ec::detail::ResultLog> myResultLog;
+    if (myOutputFormat == "binary" and not myOutputFile.empty()) {
+      myResultLog = std::make_unique<ec::detail::ResultLog>(myOutputFile);
+    }
+    const auto mySaverPath = myResultLog ? std::string() : myOutputFile;
+
+    if (myNumLoops > 0) {
+      const ec::detail::TraceFile      myTrace(myInputFile);
+      const uiiit::support::Saver      mySaver(mySaverPath, true, false, false);
+      uiiit::simulation::TraceReplayer myReplayer(
+          myTrace,
+          myNumLoops,
+          myVarMap.count("secure") == 1,
+          mySaver,
+          myResultLog.get());
+
+      std::unique_ptr<ec::detail::HdrIntervalReporter> myReporter;
+      if (myStatsInterval > 0) {
+        myReporter = std::make_unique<ec::detail::HdrIntervalReporter>(
+            myStatsInterval, "latency (us)", [&myReplayer]() {
+              return myReplayer.latencies();
+            });
+      }
+      myReplayer.run();
+      myReporter.reset();
+
+      LOG(INFO) << "dispatched      " << myReplayer.dispatched() << " / "
+                << myTrace.size();
+      LOG(INFO) << "failed          " << myReplayer.failed();
+      LOG(INFO) << "slip (us)       " << myReplayer.slips().summary();
+      LOG(INFO) << "latency (us)    " << myReplayer.latencies().summary();
+
+      return EXIT_SUCCESS;
+    }
+
     uiiit::support::Queue<Event> myEvents;
-    readFromFile(myInputFile, myEvents);
+    if (myInputFormat == "binary") {
+      readFromTrace(myInputFile, myEvents);
+    } else {
+      readFromFile(myInputFile, myEvents);
+    }
     const auto myTotalEvents = myEvents.size();
 
     LOG(INFO) << "read " << myTotalEvents << " events from " << myInputFile;
@@ -184,7 +281,7 @@ int main(int argc, char* argv[]) {
     std::atomic<bool>   myError{false};
 
     uiiit::support::Chrono      myChrono(true);
-    const uiiit::support::Saver mySaver(myOutputFile, true, false, false);
+    const uiiit::support::Saver mySaver(mySaverPath, true, false, false);
     uiiit::support::SummaryStat myStat;
     ec::EdgeClientPool          myClientPool(myVarMap.count("secure") == 1,
                                     uiiit::support::Conf(myClientConf),
@@ -199,7 +296,8 @@ int main(int argc, char* argv[]) {
                                         myChrono,
                                         mySaver,
                                         myStat,
-                                        myClientPool));
+                                        myClientPool,
+                                        myResultLog.get()));
       auto& myConsumer = myConsumers.back();
       myThreads.emplace_back(std::thread([&myConsumer, &myError]() {
         while (true) {
@@ -219,6 +317,21 @@ int main(int argc, char* argv[]) {
       }));
     }
 
+    // merge the per-thread histograms
+    const auto myLatencies = [&myConsumers]() {
+      ec::detail::HdrHistogram ret;
+      for (const auto& myConsumer : myConsumers) {
+        ret.add(myConsumer.theHistogram);
+      }
+      return ret;
+    };
+
+    std::unique_ptr<ec::detail::HdrIntervalReporter> myReporter;
+    if (myStatsInterval > 0) {
+      myReporter = std::make_unique<ec::detail::HdrIntervalReporter>(
+          myStatsInterval, "latency (us)", myLatencies);
+    }
+
     while (myDispatched.load() < myTotalEvents and not myError.load()) {
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
@@ -227,11 +340,13 @@ int main(int argc, char* argv[]) {
     for (auto& myThread : myThreads) {
       myThread.join();
     }
+    myReporter.reset();
 
     LOG(INFO) << "dispatched      " << myDispatched.load() << " / "
               << myTotalEvents;
     LOG(INFO) << "deadline misses " << myDeadlineMisses.load();
     LOG(INFO) << "average latency " << myStat.mean();
+    LOG(INFO) << "latency (us)    " << myLatencies().summary();
 
     return EXIT_SUCCESS;
 
@@ -94,7 +94,7 @@ class LambdaRequestHandler : public BaseHandler
     LambdaResponse myLambdaResp(myProtobufLambdaResp);
     // LOG(INFO) << "LambdaResponse Produced = " << myLambdaResp.toString();
 
-    if (myLambdaResp.theRetCode == std::string("OK")) {
+    if (myLambdaResp.ok()) {
       theResponse.setStatusCode(200);
       theResponse.setStatusMessage("Ok");
     } else {
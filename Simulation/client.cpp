@@ -31,6 +31,7 @@ SOFTWARE.
 
 #include "Simulation/client.h"
 
+#include "Edge/Detail/resultlog.h"
 #include "Edge/edgeclientfactory.h"
 #include "Edge/edgeclientinterface.h"
 #include "Edge/edgemessages.h"
@@ -42,7 +43,9 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
-#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 namespace uiiit {
 namespace simulation {
@@ -56,6 +59,29 @@ Client::Client(const size_t                 aSeedUser,
                const std::string&           aLambda,
                const support::Saver&        aSaver,
                const bool                   aDry)
+    : Client(aSeedUser,
+             aSeedInc,
+             aNumRequests,
+             edge::EdgeClientFactory::make(aServers, aSecure, aClientConf),
+             aLambda,
+             aSaver,
+             aDry) {
+  LOG(INFO) << "created a client with seed (" << aSeedUser << "," << aSeedInc
+            << "), which will send max " << aNumRequests << " requests to "
+            << toString(aServers, ",") << ", "
+            << (aLambda.empty() ?
+                    std::string("function chain mode") :
+                    (std::string("single function mode (") + aLambda + ")"))
+            << (aDry ? ", dry run" : "");
+}
+
+Client::Client(const size_t                                 aSeedUser,
+               const size_t                                 aSeedInc,
+               const size_t                                 aNumRequests,
+               std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+               const std::string&                           aLambda,
+               const support::Saver&                        aSaver,
+               const bool                                   aDry)
     : theSeedUser(aSeedUser)
     , theSeedInc(aSeedInc)
     , theMutex()
@@ -65,30 +91,55 @@ Client::Client(const size_t                 aSeedUser,
     , theFinishedFlag(false)
     , theNotStartedFlag(true)
     , theLambdaChrono(false)
-    , theClient(edge::EdgeClientFactory::make(aServers, aSecure, aClientConf))
+    , theClient(std::move(aClient))
     , theNumRequests(aNumRequests)
     , theLambda(aLambda)
     , theSaver(aSaver)
     , theLatencyStat()
     , theProcessingStat()
+    , theLatencyHistogram()
     , theDry(aDry)
     , theSendRequestQueue()
     , theLastStates()
     , theInvalidStates(false)
+    , theAsyncMutex()
+    , theAsyncCondition()
+    , thePending(0)
     , theSizeDist()
     , theSizes()
     , theChain(nullptr)
     , theStateSizes()
     , theCallback()
     , theContent()
-    , theStateEndpoint() {
-  LOG(INFO) << "created a client with seed (" << aSeedUser << "," << aSeedInc
-            << "), which will send max " << aNumRequests << " requests to "
-            << toString(aServers, ",") << ", "
-            << (aLambda.empty() ?
-                    std::string("function chain mode") :
-                    (std::string("single function mode (") + aLambda + ")"))
-            << (aDry ? ", dry run" : "");
+    , theStateEndpoint()
+    , theResultLog(nullptr) {
+  assert(theClient.get() != nullptr);
+}
+
+Client::ChainExecution::ChainExecution(const std::string& aInput)
+    : theMutex()
+    , theCondition()
+    , theDone(false)
+    , theNext(0)
+    , theInput(aInput)
+    , theDataIn()
+    , theResponse()
+    , theHops(0)
+    , thePtime(0) {
+  // noop
+}
+
+Client::DagExecution::DagExecution(const std::string& aInput)
+    : theMutex()
+    , theCondition()
+    , theInput(aInput)
+    , theCompleted()
+    , theCalled()
+    , theRunning(0)
+    , theFailed(false)
+    , theHops(0)
+    , thePtime(0) {
+  // noop
 }
 
 Client::~Client() {
@@ -114,9 +165,11 @@ void Client::operator()() {
       myCounter += loop();
     }
   } catch (...) {
+    drain();
     finish();
     throw;
   }
+  drain();
   finish();
 }
 
@@ -126,6 +179,13 @@ void Client::finish() {
   theExitCondition.notify_one();
 }
 
+void Client::drain() {
+  std::unique_lock<std::mutex> myLock(theAsyncMutex);
+  LOG_IF(INFO, thePending > 0)
+      << "waiting for " << thePending << " responses in progress";
+  theAsyncCondition.wait(myLock, [this]() { return thePending == 0; });
+}
+
 std::unique_ptr<edge::LambdaResponse>
 Client::singleExecution(const std::string& aInput) {
   assert(not theLambda.empty() or not theCallback.empty());
@@ -173,51 +233,19 @@ Client::functionChain(const std::string& aInput) {
   assert(theLambda.empty());
   assert(theCallback.empty());
   assert(theChain.get() != nullptr);
+  assert(not theChain->functions().empty());
 
-  std::string                           myInput = aInput;
-  std::string                           myDataIn;
-  std::unique_ptr<edge::LambdaResponse> myResp(nullptr);
-  unsigned int                          myHops  = 0;
-  unsigned int                          myPtime = 0;
   validateStates();
-  for (const auto& myFunction : theChain->functions()) {
-    // create a request and fill it with the states needed by the function
-    edge::LambdaRequest myReq(myFunction, myInput, myDataIn);
-    for (const auto& myState : theChain->states().states(myFunction)) {
-      const auto it = theLastStates.find(myState);
-      assert(it != theLastStates.end());
-      myReq.states().emplace(myState, it->second);
-    }
-
-    myReq.theChain = std::make_unique<edge::model::Chain>(
-        theChain->singleFunctionChain(myFunction));
 
-    // run the lambda function
-    myResp = std::make_unique<edge::LambdaResponse>(
-        theClient->RunLambda(myReq, theDry));
-
-    // return immediately upon failure
-    assert(myResp.get() != nullptr);
-    VLOG(2) << *myResp;
-    if (myResp->theRetCode != "OK") {
-      break;
-    }
-
-    // save the states returned
-    for (const auto& elem : myResp->states()) {
-      auto it = theLastStates.find(elem.first);
-      assert(it != theLastStates.end());
-      it->second = elem.second;
-    }
-
-    // use the return value to fill the next input
-    myInput  = myResp->theOutput;
-    myDataIn = myResp->theDataOut;
-
-    // sum the hops and processing time
-    myHops += myResp->theHops;
-    myPtime += myResp->theProcessingTime;
+  // execute the first function, the others are called upon completion
+  ChainExecution myExec(aInput);
+  callChain(myExec);
+  {
+    std::unique_lock<std::mutex> myLock(myExec.theMutex);
+    myExec.theCondition.wait(myLock, [&myExec]() { return myExec.theDone; });
   }
+  auto myResp = std::move(myExec.theResponse);
+  assert(myResp.get() != nullptr);
 
   // save all the states in the final response
   myResp->states() = theLastStates;
@@ -229,98 +257,192 @@ Client::functionChain(const std::string& aInput) {
     myResp->theLoad1          = 0;
     myResp->theLoad10         = 0;
     myResp->theLoad30         = 0;
-    myResp->theHops           = myHops;
-    myResp->theProcessingTime = myPtime;
+    myResp->theHops           = myExec.theHops;
+    myResp->theProcessingTime = myExec.thePtime;
   }
 
   return myResp;
 }
 
+void Client::callChain(ChainExecution& aExec) {
+  // no lock needed: the functions of a chain are executed one at a time
+  assert(aExec.theNext < theChain->functions().size());
+  const auto& myFunction = theChain->functions()[aExec.theNext];
+
+  // create a request and fill it with the states needed by the function
+  edge::LambdaRequest myReq(myFunction, aExec.theInput, aExec.theDataIn);
+  for (const auto& myState : theChain->states().states(myFunction)) {
+    const auto it = theLastStates.find(myState);
+    assert(it != theLastStates.end());
+    myReq.states().emplace(myState, it->second);
+  }
+
+  myReq.theChain = std::make_unique<edge::model::Chain>(
+      theChain->singleFunctionChain(myFunction));
+
+  // run the lambda function
+  theClient->RunLambdaAsync(
+      myReq, theDry, [this, &aExec](edge::LambdaResponse&& aResp) {
+        VLOG(2) << aResp;
+        aExec.theResponse =
+            std::make_unique<edge::LambdaResponse>(std::move(aResp));
+        const auto& myResp = *aExec.theResponse;
+
+        // return immediately upon failure
+        if (myResp.ok()) {
+          // save the states returned
+          for (const auto& elem : myResp.states()) {
+            auto it = theLastStates.find(elem.first);
+            assert(it != theLastStates.end());
+            it->second = elem.second;
+          }
+
+          // use the return value to fill the next input
+          aExec.theInput  = myResp.theOutput;
+          aExec.theDataIn = myResp.theDataOut;
+
+          // sum the hops and processing time
+          aExec.theHops += myResp.theHops;
+          aExec.thePtime += myResp.theProcessingTime;
+
+          if (++aExec.theNext < theChain->functions().size()) {
+            // the waiting thread must be woken up even if the next function
+            // cannot be called, so the failure is turned into a response
+            try {
+              callChain(aExec);
+              return;
+            } catch (const std::exception& aErr) {
+              aExec.theResponse =
+                  std::make_unique<edge::LambdaResponse>(aErr.what(), "");
+            }
+          }
+        }
+
+        const std::lock_guard<std::mutex> myLock(aExec.theMutex);
+        aExec.theDone = true;
+        aExec.theCondition.notify_one();
+      });
+}
+
 std::unique_ptr<edge::LambdaResponse>
 Client::functionDag(const std::string& aInput) {
   assert(theLambda.empty());
   assert(theCallback.empty());
   assert(theDag.get() != nullptr);
 
-  std::atomic<unsigned int> myHops  = 0;
-  std::atomic<unsigned int> myPtime = 0;
-  std::set<size_t>          myCompleted;
-  std::set<size_t>          myCalled;
-  support::Queue<ssize_t>   myQueue;
-  std::list<std::thread>    myThreads;
-
   validateStates();
 
-  while (myCompleted.size() != theDag->numFunctions()) {
-    for (const auto& myIndex : theDag->callable(myCompleted)) {
+  // execute the entry functions, the others are called upon completion of
+  // those they depend on
+  DagExecution myExec(aInput);
+  callDag(myExec);
+  {
+    std::unique_lock<std::mutex> myLock(myExec.theMutex);
+    myExec.theCondition.wait(myLock,
+                             [&myExec]() { return myExec.theRunning == 0; });
+  }
+
+  if (myExec.theFailed) {
+    throw std::runtime_error(
+        "Error received while executing a function in a DAG");
+  }
+  assert(myExec.theCompleted.size() == theDag->numFunctions());
+
+  auto myResp = std::make_unique<edge::LambdaResponse>("OK", aInput);
+
+  // save all the states in the final response
+  myResp->states()          = theLastStates;
+  myResp->theHops           = myExec.theHops;
+  myResp->theProcessingTime = myExec.thePtime;
+
+  return myResp;
+}
+
+void Client::callDag(DagExecution& aExec) {
+  // the functions are started without holding the lock because the callback
+  // may be invoked immediately by the edge client
+  std::vector<size_t> myIndices;
+  {
+    const std::lock_guard<std::mutex> myLock(aExec.theMutex);
+    if (aExec.theFailed) {
+      return;
+    }
+    for (const auto& myIndex : theDag->callable(aExec.theCompleted)) {
       // skip functions already called
-      if (myCalled.count(myIndex) > 0) {
-        continue;
+      if (aExec.theCalled.emplace(myIndex).second) {
+        myIndices.emplace_back(myIndex);
+        aExec.theRunning++;
       }
-      [[maybe_unused]] const auto ret = myCalled.emplace(myIndex);
-      assert(ret.second == true);
-
-      // start a thread to handle this single function in the DAG
-      myThreads.emplace_back(
-          std::thread([this, &myQueue, &aInput, &myHops, &myPtime, myIndex]() {
-            const auto myFunction = theDag->toName(myIndex); // name
-
-            // create a request and fill it with the states needed by the
-            // function
-            edge::LambdaRequest myReq(myFunction, aInput, std::string());
-            for (const auto& myState : theDag->states().states(myFunction)) {
-              const auto it = theLastStates.find(myState);
-              assert(it != theLastStates.end());
-              myReq.states().emplace(myState, it->second);
-            }
+    }
+  }
 
-            myReq.theDag = std::make_unique<edge::model::Dag>(
-                theDag->singleFunctionDag(myFunction));
+  for (size_t i = 0; i < myIndices.size(); i++) {
+    const auto myIndex    = myIndices[i];
+    const auto myFunction = theDag->toName(myIndex); // name
 
-            // run the lambda function
-            const auto myResp = theClient->RunLambda(myReq, theDry);
+    // create a request and fill it with the states needed by the function
+    edge::LambdaRequest myReq(myFunction, aExec.theInput, std::string());
+    for (const auto& myState : theDag->states().states(myFunction)) {
+      const auto it = theLastStates.find(myState);
+      assert(it != theLastStates.end());
+      myReq.states().emplace(myState, it->second);
+    }
 
-            // return an invalid function index upon failure
-            VLOG(2) << myResp;
-            if (myResp.theRetCode != "OK") {
-              myQueue.push(-1);
+    myReq.theDag = std::make_unique<edge::model::Dag>(
+        theDag->singleFunctionDag(myFunction));
+
+    // run the lambda function: if it cannot be called then the functions not
+    // started yet are not accounted as in progress any more, so that the
+    // thread waiting for the DAG is woken up once the others have completed
+    try {
+      theClient->RunLambdaAsync(
+          myReq,
+          theDry,
+          [this, &aExec, myIndex](edge::LambdaResponse&& aResp) {
+            VLOG(2) << aResp;
+            {
+              const std::lock_guard<std::mutex> myLock(aExec.theMutex);
+              if (aResp.ok()) {
+                [[maybe_unused]] const auto ret =
+                    aExec.theCompleted.emplace(myIndex);
+                assert(ret.second == true);
+
+                // sum the hops and processing time
+                aExec.theHops += aResp.theHops;
+                aExec.thePtime += aResp.theProcessingTime;
+              } else {
+                // no more functions are called upon failure
+                aExec.theFailed = true;
+              }
             }
 
             // do NOT save the states returned
 
             // do NOT use the return value to fill the next input
 
-            // sum the hops and processing time
-            myHops += myResp.theHops;
-            myPtime += myResp.theProcessingTime;
+            // start the functions that depend on this one, before this one is
+            // accounted as finished so that the DAG is not considered complete
+            callDag(aExec);
 
-            myQueue.push(myIndex);
-          }));
-    }
-    const auto myFunction = myQueue.pop();
-    if (myFunction < 0) {
-      for (auto& myThread : myThreads) {
-        myThread.join();
+            const std::lock_guard<std::mutex> myLock(aExec.theMutex);
+            assert(aExec.theRunning > 0);
+            if (--aExec.theRunning == 0) {
+              aExec.theCondition.notify_one();
+            }
+          });
+    } catch (const std::exception& aErr) {
+      LOG(WARNING) << "could not call function " << myFunction
+                   << " of DAG " << theDag->name() << ": " << aErr.what();
+      const std::lock_guard<std::mutex> myLock(aExec.theMutex);
+      aExec.theFailed = true;
+      assert(aExec.theRunning >= myIndices.size() - i);
+      aExec.theRunning -= myIndices.size() - i;
+      if (aExec.theRunning == 0) {
+        aExec.theCondition.notify_one();
       }
-      throw std::runtime_error(
-          "Error received while executing a function in a DAG");
+      return;
     }
-    [[maybe_unused]] const auto ret = myCompleted.emplace(myFunction);
-    assert(ret.second == true);
-  }
-
-  for (auto& myThread : myThreads) {
-    myThread.join();
   }
-
-  auto myResp = std::make_unique<edge::LambdaResponse>("OK", aInput);
-
-  // save all the states in the final response
-  myResp->states()          = theLastStates;
-  myResp->theHops           = myHops;
-  myResp->theProcessingTime = myPtime;
-
-  return myResp;
 }
 
 void Client::stop() {
@@ -334,7 +456,7 @@ void Client::stop() {
   theExitCondition.wait(myLock, [this]() { return theFinishedFlag; });
 }
 
-void Client::sendRequest(const size_t aSize) {
+std::string Client::content(const size_t aSize) {
   auto mySize = aSize - 12;
   if (aSize < 12) {
     LOG_FIRST_N(WARNING, 1)
@@ -343,14 +465,14 @@ void Client::sendRequest(const size_t aSize) {
     mySize = 0;
   }
 
-  std::string myContent;
-  {
-    const std::lock_guard<std::mutex> myLock(theMutex);
-    myContent =
-        theContent.empty() ?
-            (std::string("{\"input\":\"") + std::string(mySize, 'A') + "\"}") :
-            theContent;
-  }
+  const std::lock_guard<std::mutex> myLock(theMutex);
+  return theContent.empty() ?
+             (std::string("{\"input\":\"") + std::string(mySize, 'A') + "\"}") :
+             theContent;
+}
+
+void Client::sendRequest(const size_t aSize) {
+  const auto myContent = content(aSize);
 
   // execute the main loop depending on the operating mode
   theLambdaChrono.start();
@@ -373,6 +495,38 @@ void Client::sendRequest(const size_t aSize) {
   theSendRequestQueue.pop();
 }
 
+void Client::sendRequestAsync(const size_t             aSize,
+                              const Clock::time_point& aIntended) {
+  if (theLambda.empty() or not theCallback.empty()) {
+    throw std::runtime_error("asynchronous lambda requests are only supported "
+                             "in single function mode");
+  }
+
+  edge::LambdaRequest myReq(theLambda, content(aSize));
+
+  {
+    const std::lock_guard<std::mutex> myLock(theAsyncMutex);
+    thePending++;
+  }
+
+  // the response may be received before this method returns
+  theClient->RunLambdaAsync(
+      myReq, theDry, [this, aIntended](edge::LambdaResponse&& aResponse) {
+        record(aResponse,
+               std::chrono::duration<double>(Clock::now() - aIntended).count());
+        const std::lock_guard<std::mutex> myLock(theAsyncMutex);
+        assert(thePending > 0);
+        if (--thePending == 0) {
+          theAsyncCondition.notify_all();
+        }
+      });
+}
+
+size_t Client::pending() const {
+  const std::lock_guard<std::mutex> myLock(theAsyncMutex);
+  return thePending;
+}
+
 void Client::recordStat(const edge::LambdaResponse& aResponse) {
   // save the states returned
   for (const auto& elem : aResponse.states()) {
@@ -382,41 +536,57 @@ void Client::recordStat(const edge::LambdaResponse& aResponse) {
   }
 
   // measure the application latency
-  const auto myElapsed = theLambdaChrono.stop();
+  record(aResponse, theLambdaChrono.stop());
 
+  // stat recorded, sendRequest() may proceed
+  theSendRequestQueue.push(0);
+}
+
+void Client::record(const edge::LambdaResponse& aResponse,
+                    const double                aElapsed) {
   // name to be used for logging and statistics
   const auto myName = (theChain.get() != nullptr) ? theChain->name() :
                       (theDag.get() != nullptr)   ? theDag->name() :
                                                     theLambda;
 
-  if (aResponse.theRetCode == "OK") {
-    VLOG(1) << myName << ", took " << (myElapsed * 1e3 + 0.5) << " ms, return "
+  if (aResponse.ok()) {
+    VLOG(1) << myName << ", took " << (aElapsed * 1e3 + 0.5) << " ms, return "
             << aResponse;
 
-    if (theDry) {
+    // lock-free
+    theLatencyHistogram.record(
+        static_cast<uint64_t>(std::max(0.0, aElapsed * 1e6 + 0.5)));
+
+    const std::lock_guard<std::mutex> myLock(theAsyncMutex);
+
+    if (theResultLog != nullptr) {
+      (*theResultLog)(theDry ? aResponse.processingTimeSeconds() : aElapsed,
+                      aResponse.theLoad1,
+                      aResponse.theResponder,
+                      myName,
+                      aResponse.theHops,
+                      aResponse.processingTimeSeconds());
+    } else if (theDry) {
       theSaver(aResponse.processingTimeSeconds(),
                aResponse.theLoad1,
                aResponse.theResponder,
                myName,
                aResponse.theHops);
     } else {
-      theSaver(myElapsed,
+      theSaver(aElapsed,
                aResponse.theLoad1,
                aResponse.theResponder,
                myName,
                aResponse.theHops);
     }
 
-    theLatencyStat(myElapsed);
+    theLatencyStat(aElapsed);
     theProcessingStat(aResponse.processingTimeSeconds());
 
   } else {
     // do not update the output and internal statistics in case of failure
     VLOG(1) << "invalid response to " << myName << ": " << aResponse.theRetCode;
   }
-
-  // stat recorded, sendRequest() may proceed
-  theSendRequestQueue.push(0);
 }
 
 void Client::sleep(const double aTime) {
@@ -427,6 +597,12 @@ void Client::sleep(const double aTime) {
       [this]() { return theStopFlag; });
 }
 
+void Client::sleepUntil(const Clock::time_point& aTime) {
+  std::unique_lock<std::mutex> myLock(theMutex);
+  theSleepCondition.wait_until(
+      myLock, aTime, [this]() { return theStopFlag; });
+}
+
 void Client::setContent(const std::string& aContent) {
   const std::lock_guard<std::mutex> myLock(theMutex);
   theContent = aContent;
@@ -510,6 +686,11 @@ void Client::setStateServer(const std::string& aStateEndpoint) {
   theInvalidStates = true;
 }
 
+void Client::setResultLog(edge::detail::ResultLog& aResultLog) {
+  const std::lock_guard<std::mutex> myLock(theAsyncMutex);
+  theResultLog = &aResultLog;
+}
+
 void Client::setSizeDist(const size_t aSizeMin, const size_t aSizeMax) {
   LOG_IF(WARNING, theSizeDist != nullptr)
       << "changing the lambda request size r.v. parameters";
@@ -31,6 +31,7 @@ SOFTWARE.
 
 #pragma once
 
+#include "Edge/Detail/hdrhistogram.h"
 #include "Edge/Model/chain.h" // do not use forward declaration
 #include "Edge/Model/dag.h"   // do not use forward declaration
 #include "Support/chrono.h"
@@ -40,6 +41,7 @@ SOFTWARE.
 #include "Support/random.h"
 #include "Support/stat.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <map>
 #include <memory>
@@ -59,6 +61,9 @@ namespace edge {
 class EdgeClientInterface;
 struct State;
 struct LambdaResponse;
+namespace detail {
+class ResultLog;
+}
 } // namespace edge
 
 namespace simulation {
@@ -86,9 +91,43 @@ struct Stats {};
  *   in each call depending on the state dependencies; in this mode the info
  *   about the chain is provided by a dedicated method setChain() which must
  *   be called before the client is started.
+ *
+ * Specialized classes may also issue single function calls without waiting
+ * for their responses, see sendRequestAsync(): in this case the client does
+ * not finish until all the responses have been received.
  */
 class Client
 {
+  //! State of a chain of functions in progress.
+  struct ChainExecution {
+    explicit ChainExecution(const std::string& aInput);
+
+    std::mutex                            theMutex;
+    std::condition_variable               theCondition;
+    bool                                  theDone;
+    size_t                                theNext; // index of the function
+    std::string                           theInput;
+    std::string                           theDataIn;
+    std::unique_ptr<edge::LambdaResponse> theResponse; // last one
+    unsigned int                          theHops;
+    unsigned int                          thePtime;
+  };
+
+  //! State of a DAG of functions in progress.
+  struct DagExecution {
+    explicit DagExecution(const std::string& aInput);
+
+    std::mutex              theMutex;
+    std::condition_variable theCondition;
+    const std::string       theInput;
+    std::set<size_t>        theCompleted;
+    std::set<size_t>        theCalled;
+    size_t                  theRunning; // number of functions in progress
+    bool                    theFailed;
+    unsigned int            theHops;
+    unsigned int            thePtime;
+  };
+
  public:
   NONCOPYABLE_NONMOVABLE(Client);
 
@@ -102,6 +141,18 @@ class Client
                   const support::Saver&        aSaver,
                   const bool                   aDry);
 
+  /**
+   * Create a client that uses the given edge client instead of creating
+   * one towards a set of edge servers, e.g., to run against a fake transport.
+   */
+  explicit Client(const size_t                                 aSeedUser,
+                  const size_t                                 aSeedInc,
+                  const size_t                                 aNumRequests,
+                  std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+                  const std::string&                           aLambda,
+                  const support::Saver&                        aSaver,
+                  const bool                                   aDry);
+
   /**
    * Set the lambda request to a custom content, overriding the value it
    * would have according to the specialized class.
@@ -153,6 +204,12 @@ class Client
    */
   void setStateServer(const std::string& aStateEndpoint);
 
+  /**
+   * Save the responses into the given binary log instead of the saver passed
+   * in the ctor. The log is not owned and must outlive the client.
+   */
+  void setResultLog(edge::detail::ResultLog& aResultLog);
+
   //! Draw size from a uniform r.v.
   void setSizeDist(const size_t aSizeMin, const size_t aSizeMax);
 
@@ -180,6 +237,14 @@ class Client
     return theLatencyStat;
   }
 
+  /**
+   * \return the histogram of the latencies, in us, which can be read while
+   * the client is running.
+   */
+  const edge::detail::HdrHistogram& latencyHistogram() const noexcept {
+    return theLatencyHistogram;
+  }
+
   //! \return the processing time summary statistics.
   const support::SummaryStat& processingStat() const noexcept {
     return theProcessingStat;
@@ -189,6 +254,8 @@ class Client
   void recordStat(const edge::LambdaResponse& aResponse);
 
  protected:
+  using Clock = std::chrono::steady_clock;
+
   /**
    * Send out a lambda request, wait for the response.
    *
@@ -201,9 +268,28 @@ class Client
    */
   void sendRequest(const size_t aSize);
 
+  /**
+   * Send out a lambda request, return immediately.
+   *
+   * \param aSize The lambda size, in octets.
+   *
+   * \param aIntended The time when the request was intended to be sent, from
+   * which the latency is measured upon receiving the response.
+   *
+   * \throw std::runtime_error if the client does not operate in single
+   * function mode.
+   */
+  void sendRequestAsync(const size_t aSize, const Clock::time_point& aIntended);
+
+  //! \return the number of asynchronous requests waiting for a response.
+  size_t pending() const;
+
   //! Sleep for the given amount of time, in fractional seconds.
   void sleep(const double aTime);
 
+  //! Sleep until the given time, unless stopped.
+  void sleepUntil(const Clock::time_point& aTime);
+
   //! \return the size of the next lambda request.
   size_t nextSize();
 
@@ -218,6 +304,21 @@ class Client
   //! Set the finish flag.
   void finish();
 
+  //! Wait until all the asynchronous requests have been answered.
+  void drain();
+
+  //! \return the input of a lambda request with the given size.
+  std::string content(const size_t aSize);
+
+  /**
+   * Save the latency and processing time of a lambda response, if successful.
+   *
+   * \param aResponse The lambda response.
+   *
+   * \param aElapsed The latency, in fractional seconds.
+   */
+  void record(const edge::LambdaResponse& aResponse, const double aElapsed);
+
   /**
    * @brief Run a single function
    *
@@ -229,18 +330,34 @@ class Client
   /**
    * @brief Run a chain of function executions.
    *
-   * @return the last function response of the whole chain.
+   * The functions are executed asynchronously one after another, while the
+   * calling thread waits for the whole chain to complete.
+   *
+   * @return the last function response of the whole chain, which carries
+   * the error if the next function could not be called.
    */
   std::unique_ptr<edge::LambdaResponse>
   functionChain(const std::string& aInput);
 
+  //! Start the next function of a chain.
+  void callChain(ChainExecution& aExec);
+
   /**
    * @brief Run a DAG of function executions.
    *
+   * The functions are executed asynchronously as soon as they become
+   * callable, while the calling thread waits for the whole DAG to complete.
+   *
    * @return the last function response of the whole DAG.
+   *
+   * @throw std::runtime_error if a function fails or cannot be called, after
+   * all the functions in progress have completed.
    */
   std::unique_ptr<edge::LambdaResponse> functionDag(const std::string& aInput);
 
+  //! Start the functions of a DAG that have become callable, if any.
+  void callDag(DagExecution& aExec);
+
   //! Prepare the states if not valid.
   void validateStates();
 
@@ -262,11 +379,17 @@ class Client
   const support::Saver&                      theSaver;
   support::SummaryStat                       theLatencyStat;
   support::SummaryStat                       theProcessingStat;
+  edge::detail::HdrHistogram                 theLatencyHistogram;
   const bool                                 theDry;
   support::Queue<int>                        theSendRequestQueue;
   std::map<std::string, edge::State>         theLastStates;
   bool                                       theInvalidStates;
 
+  // asynchronous requests
+  mutable std::mutex      theAsyncMutex; // also protects the statistics
+  std::condition_variable theAsyncCondition;
+  size_t                  thePending;
+
   // set in setSizeDist()
   std::unique_ptr<support::UniformIntRv<size_t>> theSizeDist;
   std::vector<size_t>                            theSizes;
@@ -288,6 +411,9 @@ class Client
 
   // set in setStateServer()
   std::string theStateEndpoint;
+
+  // set in setResultLog()
+  edge::detail::ResultLog* theResultLog;
 };
 
 } // namespace simulation
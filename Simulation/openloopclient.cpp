@@ -0,0 +1,232 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "openloopclient.h"
+
+#include "Edge/edgeclientfactory.h"
+#include "Edge/edgeclientinterface.h"
+#include "Support/random.h"
+
+#include <glog/logging.h>
+
+#include <cassert>
+#include <stdexcept>
+
+namespace uiiit {
+namespace simulation {
+
+// number of arrival times drawn at once
+static constexpr size_t BATCH_SIZE = 4096;
+
+OpenLoopClient::OpenLoopClient(const std::vector<size_t>&     aSizes,
+                               const double                   aInterRequestTime,
+                               const UnifClient::Distribution aDistribution,
+                               const size_t                   aMaxPending,
+                               const size_t                   aSeedUser,
+                               const size_t                   aSeedInc,
+                               const size_t                   aNumRequests,
+                               const std::set<std::string>&   aServers,
+                               const bool                     aSecure,
+                               const support::Conf&           aClientConf,
+                               const std::string&             aLambda,
+                               const support::Saver&          aSaver,
+                               const bool                     aDry)
+    : OpenLoopClient(aInterRequestTime,
+                     aDistribution,
+                     aMaxPending,
+                     aSeedUser,
+                     aSeedInc,
+                     aNumRequests,
+                     edge::EdgeClientFactory::make(
+                         aServers, aSecure, aClientConf),
+                     aLambda,
+                     aSaver,
+                     aDry) {
+  setSizeDist(aSizes);
+}
+
+OpenLoopClient::OpenLoopClient(const size_t                   aSizeMin,
+                               const size_t                   aSizeMax,
+                               const double                   aInterRequestTime,
+                               const UnifClient::Distribution aDistribution,
+                               const size_t                   aMaxPending,
+                               const size_t                   aSeedUser,
+                               const size_t                   aSeedInc,
+                               const size_t                   aNumRequests,
+                               const std::set<std::string>&   aServers,
+                               const bool                     aSecure,
+                               const support::Conf&           aClientConf,
+                               const std::string&             aLambda,
+                               const support::Saver&          aSaver,
+                               const bool                     aDry)
+    : OpenLoopClient(aInterRequestTime,
+                     aDistribution,
+                     aMaxPending,
+                     aSeedUser,
+                     aSeedInc,
+                     aNumRequests,
+                     edge::EdgeClientFactory::make(
+                         aServers, aSecure, aClientConf),
+                     aLambda,
+                     aSaver,
+                     aDry) {
+  setSizeDist(aSizeMin, aSizeMax);
+}
+
+OpenLoopClient::OpenLoopClient(
+    const std::vector<size_t>&                   aSizes,
+    const double                                 aInterRequestTime,
+    const UnifClient::Distribution               aDistribution,
+    const size_t                                 aMaxPending,
+    const size_t                                 aSeedUser,
+    const size_t                                 aSeedInc,
+    const size_t                                 aNumRequests,
+    std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+    const std::string&                           aLambda,
+    const support::Saver&                        aSaver,
+    const bool                                   aDry)
+    : OpenLoopClient(aInterRequestTime,
+                     aDistribution,
+                     aMaxPending,
+                     aSeedUser,
+                     aSeedInc,
+                     aNumRequests,
+                     std::move(aClient),
+                     aLambda,
+                     aSaver,
+                     aDry) {
+  setSizeDist(aSizes);
+}
+
+OpenLoopClient::OpenLoopClient(
+    const double                                 aInterRequestTime,
+    const UnifClient::Distribution               aDistribution,
+    const size_t                                 aMaxPending,
+    const size_t                                 aSeedUser,
+    const size_t                                 aSeedInc,
+    const size_t                                 aNumRequests,
+    std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+    const std::string&                           aLambda,
+    const support::Saver&                        aSaver,
+    const bool                                   aDry)
+    : Client(aSeedUser,
+             aSeedInc,
+             aNumRequests,
+             std::move(aClient),
+             aLambda,
+             aSaver,
+             aDry)
+    , theInterRequestTime(aInterRequestTime)
+    , theMaxPending(aMaxPending)
+    , theSleepDist(
+          aDistribution == UnifClient::Distribution::CONSTANT ?
+              RvPtr(new support::ConstantRv(aInterRequestTime)) :
+          aDistribution == UnifClient::Distribution::UNIFORM ?
+              RvPtr(new support::UniformRv(
+                  0, 2 * aInterRequestTime, aSeedUser, aSeedInc, 1)) :
+              RvPtr(new support::ExponentialRv(
+                  1.0 / aInterRequestTime, aSeedUser, aSeedInc, 1)))
+    , theArrivals()
+    , theNext(0)
+    , theLastArrival()
+    , theStarted(false)
+    , theDropped(0) {
+  if (aInterRequestTime <= 0) {
+    throw std::runtime_error(
+        "the inter-request time of an open-loop client must be positive");
+  }
+  if (aMaxPending == 0) {
+    throw std::runtime_error(
+        "the maximum number of pending requests cannot be zero");
+  }
+  theArrivals.reserve(BATCH_SIZE);
+
+  LOG(INFO) << "created an open-loop client with seed (" << aSeedUser << ","
+            << aSeedInc << "), which will issue max " << aNumRequests
+            << " requests every " << aInterRequestTime << " s on average, "
+            << "with max " << aMaxPending << " pending"
+            << (aDry ? ", dry run" : "");
+}
+
+size_t OpenLoopClient::loop() {
+  if (not theStarted) {
+    theStarted     = true;
+    theLastArrival = Clock::now();
+  }
+
+  if (theNext == theArrivals.size()) {
+    refill();
+  }
+  assert(theNext < theArrivals.size());
+  const auto& myIntended = theArrivals[theNext++];
+
+  const auto myNow = Clock::now();
+  if (myNow < myIntended) {
+    sleepUntil(myIntended);
+  } else if (myNow - myIntended > std::chrono::seconds(1)) {
+    // log only lags greater than 1 second
+    LOG_FIRST_N(WARNING, 10)
+        << "lagging behind by "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(myNow -
+                                                                 myIntended)
+               .count()
+        << " ms [" << google::COUNTER << "/10 instances shown]";
+  }
+
+  if (pending() >= theMaxPending) {
+    theDropped++;
+    LOG_EVERY_N(WARNING, 10000)
+        << "too many pending requests, " << google::COUNTER
+        << " arrivals dropped so far";
+  } else {
+    sendRequestAsync(nextSize(), myIntended);
+  }
+
+  return 1;
+}
+
+void OpenLoopClient::refill() {
+  theArrivals.clear();
+  theNext = 0;
+  for (size_t i = 0; i < BATCH_SIZE; i++) {
+    theLastArrival += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>((*theSleepDist)()));
+    theArrivals.emplace_back(theLastArrival);
+  }
+}
+
+size_t OpenLoopClient::simulate(const double aDuration) {
+  // in an open loop the arrivals do not depend on the server response time
+  return static_cast<size_t>(aDuration / theInterRequestTime);
+}
+
+} // namespace simulation
+} // namespace uiiit
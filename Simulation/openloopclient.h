@@ -0,0 +1,166 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "client.h"
+#include "unifclient.h"
+
+#include <memory>
+#include <vector>
+
+namespace uiiit {
+
+namespace support {
+class RealRvInterface;
+}
+
+namespace simulation {
+
+/**
+ * A client issuing lambda requests in an open loop, i.e., without waiting for
+ * the responses to previous requests before sending new ones.
+ *
+ * The arrival times are drawn in batches from a uniform, constant, or
+ * exponential distribution of the inter-request time, and the latency of
+ * every request is measured from its intended send time, so that the delay
+ * accumulated when falling behind schedule, e.g., because the server is
+ * overloaded, is accounted for in the statistics.
+ *
+ * If the number of requests waiting for a response reaches a maximum, new
+ * arrivals are dropped and counted.
+ *
+ * Only single function calls are supported. The responses are received
+ * asynchronously if the edge client supports it, see
+ * edge::EdgeClientInterface::RunLambdaAsync(), otherwise every call blocks
+ * until the response is received.
+ */
+class OpenLoopClient final : public Client
+{
+  using RvPtr = std::unique_ptr<support::RealRvInterface>;
+
+ public:
+  /**
+   * \param aMaxPending The maximum number of requests waiting for a response.
+   *
+   * \throw std::runtime_error if aInterRequestTime is not positive or
+   * aMaxPending is zero.
+   */
+  explicit OpenLoopClient(const std::vector<size_t>&     aSizes,
+                          const double                   aInterRequestTime,
+                          const UnifClient::Distribution aDistribution,
+                          const size_t                   aMaxPending,
+                          const size_t                   aSeedUser,
+                          const size_t                   aSeedInc,
+                          const size_t                   aNumRequests,
+                          const std::set<std::string>&   aServers,
+                          const bool                     aSecure,
+                          const support::Conf&           aClientConf,
+                          const std::string&             aLambda,
+                          const support::Saver&          aSaver,
+                          const bool                     aDry);
+
+  /**
+   * Same as above, with the size of the lambda requests drawn from a uniform
+   * r.v. in [aSizeMin, aSizeMax].
+   */
+  explicit OpenLoopClient(const size_t                   aSizeMin,
+                          const size_t                   aSizeMax,
+                          const double                   aInterRequestTime,
+                          const UnifClient::Distribution aDistribution,
+                          const size_t                   aMaxPending,
+                          const size_t                   aSeedUser,
+                          const size_t                   aSeedInc,
+                          const size_t                   aNumRequests,
+                          const std::set<std::string>&   aServers,
+                          const bool                     aSecure,
+                          const support::Conf&           aClientConf,
+                          const std::string&             aLambda,
+                          const support::Saver&          aSaver,
+                          const bool                     aDry);
+
+  /**
+   * Same as the first one, with the given edge client instead of one
+   * created towards a set of edge servers, e.g., to run against a fake
+   * transport.
+   */
+  explicit OpenLoopClient(
+      const std::vector<size_t>&                   aSizes,
+      const double                                 aInterRequestTime,
+      const UnifClient::Distribution               aDistribution,
+      const size_t                                 aMaxPending,
+      const size_t                                 aSeedUser,
+      const size_t                                 aSeedInc,
+      const size_t                                 aNumRequests,
+      std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+      const std::string&                           aLambda,
+      const support::Saver&                        aSaver,
+      const bool                                   aDry);
+
+  size_t simulate(const double aDuration) override;
+
+  //! \return the number of arrivals dropped because of too many pending.
+  size_t dropped() const noexcept {
+    return theDropped;
+  }
+
+ private:
+  //! Initializes everything except the lambda request size generation.
+  explicit OpenLoopClient(
+      const double                                 aInterRequestTime,
+      const UnifClient::Distribution               aDistribution,
+      const size_t                                 aMaxPending,
+      const size_t                                 aSeedUser,
+      const size_t                                 aSeedInc,
+      const size_t                                 aNumRequests,
+      std::unique_ptr<edge::EdgeClientInterface>&& aClient,
+      const std::string&                           aLambda,
+      const support::Saver&                        aSaver,
+      const bool                                   aDry);
+
+  size_t loop() override;
+
+  //! Draw the next batch of arrival times.
+  void refill();
+
+ private:
+  const double                   theInterRequestTime;
+  const size_t                   theMaxPending;
+  const RvPtr                    theSleepDist;
+  std::vector<Clock::time_point> theArrivals;
+  size_t                         theNext; // index of the next arrival
+  Clock::time_point              theLastArrival;
+  bool                           theStarted;
+  size_t                         theDropped;
+};
+
+} // namespace simulation
+} // namespace uiiit
@@ -0,0 +1,295 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "tracereplayer.h"
+
+#include "Edge/Detail/resultlog.h"
+#include "Edge/Detail/tracefile.h"
+#include "Edge/edgeclientgrpcasync.h"
+#include "Edge/edgemessages.h"
+#include "Support/saver.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace uiiit {
+namespace simulation {
+
+//! Event loop serving a subset of the virtual clients.
+struct TraceReplayer::Loop {
+  struct Client {
+    std::vector<size_t> theEvents; // indices in the trace
+    size_t              theNext;   // index of the event in progress
+  };
+
+  explicit Loop(const bool aSecure)
+      : theClients()
+      , theMutex()
+      , theCondition()
+      , theReady()
+      , theLatencies()
+      , theSlips()
+      , theThread()
+      , theClient(std::make_unique<edge::EdgeClientGrpcAsync>(aSecure)) {
+    // noop
+  }
+
+  std::vector<Client>        theClients;
+  std::mutex                 theMutex;
+  std::condition_variable    theCondition;
+  std::vector<size_t>        theReady; // clients whose response has arrived
+  edge::detail::HdrHistogram theLatencies;
+  edge::detail::HdrHistogram theSlips;
+  std::thread                theThread;
+
+  // must be destroyed first, since its callbacks use the members above
+  std::unique_ptr<edge::EdgeClientGrpcAsync> theClient;
+};
+
+TraceReplayer::TraceReplayer(const edge::detail::TraceFile& aTrace,
+                             const size_t                   aNumLoops,
+                             const bool                     aSecure,
+                             const support::Saver&          aSaver,
+                             edge::detail::ResultLog*       aResultLog)
+    : theTrace(aTrace)
+    , theSaver(aSaver)
+    , theResultLog(aResultLog)
+    , theStarted(false)
+    , theStopped(false)
+    , theDispatched(0)
+    , theFailed(0)
+    , theStart()
+    , theLoops() {
+  if (aNumLoops == 0) {
+    throw std::runtime_error("Invalid number of event loops: 0");
+  }
+  std::vector<Loop*> myLoops;
+  for (size_t i = 0; i < aNumLoops; i++) {
+    theLoops.emplace_back(aSecure);
+    myLoops.emplace_back(&theLoops.back());
+  }
+
+  // assign the virtual clients to the loops in round-robin
+  // key: client identifier, value: loop and index of the client in the loop
+  std::unordered_map<uint32_t, std::pair<Loop*, size_t>> myClients;
+  for (size_t i = 0; i < theTrace.size(); i++) {
+    const auto myId = theTrace[i].theClient;
+    auto       it   = myClients.find(myId);
+    if (it == myClients.end()) {
+      auto& myLoop = *myLoops[myClients.size() % aNumLoops];
+      myLoop.theClients.emplace_back(Loop::Client{{}, 0});
+      it = myClients
+               .emplace(myId,
+                        std::make_pair(&myLoop, myLoop.theClients.size() - 1))
+               .first;
+    }
+    it->second.first->theClients[it->second.second].theEvents.emplace_back(i);
+  }
+  LOG(INFO) << "replaying " << theTrace.size() << " events of "
+            << myClients.size() << " virtual clients on " << aNumLoops
+            << " event loops";
+}
+
+TraceReplayer::~TraceReplayer() {
+  stop();
+}
+
+void TraceReplayer::run() {
+  if (theStarted.exchange(true)) {
+    throw std::runtime_error("Trace replayer started multiple times");
+  }
+  theStart = std::chrono::steady_clock::now();
+  for (auto& myLoop : theLoops) {
+    myLoop.theThread = std::thread([this, &myLoop]() { run(myLoop); });
+  }
+  for (auto& myLoop : theLoops) {
+    myLoop.theThread.join();
+  }
+}
+
+void TraceReplayer::stop() {
+  theStopped = true;
+  for (auto& myLoop : theLoops) {
+    const std::lock_guard<std::mutex> myLock(myLoop.theMutex);
+    myLoop.theCondition.notify_one();
+  }
+}
+
+edge::detail::HdrHistogram TraceReplayer::latencies() const {
+  edge::detail::HdrHistogram ret;
+  for (const auto& myLoop : theLoops) {
+    ret.add(myLoop.theLatencies);
+  }
+  return ret;
+}
+
+edge::detail::HdrHistogram TraceReplayer::slips() const {
+  edge::detail::HdrHistogram ret;
+  for (const auto& myLoop : theLoops) {
+    ret.add(myLoop.theSlips);
+  }
+  return ret;
+}
+
+void TraceReplayer::run(Loop& aLoop) {
+  // key: scheduled time of the next request, value: virtual client
+  using Entry = std::pair<uint64_t, size_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> myHeap;
+
+  size_t myActive = 0; // virtual clients with requests not yet answered
+  for (size_t i = 0; i < aLoop.theClients.size(); i++) {
+    const auto& myClient = aLoop.theClients[i];
+    if (not myClient.theEvents.empty()) {
+      myHeap.emplace(theTrace[myClient.theEvents.front()].theTime, i);
+      myActive++;
+    }
+  }
+
+  const auto myWakeUp = [this, &aLoop]() {
+    return theStopped.load() or not aLoop.theReady.empty();
+  };
+
+  std::vector<size_t>          myReady;
+  std::unique_lock<std::mutex> myLock(aLoop.theMutex);
+  while (myActive > 0 and not theStopped) {
+    // schedule the next requests of the clients whose response has arrived
+    if (not aLoop.theReady.empty()) {
+      myReady.swap(aLoop.theReady);
+      myLock.unlock();
+      for (const auto myId : myReady) {
+        auto& myClient = aLoop.theClients[myId];
+        if (++myClient.theNext < myClient.theEvents.size()) {
+          myHeap.emplace(theTrace[myClient.theEvents[myClient.theNext]].theTime,
+                         myId);
+        } else {
+          assert(myActive > 0);
+          myActive--;
+        }
+      }
+      myReady.clear();
+      myLock.lock();
+      continue;
+    }
+
+    if (myHeap.empty()) {
+      // all the active clients have a request in progress
+      aLoop.theCondition.wait(myLock, myWakeUp);
+      continue;
+    }
+
+    const auto myDue =
+        theStart + std::chrono::microseconds(myHeap.top().first);
+    if (std::chrono::steady_clock::now() < myDue) {
+      aLoop.theCondition.wait_until(myLock, myDue, myWakeUp);
+      continue;
+    }
+
+    const auto myId = myHeap.top().second;
+    myHeap.pop();
+    myLock.unlock();
+    dispatch(aLoop, myId);
+    myLock.lock();
+  }
+}
+
+void TraceReplayer::dispatch(Loop& aLoop, const size_t aClient) {
+  const auto& myClient = aLoop.theClients[aClient];
+  assert(myClient.theNext < myClient.theEvents.size());
+  const auto& myEvent = theTrace[myClient.theEvents[myClient.theNext]];
+
+  const auto mySlip = std::max(
+      0.0,
+      std::chrono::duration<double>(
+          std::chrono::steady_clock::now() -
+          (theStart + std::chrono::microseconds(myEvent.theTime)))
+          .count());
+  aLoop.theSlips.record(static_cast<uint64_t>(mySlip * 1e6 + 0.5));
+  theDispatched++;
+
+  const auto& myLambda = theTrace.name(myEvent.theLambda);
+  const auto& myServer = theTrace.name(myEvent.theServer);
+
+  const auto myDone = [&aLoop, aClient]() {
+    const std::lock_guard<std::mutex> myLock(aLoop.theMutex);
+    aLoop.theReady.emplace_back(aClient);
+    aLoop.theCondition.notify_one();
+  };
+
+  try {
+    aLoop.theClient->RunLambda(
+        myServer,
+        edge::LambdaRequest(myLambda, std::string(myEvent.theSize, 'A')),
+        false,
+        [this, &aLoop, &myLambda, &myServer, mySlip, myDone](
+            edge::LambdaResponse&& aRep, const double aTime) {
+          if (aRep.ok()) {
+            aLoop.theLatencies.record(static_cast<uint64_t>(aTime * 1e6 + 0.5));
+            if (theResultLog != nullptr) {
+              (*theResultLog)(aTime,
+                              aRep.theLoad1,
+                              aRep.theResponder,
+                              myLambda,
+                              aRep.theHops,
+                              aRep.processingTimeSeconds(),
+                              mySlip);
+            } else {
+              theSaver(aTime, aRep.theLoad1, aRep.theResponder, mySlip);
+            }
+          } else {
+            theFailed++;
+            LOG_EVERY_N(WARNING, 1000)
+                << "invalid response received from " << myServer << ": "
+                << aRep.theRetCode << " [" << google::COUNTER
+                << " failures so far]";
+          }
+          myDone();
+        });
+  } catch (const std::exception& aErr) {
+    theFailed++;
+    LOG(ERROR) << "could not send a request to " << myServer << ": "
+               << aErr.what();
+    myDone();
+  }
+}
+
+} // namespace simulation
+} // namespace uiiit
@@ -0,0 +1,152 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/Detail/hdrhistogram.h"
+#include "Support/macros.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+
+namespace uiiit {
+
+namespace support {
+class Saver;
+}
+
+namespace edge {
+class EdgeClientGrpcAsync;
+namespace detail {
+class ResultLog;
+class TraceFile;
+} // namespace detail
+} // namespace edge
+
+namespace simulation {
+
+/**
+ * Replay a binary trace of lambda requests, see edge::detail::TraceFile,
+ * through asynchronous gRPC calls.
+ *
+ * Every client identifier in the trace is a virtual client, which issues its
+ * requests in order and never has more than one request in progress: a
+ * request is sent at its scheduled time or, if the response to the previous
+ * request of the same client has not been received yet, as soon as it is.
+ * The virtual clients are spread over a few event loops, each with its own
+ * thread and completion queue, so that many thousands of virtual clients
+ * require only a handful of threads.
+ *
+ * For every request the schedule slip, i.e., the delay between the time the
+ * request was sent and the time it was scheduled in the trace, is saved
+ * along with its latency.
+ */
+class TraceReplayer final
+{
+  struct Loop;
+
+ public:
+  NONCOPYABLE_NONMOVABLE(TraceReplayer);
+
+  /**
+   * \param aTrace the trace to be replayed, which must outlive this object.
+   *
+   * \param aNumLoops the number of event loops.
+   *
+   * \param aSecure if true then use SSL/TLS authentication.
+   *
+   * \param aSaver the saver of the text output, with latency, load,
+   * responder, and slip of every successful request.
+   *
+   * \param aResultLog if not null then save the output in this binary log
+   * instead of using aSaver.
+   *
+   * \throw std::runtime_error if aNumLoops is zero.
+   */
+  explicit TraceReplayer(const edge::detail::TraceFile& aTrace,
+                         const size_t                   aNumLoops,
+                         const bool                     aSecure,
+                         const support::Saver&          aSaver,
+                         edge::detail::ResultLog*       aResultLog);
+
+  //! Stop the replay, if in progress.
+  ~TraceReplayer();
+
+  /**
+   * Replay the trace, with the time 0 of the trace corresponding to now.
+   * Return when all the responses have been received or stop() is called.
+   *
+   * \throw std::runtime_error if called more than once.
+   */
+  void run();
+
+  //! Stop the replay: no further requests are sent.
+  void stop();
+
+  //! \return the number of requests sent so far.
+  size_t dispatched() const noexcept {
+    return theDispatched.load();
+  }
+
+  //! \return the number of requests failed so far.
+  size_t failed() const noexcept {
+    return theFailed.load();
+  }
+
+  //! \return a snapshot of the latencies of successful requests, in us.
+  edge::detail::HdrHistogram latencies() const;
+
+  //! \return a snapshot of the schedule slips of all the requests, in us.
+  edge::detail::HdrHistogram slips() const;
+
+ private:
+  //! Event loop body.
+  void run(Loop& aLoop);
+
+  //! Send out the next request of a virtual client.
+  void dispatch(Loop& aLoop, const size_t aClient);
+
+ private:
+  const edge::detail::TraceFile&        theTrace;
+  const support::Saver&                 theSaver;
+  edge::detail::ResultLog*              theResultLog;
+  std::atomic<bool>                     theStarted;
+  std::atomic<bool>                     theStopped;
+  std::atomic<size_t>                   theDispatched;
+  std::atomic<size_t>                   theFailed;
+  std::chrono::steady_clock::time_point theStart;
+  std::list<Loop>                       theLoops;
+};
+
+} // namespace simulation
+} // namespace uiiit
@@ -0,0 +1,148 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Edge/edgeclientinterface.h"
+#include "Edge/edgemessages.h"
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * Edge client answering asynchronously, from a separate thread per call,
+ * after a given delay.
+ *
+ * Every function succeeds with one hop and 10 ms of processing time, except
+ * those named as failing, which return an error, and those named as
+ * throwing, for which RunLambdaAsync() throws.
+ */
+class FakeEdgeClient final : public uiiit::edge::EdgeClientInterface
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FakeEdgeClient(const Clock::duration        aDelay,
+                          const std::set<std::string>& aFailing,
+                          const std::set<std::string>& aThrowing)
+      : uiiit::edge::EdgeClientInterface()
+      , theDelay(aDelay)
+      , theFailing(aFailing)
+      , theThrowing(aThrowing)
+      , theMutex()
+      , theCalled()
+      , theTimes()
+      , theInFlight(0)
+      , theMaxInFlight(0)
+      , theThreads() {
+    // noop
+  }
+
+  ~FakeEdgeClient() override {
+    for (auto& myThread : theThreads) {
+      myThread.join();
+    }
+  }
+
+  uiiit::edge::LambdaResponse
+  RunLambda(const uiiit::edge::LambdaRequest& aReq,
+            [[maybe_unused]] const bool       aDry) override {
+    if (theFailing.count(aReq.theName) > 0) {
+      return uiiit::edge::LambdaResponse("function failed", "");
+    }
+    uiiit::edge::LambdaResponse myResp("OK", *aReq.theInput);
+    myResp.theHops           = 1;
+    myResp.theProcessingTime = 10;
+    return myResp;
+  }
+
+  void RunLambdaAsync(const uiiit::edge::LambdaRequest& aReq,
+                      const bool                        aDry,
+                      Callback&&                        aCallback) override {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theCalled.emplace_back(aReq.theName);
+    theTimes.emplace_back(Clock::now());
+    if (theThrowing.count(aReq.theName) > 0) {
+      throw std::runtime_error("cannot call " + aReq.theName);
+    }
+    theMaxInFlight = std::max(theMaxInFlight, ++theInFlight);
+    theThreads.emplace_back([this,
+                             myResp     = RunLambda(aReq, aDry),
+                             myCallback = std::move(aCallback)]() mutable {
+      std::this_thread::sleep_for(theDelay);
+      {
+        const std::lock_guard<std::mutex> myLock(theMutex);
+        theInFlight--;
+      }
+      myCallback(std::move(myResp));
+    });
+  }
+
+  //! \return the names of the functions called, in order.
+  std::vector<std::string> called() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theCalled;
+  }
+
+  //! \return the times when the functions were called, in order.
+  std::vector<Clock::time_point> times() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theTimes;
+  }
+
+  //! \return the maximum number of calls waiting for a response at once.
+  size_t maxInFlight() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theMaxInFlight;
+  }
+
+ private:
+  const Clock::duration          theDelay;
+  const std::set<std::string>    theFailing;
+  const std::set<std::string>    theThrowing;
+  mutable std::mutex             theMutex;
+  std::vector<std::string>       theCalled;
+  std::vector<Clock::time_point> theTimes;
+  size_t                         theInFlight;
+  size_t                         theMaxInFlight;
+  std::list<std::thread>         theThreads;
+};
+
+} // namespace
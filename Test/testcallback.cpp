@@ -30,6 +30,8 @@ SOFTWARE.
 */
 
 #include "Edge/callbackclient.h"
+#include "Edge/callbackclientcache.h"
+#include "Edge/callbacksender.h"
 #include "Edge/callbackserver.h"
 #include "Edge/edgemessages.h"
 #include "Support/queue.h"
@@ -38,6 +40,10 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 namespace uiiit {
 namespace edge {
 
@@ -67,5 +73,99 @@ TEST_F(TestCallback, test_client_server) {
   ASSERT_EQ(5, myReceived);
 }
 
+TEST_F(TestCallback, test_client_server_batch) {
+  CallbackServer::Queue myQueue;
+  const std::string     myEndpoint = "127.0.0.1:6480";
+  CallbackServer        myServer(myEndpoint, myQueue);
+  myServer.run(false);
+  CallbackClient myClient(myEndpoint);
+
+  std::vector<LambdaResponse> myResponses;
+  for (auto i = 0; i < 10; i++) {
+    myResponses.emplace_back("OK", std::to_string(i));
+  }
+  for (const size_t myBatchSize : {0, 1, 3, 10, 20}) {
+    ASSERT_NO_THROW(myClient.ReceiveResponses(myResponses, myBatchSize));
+    for (auto i = 0; i < 10; i++) {
+      ASSERT_EQ(std::to_string(i), myQueue.pop().theOutput) << myBatchSize;
+    }
+  }
+  ASSERT_NO_THROW(myClient.ReceiveResponses({}));
+}
+
+TEST_F(TestCallback, test_client_cache) {
+  ASSERT_THROW(CallbackClientCache(0), std::runtime_error);
+
+  CallbackClientCache myCache(2);
+  const auto          myFirst = myCache("127.0.0.1:10000");
+  ASSERT_EQ(myFirst, myCache("127.0.0.1:10000"));
+  const auto mySecond = myCache("127.0.0.1:10001");
+  ASSERT_NE(myFirst, mySecond);
+  ASSERT_EQ(2u, myCache.size());
+
+  // the first is the most recently used, hence the second is evicted
+  ASSERT_EQ(myFirst, myCache("127.0.0.1:10000"));
+  myCache("127.0.0.1:10002");
+  ASSERT_EQ(2u, myCache.size());
+  ASSERT_EQ(myFirst, myCache("127.0.0.1:10000"));
+  ASSERT_NE(mySecond, myCache("127.0.0.1:10001"));
+  ASSERT_EQ(2u, myCache.size());
+}
+
+TEST_F(TestCallback, test_sender) {
+  CallbackServer::Queue myQueue;
+  const std::string     myEndpoint = "127.0.0.1:6480";
+  CallbackServer        myServer(myEndpoint, myQueue);
+  myServer.run(false);
+
+  for (const size_t myMaxBatch : {1, 4}) {
+    {
+      CallbackSender mySender(10, myMaxBatch, 1000, 0, 2);
+      ASSERT_EQ(myMaxBatch > 1, mySender.batching());
+      for (auto i = 0; i < 100; i++) {
+        mySender(myEndpoint, LambdaResponse("OK", std::to_string(i)));
+      }
+    } // all the responses are delivered upon destruction
+    for (auto i = 0; i < 100; i++) {
+      ASSERT_EQ(std::to_string(i), myQueue.pop().theOutput) << myMaxBatch;
+    }
+  }
+
+  // an unreachable end-point does not prevent delivery to the others, in
+  // order
+  {
+    CallbackSender mySender(10, 4, 1000, 0, 2);
+    for (auto i = 0; i < 100; i++) {
+      mySender("127.0.0.1:6481", LambdaResponse("OK", "lost"));
+      mySender(myEndpoint, LambdaResponse("OK", std::to_string(i)));
+    }
+    for (auto i = 0; i < 100; i++) {
+      ASSERT_EQ(std::to_string(i), myQueue.pop().theOutput);
+    }
+    ASSERT_EQ(0u, mySender.dropped());
+  }
+}
+
+TEST_F(TestCallback, test_sender_bounded_queue) {
+  ASSERT_THROW(CallbackSender(10, 4, 1000, 0, 0), std::runtime_error);
+
+  // responses beyond the limit are dropped, not queued
+  CallbackSender mySender(10, 4, 1000, 5, 1);
+  for (auto i = 0; i < 100; i++) {
+    mySender("127.0.0.1:6481", LambdaResponse("OK", std::to_string(i)));
+  }
+  ASSERT_GT(mySender.dropped(), 0u);
+  ASSERT_LE(mySender.dropped(), 95u);
+
+  // without batching there is no queue
+  CallbackSender myDirectSender(10, 1, 1000, 5, 0);
+  for (auto i = 0; i < 10; i++) {
+    ASSERT_THROW(
+        myDirectSender("127.0.0.1:6481", LambdaResponse("OK", "")),
+        std::exception);
+  }
+  ASSERT_EQ(0u, myDirectSender.dropped());
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -539,5 +539,81 @@ TEST_F(TestChainDagTransactionGrpc, test_dag) {
   }
 }
 
+TEST_F(TestChainDagTransactionGrpc, test_dag_many_successors) {
+  System mySystem;
+
+  EdgeClientGrpc        myClient(mySystem.theRouterEndpoint, false);
+  CallbackServer::Queue myResponses;
+  CallbackServer myCallbackServer(mySystem.theCallbackEndpoint, myResponses);
+  myCallbackServer.run(false);
+
+  // the successors of the first function are all invoked concurrently via
+  // the shared companion client, then the last one joins them
+  for (size_t i = 0; i < N; i++) {
+    LambdaRequest myReq("f0", std::string(10, 'A'));
+    myReq.theCallback = mySystem.theCallbackEndpoint;
+    myReq.theDag      = std::make_unique<model::Dag>(
+        model::Dag::Successors({{1, 2, 3, 4}, {5}, {5}, {5}, {5}}),
+        model::Dag::FunctionNames({"f0", "f1", "f0", "f1", "f0", "f1"}),
+        model::Dag::Dependencies());
+    myReq.theNextFunctionIndex = 0;
+
+    const auto myResp = myClient.RunLambda(myReq, false);
+    ASSERT_EQ("OK", myResp.theRetCode);
+    ASSERT_TRUE(myResp.theAsynchronous);
+  }
+
+  ASSERT_TRUE(support::waitFor<size_t>(
+      [&myResponses]() { return myResponses.size(); }, N, 10));
+
+  // exactly one response per DAG
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  ASSERT_EQ(N, myResponses.size());
+
+  for (size_t i = 0; i < N; i++) {
+    const auto myResp = myResponses.pop();
+    ASSERT_EQ("OK", myResp.theRetCode);
+    ASSERT_FALSE(myResp.theAsynchronous);
+    ASSERT_EQ(6, myResp.theHops);
+    ASSERT_EQ(std::string(10, 'A'), myResp.theOutput);
+  }
+}
+
+TEST_F(TestChainDagTransactionGrpc, test_chain_without_companion) {
+  System mySystem;
+
+  // f0 is only served by the first computer
+  mySystem.theComputers[0]->companion("");
+
+  EdgeClientGrpc myClient(mySystem.theRouterEndpoint, false);
+  LambdaRequest  myReq("f0", std::string(10, 'A'));
+  myReq.theCallback = mySystem.theCallbackEndpoint;
+  myReq.theChain    = std::make_unique<model::Chain>(
+      model::Chain::Functions({"f0", "f1"}), model::Chain::Dependencies());
+  myReq.theNextFunctionIndex = 0;
+  CallbackServer::Queue myResponses;
+  CallbackServer myCallbackServer(mySystem.theCallbackEndpoint, myResponses);
+  myCallbackServer.run(false);
+
+  const auto myResp = myClient.RunLambda(myReq, false);
+  ASSERT_EQ("OK", myResp.theRetCode);
+  ASSERT_TRUE(myResp.theAsynchronous);
+
+  // the next function cannot be invoked, which is notified to the callback
+  ASSERT_TRUE(support::waitFor<size_t>(
+      [&myResponses]() { return myResponses.size(); }, 1, 5));
+  const auto myError = myResponses.pop();
+  ASSERT_EQ("companion not set", myError.theRetCode);
+  ASSERT_EQ(mySystem.theComputerEndpoints[0], myError.theResponder);
+
+  // a single function does not need the companion
+  myReq.theChain.reset();
+  const auto mySingle = myClient.RunLambda(myReq, false);
+  ASSERT_EQ("OK", mySingle.theRetCode);
+  ASSERT_TRUE(support::waitFor<size_t>(
+      [&myResponses]() { return myResponses.size(); }, 1, 5));
+  ASSERT_EQ("OK", myResponses.pop().theRetCode);
+}
+
 } // namespace edge
 } // namespace uiiit
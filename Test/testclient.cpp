@@ -0,0 +1,204 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Simulation/client.h"
+#include "Support/saver.h"
+#include "Test/fakeedgeclient.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace uiiit {
+namespace simulation {
+
+struct TestClient : public ::testing::Test {
+  //! Client sending back-to-back requests of 100 bytes.
+  class BackToBackClient final : public Client
+  {
+   public:
+    explicit BackToBackClient(const size_t          aNumRequests,
+                              FakeEdgeClient*       aClient,
+                              const support::Saver& aSaver)
+        : Client(0,
+                 0,
+                 aNumRequests,
+                 std::unique_ptr<edge::EdgeClientInterface>(aClient),
+                 std::string(),
+                 aSaver,
+                 false) {
+    }
+
+    size_t simulate(const double) override {
+      throw std::runtime_error("Not implemented");
+    }
+
+   private:
+    size_t loop() override {
+      sendRequest(100);
+      return 1;
+    }
+  };
+
+  TestClient()
+      : theSaver("", false, false, false) {
+  }
+
+  //! \return a new fake edge client answering after 1 ms.
+  static FakeEdgeClient* makeFake(const std::set<std::string>& aFailing,
+                                  const std::set<std::string>& aThrowing) {
+    return new FakeEdgeClient(
+        std::chrono::milliseconds(1), aFailing, aThrowing);
+  }
+
+  //! State sizes of the example chain and DAG.
+  static std::map<std::string, size_t> stateSizes() {
+    return {{"s0", 10}, {"s1", 20}, {"s2", 30}, {"s3", 40}};
+  }
+
+  const support::Saver theSaver;
+};
+
+TEST_F(TestClient, test_chain) {
+  auto myFake = makeFake({}, {});
+  {
+    BackToBackClient myClient(2, myFake, theSaver);
+    myClient.setChain(edge::model::exampleChain(), stateSizes());
+    myClient();
+    ASSERT_EQ(2, myClient.latencyStat().count());
+    ASSERT_FLOAT_EQ(0.03, myClient.processingStat().mean());
+    ASSERT_EQ(std::vector<std::string>({"f1", "f2", "f1", "f1", "f2", "f1"}),
+              myFake->called());
+  }
+}
+
+TEST_F(TestClient, test_chain_failure) {
+  // function failed
+  auto myFake = makeFake({"f2"}, {});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setChain(edge::model::exampleChain(), stateSizes());
+    myClient();
+    ASSERT_EQ(0, myClient.latencyStat().count());
+    ASSERT_EQ(std::vector<std::string>({"f1", "f2"}), myFake->called());
+  }
+
+  // function cannot be called from the completion of the previous one
+  myFake = makeFake({}, {"f2"});
+  {
+    BackToBackClient myClient(2, myFake, theSaver);
+    myClient.setChain(edge::model::exampleChain(), stateSizes());
+    myClient();
+    ASSERT_EQ(0, myClient.latencyStat().count());
+    ASSERT_EQ(std::vector<std::string>({"f1", "f2", "f1", "f2"}),
+              myFake->called());
+  }
+
+  // entry function cannot be called
+  myFake = makeFake({}, {"f1"});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setChain(edge::model::exampleChain(), stateSizes());
+    ASSERT_THROW(myClient(), std::runtime_error);
+  }
+}
+
+TEST_F(TestClient, test_dag) {
+  auto myFake = makeFake({}, {});
+  {
+    BackToBackClient myClient(2, myFake, theSaver);
+    myClient.setDag(edge::model::exampleDag(), stateSizes());
+    myClient();
+    ASSERT_EQ(2, myClient.latencyStat().count());
+    ASSERT_FLOAT_EQ(0.04, myClient.processingStat().mean());
+
+    // f1 and f2 run concurrently, then the final f2 after both
+    const auto myCalled = myFake->called();
+    ASSERT_EQ(8, myCalled.size());
+    for (size_t i = 0; i < 2; i++) {
+      ASSERT_EQ("f0", myCalled[i * 4]);
+      ASSERT_EQ(std::multiset<std::string>({"f1", "f2"}),
+                std::multiset<std::string>(myCalled.begin() + i * 4 + 1,
+                                           myCalled.begin() + i * 4 + 3));
+      ASSERT_EQ("f2", myCalled[i * 4 + 3]);
+    }
+  }
+}
+
+TEST_F(TestClient, test_dag_failure) {
+  // function failed: its successors are not called
+  auto myFake = makeFake({"f1"}, {});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setDag(edge::model::exampleDag(), stateSizes());
+    ASSERT_THROW(myClient(), std::runtime_error);
+    ASSERT_EQ(3, myFake->called().size());
+  }
+
+  // the first of two functions cannot be called from the completion of the
+  // entry function: the second one is not called either
+  myFake = makeFake({}, {"f1"});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setDag(edge::model::exampleDag(), stateSizes());
+    ASSERT_THROW(myClient(), std::runtime_error);
+    ASSERT_EQ(std::vector<std::string>({"f0", "f1"}), myFake->called());
+  }
+
+  // the second of two functions cannot be called: the DAG completes once the
+  // first one has finished, without calling the final function
+  myFake = makeFake({}, {"f2"});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setDag(edge::model::exampleDag(), stateSizes());
+    ASSERT_THROW(myClient(), std::runtime_error);
+    ASSERT_EQ(std::vector<std::string>({"f0", "f1", "f2"}), myFake->called());
+  }
+
+  // entry function cannot be called
+  myFake = makeFake({}, {"f0"});
+  {
+    BackToBackClient myClient(1, myFake, theSaver);
+    myClient.setDag(edge::model::exampleDag(), stateSizes());
+    ASSERT_THROW(myClient(), std::runtime_error);
+    ASSERT_EQ(std::vector<std::string>({"f0"}), myFake->called());
+  }
+}
+
+} // namespace simulation
+} // namespace uiiit
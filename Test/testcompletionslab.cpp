@@ -0,0 +1,108 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/completionslab.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestCompletionSlab : public ::testing::Test {};
+
+TEST_F(TestCompletionSlab, test_size) {
+  ASSERT_EQ(1u, CompletionSlab<int>(0).size());
+  ASSERT_EQ(1u, CompletionSlab<int>(1).size());
+  ASSERT_EQ(4u, CompletionSlab<int>(3).size());
+  ASSERT_EQ(1024u, CompletionSlab<int>(1024).size());
+}
+
+TEST_F(TestCompletionSlab, test_post_before_wait) {
+  CompletionSlab<std::string> mySlab(4);
+  mySlab.post(0, "zero");
+  mySlab.post(4, "four"); // same slot
+  mySlab.post(1, "one");
+  ASSERT_EQ("one", mySlab.wait(1));
+  ASSERT_EQ("four", mySlab.wait(4));
+  ASSERT_EQ("zero", mySlab.wait(0));
+}
+
+TEST_F(TestCompletionSlab, test_wait_before_post) {
+  CompletionSlab<std::string> mySlab(4);
+  std::string                 myValue;
+  std::thread myWaiter([&mySlab, &myValue]() { myValue = mySlab.wait(42); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  mySlab.post(2, "two"); // same slot, different identifier
+  mySlab.post(42, "forty-two");
+  myWaiter.join();
+  ASSERT_EQ("forty-two", myValue);
+  ASSERT_EQ("two", mySlab.wait(2));
+}
+
+TEST_F(TestCompletionSlab, test_concurrent) {
+  // fewer slots than results in progress to exercise collisions
+  CompletionSlab<uint64_t> mySlab(8);
+  const uint64_t           N = 64;
+  const uint64_t           R = 200;
+  std::atomic<uint64_t>    myErrors(0);
+
+  std::vector<std::thread> myThreads;
+  for (uint64_t i = 0; i < N; i++) {
+    myThreads.emplace_back([&mySlab, &myErrors, i, N, R]() {
+      for (uint64_t r = 0; r < R; r++) {
+        const auto myId = r * N + i;
+        if (mySlab.wait(myId) != myId * 10) {
+          myErrors++;
+        }
+      }
+    });
+    myThreads.emplace_back([&mySlab, i, N, R]() {
+      for (uint64_t r = 0; r < R; r++) {
+        const auto myId = r * N + i;
+        mySlab.post(myId, myId * 10);
+      }
+    });
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  ASSERT_EQ(0u, myErrors.load());
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
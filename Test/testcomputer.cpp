@@ -41,6 +41,8 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <mutex>
+
 namespace uiiit {
 namespace edge {
 
@@ -224,5 +226,56 @@ TEST_F(TestComputer, test_multiple_containers) {
   ASSERT_EQ(4, myList.back().first);
 }
 
+TEST_F(TestComputer, test_shared_processor) {
+  std::mutex                             myMutex;
+  std::list<std::pair<uint64_t, double>> myList;
+  support::Chrono                        myChrono(false);
+  Computer                               myComputer(
+      theName,
+      [&](const uint64_t aId, const RespPtr&) {
+        const std::lock_guard<std::mutex> myLock(myMutex);
+        myList.emplace_back(aId, myChrono.time());
+      },
+      Computer::UtilCallback());
+
+  // 100 operations/s shared by all the tasks running on the processor
+  myComputer.addProcessor("cpu", ProcessorType::GenericCpu, 100, 1, 1000);
+  myComputer.addContainer(
+      "container_short", "cpu", Lambda("short", FixedRequirements(10, 1)), 1);
+  myComputer.addContainer(
+      "container_long", "cpu", Lambda("long", FixedRequirements(40, 1)), 1);
+
+  // other containers on other processors, never used
+  for (auto i = 0; i < 100; i++) {
+    const auto myName = std::to_string(i);
+    myComputer.addProcessor(
+        "cpu" + myName, ProcessorType::GenericCpu, 100, 1, 1000);
+    myComputer.addContainer("container" + myName,
+                            "cpu" + myName,
+                            Lambda("lambda" + myName, FixedRequirements(1, 1)),
+                            1);
+  }
+
+  // the short task runs at half speed: 10 / 50 = 0.2 s
+  // the long task runs at half speed for 0.2 s, then at full speed for the
+  // remaining 30 operations: 0.2 + 30 / 100 = 0.5 s
+  myChrono.start();
+  const auto myLongId  = myComputer.addTask(LambdaRequest("long", ""));
+  const auto myShortId = myComputer.addTask(LambdaRequest("short", ""));
+
+  WAIT_FOR(
+      [&]() {
+        const std::lock_guard<std::mutex> myLock(myMutex);
+        return myList.size() == 2;
+      },
+      2.0);
+  const std::lock_guard<std::mutex> myLock(myMutex);
+  ASSERT_EQ(2u, myList.size());
+  ASSERT_EQ(myShortId, myList.front().first);
+  ASSERT_EQ(myLongId, myList.back().first);
+  ASSERT_NEAR(0.2, myList.front().second, 0.05);
+  ASSERT_NEAR(0.5, myList.back().second, 0.05);
+}
+
 } // namespace edge
 } // namespace uiiit
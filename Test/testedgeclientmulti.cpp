@@ -30,19 +30,33 @@ SOFTWARE.
 */
 
 #include "Edge/computer.h"
+#include "Edge/edgeclientgrpc.h"
 #include "Edge/edgeclientmulti.h"
 #include "Edge/edgecomputersim.h"
 #include "Edge/edgeservergrpc.h"
 #include "Edge/edgeserverimpl.h"
 #include "Edge/lambda.h"
 #include "Edge/processortype.h"
+#include "Support/chrono.h"
 #include "Support/conf.h"
+#include "Support/random.h"
+#include "Support/split.h"
 #include "Support/wait.h"
+#include "Test/testenv.h"
 
 #include "gtest/gtest.h"
 
 #include <glog/logging.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace uiiit {
 namespace edge {
 
@@ -183,5 +197,154 @@ TEST_F(TestEdgeClientMulti, test_grpc_three_destinations) {
   ASSERT_GT(myCounter[theEndpoint2], 0u);
 }
 
+TEST_F(TestEdgeClientMulti, DISABLED_test_slow_secondary_performance) {
+  const auto myThreads =
+      support::split<std::list<size_t>>(envOrDefault("THREADS", "1,4,16"), ",");
+  const auto myDuration    = std::stod(envOrDefault("DURATION", "2"));
+  const auto myPersistence = std::stod(envOrDefault("PERSISTENCE", "0.5"));
+  const auto mySlowSpeed   = std::stod(envOrDefault("SLOWSPEED", "1e7"));
+
+  // two fast computers and a slow one
+  std::vector<std::unique_ptr<EdgeComputer>>   myComputers;
+  std::vector<std::unique_ptr<EdgeServerImpl>> myServers;
+  for (const auto& myEndpoint : {theEndpoint1, theEndpoint2, theEndpoint3}) {
+    myComputers.emplace_back(makeComputer(
+        myEndpoint, myEndpoint == theEndpoint3 ? mySlowSpeed : 1e9));
+    myServers.emplace_back(
+        std::make_unique<EdgeServerGrpc>(*myComputers.back(), 4, false));
+    myServers.back()->run();
+  }
+  const std::set<std::string> myEndpoints(
+      {theEndpoint1, theEndpoint2, theEndpoint3});
+
+  // mimic the previous implementation: the fastest response is returned but
+  // the next request waits until all the destinations of this one replied
+  struct BlockingClient {
+    BlockingClient(const std::set<std::string>& aEndpoints,
+                   const double                 aPersistence)
+        : thePersistence(aPersistence)
+        , theMutex()
+        , theClients()
+        , thePrimary(0)
+        , thePending() {
+      for (const auto& myEndpoint : aEndpoints) {
+        theClients.emplace_back(
+            std::make_unique<EdgeClientGrpc>(myEndpoint, false));
+      }
+    }
+
+    LambdaResponse operator()(const LambdaRequest& aReq) {
+      const std::lock_guard<std::mutex> myLock(theMutex);
+      for (auto& myFuture : thePending) {
+        myFuture.wait();
+      }
+      thePending.clear();
+
+      // the request may be used after this function returns
+      const auto myReq = std::make_shared<LambdaRequest>(aReq.copy());
+      std::vector<std::future<LambdaResponse>> myFutures;
+      std::vector<size_t>                      myIndices;
+      for (size_t i = 0; i < theClients.size(); i++) {
+        if (i != thePrimary and support::random() >= thePersistence) {
+          continue;
+        }
+        myIndices.emplace_back(i);
+        myFutures.emplace_back(
+            std::async(std::launch::async, [this, i, myReq]() {
+              return theClients[i]->RunLambda(*myReq, false);
+            }));
+      }
+
+      // poll the futures until one succeeds or all fail
+      std::unique_ptr<LambdaResponse> ret;
+      std::vector<bool>               myDone(myFutures.size(), false);
+      for (size_t myLeft = myFutures.size(); myLeft > 0;) {
+        for (size_t i = 0; i < myFutures.size() and myLeft > 0; i++) {
+          if (myDone[i] or myFutures[i].wait_for(std::chrono::microseconds(
+                               10)) != std::future_status::ready) {
+            continue;
+          }
+          myDone[i] = true;
+          myLeft--;
+          try {
+            ret = std::make_unique<LambdaResponse>(myFutures[i].get());
+          } catch (const std::exception& aErr) {
+            ret = std::make_unique<LambdaResponse>(aErr.what(), "");
+          }
+          if (ret->ok()) {
+            thePrimary = myIndices[i];
+            myLeft     = 0;
+          }
+        }
+      }
+      for (size_t i = 0; i < myFutures.size(); i++) {
+        if (not myDone[i]) {
+          thePending.emplace_back(std::move(myFutures[i]));
+        }
+      }
+      return *ret;
+    }
+
+    const double                                 thePersistence;
+    std::mutex                                   theMutex;
+    std::vector<std::unique_ptr<EdgeClientGrpc>> theClients;
+    size_t                                       thePrimary;
+    std::list<std::future<LambdaResponse>>       thePending;
+  };
+
+  EdgeClientMulti myClient(myEndpoints,
+                           false,
+                           support::Conf("type=grpc,persistence=" +
+                                         std::to_string(myPersistence)));
+  BlockingClient  myBlockingClient(myEndpoints, myPersistence);
+
+  // wait for all the computers to be ready
+  const LambdaRequest myReq("lambda0", "hello");
+  for (const auto& myEndpoint : myEndpoints) {
+    EdgeClientGrpc myWarmUpClient(myEndpoint, false);
+    ASSERT_TRUE(support::waitFor<bool>(
+        [&]() { return myWarmUpClient.RunLambda(myReq, false).ok(); },
+        true,
+        5.0));
+  }
+
+  const auto myRun = [myDuration,
+                      &myReq](const size_t                    aNumThreads,
+                              std::function<LambdaResponse()> aRun) {
+    std::atomic<bool>      myStop(false);
+    std::atomic<size_t>    myLambdas(0);
+    std::list<std::thread> myThreads;
+    for (size_t i = 0; i < aNumThreads; i++) {
+      myThreads.emplace_back([&]() {
+        size_t myLocal = 0;
+        while (not myStop) {
+          if (aRun().ok()) {
+            myLocal++;
+          }
+        }
+        myLambdas += myLocal;
+      });
+    }
+    support::Chrono myChrono(true);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(static_cast<long>(myDuration * 1e3)));
+    myStop = true;
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+    return myLambdas / myChrono.stop();
+  };
+
+  for (const auto myNumThreads : myThreads) {
+    const auto myPipelinedRate = myRun(
+        myNumThreads, [&]() { return myClient.RunLambda(myReq, false); });
+    const auto myBlockingRate =
+        myRun(myNumThreads, [&]() { return myBlockingClient(myReq); });
+    LOG(INFO) << "threads " << myNumThreads << ", persistence "
+              << myPersistence << ", lambdas/s pipelined " << myPipelinedRate
+              << ", blocking " << myBlockingRate;
+  }
+}
+
 } // namespace edge
 } // namespace uiiit
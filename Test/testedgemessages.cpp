@@ -32,11 +32,16 @@ SOFTWARE.
 #include "Edge/Model/chain.h"
 #include "Edge/Model/dag.h"
 #include "Edge/edgemessages.h"
+#include "Edge/lambdaprotocol.h"
 
 #include "gtest/gtest.h"
 
 #include <glog/logging.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace uiiit {
 namespace edge {
 
@@ -55,6 +60,7 @@ TEST_F(TestEdgeMessages, test_request_serialize_deserialize) {
   myRequest.states().emplace("state1", State::fromContent("another_content"));
   myRequest.states().emplace("state2", State::fromLocation("1.2.3.4:6666"));
   myRequest.theCallback = "1.2.3.4:6666";
+  myRequest.theTimeout  = 1500;
   LOG(INFO) << myRequest.toString();
 
   const auto    myReqSerialized = myRequest.toProtobuf();
@@ -110,10 +116,45 @@ TEST_F(TestEdgeMessages, test_request_copy) {
 
 TEST_F(TestEdgeMessages, test_request_one_more_hop) {
   LambdaRequest myRequest("name", "input", "datain");
-  const auto    myCopy = myRequest.makeOneMoreHop();
+  myRequest.theTimeout = 42;
+  const auto myCopy    = myRequest.makeOneMoreHop();
   ASSERT_FALSE(myRequest == myCopy);
   ASSERT_EQ(myRequest.theUuid, myCopy.theUuid);
   ASSERT_EQ(myRequest.theHops + 1, myCopy.theHops);
+  ASSERT_EQ(42u, myCopy.theTimeout);
+}
+
+TEST_F(TestEdgeMessages, test_request_shared_payloads) {
+  LambdaRequest myRequest("name", "input", "datain");
+  myRequest.states().emplace("state0", State::fromContent("content"));
+
+  // copies share the same payloads
+  const auto myCopy = myRequest.copy();
+  ASSERT_EQ(myRequest.theInput.get(), myCopy.theInput.get());
+  ASSERT_EQ(myRequest.theDataIn.get(), myCopy.theDataIn.get());
+  ASSERT_EQ(myRequest.states().at("state0").theContent.get(),
+            myCopy.states().at("state0").theContent.get());
+  const auto myOneMoreHop = myRequest.makeOneMoreHop();
+  ASSERT_EQ(myRequest.theInput.get(), myOneMoreHop.theInput.get());
+
+  // deserialization copies the payloads from the message
+  const auto    myMsg = myRequest.toProtobuf();
+  LambdaRequest myDeserialized(myMsg);
+  ASSERT_NE(&myMsg.input(), &myDeserialized.input());
+  ASSERT_NE(&myMsg.datain(), &myDeserialized.dataIn());
+  ASSERT_NE(&myMsg.states().at("state0").content(),
+            &myDeserialized.states().at("state0").content());
+
+  // a view refers to the payloads of the message
+  const auto myView = LambdaRequest::view(myMsg);
+  ASSERT_EQ(&myMsg.input(), &myView.input());
+  ASSERT_EQ(&myMsg.datain(), &myView.dataIn());
+  ASSERT_EQ(&myMsg.states().at("state0").content(),
+            &myView.states().at("state0").content());
+  ASSERT_TRUE(myRequest == myView) << "\n"
+                                   << myRequest.toString() << "\nvs.\n"
+                                   << myView.toString();
+  ASSERT_TRUE(myDeserialized == myView);
 }
 
 TEST_F(TestEdgeMessages, test_response_serialize_deserialize_sync) {
@@ -143,5 +184,173 @@ TEST_F(TestEdgeMessages, test_response_serialize_deserialize_async) {
       << myResDeserialized.toString();
 }
 
+TEST_F(TestEdgeMessages, test_response_status) {
+  for (const auto& myRetCode : std::vector<std::string>({"OK",
+                                                         "deadline exceeded",
+                                                         "overloaded",
+                                                         "loop detected",
+                                                         "unknown lambda id",
+                                                         "some error"})) {
+    const auto myStatus = toStatus(myRetCode);
+    ASSERT_EQ(myRetCode,
+              toRetCode(myStatus, myStatus == rpc::STATUS_ERROR ? myRetCode :
+                                                                  ""));
+    ASSERT_EQ(myRetCode == "OK", LambdaResponse(myRetCode, "").ok());
+  }
+  ASSERT_EQ(rpc::STATUS_ERROR, toStatus(""));
+  ASSERT_EQ("legacy", toRetCode(rpc::STATUS_UNSPECIFIED, "legacy"));
+
+  // version 1: status with the detail only for generic errors
+  rpc::LambdaResponse myMsg;
+  myMsg.set_status(rpc::STATUS_OVERLOADED);
+  ASSERT_FALSE(LambdaResponse(myMsg).ok());
+  ASSERT_EQ("overloaded", LambdaResponse(myMsg).theRetCode);
+  myMsg.set_status(rpc::STATUS_ERROR);
+  myMsg.set_retcode("some error");
+  ASSERT_EQ("some error", LambdaResponse(myMsg).theRetCode);
+  myMsg.set_status(rpc::STATUS_OK);
+  myMsg.clear_retcode();
+  ASSERT_TRUE(LambdaResponse(myMsg).ok());
+  ASSERT_EQ("OK", LambdaResponse(myMsg).theRetCode);
+
+  // version 0: return code only
+  ASSERT_TRUE(LambdaResponse(LambdaResponse("OK", "").toProtobuf()).ok());
+  ASSERT_FALSE(LambdaResponse(LambdaResponse("KO", "").toProtobuf()).ok());
+}
+
+TEST_F(TestEdgeMessages, test_lambda_protocol) {
+  auto myServer = std::make_unique<LambdaProtocolServer>();
+  LambdaProtocolClient myClient;
+
+  const auto myRun = [&](const std::string& aName,
+                         const std::string& aRetCode) {
+    auto myReq = LambdaRequest(aName, "input").toProtobuf();
+    myClient.encode(myReq);
+    const auto          mySent = myReq;
+    rpc::LambdaResponse myRep;
+    if (myServer->resolve(myReq)) {
+      EXPECT_EQ(aName, myReq.name());
+      myRep = LambdaResponse(aRetCode, "output").toProtobuf();
+    } else {
+      myRep.set_retcode(toRetCode(rpc::STATUS_UNKNOWN_LAMBDA_ID, ""));
+    }
+    myServer->encode(myReq, myRep);
+    return std::make_pair(mySent, myRep);
+  };
+
+  // first request: by name, the server assigns an identifier
+  auto res = myRun("lambda0", "OK");
+  ASSERT_EQ(LambdaProtocol::theVersion, res.first.version());
+  ASSERT_EQ(0u, res.first.lambdaid());
+  ASSERT_EQ(rpc::STATUS_OK, res.second.status());
+  ASSERT_TRUE(res.second.retcode().empty());
+  ASSERT_NE(0u, res.second.lambdaid());
+  const auto myId = res.second.lambdaid();
+  ASSERT_TRUE(myClient.decode("lambda0", res.second));
+
+  // following requests: by identifier
+  res = myRun("lambda0", "some error");
+  ASSERT_EQ(myId, res.first.lambdaid());
+  ASSERT_EQ(rpc::STATUS_ERROR, res.second.status());
+  ASSERT_EQ("some error", res.second.retcode());
+  ASSERT_EQ(myId, res.second.lambdaid());
+  ASSERT_TRUE(myClient.decode("lambda0", res.second));
+
+  // other lambdas have other identifiers
+  res = myRun("lambda1", "OK");
+  ASSERT_NE(myId, res.second.lambdaid());
+  ASSERT_TRUE(myClient.decode("lambda1", res.second));
+
+  // a new server does not know the identifiers of the previous one
+  myServer = std::make_unique<LambdaProtocolServer>();
+  res = myRun("lambda0", "OK");
+  ASSERT_EQ(rpc::STATUS_UNKNOWN_LAMBDA_ID, res.second.status());
+  ASSERT_EQ(0u, res.second.lambdaid());
+  ASSERT_FALSE(myClient.decode("lambda0", res.second));
+  res = myRun("lambda0", "OK");
+  ASSERT_EQ(0u, res.first.lambdaid());
+  ASSERT_EQ(rpc::STATUS_OK, res.second.status());
+
+  // legacy clients: return code only and no identifiers
+  rpc::LambdaRequest myLegacyReq = LambdaRequest("lambda0", "").toProtobuf();
+  ASSERT_TRUE(myServer->resolve(myLegacyReq));
+  auto myLegacyRep = LambdaResponse("overloaded", "").toProtobuf();
+  myServer->encode(myLegacyReq, myLegacyRep);
+  ASSERT_EQ(rpc::STATUS_UNSPECIFIED, myLegacyRep.status());
+  ASSERT_EQ("overloaded", myLegacyRep.retcode());
+  ASSERT_EQ(0u, myLegacyRep.lambdaid());
+}
+
+TEST_F(TestEdgeMessages, test_lambda_protocol_max_ids) {
+  const auto myEncode = [](LambdaProtocolServer& aServer,
+                           const std::string&    aName,
+                           const std::string&    aRetCode) {
+    auto myReq = LambdaRequest(aName, "").toProtobuf();
+    myReq.set_version(LambdaProtocol::theVersion);
+    auto myRep = LambdaResponse(aRetCode, "").toProtobuf();
+    aServer.encode(myReq, myRep);
+    return myRep.lambdaid();
+  };
+
+  LambdaProtocolServer myServer(2);
+  for (const auto& myName : {"lambda0", "lambda1", "lambda2"}) {
+    ASSERT_EQ(std::string(myName) == "lambda2",
+              myEncode(myServer, myName, "OK") == 0);
+  }
+  ASSERT_EQ(2u, myServer.size());
+
+  // no identifiers at all
+  LambdaProtocolServer myNoIdsServer(0);
+  ASSERT_EQ(0u, myEncode(myNoIdsServer, "lambda0", "OK"));
+
+  // the table is full with 65535 identifiers, which do not overflow into
+  // the epoch bits and remain valid after the table is full
+  LambdaProtocolServer myFullServer;
+  uint32_t             myLast = 0;
+  for (size_t i = 0; i < 65535; i++) {
+    const auto myId = myEncode(myFullServer, "l" + std::to_string(i), "OK");
+    ASSERT_NE(0u, myId);
+    ASSERT_EQ(i + 1, myId & 0xffff);
+    ASSERT_TRUE(myLast == 0 or (myLast & 0xffff0000) == (myId & 0xffff0000));
+    myLast = myId;
+  }
+  ASSERT_EQ(65535u, myFullServer.size());
+  ASSERT_EQ(0u, myEncode(myFullServer, "another", "OK"));
+  ASSERT_EQ(65535u, myFullServer.size());
+  ASSERT_EQ(myLast, myEncode(myFullServer, "l65534", "OK"));
+
+  rpc::LambdaRequest myReq;
+  myReq.set_lambdaid(myLast);
+  ASSERT_TRUE(myFullServer.resolve(myReq));
+  ASSERT_EQ("l65534", myReq.name());
+}
+
+TEST_F(TestEdgeMessages, test_lambda_protocol_failed_lambdas) {
+  LambdaProtocolServer myServer;
+
+  // no identifier is assigned to lambdas that are unknown or fail
+  for (const auto& myRetCode :
+       {"could not find lambda", "overloaded", "deadline exceeded"}) {
+    auto myReq = LambdaRequest("lambda0", "").toProtobuf();
+    myReq.set_version(LambdaProtocol::theVersion);
+    auto myRep = LambdaResponse(myRetCode, "").toProtobuf();
+    myServer.encode(myReq, myRep);
+    ASSERT_EQ(0u, myRep.lambdaid()) << myRetCode;
+  }
+  ASSERT_EQ(0u, myServer.size());
+
+  // once assigned, the identifier is returned whatever the outcome
+  auto myReq = LambdaRequest("lambda0", "").toProtobuf();
+  myReq.set_version(LambdaProtocol::theVersion);
+  auto myRep = LambdaResponse("OK", "").toProtobuf();
+  myServer.encode(myReq, myRep);
+  const auto myId = myRep.lambdaid();
+  ASSERT_NE(0u, myId);
+  myRep = LambdaResponse("overloaded", "").toProtobuf();
+  myServer.encode(myReq, myRep);
+  ASSERT_EQ(myId, myRep.lambdaid());
+  ASSERT_EQ(1u, myServer.size());
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -30,8 +30,17 @@ SOFTWARE.
 */
 
 #include "Edge/edgeclientgrpc.h"
+#include "Edge/edgeclientgrpcasync.h"
+#include "Edge/edgeclientpool.h"
+#include "Edge/edgelambdaprocessor.h"
+#include "Edge/edgerouter.h"
 #include "Edge/edgeserver.h"
 #include "Edge/edgeservergrpc.h"
+#include "Edge/forwardingtableinterface.h"
+#include "Support/chrono.h"
+#include "Support/conf.h"
+#include "Support/split.h"
+#include "Test/testenv.h"
 
 #include "gtest/gtest.h"
 
@@ -39,10 +48,15 @@ SOFTWARE.
 
 #include <glog/logging.h>
 
+#include <atomic>
 #include <cctype>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
 #include <stdexcept>
 #include <thread>
 
@@ -87,6 +101,89 @@ class TrivialEdgeServer final : public EdgeServer
   const std::string theThrowingLambda;
 };
 
+// return in the output the fields that change at every hop
+class HopsEdgeServer final : public EdgeServer
+{
+ public:
+  explicit HopsEdgeServer(const std::string& aEndpoint)
+      : EdgeServer(aEndpoint) {
+    // noop
+  }
+
+  rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override {
+    rpc::LambdaResponse ret;
+    ret.set_retcode("OK");
+    ret.set_output(
+        "hops=" + std::to_string(aReq.hops()) +
+        ",forward=" + std::to_string(aReq.forward()) +
+        ",dry=" + std::to_string(aReq.dry()) +
+        ",timeout=" + std::to_string(aReq.timeout() > 0) +
+        ",input=" + std::to_string(aReq.input().size()) +
+        ",states=" + std::to_string(aReq.states().size()));
+    return ret;
+  }
+};
+
+// return the input with all the response fields set
+class EchoEdgeServer final : public EdgeServer
+{
+ public:
+  explicit EchoEdgeServer(const std::string& aEndpoint)
+      : EdgeServer(aEndpoint) {
+    // noop
+  }
+
+  rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override {
+    rpc::LambdaResponse ret;
+    ret.set_retcode("OK");
+    ret.set_output(aReq.input());
+    ret.set_responder(serverEndpoint());
+    ret.set_ptime(42);
+    ret.set_hops(aReq.hops() + 1);
+    return ret;
+  }
+};
+
+// park all the requests until release() is called
+class DeferredEdgeServer final : public EdgeServer
+{
+ public:
+  explicit DeferredEdgeServer(const std::string& aEndpoint)
+      : EdgeServer(aEndpoint)
+      , theCallbacks() {
+    // noop
+  }
+
+  rpc::LambdaResponse process(const rpc::LambdaRequest&) override {
+    throw std::runtime_error("synchronous processing not expected");
+  }
+
+  void processAsync(const rpc::LambdaRequest& aReq,
+                    const AsyncCallback&      aCallback) override {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theCallbacks.emplace_back(aReq.input(), aCallback);
+  }
+
+  size_t parked() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theCallbacks.size();
+  }
+
+  void release() {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    for (const auto& myCallback : theCallbacks) {
+      rpc::LambdaResponse myResp;
+      myResp.set_retcode("OK");
+      myResp.set_output(myCallback.first);
+      myCallback.second(std::move(myResp));
+    }
+    theCallbacks.clear();
+  }
+
+ private:
+  std::list<std::pair<std::string, AsyncCallback>> theCallbacks;
+};
+
 struct TestEdgeServerGrpc : public ::testing::Test {
   TestEdgeServerGrpc()
       : theEndpoint("localhost:6666") {
@@ -396,5 +493,474 @@ TEST_F(TestEdgeServerGrpc, test_insecure_server_secure_client) {
       rpc::RpcFailed);
 }
 
+TEST_F(TestEdgeServerGrpc, test_async_client_and_server) {
+  // one single server thread
+  DeferredEdgeServer myEdgeServer(theEndpoint);
+  EdgeServerGrpc     myEdgeServerGrpc(myEdgeServer, 1, false);
+  myEdgeServerGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  const size_t            N = 50;
+  std::mutex              myMutex;
+  std::condition_variable myCond;
+  std::list<std::string>  myOutputs;
+  size_t                  myErrors = 0;
+
+  EdgeClientGrpcAsync myClient(false);
+  for (size_t i = 0; i < N; i++) {
+    myClient.RunLambda(
+        theEndpoint,
+        LambdaRequest("my-lambda", std::to_string(i)),
+        false,
+        [&](LambdaResponse&& aRep, const double aTime) {
+          const std::lock_guard<std::mutex> myLock(myMutex);
+          if (aRep.theRetCode == "OK" and aRep.theResponder == theEndpoint and
+              aTime >= 0) {
+            myOutputs.emplace_back(aRep.theOutput);
+          } else {
+            myErrors++;
+          }
+          myCond.notify_one();
+        });
+  }
+
+  // all the requests are in flight at the same time
+  for (auto i = 0; i < 50 and myEdgeServer.parked() < N; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  ASSERT_EQ(N, myEdgeServer.parked());
+  ASSERT_EQ(N, myClient.pending());
+
+  myEdgeServer.release();
+
+  std::unique_lock<std::mutex> myLock(myMutex);
+  ASSERT_TRUE(myCond.wait_for(myLock, std::chrono::seconds(5), [&]() {
+    return (myOutputs.size() + myErrors) == N;
+  }));
+  ASSERT_EQ(0u, myErrors);
+  myOutputs.sort();
+  myOutputs.unique();
+  ASSERT_EQ(N, myOutputs.size());
+}
+
+TEST_F(TestEdgeServerGrpc, test_async_client_unreachable) {
+  EdgeClientGrpcAsync     myClient(false);
+  std::mutex              myMutex;
+  std::condition_variable myCond;
+  std::string             myRetCode;
+
+  myClient.RunLambda("localhost:10000",
+                     LambdaRequest("my-lambda", "Hello world!"),
+                     false,
+                     [&](LambdaResponse&& aRep, const double) {
+                       const std::lock_guard<std::mutex> myLock(myMutex);
+                       myRetCode = aRep.theRetCode;
+                       myCond.notify_one();
+                     });
+
+  std::unique_lock<std::mutex> myLock(myMutex);
+  ASSERT_TRUE(myCond.wait_for(myLock, std::chrono::seconds(30), [&]() {
+    return not myRetCode.empty();
+  }));
+  ASSERT_NE("OK", myRetCode);
+}
+
+TEST_F(TestEdgeServerGrpc, test_shared_client_pool) {
+  ASSERT_THROW(
+      EdgeClientPool(false, support::Conf("type=quic,channels=2"), 5),
+      std::runtime_error);
+
+  DeferredEdgeServer myEdgeServer(theEndpoint);
+  EdgeServerGrpc     myEdgeServerGrpc(myEdgeServer, 1, false);
+  myEdgeServerGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // up to 5 requests in flight over 2 shared clients
+  const size_t   N = 5;
+  EdgeClientPool myPool(false, support::Conf("type=grpc,channels=2"), N);
+  std::atomic<size_t>    mySuccesses(0);
+  std::list<std::thread> myThreads;
+  for (size_t i = 0; i < N; i++) {
+    myThreads.emplace_back([&, i]() {
+      const auto ret = myPool(
+          theEndpoint, LambdaRequest("my-lambda", std::to_string(i)), false);
+      if (ret.first.theRetCode == "OK" and
+          ret.first.theOutput == std::to_string(i) and
+          ret.first.theResponder == theEndpoint) {
+        mySuccesses++;
+      }
+    });
+  }
+
+  for (auto i = 0; i < 50 and myEdgeServer.parked() < N; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  ASSERT_EQ(N, myEdgeServer.parked());
+
+  // one more request is rejected without waiting
+  support::Chrono myChrono(true);
+  ASSERT_THROW(myPool(theEndpoint, LambdaRequest("my-lambda", ""), false),
+               TooManyPendingRequests);
+  ASSERT_LT(myChrono.stop(), 1.0);
+
+  myEdgeServer.release();
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  ASSERT_EQ(N, mySuccesses);
+
+  // slots are released after the responses
+  myThreads.clear();
+  myThreads.emplace_back([&]() {
+    myPool(theEndpoint, LambdaRequest("my-lambda", "again"), false);
+  });
+  for (auto i = 0; i < 50 and myEdgeServer.parked() < 1; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  ASSERT_EQ(1u, myEdgeServer.parked());
+  myEdgeServer.release();
+  myThreads.front().join();
+
+  // requests executed without the pool clients, e.g., asynchronously, count
+  // as in flight as long as their reservation is kept
+  std::list<EdgeClientPool::Reservation> myReservations;
+  for (size_t i = 0; i < N; i++) {
+    myReservations.emplace_back(myPool.reserve(theEndpoint));
+  }
+  ASSERT_THROW(myPool.reserve(theEndpoint), TooManyPendingRequests);
+  ASSERT_THROW(myPool(theEndpoint, LambdaRequest("my-lambda", ""), false),
+               TooManyPendingRequests);
+  myReservations.pop_front();
+  ASSERT_NO_THROW(myPool.reserve(theEndpoint));
+  myReservations.clear();
+  for (size_t i = 0; i < N; i++) {
+    myReservations.emplace_back(myPool.reserve(theEndpoint));
+  }
+  myReservations.clear();
+
+  // nothing is reserved in non-shared mode
+  EdgeClientPool myExclusivePool(false, support::Conf("type=grpc"), 1);
+  ASSERT_NO_THROW(myReservations.emplace_back(
+      myExclusivePool.reserve(theEndpoint)));
+  ASSERT_NO_THROW(myReservations.emplace_back(
+      myExclusivePool.reserve(theEndpoint)));
+}
+
+TEST_F(TestEdgeServerGrpc, test_router_deadline_overload) {
+  // the computer never answers until released
+  const std::string  myComputerEndpoint("localhost:6667");
+  DeferredEdgeServer myComputer(myComputerEndpoint);
+  EdgeServerGrpc     myComputerGrpc(myComputer, 1, false);
+  myComputerGrpc.run();
+
+  EdgeRouter myRouter(theEndpoint,
+                      "",
+                      "",
+                      false,
+                      support::Conf(EdgeLambdaProcessor::defaultConf() +
+                                    ",async=true,timeout=0.5,max-pending=2"),
+                      support::Conf("type=random"),
+                      support::Conf("type=trivial,period=10,stat=mean"),
+                      support::Conf("type=grpc"));
+  myRouter.tables()[0]->change("lambda0", myComputerEndpoint, 1);
+  EdgeServerGrpc myRouterGrpc(myRouter, 1, false);
+  myRouterGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // fill the router up to max-pending
+  std::list<std::string> myRetCodes;
+  std::mutex             myMutex;
+  std::list<std::thread> myThreads;
+  for (auto i = 0; i < 2; i++) {
+    myThreads.emplace_back([&]() {
+      EdgeClientGrpc myClient(theEndpoint, false);
+      const auto     myRetCode =
+          myClient.RunLambda(LambdaRequest("lambda0", ""), false).theRetCode;
+      const std::lock_guard<std::mutex> myLock(myMutex);
+      myRetCodes.emplace_back(myRetCode);
+    });
+  }
+  for (auto i = 0; i < 50 and myComputer.parked() < 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(2u, myComputer.parked());
+
+  // the next lambda is rejected immediately
+  EdgeClientGrpc myClient(theEndpoint, false);
+  ASSERT_EQ("overloaded",
+            myClient.RunLambda(LambdaRequest("lambda0", ""), false).theRetCode);
+
+  // the lambdas in progress expire without the computer being purged
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  ASSERT_EQ(std::list<std::string>({"deadline exceeded", "deadline exceeded"}),
+            myRetCodes);
+  ASSERT_EQ(1u, myRouter.tables()[0]->fullTable()["lambda0"].size());
+
+  // the deadline carried by a lambda is enforced by the client
+  LambdaRequest myReq("lambda0", "");
+  myReq.theTimeout = 100;
+  EdgeClientGrpc  myComputerClient(myComputerEndpoint, false);
+  support::Chrono myChrono(true);
+  ASSERT_ANY_THROW(myComputerClient.RunLambda(myReq, false));
+  ASSERT_LT(myChrono.stop(), 1.0);
+
+  myComputer.release();
+}
+
+TEST_F(TestEdgeServerGrpc, test_router_forward) {
+  const std::string myComputerEndpoint("localhost:6667");
+  HopsEdgeServer    myComputer(myComputerEndpoint);
+  EdgeServerGrpc    myComputerGrpc(myComputer, 1, false);
+  myComputerGrpc.run();
+
+  for (const std::string myConf : {"", ",async=true", ",timeout=5"}) {
+    EdgeRouter myRouter(
+        theEndpoint,
+        "",
+        "",
+        false,
+        support::Conf(EdgeLambdaProcessor::defaultConf() + myConf),
+        support::Conf("type=random"),
+        support::Conf("type=trivial,period=10,stat=mean"),
+        support::Conf("type=grpc"));
+    myRouter.tables()[0]->change("lambda0", myComputerEndpoint, 1);
+    EdgeServerGrpc myRouterGrpc(myRouter, 1, false);
+    myRouterGrpc.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // the request is forwarded unchanged, except for the hop-by-hop fields
+    LambdaRequest myReq("lambda0", std::string(1 << 20, 'x'));
+    myReq.states().emplace("s0", State::fromContent("content"));
+    EdgeClientGrpc myClient(theEndpoint, false);
+    const auto     myResp = myClient.RunLambda(myReq, false);
+    ASSERT_EQ("OK", myResp.theRetCode);
+    ASSERT_EQ(std::string("hops=1,forward=1,dry=0,timeout=") +
+                  (myConf == ",timeout=5" ? "1" : "0") +
+                  ",input=1048576,states=1",
+              myResp.theOutput)
+        << "conf: " << myConf;
+  }
+}
+
+TEST_F(TestEdgeServerGrpc, test_router_hedged) {
+  const std::string myFastEndpoint("localhost:6667");
+  EchoEdgeServer    myFast(myFastEndpoint);
+  EdgeServerGrpc    myFastGrpc(myFast, 1, false);
+  myFastGrpc.run();
+
+  // the slow computer never answers until released
+  const std::string  mySlowEndpoint("localhost:6668");
+  DeferredEdgeServer mySlow(mySlowEndpoint);
+  EdgeServerGrpc     mySlowGrpc(mySlow, 1, false);
+  mySlowGrpc.run();
+
+  EdgeRouter myRouter(theEndpoint,
+                      "",
+                      "",
+                      false,
+                      support::Conf(EdgeLambdaProcessor::defaultConf() +
+                                    ",hedge-percentile=0.9,hedge-window=10"),
+                      support::Conf("type=round-robin"),
+                      support::Conf("type=trivial,period=10,stat=mean"),
+                      support::Conf("type=grpc"));
+  myRouter.tables()[0]->change("lambda0", myFastEndpoint, 1);
+  EdgeServerGrpc myRouterGrpc(myRouter, 1, false);
+  myRouterGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // learn the response times of the fast computer, then add the slow one:
+  // the destinations are selected alternately, with equal weights, hence
+  // the lambdas forwarded to the slow computer are hedged to the fast one
+  EdgeClientGrpc myClient(theEndpoint, false);
+  for (auto i = 0; i < 10; i++) {
+    ASSERT_EQ("OK",
+              myClient.RunLambda(LambdaRequest("lambda0", ""), false)
+                  .theRetCode);
+  }
+  myRouter.tables()[0]->change("lambda0", mySlowEndpoint, 1);
+
+  for (auto i = 0; i < 20; i++) {
+    const auto myInput = std::to_string(i);
+    const auto myResp =
+        myClient.RunLambda(LambdaRequest("lambda0", myInput), false);
+
+    // the response of the computer is returned as it is
+    ASSERT_EQ("OK", myResp.theRetCode);
+    ASSERT_EQ(myInput, myResp.theOutput);
+    ASSERT_EQ(myFastEndpoint, myResp.theResponder);
+    ASSERT_EQ(42u, myResp.theProcessingTime);
+    ASSERT_EQ(2u, myResp.theHops);
+  }
+  ASSERT_GT(mySlow.parked(), 0u);
+  mySlow.release();
+}
+
+TEST_F(TestEdgeServerGrpc, test_router_async_retry) {
+  const std::string myComputerEndpoint("localhost:6667");
+  HopsEdgeServer    myComputer(myComputerEndpoint);
+  EdgeServerGrpc    myComputerGrpc(myComputer, 1, false);
+  myComputerGrpc.run();
+
+  EdgeRouter myRouter(theEndpoint,
+                      "",
+                      "",
+                      false,
+                      support::Conf(EdgeLambdaProcessor::defaultConf() +
+                                    ",async=true"),
+                      support::Conf("type=random"),
+                      support::Conf("type=trivial,period=10,stat=mean"),
+                      support::Conf("type=grpc"));
+  myRouter.tables()[0]->change("lambda0", myComputerEndpoint, 1);
+  myRouter.tables()[0]->change("lambda0", "localhost:6668", 1);
+  EdgeServerGrpc myRouterGrpc(myRouter, 1, false);
+  myRouterGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // the unreachable destination is purged and the lambdas are retried on
+  // the other one
+  EdgeClientGrpc myClient(theEndpoint, false);
+  for (auto i = 0; i < 20; i++) {
+    ASSERT_EQ("OK",
+              myClient.RunLambda(LambdaRequest("lambda0", ""), false)
+                  .theRetCode);
+  }
+  ASSERT_EQ(1u, myRouter.tables()[0]->fullTable()["lambda0"].size());
+}
+
+TEST_F(TestEdgeServerGrpc, test_router_async_stop) {
+  // the computer never answers until released
+  const std::string  myComputerEndpoint("localhost:6667");
+  DeferredEdgeServer myComputer(myComputerEndpoint);
+  EdgeServerGrpc     myComputerGrpc(myComputer, 1, false);
+  myComputerGrpc.run();
+
+  const size_t           N = 5;
+  rpc::LambdaRequest     myReq;
+  std::list<std::string> myRetCodes;
+  std::mutex             myMutex;
+  myReq.set_name("lambda0");
+  {
+    EdgeRouter myRouter(theEndpoint,
+                        "",
+                        "",
+                        false,
+                        support::Conf(EdgeLambdaProcessor::defaultConf() +
+                                      ",async=true"),
+                        support::Conf("type=random"),
+                        support::Conf("type=trivial,period=10,stat=mean"),
+                        support::Conf("type=grpc"));
+    myRouter.tables()[0]->change("lambda0", myComputerEndpoint, 1);
+
+    EdgeServer& myServer = myRouter;
+    for (size_t i = 0; i < N; i++) {
+      myServer.processAsync(myReq, [&](rpc::LambdaResponse&& aResp) {
+        const std::lock_guard<std::mutex> myLock(myMutex);
+        myRetCodes.emplace_back(aResp.retcode());
+      });
+    }
+    for (auto i = 0; i < 50 and myComputer.parked() < N; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(N, myComputer.parked());
+
+    // the router is destroyed with the forwards in progress
+  }
+
+  // all the responses are delivered, with an error and without retrying
+  ASSERT_EQ(N, myRetCodes.size());
+  for (const auto& myRetCode : myRetCodes) {
+    ASSERT_NE("OK", myRetCode);
+  }
+
+  myComputer.release();
+}
+
+// measure the requests/s served by a fake router with a growing number of
+// server threads, with the following environment variables:
+// THREADS: comma-separated list of the number of server threads
+// CONCURRENCY: number of client threads issuing requests back-to-back
+// DURATION: duration of each experiment, in s
+// CQPERTHREAD, AFFINITY: if set to 1 then enable the corresponding option
+// PRESPAWN: number of requests pre-spawned per server thread
+// OUTPUT: if set then save "threads requests/s" in this file
+TEST_F(TestEdgeServerGrpc, DISABLED_bench_fake_router_threads) {
+  const auto myThreads = support::split<std::list<size_t>>(
+      envOrDefault("THREADS", "1,2,4,8,16,32"), ",");
+  const auto myConcurrency    = std::stoull(envOrDefault("CONCURRENCY", "64"));
+  const auto myDuration       = std::stod(envOrDefault("DURATION", "5"));
+  const auto myQueuePerThread = envOrDefault("CQPERTHREAD", "0") != "0";
+  const auto myAffinity       = envOrDefault("AFFINITY", "0") != "0";
+  const auto myPreSpawn       = std::stoull(envOrDefault("PRESPAWN", "1"));
+  const auto myOutput         = envOrDefault("OUTPUT", "");
+
+  std::ofstream myOutFile;
+  if (not myOutput.empty()) {
+    myOutFile.open(myOutput);
+    ASSERT_TRUE(myOutFile) << "could not open file for writing: " << myOutput;
+  }
+
+  for (const auto myNumThreads : myThreads) {
+    EdgeRouter myRouter(theEndpoint,
+                        "",
+                        "",
+                        false,
+                        support::Conf(EdgeLambdaProcessor::defaultConf() +
+                                      ",fake=true"),
+                        support::Conf("type=random"),
+                        support::Conf("type=trivial,period=10,stat=mean"),
+                        support::Conf("type=grpc"));
+    fakeFill(*myRouter.tables()[0], 1, 1);
+
+    EdgeServerGrpc myServer(myRouter,
+                            myNumThreads,
+                            false,
+                            myQueuePerThread,
+                            myAffinity,
+                            myPreSpawn);
+    myServer.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::atomic<bool>      myStop(false);
+    std::atomic<size_t>    myServed(0);
+    std::atomic<size_t>    myFailed(0);
+    std::list<std::thread> myClients;
+    for (size_t i = 0; i < myConcurrency; i++) {
+      myClients.emplace_back([this, &myStop, &myServed, &myFailed]() {
+        EdgeClientGrpc myClient(theEndpoint, false);
+        LambdaRequest  myReq("lambda0", "Hello world!");
+        while (not myStop) {
+          try {
+            if (myClient.RunLambda(myReq, false).theRetCode == "OK") {
+              myServed++;
+            } else {
+              myFailed++;
+            }
+          } catch (...) {
+            myFailed++;
+          }
+        }
+      });
+    }
+
+    support::Chrono myChrono(true);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(static_cast<long>(myDuration * 1e3)));
+    myStop = true;
+    for (auto& myClient : myClients) {
+      myClient.join();
+    }
+    const auto myRate = myServed / myChrono.stop();
+
+    LOG(INFO) << "threads " << myNumThreads << ", served " << myServed
+              << ", failed " << myFailed << ", requests/s " << myRate;
+    if (myOutFile) {
+      myOutFile << myNumThreads << ' ' << myRate << std::endl;
+    }
+    ASSERT_EQ(0u, myFailed.load());
+  }
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -0,0 +1,132 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/fenwicktree.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestFenwickTree : public ::testing::Test {
+  // brute-force version of FenwickTree::find()
+  static size_t find(const std::vector<double>& aValues, const double aValue) {
+    double mySum = 0;
+    for (size_t i = 0; i < aValues.size(); i++) {
+      mySum += aValues[i];
+      if (mySum > aValue) {
+        return i;
+      }
+    }
+    return aValues.size() - 1;
+  }
+};
+
+TEST_F(TestFenwickTree, test_prefix_find) {
+  FenwickTree myTree;
+  ASSERT_EQ(0u, myTree.size());
+  ASSERT_EQ(0, myTree.total());
+
+  myTree.push_back(1);
+  myTree.push_back(2);
+  myTree.push_back(0);
+  myTree.push_back(3);
+  ASSERT_EQ(4u, myTree.size());
+  ASSERT_EQ(6, myTree.total());
+  ASSERT_EQ(3, myTree.prefix(2));
+  ASSERT_EQ(3, myTree.prefix(3));
+
+  ASSERT_EQ(0u, myTree.find(0));
+  ASSERT_EQ(0u, myTree.find(0.5));
+  ASSERT_EQ(1u, myTree.find(1));
+  ASSERT_EQ(1u, myTree.find(2.9));
+  ASSERT_EQ(3u, myTree.find(3)); // the element with 0 value is skipped
+  ASSERT_EQ(3u, myTree.find(5.9));
+  ASSERT_EQ(3u, myTree.find(6));
+  ASSERT_EQ(3u, myTree.find(99));
+
+  myTree.set(2, 4);
+  ASSERT_EQ(10, myTree.total());
+  ASSERT_EQ(2u, myTree.find(3));
+
+  myTree.pop_back();
+  ASSERT_EQ(3u, myTree.size());
+  ASSERT_EQ(7, myTree.total());
+
+  myTree.clear();
+  ASSERT_EQ(0u, myTree.size());
+  ASSERT_EQ(0, myTree.total());
+}
+
+TEST_F(TestFenwickTree, test_random_operations) {
+  ::srand(42);
+  FenwickTree         myTree;
+  std::vector<double> myValues;
+  for (size_t i = 0; i < 10000; i++) {
+    const auto myOp    = ::rand() % 5;
+    const auto myValue = static_cast<double>(::rand() % 100);
+    if (myOp == 0 or myValues.empty()) {
+      myTree.push_back(myValue);
+      myValues.emplace_back(myValue);
+    } else if (myOp == 1) {
+      myTree.pop_back();
+      myValues.pop_back();
+    } else if (myOp == 2) {
+      const auto myIndex = ::rand() % myValues.size();
+      myTree.erase(myIndex);
+      myValues.erase(myValues.begin() + myIndex);
+    } else {
+      const auto myIndex = ::rand() % myValues.size();
+      myTree.set(myIndex, myValue);
+      myValues[myIndex] = myValue;
+    }
+
+    ASSERT_EQ(myValues.size(), myTree.size());
+    if (myValues.empty()) {
+      continue;
+    }
+    const auto myTotal =
+        std::accumulate(myValues.begin(), myValues.end(), 0.0);
+    ASSERT_EQ(myTotal, myTree.total());
+    const auto myTarget = (::rand() % 1000) * myTotal / 1000.0;
+    ASSERT_EQ(find(myValues, myTarget), myTree.find(myTarget))
+        << "target " << myTarget << ", total " << myTotal;
+  }
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
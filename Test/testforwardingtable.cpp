@@ -29,19 +29,34 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Entries/entryleastimpedance.h"
+#include "Edge/Entries/entryproportionalfairness.h"
+#include "Edge/Entries/entryrandom.h"
+#include "Edge/Entries/entryroundrobin.h"
 #include "Edge/forwardingtable.h"
 #include "Edge/forwardingtableexceptions.h"
 #include "Edge/forwardingtablefactory.h"
 #include "Edge/lambda.h"
 #include "Support/chrono.h"
 #include "Support/conf.h"
+#include "Support/split.h"
 #include "Support/tostring.h"
 #include "Support/wait.h"
+#include "Test/testenv.h"
 
 #include "gtest/gtest.h"
 #include <cmath>
 #include <glog/logging.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace uiiit {
 namespace edge {
 
@@ -198,8 +213,13 @@ TEST_F(TestForwardingTable, test_invalid_operations) {
 
   ASSERT_THROW(myTable.change("lambda1", "", 1), NoDestinations);
   ASSERT_THROW(myTable.change("lambda1", "", 1, true), InvalidDestination);
-  ASSERT_THROW(myTable.change("lambda1", "valid", 0), InvalidDestination);
+
+  // a failed change does not leave an empty entry behind
+  ASSERT_TRUE(myTable.lambdas().empty());
+  ASSERT_THROW(myTable.change("lambda1", "valid", 0), NoDestinations);
+
   ASSERT_NO_THROW(myTable.change("lambda1", "valid", 99, true));
+  ASSERT_THROW(myTable.change("lambda1", "valid", 0), InvalidDestination);
   ASSERT_NO_THROW(myTable.change("lambda1", "valid", 49));
   ASSERT_THROW(myTable.change("lambda1", "valid", -99), InvalidWeight);
   ASSERT_NO_THROW(myTable.multiply("lambda1", "valid", 99));
@@ -337,6 +357,39 @@ TEST_F(TestForwardingTable, test_access_round_robin) {
       myDestinations);
 }
 
+TEST_F(TestForwardingTable, test_round_robin_weights) {
+  ForwardingTable myTable(ForwardingTable::Type::RoundRobin);
+
+  // all destinations in the active set: selected inversely to their weight
+  for (size_t i = 0; i < 100; i++) {
+    myTable.change("lambda1", "dest" + std::to_string(i), 1 + (i % 2), true);
+  }
+
+  std::map<std::string, size_t> myCounts;
+  for (size_t i = 0; i < 1500; i++) {
+    myCounts[myTable("lambda1")]++;
+  }
+  ASSERT_EQ(100u, myCounts.size());
+  for (const auto& myPair : myCounts) {
+    const auto myIndex = std::stoul(myPair.first.substr(4));
+    ASSERT_EQ(myIndex % 2 == 0 ? 20u : 10u, myPair.second) << myPair.first;
+  }
+
+  // make half of the destinations leave the active set
+  for (size_t i = 0; i < 100; i += 2) {
+    myTable.change("lambda1", "dest" + std::to_string(i), 10);
+  }
+  myCounts.clear();
+  for (size_t i = 0; i < 500; i++) {
+    myCounts[myTable("lambda1")]++;
+  }
+  ASSERT_EQ(50u, myCounts.size());
+  for (const auto& myPair : myCounts) {
+    ASSERT_EQ(1u, std::stoul(myPair.first.substr(4)) % 2) << myPair.first;
+    ASSERT_EQ(10u, myPair.second) << myPair.first;
+  }
+}
+
 TEST_F(TestForwardingTable, DISABLED_test_access_round_robin_stale) {
   ForwardingTable myTable(ForwardingTable::Type::RoundRobin);
 
@@ -365,5 +418,194 @@ TEST_F(TestForwardingTable, DISABLED_test_access_round_robin_stale) {
   ASSERT_EQ("dest1", myTable("lambda1"));
 }
 
+TEST_F(TestForwardingTable, test_concurrent_access) {
+  for (const auto myType : {ForwardingTable::Type::Random,
+                            ForwardingTable::Type::LeastImpedance,
+                            ForwardingTable::Type::RoundRobin,
+                            ForwardingTable::Type::ProportionalFairness}) {
+    ForwardingTable myTable(myType);
+    myTable.change("lambda1", "dest1", 1, true);
+    myTable.change("lambda1", "dest2", 1, true);
+
+    std::atomic<bool>      myStop(false);
+    std::atomic<size_t>    myInvalid(0);
+    std::atomic<size_t>    myLookups(0);
+    std::list<std::thread> myThreads;
+    for (size_t i = 0; i < 4; i++) {
+      myThreads.emplace_back([&]() {
+        while (not myStop) {
+          const auto myDest = myTable("lambda1");
+          if (myDest != "dest1" and myDest != "dest2" and myDest != "dest3") {
+            myInvalid++;
+          }
+          myLookups++;
+        }
+      });
+    }
+
+    // modify the table while the lookups are in progress
+    while (myLookups < myThreads.size()) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < 200; i++) {
+      myTable.change("lambda1", "dest1", 1.0f + (i % 10), true);
+      myTable.multiply("lambda1", "dest2", i % 2 == 0 ? 2.0f : 0.5f);
+      myTable.change("lambda1", "dest3", 1, false);
+      myTable.remove("lambda1", "dest3");
+      myTable.change("lambda2", "dest1", 1, true);
+      myTable.remove("lambda2");
+    }
+    myStop = true;
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+
+    ASSERT_EQ(0u, myInvalid.load()) << toString(myType);
+    ASSERT_GT(myLookups.load(), 0u) << toString(myType);
+    ASSERT_EQ(std::set<std::string>({"lambda1"}), myTable.lambdas());
+    ASSERT_EQ(2u, myTable.destinations("lambda1").size());
+  }
+}
+
+// compare the number of lookups/s of ForwardingTable vs. a table protected
+// by a single mutex, with the following environment variables:
+// THREADS: comma-separated list of the number of threads doing lookups
+// DURATION: duration of each experiment, in s
+// TYPE: forwarding table type
+// NUMDESTS: number of destinations of the only lambda
+TEST_F(TestForwardingTable, DISABLED_test_lookup_performance) {
+  const auto myThreads = support::split<std::list<size_t>>(
+      envOrDefault("THREADS", "1,2,4,8,16"), ",");
+  const auto myDuration = std::stod(envOrDefault("DURATION", "2"));
+  const auto myType =
+      forwardingTableTypeFromString(envOrDefault("TYPE", "random"));
+  const auto myNumDests = std::stoull(envOrDefault("NUMDESTS", "10"));
+
+  // mimic the previous implementation: all lookups serialize on a mutex
+  struct LockedTable {
+    explicit LockedTable(const ForwardingTable::Type aType)
+        : theMutex()
+        , theTable() {
+      std::unique_ptr<entries::Entry> myEntry;
+      if (aType == ForwardingTable::Type::Random) {
+        myEntry.reset(new entries::EntryRandom());
+      } else if (aType == ForwardingTable::Type::LeastImpedance) {
+        myEntry.reset(new entries::EntryLeastImpedance());
+      } else if (aType == ForwardingTable::Type::RoundRobin) {
+        myEntry.reset(new entries::EntryRoundRobin());
+      } else {
+        myEntry.reset(new entries::EntryProportionalFairness(1, 1));
+      }
+      theTable.emplace("lambda1", std::move(myEntry));
+    }
+
+    std::string operator()(const std::string& aLambda) {
+      const std::lock_guard<std::mutex> myLock(theMutex);
+      const auto                        it = theTable.find(aLambda);
+      if (it != theTable.end()) {
+        return (*it->second)();
+      }
+      throw NoDestinations();
+    }
+
+    std::mutex                                             theMutex;
+    std::map<std::string, std::unique_ptr<entries::Entry>> theTable;
+  };
+
+  ForwardingTable myTable(myType);
+  LockedTable     myLockedTable(myType);
+  for (size_t i = 0; i < myNumDests; i++) {
+    const auto myDest   = "dest" + std::to_string(i);
+    const auto myWeight = 1.0f + i;
+    myTable.change("lambda1", myDest, myWeight, true);
+    myLockedTable.theTable["lambda1"]->change(myDest, myWeight, true);
+  }
+
+  const auto myRun = [myDuration](const size_t                 aNumThreads,
+                                  std::function<std::string()> aLookup) {
+    std::atomic<bool>      myStop(false);
+    std::atomic<size_t>    myLookups(0);
+    std::list<std::thread> myThreads;
+    for (size_t i = 0; i < aNumThreads; i++) {
+      myThreads.emplace_back([&]() {
+        size_t myLocal = 0;
+        while (not myStop) {
+          aLookup();
+          myLocal++;
+        }
+        myLookups += myLocal;
+      });
+    }
+    support::Chrono myChrono(true);
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(static_cast<long>(myDuration * 1e3)));
+    myStop = true;
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+    return myLookups / myChrono.stop();
+  };
+
+  for (const auto myNumThreads : myThreads) {
+    const auto myLockFreeRate =
+        myRun(myNumThreads, [&myTable]() { return myTable("lambda1"); });
+    const auto myLockedRate = myRun(
+        myNumThreads, [&myLockedTable]() { return myLockedTable("lambda1"); });
+    LOG(INFO) << "type " << toString(myType) << ", threads " << myNumThreads
+              << ", lookups/s snapshot " << myLockFreeRate << ", mutex "
+              << myLockedRate;
+  }
+}
+
+TEST_F(TestForwardingTable, DISABLED_test_selection_performance) {
+  const auto myNumDests = support::split<std::list<size_t>>(
+      envOrDefault("NUMDESTS", "2,10,100,1000,10000"), ",");
+  const auto myDuration = std::stod(envOrDefault("DURATION", "1"));
+  const auto myTypes    = support::split<std::list<std::string>>(
+      envOrDefault("TYPES", "random,proportional-fairness"), ",");
+
+  const auto myRun = [myDuration](std::function<void()> aFunction) {
+    size_t          myCount = 0;
+    support::Chrono myChrono(true);
+    while (myChrono.time() < myDuration) {
+      for (size_t i = 0; i < 100; i++) {
+        aFunction();
+      }
+      myCount += 100;
+    }
+    return myCount / myChrono.stop();
+  };
+
+  for (const auto& myTypeStr : myTypes) {
+    const auto myType = forwardingTableTypeFromString(myTypeStr);
+    for (const auto myN : myNumDests) {
+      std::unique_ptr<entries::Entry> myEntry;
+      if (myType == ForwardingTable::Type::Random) {
+        myEntry.reset(new entries::EntryRandom());
+      } else if (myType == ForwardingTable::Type::ProportionalFairness) {
+        myEntry.reset(new entries::EntryProportionalFairness(1, 1));
+      } else {
+        FAIL() << "unsupported type: " << myTypeStr;
+      }
+
+      std::vector<std::string> myDests;
+      for (size_t i = 0; i < myN; i++) {
+        myDests.emplace_back("dest" + std::to_string(i));
+        myEntry->change(myDests.back(), 1.0f + i % 10, true);
+      }
+
+      size_t     myNext       = 0;
+      const auto mySelectRate = myRun([&myEntry]() { (*myEntry)(); });
+      const auto myUpdateRate = myRun([&]() {
+        myNext = (myNext + 7919) % myN;
+        myEntry->change(myDests[myNext], 1.0f + myNext % 13, false);
+      });
+      LOG(INFO) << "type " << myTypeStr << ", destinations " << myN
+                << ", selections/s " << mySelectRate << ", updates/s "
+                << myUpdateRate;
+    }
+  }
+}
+
 } // namespace edge
 } // namespace uiiit
@@ -0,0 +1,189 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/hdrhistogram.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestHdrHistogram : public ::testing::Test {};
+
+TEST_F(TestHdrHistogram, test_invalid_precision) {
+  ASSERT_THROW(HdrHistogram(0), std::runtime_error);
+  ASSERT_THROW(HdrHistogram(17), std::runtime_error);
+  ASSERT_NO_THROW(HdrHistogram(1));
+  ASSERT_NO_THROW(HdrHistogram(16));
+
+  HdrHistogram myFirst(7);
+  HdrHistogram mySecond(8);
+  ASSERT_THROW(myFirst.add(mySecond), std::runtime_error);
+  ASSERT_THROW(myFirst.subtract(mySecond), std::runtime_error);
+  ASSERT_THROW(myFirst = mySecond, std::runtime_error);
+}
+
+TEST_F(TestHdrHistogram, test_exact_values) {
+  HdrHistogram myHistogram(7);
+  ASSERT_EQ(0u, myHistogram.count());
+  ASSERT_EQ(0u, myHistogram.percentile(50));
+  ASSERT_EQ(0u, myHistogram.min());
+  ASSERT_EQ(0u, myHistogram.max());
+  ASSERT_EQ(0, myHistogram.mean());
+
+  // values below 2^7 are exact
+  for (uint64_t i = 1; i <= 100; i++) {
+    myHistogram.record(i);
+  }
+  ASSERT_EQ(100u, myHistogram.count());
+  ASSERT_DOUBLE_EQ(50.5, myHistogram.mean());
+  ASSERT_EQ(1u, myHistogram.min());
+  ASSERT_EQ(100u, myHistogram.max());
+  ASSERT_EQ(1u, myHistogram.percentile(0));
+  ASSERT_EQ(50u, myHistogram.percentile(50));
+  ASSERT_EQ(99u, myHistogram.percentile(99));
+  ASSERT_EQ(100u, myHistogram.percentile(99.9));
+  ASSERT_EQ(100u, myHistogram.percentile(100));
+
+  myHistogram.record(0, 10);
+  ASSERT_EQ(110u, myHistogram.count());
+  ASSERT_EQ(0u, myHistogram.min());
+  ASSERT_EQ(0u, myHistogram.percentile(5));
+
+  myHistogram.clear();
+  ASSERT_EQ(0u, myHistogram.count());
+  ASSERT_EQ(0u, myHistogram.max());
+}
+
+TEST_F(TestHdrHistogram, test_relative_error) {
+  std::mt19937                        myRng(42);
+  std::lognormal_distribution<double> myDist(8, 3);
+  std::vector<uint64_t>               myValues;
+  for (const auto myPrecision : {3u, 7u, 10u}) {
+    HdrHistogram myHistogram(myPrecision);
+    myValues.clear();
+    for (size_t i = 0; i < 100000; i++) {
+      myValues.emplace_back(static_cast<uint64_t>(myDist(myRng)));
+      myHistogram.record(myValues.back());
+    }
+    myValues.emplace_back(std::numeric_limits<uint64_t>::max());
+    myHistogram.record(myValues.back());
+    std::sort(myValues.begin(), myValues.end());
+
+    const auto myError = 1.0 / (1u << (myPrecision - 1));
+    for (const auto myPercentile : {1.0, 50.0, 90.0, 99.0, 99.9, 99.99}) {
+      const auto myRank = static_cast<size_t>(
+          std::ceil(myPercentile / 100.0 * myValues.size()));
+      const auto myExpected = myValues[myRank - 1];
+      const auto myActual   = myHistogram.percentile(myPercentile);
+      ASSERT_GE(myActual, myExpected) << myPrecision << ' ' << myPercentile;
+      ASSERT_LE(myActual - myExpected, myError * myExpected)
+          << myPrecision << ' ' << myPercentile;
+    }
+    ASSERT_EQ(myValues.front(), myHistogram.min());
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), myHistogram.max());
+  }
+}
+
+TEST_F(TestHdrHistogram, test_merge_and_intervals) {
+  HdrHistogram myFirst;
+  HdrHistogram mySecond;
+  for (uint64_t i = 0; i < 1000; i++) {
+    myFirst.record(i);
+    mySecond.record(1000 + i);
+  }
+
+  HdrHistogram myTotal;
+  myTotal.add(myFirst);
+  myTotal.add(mySecond);
+  ASSERT_EQ(2000u, myTotal.count());
+  ASSERT_DOUBLE_EQ(999.5, myTotal.mean());
+  ASSERT_EQ(0u, myTotal.min());
+  ASSERT_GE(myTotal.max(), 1999u);
+
+  // the interval since the snapshot only contains the second histogram
+  const HdrHistogram mySnapshot(myFirst);
+  myFirst.add(mySecond);
+  auto myInterval = myFirst;
+  myInterval.subtract(mySnapshot);
+  ASSERT_EQ(1000u, myInterval.count());
+  ASSERT_DOUBLE_EQ(1499.5, myInterval.mean());
+  ASSERT_GE(myInterval.min(), 990u);
+  ASSERT_EQ(mySecond.percentile(50), myInterval.percentile(50));
+  ASSERT_FALSE(myInterval.summary().empty());
+}
+
+TEST_F(TestHdrHistogram, test_concurrent_snapshots) {
+  const size_t              myNumThreads = 4;
+  const uint64_t            myNumValues  = 200000;
+  std::vector<HdrHistogram> myHistograms(myNumThreads);
+  std::vector<std::thread>  myThreads;
+  for (size_t i = 0; i < myNumThreads; i++) {
+    myThreads.emplace_back([&myHistograms, myNumValues, i]() {
+      for (uint64_t j = 0; j < myNumValues; j++) {
+        myHistograms[i].record(j % 5000);
+      }
+    });
+  }
+
+  // snapshots taken while recording never decrease
+  uint64_t myLast = 0;
+  for (size_t k = 0; k < 100; k++) {
+    HdrHistogram myTotal;
+    for (const auto& myHistogram : myHistograms) {
+      myTotal.add(myHistogram);
+    }
+    ASSERT_GE(myTotal.count(), myLast);
+    myLast = myTotal.count();
+  }
+
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+  HdrHistogram myTotal;
+  for (const auto& myHistogram : myHistograms) {
+    myTotal.add(myHistogram);
+  }
+  ASSERT_EQ(myNumThreads * myNumValues, myTotal.count());
+  ASSERT_LE(4999u, myTotal.max());
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,147 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/indexedheap.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <map>
+#include <string>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestIndexedHeap : public ::testing::Test {};
+
+TEST_F(TestIndexedHeap, test_operations) {
+  IndexedHeap<double> myHeap;
+  ASSERT_TRUE(myHeap.empty());
+  ASSERT_FALSE(myHeap.contains(0));
+
+  myHeap.push(3, 1.0);
+  myHeap.push(1, 2.0);
+  myHeap.push(0, 2.0);
+  myHeap.push(7, 0.5);
+  ASSERT_EQ(4u, myHeap.size());
+  ASSERT_TRUE(myHeap.contains(1));
+  ASSERT_FALSE(myHeap.contains(2));
+  ASSERT_FALSE(myHeap.contains(99));
+
+  ASSERT_EQ(7u, myHeap.top());
+  myHeap.update(7, 3.0);
+  ASSERT_EQ(3u, myHeap.top());
+  myHeap.erase(3);
+  ASSERT_FALSE(myHeap.contains(3));
+
+  // ties are broken by identifier
+  ASSERT_EQ(0u, myHeap.top());
+  myHeap.erase(0);
+  ASSERT_EQ(1u, myHeap.top());
+  ASSERT_EQ(2.0, myHeap.key(1));
+
+  myHeap.set(1, 4.0);
+  myHeap.set(2, 3.5);
+  ASSERT_EQ(7u, myHeap.top());
+  ASSERT_EQ(3u, myHeap.size());
+
+  myHeap.clear();
+  ASSERT_TRUE(myHeap.empty());
+  ASSERT_FALSE(myHeap.contains(7));
+  myHeap.push(7, 1.0);
+  ASSERT_EQ(7u, myHeap.top());
+}
+
+TEST_F(TestIndexedHeap, test_shift) {
+  IndexedHeap<double> myHeap;
+  myHeap.push(0, 2.0);
+  myHeap.push(1, 1.0);
+  myHeap.push(3, 1.0);
+  myHeap.push(4, 0.5);
+
+  // identifier not present: only the larger ones are renumbered
+  myHeap.shift(2);
+  ASSERT_EQ(4u, myHeap.size());
+  ASSERT_EQ(3u, myHeap.top());
+  ASSERT_EQ(0.5, myHeap.key(3));
+  ASSERT_FALSE(myHeap.contains(4));
+
+  myHeap.shift(3);
+  ASSERT_EQ(3u, myHeap.size());
+  ASSERT_FALSE(myHeap.contains(3));
+
+  // ties are still broken by identifier
+  ASSERT_EQ(1u, myHeap.top());
+  myHeap.shift(1);
+  ASSERT_EQ(1u, myHeap.top());
+  ASSERT_EQ(1.0, myHeap.key(1));
+  myHeap.erase(1);
+  ASSERT_EQ(0u, myHeap.top());
+  ASSERT_EQ(2.0, myHeap.key(0));
+
+  myHeap.shift(99);
+  ASSERT_EQ(1u, myHeap.size());
+}
+
+TEST_F(TestIndexedHeap, test_random_operations) {
+  ::srand(42);
+  IndexedHeap<int>      myHeap;
+  std::map<size_t, int> myElems;
+  for (size_t i = 0; i < 10000; i++) {
+    const size_t myId  = ::rand() % 100;
+    const auto   myKey = ::rand() % 50;
+    if (::rand() % 3 == 0) {
+      myHeap.erase(myId);
+      myElems.erase(myId);
+    } else {
+      myHeap.set(myId, myKey);
+      myElems[myId] = myKey;
+    }
+
+    ASSERT_EQ(myElems.size(), myHeap.size());
+    if (myElems.empty()) {
+      continue;
+    }
+    auto myMin = myElems.begin();
+    for (auto it = myElems.begin(); it != myElems.end(); ++it) {
+      if (it->second < myMin->second) {
+        myMin = it;
+      }
+    }
+    ASSERT_EQ(myMin->first, myHeap.top());
+    ASSERT_EQ(myMin->second, myHeap.key(myHeap.top()));
+  }
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,214 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Simulation/openloopclient.h"
+#include "Support/saver.h"
+#include "Test/fakeedgeclient.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace simulation {
+
+struct TestOpenLoopClient : public ::testing::Test {
+  using Clock = FakeEdgeClient::Clock;
+
+  //! Edge client that only supports blocking calls.
+  class BlockingEdgeClient final : public edge::EdgeClientInterface
+  {
+   public:
+    explicit BlockingEdgeClient(const Clock::duration aDelay)
+        : edge::EdgeClientInterface()
+        , theDelay(aDelay) {
+      // noop
+    }
+
+    edge::LambdaResponse
+    RunLambda(const edge::LambdaRequest&  aReq,
+              [[maybe_unused]] const bool aDry) override {
+      std::this_thread::sleep_for(theDelay);
+      return edge::LambdaResponse("OK", *aReq.theInput);
+    }
+
+   private:
+    const Clock::duration theDelay;
+  };
+
+  TestOpenLoopClient()
+      : theSaver("", false, false, false) {
+  }
+
+  std::unique_ptr<OpenLoopClient>
+  makeClient(const double                   aInterRequestTime,
+             const UnifClient::Distribution aDistribution,
+             const size_t                   aMaxPending,
+             const size_t                   aNumRequests,
+             edge::EdgeClientInterface*     aClient) {
+    return std::make_unique<OpenLoopClient>(
+        std::vector<size_t>({100}),
+        aInterRequestTime,
+        aDistribution,
+        aMaxPending,
+        0,
+        0,
+        aNumRequests,
+        std::unique_ptr<edge::EdgeClientInterface>(aClient),
+        "clambda",
+        theSaver,
+        false);
+  }
+
+  //! \return the time between two time points, in ms.
+  static double ms(const Clock::time_point& aFrom,
+                   const Clock::time_point& aTo) {
+    return std::chrono::duration<double, std::milli>(aTo - aFrom).count();
+  }
+
+  const support::Saver theSaver;
+};
+
+TEST_F(TestOpenLoopClient, test_invalid_args) {
+  ASSERT_THROW(makeClient(0,
+                          UnifClient::Distribution::CONSTANT,
+                          1,
+                          1,
+                          new FakeEdgeClient(Clock::duration(0), {}, {})),
+               std::runtime_error);
+  ASSERT_THROW(makeClient(0.001,
+                          UnifClient::Distribution::CONSTANT,
+                          0,
+                          1,
+                          new FakeEdgeClient(Clock::duration(0), {}, {})),
+               std::runtime_error);
+}
+
+TEST_F(TestOpenLoopClient, test_schedule_constant) {
+  auto myFake   = new FakeEdgeClient(std::chrono::milliseconds(1), {}, {});
+  auto myClient = makeClient(
+      0.002, UnifClient::Distribution::CONSTANT, 100, 50, myFake);
+  ASSERT_EQ(500, myClient->simulate(1));
+  const auto myStart = Clock::now();
+  (*myClient)();
+
+  ASSERT_EQ(0, myClient->dropped());
+  ASSERT_EQ(50, myClient->latencyStat().count());
+
+  // the i-th request is never sent before its arrival time, i.e., 2 ms after
+  // the previous one, and the client does not fall behind schedule
+  const auto myTimes = myFake->times();
+  ASSERT_EQ(50, myTimes.size());
+  for (size_t i = 0; i < myTimes.size(); i++) {
+    ASSERT_GE(ms(myStart, myTimes[i]), 2.0 * (i + 1)) << i;
+  }
+  ASSERT_LT(ms(myStart, myTimes.back()), 150);
+}
+
+TEST_F(TestOpenLoopClient, test_schedule_exponential) {
+  auto myFake   = new FakeEdgeClient(std::chrono::milliseconds(1), {}, {});
+  auto myClient = makeClient(
+      0.001, UnifClient::Distribution::EXPONENTIAL, 1000, 1000, myFake);
+  const auto myStart = Clock::now();
+  (*myClient)();
+
+  ASSERT_EQ(0, myClient->dropped());
+  ASSERT_EQ(1000, myClient->latencyStat().count());
+
+  const auto myTimes = myFake->times();
+  ASSERT_EQ(1000, myTimes.size());
+  const auto myAvgInterArrival = ms(myStart, myTimes.back()) / myTimes.size();
+  LOG(INFO) << "average inter-arrival time " << myAvgInterArrival << " ms";
+  ASSERT_GT(myAvgInterArrival, 0.85);
+  ASSERT_LT(myAvgInterArrival, 1.3);
+}
+
+TEST_F(TestOpenLoopClient, test_latency_from_intended_time) {
+  // every call blocks for 5 ms while the requests arrive every 1 ms: the
+  // client falls behind schedule and the delay accumulated is accounted for
+  // in the latency, which grows well beyond the service time
+  auto myClient =
+      makeClient(0.001,
+                 UnifClient::Distribution::CONSTANT,
+                 100,
+                 20,
+                 new BlockingEdgeClient(std::chrono::milliseconds(5)));
+  (*myClient)();
+
+  ASSERT_EQ(0, myClient->dropped());
+  ASSERT_EQ(20, myClient->latencyStat().count());
+  // latencies in us, with 1/64 relative error
+  ASSERT_GE(myClient->latencyHistogram().min(), 4900u);
+  ASSERT_GT(myClient->latencyHistogram().max(), 50000u);
+}
+
+TEST_F(TestOpenLoopClient, test_max_pending) {
+  // responses take 100 ms while 20 requests arrive within 20 ms: only the
+  // first 5 are sent, the others are dropped
+  auto myFake   = new FakeEdgeClient(std::chrono::milliseconds(100), {}, {});
+  auto myClient = makeClient(
+      0.001, UnifClient::Distribution::CONSTANT, 5, 20, myFake);
+  (*myClient)();
+
+  ASSERT_EQ(15, myClient->dropped());
+  ASSERT_EQ(5, myFake->called().size());
+  ASSERT_EQ(5, myFake->maxInFlight());
+  ASSERT_EQ(5, myClient->latencyStat().count());
+  ASSERT_GE(myClient->latencyHistogram().min(), 98000u);
+}
+
+TEST_F(TestOpenLoopClient, test_pending_released) {
+  // responses take 20 ms while requests arrive every 1 ms for 300 ms: new
+  // requests are sent after the responses are received, up to 5 at a time
+  auto myFake   = new FakeEdgeClient(std::chrono::milliseconds(20), {}, {});
+  auto myClient = makeClient(
+      0.001, UnifClient::Distribution::CONSTANT, 5, 300, myFake);
+  (*myClient)();
+
+  const auto mySent = myFake->called().size();
+  LOG(INFO) << mySent << " requests sent, " << myClient->dropped()
+            << " dropped";
+  ASSERT_EQ(300, mySent + myClient->dropped());
+  ASSERT_GT(mySent, 20);
+  ASSERT_GT(myClient->dropped(), 0);
+  ASSERT_LE(myFake->maxInFlight(), 5);
+  ASSERT_EQ(mySent, myClient->latencyStat().count());
+}
+
+} // namespace simulation
+} // namespace uiiit
@@ -29,13 +29,34 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/computer.h"
+#include "Edge/destinationtable.h"
+#include "Edge/edgecomputersim.h"
 #include "Edge/edgemessages.h"
+#include "Edge/edgeservergrpc.h"
+#include "Edge/edgeserverimpl.h"
+#include "Edge/forwardingtableexceptions.h"
+#include "Edge/lambda.h"
+#include "Edge/processortype.h"
 #include "Edge/ptimeestimator.h"
+#include "Edge/ptimeestimatorprobe.h"
+#include "Edge/ptimeestimatorrtt.h"
+#include "Edge/ptimeestimatorutil.h"
+#include "Support/chrono.h"
+#include "Support/split.h"
 #include "Support/tostring.h"
+#include "Support/wait.h"
+#include "Test/testenv.h"
 
 #include "gtest/gtest.h"
 
+#include <glog/logging.h>
+
+#include <cstdlib>
 #include <list>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace uiiit {
 namespace edge {
@@ -45,16 +66,20 @@ struct TrivialPtimeEstimator final : PtimeEstimator {
       : PtimeEstimator(Type::Test) {
   }
 
-  std::string operator()(const rpc::LambdaRequest& aReq) override {
+  std::string operator()(const rpc::LambdaRequest& aReq,
+                         Token&                    aToken) override {
     std::ignore = aReq;
+    aToken      = token(Estimates{1.0f, 2.0f});
     return "";
   }
 
   void processSuccess(const rpc::LambdaRequest& aReq,
+                      const Token               aToken,
                       const std::string&        aDestination,
                       const LambdaResponse&     aRep,
                       const double              aTime) override {
     std::ignore = aReq;
+    theLastEstimates.emplace_back(estimates(aToken));
     std::ignore = aDestination;
     std::ignore = aRep;
     std::ignore = aTime;
@@ -88,10 +113,47 @@ struct TrivialPtimeEstimator final : PtimeEstimator {
     theCommands.emplace_back(Command{Command::REMOVED, aLambda, aDestination});
   }
 
-  std::list<Command> theCommands;
+  std::list<Command>   theCommands;
+  std::list<Estimates> theLastEstimates;
 };
 
-struct TestPtimeEstimator : public ::testing::Test {};
+struct TestPtimeEstimator : public ::testing::Test {
+  TestPtimeEstimator()
+      : theFastEndpoint("localhost:10000")
+      , theSlowEndpoint("localhost:10001")
+      , theDeadEndpoint("localhost:10002") {
+    // noop
+  }
+
+  static std::unique_ptr<EdgeComputer>
+  makeComputer(const std::string& aEndpoint, const double aCpuSpeed) {
+    auto ret = std::make_unique<EdgeComputerSim>(
+        aEndpoint, false, Computer::UtilCallback());
+    ret->computer().addProcessor(
+        "cpu", ProcessorType::GenericCpu, aCpuSpeed, 1, 1);
+    ret->computer().addContainer(
+        "container",
+        "cpu",
+        Lambda("lambda0", ProportionalRequirements(1e6, 1e6, 0, 0)),
+        1);
+    return ret;
+  }
+
+  //! \return the destination selected by the estimator for a new request.
+  static std::string select(PtimeEstimator&    aEstimator,
+                            const std::string& aLambda = "lambda0") {
+    const auto myReq = LambdaRequest(aLambda, "hello").toProtobuf();
+    PtimeEstimator::Token myToken = 0;
+    const auto            ret     = aEstimator(myReq, myToken);
+    aEstimator.processSuccess(
+        myReq, myToken, ret, LambdaResponse("OK", ""), 0.001);
+    return ret;
+  }
+
+  const std::string theFastEndpoint;
+  const std::string theSlowEndpoint;
+  const std::string theDeadEndpoint;
+};
 
 TEST_F(TestPtimeEstimator, test_ctor) {
   ASSERT_NO_THROW(TrivialPtimeEstimator());
@@ -189,5 +251,300 @@ TEST_F(TestPtimeEstimator, test_print) {
       ::toString(myEst));
 }
 
+TEST_F(TestPtimeEstimator, test_destination_table) {
+  DestinationTable<float> myTable(
+      [](const std::string&, const std::string& aDestination) {
+        return std::make_unique<float>(std::stof(aDestination.substr(4)));
+      });
+  const auto myValue = [](float& aValue) { return aValue; };
+  const auto myNames = [&myTable](const std::string& aLambda) {
+    std::vector<std::string> ret;
+    for (const auto myId : myTable.destinations(aLambda)) {
+      ret.emplace_back(myTable.name(myId));
+    }
+    return ret;
+  };
+
+  ASSERT_THROW(myTable.best("lambda0", myValue), NoDestinations);
+  ASSERT_TRUE(myTable.add("lambda0", "dest1"));
+  ASSERT_TRUE(myTable.add("lambda0", "dest3"));
+  ASSERT_TRUE(myTable.add("lambda0", "dest2"));
+  ASSERT_FALSE(myTable.add("lambda0", "dest3"));
+  ASSERT_TRUE(myTable.add("lambda1", "dest2"));
+
+  // the destinations are kept sorted by name, whatever the order in which
+  // they are added
+  std::vector<float> myValues;
+  myTable.values("lambda0", myValue, myValues);
+  ASSERT_EQ(std::vector<float>({1, 2, 3}), myValues);
+  ASSERT_EQ(std::vector<std::string>({"dest1", "dest2", "dest3"}),
+            myNames("lambda0"));
+  ASSERT_EQ(std::make_pair(std::string("dest3"), 3.0f),
+            myTable.best("lambda0", myValue));
+  ASSERT_FLOAT_EQ(2.0f, myTable.all("lambda0", myValue).at("dest2"));
+
+  // destinations have the same identifier for all lambdas
+  ASSERT_EQ(myTable.destinations("lambda0")[1],
+            myTable.destinations("lambda1")[0]);
+  ASSERT_FLOAT_EQ(2.0f, myTable.find("lambda1", "dest2"));
+  ASSERT_THROW(myTable.find("lambda1", "dest1"), InvalidDestination);
+  ASSERT_THROW(myTable.find("lambda1", "dest0"), InvalidDestination);
+  ASSERT_THROW(myTable.find("lambda1", "dest9"), InvalidDestination);
+  ASSERT_THROW(myTable.find("lambda9", "dest1"), InvalidDestination);
+  ASSERT_TRUE(myTable.contains("lambda1", "dest2"));
+  ASSERT_FALSE(myTable.contains("lambda1", "dest1"));
+  ASSERT_FALSE(myTable.contains("lambda1", "dest9"));
+  ASSERT_FALSE(myTable.contains("lambda9", "dest1"));
+
+  // removal preserves the order of the remaining destinations
+  const auto myId = myTable.destinations("lambda0")[2];
+  ASSERT_TRUE(myTable.remove("lambda0", "dest3"));
+  ASSERT_FALSE(myTable.remove("lambda0", "dest3"));
+  ASSERT_FALSE(myTable.remove("lambda9", "dest3"));
+  ASSERT_FALSE(myTable.contains("lambda0", "dest3"));
+  myTable.values("lambda0", myValue, myValues);
+  ASSERT_EQ(std::vector<float>({1, 2}), myValues);
+  ASSERT_EQ(std::make_pair(std::string("dest2"), 2.0f),
+            myTable.best("lambda0", myValue));
+
+  // identifiers are not reused
+  ASSERT_TRUE(myTable.add("lambda0", "dest3"));
+  ASSERT_TRUE(myTable.add("lambda0", "dest0"));
+  ASSERT_EQ(myId, myTable.destinations("lambda0")[3]);
+  ASSERT_EQ(std::vector<std::string>({"dest0", "dest1", "dest2", "dest3"}),
+            myNames("lambda0"));
+
+  ASSERT_TRUE(myTable.remove("lambda1", "dest2"));
+  ASSERT_THROW(myTable.best("lambda1", myValue), NoDestinations);
+  ASSERT_THROW(myTable.values("lambda1", myValue, myValues), NoDestinations);
+}
+
+TEST_F(TestPtimeEstimator, test_destination_table_ties) {
+  // all the destinations have the same value
+  DestinationTable<float> myTable(
+      [](const std::string&, const std::string&) {
+        return std::make_unique<float>(42.0f);
+      });
+  const auto myValue = [](float& aValue) { return aValue; };
+
+  // ties are broken in favor of the destination whose name comes first
+  for (const auto& myDest : {"c", "a", "d", "b"}) {
+    ASSERT_TRUE(myTable.add("lambda0", myDest));
+  }
+  ASSERT_EQ(std::make_pair(std::string("a"), 42.0f),
+            myTable.best("lambda0", myValue));
+  ASSERT_TRUE(myTable.remove("lambda0", "a"));
+  ASSERT_EQ("b", myTable.best("lambda0", myValue).first);
+  ASSERT_TRUE(myTable.add("lambda0", "a"));
+  ASSERT_EQ("a", myTable.best("lambda0", myValue).first);
+}
+
+TEST_F(TestPtimeEstimator, test_destination_table_shared_ids) {
+  const auto myCtor = [](const std::string&, const std::string&) {
+    return std::make_unique<float>(0.0f);
+  };
+  const auto              myIds = std::make_shared<DestinationIds>();
+  DestinationTable<float> myFirst(myCtor, myIds);
+  DestinationTable<float> mySecond(myCtor, myIds);
+
+  // same pairs added in a different order, and with a removal in between
+  for (const auto& myDest : {"x", "y", "z"}) {
+    ASSERT_TRUE(myFirst.add("lambda0", myDest));
+  }
+  ASSERT_TRUE(mySecond.add("lambda0", "z"));
+  ASSERT_TRUE(mySecond.add("lambda0", "x"));
+  ASSERT_TRUE(mySecond.add("lambda0", "w"));
+  ASSERT_TRUE(mySecond.add("lambda0", "y"));
+  ASSERT_TRUE(mySecond.remove("lambda0", "w"));
+
+  ASSERT_EQ(myFirst.destinations("lambda0"), mySecond.destinations("lambda0"));
+  ASSERT_EQ(myIds->intern("y"), mySecond.destinations("lambda0")[1]);
+  ASSERT_EQ("w", mySecond.name(myIds->intern("w")));
+}
+
+TEST_F(TestPtimeEstimator, test_util_estimator_alignment) {
+  const auto    myIds = std::make_shared<DestinationIds>();
+  RttEstimator  myRttEstimator(10, 60, myIds);
+  UtilEstimator myUtilEstimator(1, 10, myIds);
+  for (const auto& myDest : {"dest2", "dest0", "dest1"}) {
+    ASSERT_TRUE(myRttEstimator.add("lambda0", myDest));
+  }
+  for (const auto& myDest : {"dest1", "dest2", "dest0"}) {
+    ASSERT_TRUE(myUtilEstimator.add("lambda0", myDest));
+  }
+
+  // the RTTs are matched with the processing times of the same destinations
+  std::vector<float> myRtts;
+  const auto& myDestinations = myRttEstimator.rtts("lambda0", 1, myRtts);
+  ASSERT_EQ(3u, myRtts.size());
+  myRtts = {0.3f, 0.1f, 0.2f};
+  ASSERT_EQ("dest1",
+            std::get<UtilEstimator::BT_DEST>(myUtilEstimator.best(
+                "lambda0", 1, myRtts, myDestinations)));
+
+  // mismatching destinations are detected
+  ASSERT_TRUE(myUtilEstimator.remove("lambda0", "dest1"));
+  ASSERT_THROW(myUtilEstimator.best("lambda0", 1, myRtts, myDestinations),
+               std::runtime_error);
+  std::vector<DestinationIds::Id> myOther(myDestinations);
+  myOther.pop_back();
+  myRtts.pop_back();
+  ASSERT_THROW(myUtilEstimator.best("lambda0", 1, myRtts, myOther),
+               std::runtime_error);
+}
+
+TEST_F(TestPtimeEstimator, test_token) {
+  TrivialPtimeEstimator myEst;
+  ASSERT_EQ("", select(myEst));
+  ASSERT_EQ(1u, myEst.theLastEstimates.size());
+  ASSERT_FLOAT_EQ(1.0f, myEst.theLastEstimates.back().theRtt);
+  ASSERT_FLOAT_EQ(2.0f, myEst.theLastEstimates.back().thePtime);
+}
+
+TEST_F(TestPtimeEstimator, test_concurrent_lambdas) {
+  PtimeEstimatorRtt myEst(10, 60);
+  const std::vector<std::string> myLambdas({"lambda0", "lambda1", "lambda2"});
+  for (const auto& myLambda : myLambdas) {
+    myEst.change(myLambda, "dest0", 1, true);
+    myEst.change(myLambda, "dest1", 1, true);
+  }
+
+  // requests of different lambdas are served in parallel with changes to
+  // the table of destinations of another lambda
+  std::vector<std::thread> myThreads;
+  for (const auto& myLambda : myLambdas) {
+    myThreads.emplace_back([&myEst, myLambda]() {
+      for (auto i = 0; i < 1000; i++) {
+        const auto myDestination = select(myEst, myLambda);
+        ASSERT_TRUE(myDestination == "dest0" or myDestination == "dest1");
+      }
+    });
+  }
+  for (auto i = 0; i < 100; i++) {
+    myEst.change("lambda9", "dest" + std::to_string(i), 1, true);
+    myEst.remove("lambda9", "dest" + std::to_string(i));
+  }
+  for (auto& myThread : myThreads) {
+    myThread.join();
+  }
+
+  ASSERT_EQ(std::set<std::string>(myLambdas.begin(), myLambdas.end()),
+            myEst.lambdas());
+}
+
+TEST_F(TestPtimeEstimator, test_probe) {
+  auto myFastComputer = makeComputer(theFastEndpoint, 1e9);
+  auto mySlowComputer = makeComputer(theSlowEndpoint, 1e8);
+  EdgeServerGrpc myFastServer(*myFastComputer, 1, false);
+  EdgeServerGrpc mySlowServer(*mySlowComputer, 1, false);
+  myFastServer.run();
+  mySlowServer.run();
+
+  ASSERT_THROW(PtimeEstimatorProbe(false, 0, 0, ""), std::runtime_error);
+
+  PtimeEstimatorProbe myEst(false, 1, 0, "");
+  ASSERT_THROW(select(myEst), NoDestinations);
+
+  myEst.change("lambda0", theDeadEndpoint, 1, true);
+  myEst.change("lambda0", theSlowEndpoint, 1, true);
+  myEst.change("lambda0", theFastEndpoint, 1, true);
+
+  ASSERT_TRUE(support::waitFor<std::string>(
+      [&]() { return select(myEst); }, theFastEndpoint, 5.0));
+
+  myEst.remove("lambda0", theFastEndpoint);
+  ASSERT_EQ(theSlowEndpoint, select(myEst));
+
+  // no destination replies: one is selected anyway
+  myEst.remove("lambda0", theSlowEndpoint);
+  ASSERT_EQ(theDeadEndpoint, select(myEst));
+}
+
+TEST_F(TestPtimeEstimator, test_probe_cache) {
+  auto myFastComputer = makeComputer(theFastEndpoint, 1e9);
+  auto mySlowComputer = makeComputer(theSlowEndpoint, 1e8);
+  auto myFastServer =
+      std::make_unique<EdgeServerGrpc>(*myFastComputer, 1, false);
+  EdgeServerGrpc mySlowServer(*mySlowComputer, 1, false);
+  myFastServer->run();
+  mySlowServer.run();
+
+  // wait for the servers to be ready without caching
+  {
+    PtimeEstimatorProbe myEst(false, 1, 0, "");
+    myEst.change("lambda0", theSlowEndpoint, 1, true);
+    myEst.change("lambda0", theFastEndpoint, 1, true);
+    ASSERT_TRUE(support::waitFor<std::string>(
+        [&]() { return select(myEst); }, theFastEndpoint, 5.0));
+  }
+
+  PtimeEstimatorProbe myEst(false, 1, 60, "");
+  myEst.change("lambda0", theSlowEndpoint, 1, true);
+  myEst.change("lambda0", theFastEndpoint, 1, true);
+  ASSERT_EQ(theFastEndpoint, select(myEst));
+
+  // the outcome of the last probe is reused even if the destination is gone
+  myFastServer.reset();
+  for (auto i = 0; i < 10; i++) {
+    ASSERT_EQ(theFastEndpoint, select(myEst));
+  }
+
+  // a change of the destinations invalidates the cache
+  myEst.change("lambda0", theDeadEndpoint, 1, true);
+  ASSERT_EQ(theSlowEndpoint, select(myEst));
+}
+
+// measure the number of dispatch decisions/s of the processing time
+// estimators, with the following environment variables:
+// TYPES: comma-separated list of estimator types
+// NUMLAMBDAS: number of lambdas
+// NUMDESTS: number of destinations of every lambda
+// DURATION: duration of each experiment, in s
+TEST_F(TestPtimeEstimator, DISABLED_test_dispatch_performance) {
+  const auto myTypes = support::split<std::list<std::string>>(
+      envOrDefault("TYPES", "rtt,util"), ",");
+  const auto myNumLambdas = std::stoull(envOrDefault("NUMLAMBDAS", "1000"));
+  const auto myNumDests   = std::stoull(envOrDefault("NUMDESTS", "100"));
+  const auto myDuration   = std::stod(envOrDefault("DURATION", "2"));
+
+  std::vector<rpc::LambdaRequest> myReqs;
+  for (size_t i = 0; i < myNumLambdas; i++) {
+    myReqs.emplace_back(
+        LambdaRequest("lambda" + std::to_string(i), "hello").toProtobuf());
+  }
+  LambdaResponse myRep("OK", "");
+  myRep.theProcessingTime = 1;
+
+  for (const auto& myType : myTypes) {
+    std::unique_ptr<PtimeEstimator> myEst;
+    if (myType == "rtt") {
+      myEst = std::make_unique<PtimeEstimatorRtt>(10, 60);
+    } else if (myType == "util") {
+      myEst = std::make_unique<PtimeEstimatorUtil>(10, 60, 1, 10, "");
+    } else {
+      FAIL() << "unsupported type: " << myType;
+    }
+    for (const auto& myReq : myReqs) {
+      for (size_t j = 0; j < myNumDests; j++) {
+        myEst->change(myReq.name(), "dest" + std::to_string(j), 1, true);
+      }
+    }
+
+    size_t          myCount = 0;
+    support::Chrono myChrono(true);
+    while (myChrono.time() < myDuration) {
+      for (const auto& myReq : myReqs) {
+        PtimeEstimator::Token myToken       = 0;
+        const auto            myDestination = (*myEst)(myReq, myToken);
+        myEst->processSuccess(myReq, myToken, myDestination, myRep, 0.002);
+      }
+      myCount += myReqs.size();
+    }
+    LOG(INFO) << "type " << myType << ", lambdas " << myNumLambdas
+              << ", destinations " << myNumDests << ", decisions/s "
+              << (myCount / myChrono.stop());
+  }
+}
+
 } // namespace edge
 } // namespace uiiit
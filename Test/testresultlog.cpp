@@ -0,0 +1,132 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/resultlog.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestResultLog : public ::testing::Test {
+  static constexpr const char* thePath = "testresultlog.bin";
+
+  void TearDown() override {
+    std::remove(thePath);
+    std::remove((std::string(thePath) + ".names").c_str());
+  }
+};
+
+TEST_F(TestResultLog, test_write_read) {
+  {
+    ResultLog myLog(thePath, 3);
+    myLog(0.0015, 42, "host1:6473", "clambda0", 2, 0.001);
+    myLog(1e6, 100000, "host2:6473", "clambda0", 1, -1, 0.25);
+    for (size_t i = 0; i < 10; i++) {
+      myLog(i * 1e-6, 0, "host1:6473", "clambda1", 1, 0);
+    }
+    ASSERT_EQ(12u, myLog.size());
+  }
+
+  std::vector<std::string> myNames;
+  const auto               myRecords = ResultLog::read(thePath, myNames);
+  ASSERT_EQ(12u, myRecords.size());
+  ASSERT_EQ(std::vector<std::string>({"host1:6473", "clambda0", "host2:6473",
+                                      "clambda1"}),
+            myNames);
+
+  ASSERT_EQ(1500u, myRecords[0].theLatency);
+  ASSERT_EQ(1000u, myRecords[0].theProcessing);
+  ASSERT_EQ(42u, myRecords[0].theLoad1);
+  ASSERT_EQ(2u, myRecords[0].theHops);
+  ASSERT_EQ("host1:6473", myNames.at(myRecords[0].theResponder));
+  ASSERT_EQ("clambda0", myNames.at(myRecords[0].theName));
+
+  // out-of-range values are saturated
+  ASSERT_EQ(0xFFFFFFFFu, myRecords[1].theLatency);
+  ASSERT_EQ(0u, myRecords[1].theProcessing);
+  ASSERT_EQ(0xFFFFu, myRecords[1].theLoad1);
+  ASSERT_EQ("host2:6473", myNames.at(myRecords[1].theResponder));
+  ASSERT_EQ(250000u, myRecords[1].theSlip);
+  ASSERT_EQ(0u, myRecords[0].theSlip);
+
+  for (size_t i = 0; i < 10; i++) {
+    ASSERT_EQ(i, myRecords[2 + i].theLatency);
+    ASSERT_EQ("clambda1", myNames.at(myRecords[2 + i].theName));
+  }
+  for (size_t i = 1; i < myRecords.size(); i++) {
+    ASSERT_GE(myRecords[i].theTime, myRecords[i - 1].theTime);
+  }
+}
+
+TEST_F(TestResultLog, test_concurrent_writers) {
+  const size_t myNumThreads = 4;
+  const size_t myNumRecords = 10000;
+  {
+    ResultLog                myLog(thePath);
+    std::vector<std::thread> myThreads;
+    for (size_t i = 0; i < myNumThreads; i++) {
+      myThreads.emplace_back([&myLog, i, myNumRecords]() {
+        for (size_t j = 0; j < myNumRecords; j++) {
+          myLog(j * 1e-6, 0, "host" + std::to_string(i), "f", 1, 0);
+        }
+      });
+    }
+    for (auto& myThread : myThreads) {
+      myThread.join();
+    }
+  }
+
+  std::vector<std::string> myNames;
+  const auto               myRecords = ResultLog::read(thePath, myNames);
+  ASSERT_EQ(myNumThreads * myNumRecords, myRecords.size());
+  ASSERT_EQ(myNumThreads + 1, myNames.size());
+}
+
+TEST_F(TestResultLog, test_invalid_file) {
+  std::vector<std::string> myNames;
+  ASSERT_THROW(ResultLog::read(thePath, myNames), std::runtime_error);
+
+  std::ofstream(thePath) << "not a result log";
+  ASSERT_THROW(ResultLog::read(thePath, myNames), std::runtime_error);
+
+  ASSERT_THROW(ResultLog("/non/existing/dir/file.bin"), std::runtime_error);
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -0,0 +1,106 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/ringbuffer.h"
+
+#include "gtest/gtest.h"
+
+#include <deque>
+#include <memory>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestRingBuffer : public ::testing::Test {
+  // move-constructible but neither copyable nor assignable
+  struct Elem {
+    explicit Elem(const int aValue)
+        : theId(aValue)
+        , theValue(std::make_unique<int>(aValue)) {
+      // noop
+    }
+    const int            theId;
+    std::unique_ptr<int> theValue;
+  };
+};
+
+TEST_F(TestRingBuffer, test_operations) {
+  RingBuffer<Elem> myBuffer;
+  ASSERT_TRUE(myBuffer.empty());
+
+  myBuffer.push_back(Elem(1));
+  myBuffer.push_back(Elem(3));
+  myBuffer.insert(1, Elem(2));
+  myBuffer.insert(0, Elem(0));
+  ASSERT_EQ(4u, myBuffer.size());
+  for (size_t i = 0; i < myBuffer.size(); i++) {
+    ASSERT_EQ(static_cast<int>(i), *myBuffer[i].theValue);
+  }
+
+  myBuffer.pop_front();
+  ASSERT_EQ(1, *myBuffer.front().theValue);
+  ASSERT_EQ(3u, myBuffer.size());
+
+  myBuffer.clear();
+  ASSERT_TRUE(myBuffer.empty());
+  myBuffer.push_back(Elem(42));
+  ASSERT_EQ(42, *myBuffer.front().theValue);
+}
+
+TEST_F(TestRingBuffer, test_against_deque) {
+  RingBuffer<Elem> myBuffer;
+  std::deque<int>  myExpected;
+  ::srand(42);
+  for (auto i = 0; i < 10000; i++) {
+    const auto myOp = ::rand() % 3;
+    if (myOp == 0 and not myExpected.empty()) {
+      myBuffer.pop_front();
+      myExpected.pop_front();
+    } else if (myOp == 1) {
+      myBuffer.push_back(Elem(i));
+      myExpected.push_back(i);
+    } else {
+      const auto myPos = ::rand() % (myExpected.size() + 1);
+      myBuffer.insert(myPos, Elem(i));
+      myExpected.insert(myExpected.begin() + myPos, i);
+    }
+    ASSERT_EQ(myExpected.size(), myBuffer.size());
+    for (size_t j = 0; j < myExpected.size(); j++) {
+      ASSERT_EQ(myExpected[j], myBuffer[j].theId);
+      ASSERT_EQ(myExpected[j], *myBuffer[j].theValue);
+    }
+  }
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
@@ -29,8 +29,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "Edge/Detail/spillfile.h"
 #include "Edge/edgemessages.h"
 #include "Edge/stateclient.h"
+#include "Edge/staterepo.h"
 #include "Edge/stateserver.h"
 
 #include "gtest/gtest.h"
@@ -85,5 +87,184 @@ TEST_F(TestState, test_client_server) {
   ASSERT_EQ("new-content-s0", myContent);
 }
 
+TEST_F(TestState, test_client_server_stream) {
+  const std::string myEndpoint = "127.0.0.1:6480";
+  StateServer       myServer(myEndpoint);
+  myServer.run(false);
+
+  const std::string myLarge(5 * (1 << 20) + 42, 'x');
+  for (const size_t myThreshold : std::vector<size_t>({0, 1000, 1 << 20})) {
+    StateClient myClient(myEndpoint, myThreshold);
+
+    ASSERT_NO_THROW(myClient.Put("small", "small-content"));
+    ASSERT_NO_THROW(myClient.Put("large", std::string(myLarge)));
+
+    std::string myContent;
+    ASSERT_TRUE(myClient.Get("small", myContent));
+    ASSERT_EQ("small-content", myContent);
+    ASSERT_TRUE(myClient.Get("large", myContent));
+    ASSERT_EQ(myLarge, myContent);
+    ASSERT_FALSE(myClient.Get("sX", myContent));
+
+    ASSERT_TRUE(myClient.Del("large"));
+    ASSERT_FALSE(myClient.Get("large", myContent));
+  }
+}
+
+TEST_F(TestState, test_pull_migrate) {
+  const std::string myEndpointA = "127.0.0.1:6480";
+  const std::string myEndpointB = "127.0.0.1:6481";
+  StateServer       myServerA(myEndpointA);
+  StateServer       myServerB(myEndpointB);
+  myServerA.run(false);
+  myServerB.run(false);
+  StateClient myClientA(myEndpointA);
+  StateClient myClientB(myEndpointB);
+
+  const std::string myLarge(3 * (1 << 20) + 42, 'x');
+  ASSERT_NO_THROW(myClientA.Put("small", "small-content"));
+  ASSERT_NO_THROW(myClientA.Put("large", myLarge));
+
+  // pull removes the state from the server
+  std::string myContent;
+  ASSERT_TRUE(myClientA.Pull("small", myContent));
+  ASSERT_EQ("small-content", myContent);
+  ASSERT_FALSE(myClientA.Get("small", myContent));
+  ASSERT_FALSE(myClientA.Pull("small", myContent));
+
+  // migrate moves the state directly from A to B
+  ASSERT_TRUE(myClientB.Migrate("large", myEndpointA));
+  ASSERT_FALSE(myClientA.Get("large", myContent));
+  ASSERT_TRUE(myClientB.Get("large", myContent));
+  ASSERT_EQ(myLarge, myContent);
+
+  // migrate non-existing states or from non-existing servers
+  ASSERT_FALSE(myClientB.Migrate("large", myEndpointA));
+  ASSERT_FALSE(myClientB.Migrate("large", "127.0.0.1:6482"));
+  ASSERT_TRUE(myClientB.Get("large", myContent));
+}
+
+TEST_F(TestState, test_spill_file) {
+  detail::SpillFile mySpillFile("teststate.spill");
+  ASSERT_EQ(0u, mySpillFile.used());
+
+  const auto myFirst  = mySpillFile.write("first");
+  const auto mySecond = mySpillFile.write(std::string(3 << 20, 'y'));
+  const auto myThird  = mySpillFile.write("third");
+  ASSERT_EQ((3u << 20) + 10, mySpillFile.used());
+  ASSERT_GE(mySpillFile.size(), mySpillFile.used());
+
+  ASSERT_EQ("first", mySpillFile.read(myFirst));
+  ASSERT_EQ(std::string(3 << 20, 'y'), mySpillFile.read(mySecond));
+  ASSERT_EQ("third", mySpillFile.read(myThird));
+
+  // freed extents are reused
+  mySpillFile.free(myFirst);
+  const auto myFourth = mySpillFile.write("four");
+  ASSERT_EQ(myFirst.theOffset, myFourth.theOffset);
+  ASSERT_EQ("four", mySpillFile.read(myFourth));
+  ASSERT_EQ("third", mySpillFile.read(myThird));
+
+  mySpillFile.free(mySecond);
+  mySpillFile.free(myThird);
+  mySpillFile.free(myFourth);
+  ASSERT_EQ(0u, mySpillFile.used());
+}
+
+TEST_F(TestState, test_repo) {
+  ASSERT_THROW(StateRepo(0, 0, ""), std::runtime_error);
+
+  StateRepo myRepo(4, 100, "teststate.spill");
+  ASSERT_EQ(0u, myRepo.size());
+  ASSERT_FALSE(myRepo.get("s0"));
+
+  // states fitting in memory are shared, not copied
+  myRepo.put("s0", std::string(40, '0'));
+  myRepo.put("s1", std::string(40, '1'));
+  ASSERT_EQ(80u, myRepo.memory());
+  ASSERT_EQ(0u, myRepo.spilled());
+  ASSERT_EQ(myRepo.get("s0").get(), myRepo.get("s0").get());
+
+  // exceeding the memory cap spills the least recently accessed state
+  myRepo.put("s2", std::string(40, '2'));
+  ASSERT_EQ(3u, myRepo.size());
+  ASSERT_EQ(1u, myRepo.spilled());
+  ASSERT_EQ(80u, myRepo.memory());
+  for (size_t i = 0; i < 3; i++) {
+    const auto myContent = myRepo.get("s" + std::to_string(i));
+    ASSERT_TRUE(myContent);
+    ASSERT_EQ(std::string(40, '0' + i), *myContent);
+  }
+
+  // overwriting a spilled state brings it back to memory
+  myRepo.put("s1", "one");
+  ASSERT_EQ("one", *myRepo.get("s1"));
+  ASSERT_EQ(3u, myRepo.size());
+  ASSERT_LE(myRepo.memory(), 100u);
+
+  // a state larger than the cap is spilled immediately
+  myRepo.put("s3", std::string(200, '3'));
+  ASSERT_LE(myRepo.memory(), 100u);
+  ASSERT_EQ(std::string(200, '3'), *myRepo.get("s3"));
+
+  // take both in-memory and spilled states
+  myRepo.put("s4", "four");
+  ASSERT_EQ("four", *myRepo.take("s4"));
+  ASSERT_FALSE(myRepo.take("s4"));
+  myRepo.put("s5", std::string(200, '5'));
+  ASSERT_EQ(std::string(200, '5'), *myRepo.take("s5"));
+  ASSERT_FALSE(myRepo.get("s5"));
+
+  // conditional delete of a state, whether in memory or spilled
+  uint64_t myVersion = 0;
+  ASSERT_FALSE(myRepo.get("s6", myVersion));
+  myRepo.put("s6", "six");
+  ASSERT_EQ("six", *myRepo.get("s6", myVersion));
+  myRepo.put("s6", "six again");
+  ASSERT_FALSE(myRepo.del("s6", myVersion));
+  ASSERT_EQ("six again", *myRepo.get("s6", myVersion));
+  myRepo.put("s7", std::string(200, '7')); // spills s6
+  ASSERT_EQ("six again", *myRepo.get("s6"));
+  ASSERT_TRUE(myRepo.del("s6", myVersion));
+  ASSERT_FALSE(myRepo.get("s6"));
+  ASSERT_TRUE(myRepo.del("s7"));
+
+  // delete both in-memory and spilled states
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(myRepo.del("s" + std::to_string(i)));
+    ASSERT_FALSE(myRepo.del("s" + std::to_string(i)));
+  }
+  ASSERT_EQ(0u, myRepo.size());
+  ASSERT_EQ(0u, myRepo.spilled());
+  ASSERT_EQ(0u, myRepo.memory());
+}
+
+TEST_F(TestState, test_repo_lru_across_shards) {
+  // the victim is the least recently accessed state among all shards,
+  // whichever shard was visited last
+  StateRepo myRepo(16, 100, "teststate.spill");
+  for (size_t i = 0; i < 10; i++) {
+    myRepo.put("s" + std::to_string(i), std::string(10 - i, 'x'));
+  }
+  ASSERT_EQ(55u, myRepo.memory());
+  for (size_t i = 0; i < 10; i++) {
+    if (i != 3) {
+      ASSERT_TRUE(myRepo.get("s" + std::to_string(i)));
+    }
+  }
+
+  // s3 is the oldest, then s0, s1, s2, s4, ...
+  myRepo.put("big", std::string(50, 'y'));
+  ASSERT_EQ(1u, myRepo.spilled());
+  ASSERT_EQ(98u, myRepo.memory());
+  myRepo.put("small", std::string(15, 'z'));
+  ASSERT_EQ(3u, myRepo.spilled());
+  ASSERT_EQ(94u, myRepo.memory());
+
+  // accessing a spilled state does not bring it back to memory
+  ASSERT_EQ(std::string(7, 'x'), *myRepo.get("s3"));
+  ASSERT_EQ(94u, myRepo.memory());
+}
+
 } // namespace edge
 } // namespace uiiit
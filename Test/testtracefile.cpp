@@ -0,0 +1,212 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/tracefile.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace uiiit {
+namespace edge {
+namespace detail {
+
+struct TestTraceFile : public ::testing::Test {
+  static constexpr const char* thePath = "testtracefile.bin";
+
+  void TearDown() override {
+    std::remove(thePath);
+  }
+};
+
+TEST_F(TestTraceFile, test_write_read) {
+  {
+    TraceWriter myWriter(thePath);
+    myWriter.add(0, "clambda0", "host1:6473", 100, 0);
+    myWriter.add(0.5, "clambda1", "host1:6473", 200, 1);
+    myWriter.add(0.5, "clambda0", "host2:6473", 300, 0);
+    myWriter.add(1000.000001, "clambda1", "host2:6473", 400, 2);
+  }
+
+  ASSERT_TRUE(TraceFile::isTrace(thePath));
+  TraceFile myTrace(thePath);
+  ASSERT_EQ(4u, myTrace.size());
+
+  ASSERT_EQ(0u, myTrace[0].theTime);
+  ASSERT_EQ("clambda0", myTrace.name(myTrace[0].theLambda));
+  ASSERT_EQ("host1:6473", myTrace.name(myTrace[0].theServer));
+  ASSERT_EQ(100u, myTrace[0].theSize);
+  ASSERT_EQ(0u, myTrace[0].theClient);
+
+  ASSERT_EQ(500000u, myTrace[1].theTime);
+  ASSERT_EQ("clambda1", myTrace.name(myTrace[1].theLambda));
+  ASSERT_EQ(1u, myTrace[1].theClient);
+
+  ASSERT_EQ(500000u, myTrace[2].theTime);
+  ASSERT_EQ("host2:6473", myTrace.name(myTrace[2].theServer));
+  ASSERT_EQ(300u, myTrace[2].theSize);
+
+  ASSERT_EQ(1000000001u, myTrace[3].theTime);
+  ASSERT_EQ(400u, myTrace[3].theSize);
+  ASSERT_EQ(2u, myTrace[3].theClient);
+
+  ASSERT_THROW(myTrace.name(4), std::out_of_range);
+}
+
+TEST_F(TestTraceFile, test_round_trip) {
+  // random events, with names shared by many of them
+  std::mt19937                            myRng(42);
+  std::uniform_int_distribution<uint32_t> myIndex(0, 99);
+  std::uniform_int_distribution<uint32_t> mySize(0, 1 << 20);
+  std::exponential_distribution<double>   myInterArrival(1000);
+
+  std::vector<TraceEvent> myEvents;
+  double                  myTime = 0;
+  {
+    TraceWriter myWriter(thePath);
+    for (size_t i = 0; i < 10000; i++) {
+      myTime += myInterArrival(myRng);
+      const TraceEvent myEvent{
+          static_cast<uint64_t>(std::llround(myTime * 1e6)),
+          myIndex(myRng) % 50,
+          myIndex(myRng) % 20,
+          mySize(myRng),
+          myIndex(myRng)};
+      myWriter.add(myTime,
+                   "clambda" + std::to_string(myEvent.theLambda),
+                   "host" + std::to_string(myEvent.theServer) + ":6473",
+                   myEvent.theSize,
+                   myEvent.theClient);
+      myEvents.emplace_back(myEvent);
+    }
+  }
+
+  TraceFile myTrace(thePath);
+  ASSERT_EQ(myEvents.size(), myTrace.size());
+  for (size_t i = 0; i < myEvents.size(); i++) {
+    ASSERT_EQ(myEvents[i].theTime, myTrace[i].theTime) << i;
+    ASSERT_EQ("clambda" + std::to_string(myEvents[i].theLambda),
+              myTrace.name(myTrace[i].theLambda))
+        << i;
+    ASSERT_EQ("host" + std::to_string(myEvents[i].theServer) + ":6473",
+              myTrace.name(myTrace[i].theServer))
+        << i;
+    ASSERT_EQ(myEvents[i].theSize, myTrace[i].theSize) << i;
+    ASSERT_EQ(myEvents[i].theClient, myTrace[i].theClient) << i;
+  }
+
+  // every name is stored only once
+  ASSERT_NO_THROW(myTrace.name(69));
+  ASSERT_THROW(myTrace.name(70), std::out_of_range);
+}
+
+TEST_F(TestTraceFile, test_time_rounding) {
+  {
+    TraceWriter myWriter(thePath);
+    myWriter.add(1.0000004, "clambda0", "host1:6473", 100, 0);
+    myWriter.add(1.0000006, "clambda0", "host1:6473", 100, 0);
+    myWriter.add(3600.25, "clambda0", "host1:6473", 100, 0);
+  }
+
+  TraceFile myTrace(thePath);
+  ASSERT_EQ(3u, myTrace.size());
+  ASSERT_EQ(1000000u, myTrace[0].theTime);
+  ASSERT_EQ(1000001u, myTrace[1].theTime);
+  ASSERT_EQ(3600250000u, myTrace[2].theTime);
+}
+
+TEST_F(TestTraceFile, test_truncated) {
+  const auto myWrite = [this]() {
+    TraceWriter myWriter(thePath);
+    myWriter.add(0, "clambda0", "host1:6473", 100, 0);
+    myWriter.add(1, "clambda1", "host1:6473", 100, 0);
+  };
+
+  // names cut short
+  myWrite();
+  std::ifstream myStream(thePath, std::ios::binary | std::ios::ate);
+  const auto    mySize = static_cast<off_t>(myStream.tellg());
+  myStream.close();
+  ASSERT_EQ(0, ::truncate(thePath, mySize - 1));
+  ASSERT_TRUE(TraceFile::isTrace(thePath));
+  ASSERT_THROW(TraceFile myTrace(thePath), std::runtime_error);
+
+  // events cut short
+  myWrite();
+  ASSERT_EQ(0, ::truncate(thePath, 32 + sizeof(TraceEvent) + 1));
+  ASSERT_THROW(TraceFile myTrace(thePath), std::runtime_error);
+
+  // header only
+  myWrite();
+  ASSERT_EQ(0, ::truncate(thePath, 16));
+  ASSERT_THROW(TraceFile myTrace(thePath), std::runtime_error);
+}
+
+TEST_F(TestTraceFile, test_empty) {
+  TraceWriter(thePath).close();
+
+  TraceFile myTrace(thePath);
+  ASSERT_EQ(0u, myTrace.size());
+}
+
+TEST_F(TestTraceFile, test_invalid_events) {
+  TraceWriter myWriter(thePath);
+  ASSERT_THROW(myWriter.add(-1, "clambda0", "host1:6473", 100, 0),
+               std::runtime_error);
+  myWriter.add(1, "clambda0", "host1:6473", 100, 0);
+  ASSERT_THROW(myWriter.add(0.5, "clambda0", "host1:6473", 100, 0),
+               std::runtime_error);
+  myWriter.close();
+  ASSERT_THROW(myWriter.add(2, "clambda0", "host1:6473", 100, 0),
+               std::runtime_error);
+}
+
+TEST_F(TestTraceFile, test_invalid_file) {
+  ASSERT_FALSE(TraceFile::isTrace(thePath));
+  ASSERT_THROW(TraceFile myTrace(thePath), std::runtime_error);
+
+  std::ofstream(thePath) << "0.1,clambda0,host1:6473,100\n";
+  ASSERT_FALSE(TraceFile::isTrace(thePath));
+  ASSERT_THROW(TraceFile myTrace(thePath), std::runtime_error);
+
+  ASSERT_THROW(TraceWriter("/non/existing/dir/file.bin"), std::runtime_error);
+}
+
+} // namespace detail
+} // namespace edge
+} // namespace uiiit
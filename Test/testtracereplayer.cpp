@@ -0,0 +1,261 @@
+/*
+              __ __ __
+             |__|__|  | __
+             |  |  |  ||__|
+  ___ ___ __ |  |  |  |
+ |   |   |  ||  |  |  |    Ubiquitous Internet @ IIT-CNR
+ |   |   |  ||  |  |  |    C++ edge computing libraries and tools
+ |_______|__||__|__|__|    https://github.com/ccicconetti/serverlessonedge
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>
+Copyright (c) 2021 C. Cicconetti <https://ccicconetti.github.io/>
+
+Permission is hereby  granted, free of charge, to any  person obtaining a copy
+of this software and associated  documentation files (the "Software"), to deal
+in the Software  without restriction, including without  limitation the rights
+to  use, copy,  modify, merge,  publish, distribute,  sublicense, and/or  sell
+copies  of  the Software,  and  to  permit persons  to  whom  the Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS OR
+IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF  MERCHANTABILITY,
+FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN NO EVENT  SHALL THE
+AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY  CLAIM,  DAMAGES OR  OTHER
+LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Edge/Detail/tracefile.h"
+#include "Edge/edgeserver.h"
+#include "Edge/edgeservergrpc.h"
+#include "Simulation/tracereplayer.h"
+#include "Support/saver.h"
+
+#include "gtest/gtest.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace uiiit {
+namespace simulation {
+
+// answer after a given delay, keeping track of the requests in progress
+class SlowEdgeServer final : public edge::EdgeServer
+{
+ public:
+  explicit SlowEdgeServer(const std::string&              aEndpoint,
+                          const std::chrono::milliseconds aDelay)
+      : edge::EdgeServer(aEndpoint)
+      , theDelay(aDelay)
+      , theInProgress(0)
+      , theMaxInProgress(0)
+      , theServed(0) {
+    // noop
+  }
+
+  rpc::LambdaResponse process(const rpc::LambdaRequest& aReq) override {
+    {
+      const std::lock_guard<std::mutex> myLock(theMutex);
+      theMaxInProgress = std::max(theMaxInProgress, ++theInProgress);
+    }
+    std::this_thread::sleep_for(theDelay);
+    rpc::LambdaResponse ret;
+    ret.set_retcode("OK");
+    ret.set_output(aReq.input());
+    ret.set_responder(serverEndpoint());
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    theInProgress--;
+    theServed++;
+    return ret;
+  }
+
+  //! \return the maximum number of requests in progress at the same time.
+  size_t maxInProgress() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theMaxInProgress;
+  }
+
+  //! \return the number of requests served.
+  size_t served() const {
+    const std::lock_guard<std::mutex> myLock(theMutex);
+    return theServed;
+  }
+
+ private:
+  const std::chrono::milliseconds theDelay;
+  size_t                          theInProgress;
+  size_t                          theMaxInProgress;
+  size_t                          theServed;
+};
+
+struct TestTraceReplayer : public ::testing::Test {
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr const char* thePath = "testtracereplayer.bin";
+
+  TestTraceReplayer()
+      : theEndpoint("localhost:6666")
+      , theSaver("", false, false, false) {
+    // noop
+  }
+
+  void TearDown() override {
+    std::remove(thePath);
+  }
+
+  /**
+   * Write a trace where every client issues the given number of requests,
+   * with the given inter-arrival time, the first one at a time given by the
+   * client identifier multiplied by the offset.
+   */
+  void writeTrace(const size_t aNumClients,
+                  const size_t aNumRequests,
+                  const double aInterArrival,
+                  const double aOffset) {
+    std::vector<std::tuple<double, uint32_t>> myEvents;
+    for (size_t i = 0; i < aNumRequests; i++) {
+      for (uint32_t c = 0; c < aNumClients; c++) {
+        myEvents.emplace_back(i * aInterArrival + c * aOffset, c);
+      }
+    }
+    std::sort(myEvents.begin(), myEvents.end());
+    edge::detail::TraceWriter myWriter(thePath);
+    for (const auto& myEvent : myEvents) {
+      myWriter.add(std::get<0>(myEvent),
+                   "clambda0",
+                   theEndpoint,
+                   100,
+                   std::get<1>(myEvent));
+    }
+  }
+
+  //! \return the time elapsed since the given time point, in s.
+  static double elapsed(const Clock::time_point& aStart) {
+    return std::chrono::duration<double>(Clock::now() - aStart).count();
+  }
+
+  const std::string    theEndpoint;
+  const support::Saver theSaver;
+};
+
+TEST_F(TestTraceReplayer, test_invalid) {
+  writeTrace(1, 1, 0, 0);
+  edge::detail::TraceFile myTrace(thePath);
+  ASSERT_THROW(TraceReplayer(myTrace, 0, false, theSaver, nullptr),
+               std::runtime_error);
+}
+
+TEST_F(TestTraceReplayer, test_replay_timing) {
+  SlowEdgeServer       myServer(theEndpoint, std::chrono::milliseconds(0));
+  edge::EdgeServerGrpc myServerGrpc(myServer, 4, false);
+  myServerGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // 4 clients with one request every 8 ms each, interleaved every 2 ms
+  writeTrace(4, 25, 0.008, 0.002);
+  edge::detail::TraceFile myTrace(thePath);
+  ASSERT_EQ(100u, myTrace.size());
+  const auto myLast = myTrace[myTrace.size() - 1].theTime * 1e-6;
+
+  TraceReplayer myReplayer(myTrace, 2, false, theSaver, nullptr);
+  const auto    myStart = Clock::now();
+  myReplayer.run();
+  const auto myElapsed = elapsed(myStart);
+  ASSERT_THROW(myReplayer.run(), std::runtime_error);
+
+  ASSERT_EQ(100u, myReplayer.dispatched());
+  ASSERT_EQ(0u, myReplayer.failed());
+  ASSERT_EQ(100u, myServer.served());
+  ASSERT_EQ(100u, myReplayer.latencies().count());
+
+  // the requests are not sent before their time, nor much later
+  const auto mySlips = myReplayer.slips();
+  LOG(INFO) << "slips (us): " << mySlips.summary();
+  ASSERT_EQ(100u, mySlips.count());
+  ASSERT_LT(mySlips.percentile(99), 20000u);
+  ASSERT_GE(myElapsed, myLast);
+  ASSERT_LT(myElapsed, myLast + 1);
+}
+
+TEST_F(TestTraceReplayer, test_replay_sequential_clients) {
+  SlowEdgeServer       myServer(theEndpoint, std::chrono::milliseconds(20));
+  edge::EdgeServerGrpc myServerGrpc(myServer, 4, false);
+  myServerGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // 2 clients with one request every 1 ms each: since every request takes
+  // 20 ms, they fall behind schedule but never have two requests in progress
+  writeTrace(2, 10, 0.001, 0);
+  edge::detail::TraceFile myTrace(thePath);
+
+  TraceReplayer myReplayer(myTrace, 1, false, theSaver, nullptr);
+  const auto    myStart = Clock::now();
+  myReplayer.run();
+  const auto myElapsed = elapsed(myStart);
+
+  ASSERT_EQ(20u, myReplayer.dispatched());
+  ASSERT_EQ(0u, myReplayer.failed());
+  ASSERT_EQ(20u, myServer.served());
+  ASSERT_LE(myServer.maxInProgress(), 2u);
+  ASSERT_GE(myElapsed, 0.2);
+
+  // latencies and slips in us, with 1/64 relative error: the last request of
+  // each client is scheduled at 9 ms but sent after 9 responses of 20 ms
+  const auto myLatencies = myReplayer.latencies();
+  ASSERT_EQ(20u, myLatencies.count());
+  ASSERT_GE(myLatencies.min(), 19000u);
+  ASSERT_GE(myReplayer.slips().max(), 150000u);
+}
+
+TEST_F(TestTraceReplayer, test_stop) {
+  SlowEdgeServer       myServer(theEndpoint, std::chrono::milliseconds(0));
+  edge::EdgeServerGrpc myServerGrpc(myServer, 4, false);
+  myServerGrpc.run();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // one request every 100 ms for 10 s
+  writeTrace(1, 100, 0.1, 0);
+  edge::detail::TraceFile myTrace(thePath);
+
+  TraceReplayer myReplayer(myTrace, 1, false, theSaver, nullptr);
+  const auto    myStart = Clock::now();
+  std::thread   myThread([&myReplayer]() { myReplayer.run(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  myReplayer.stop();
+  myThread.join();
+
+  ASSERT_LT(elapsed(myStart), 2);
+  ASSERT_GE(myReplayer.dispatched(), 1u);
+  ASSERT_LE(myReplayer.dispatched(), 5u);
+}
+
+TEST_F(TestTraceReplayer, test_unreachable) {
+  // no server running: all the requests fail
+  writeTrace(2, 3, 0.01, 0);
+  edge::detail::TraceFile myTrace(thePath);
+
+  TraceReplayer myReplayer(myTrace, 2, false, theSaver, nullptr);
+  myReplayer.run();
+
+  ASSERT_EQ(6u, myReplayer.dispatched());
+  ASSERT_EQ(6u, myReplayer.failed());
+  ASSERT_EQ(0u, myReplayer.latencies().count());
+  ASSERT_EQ(6u, myReplayer.slips().count());
+}
+
+} // namespace simulation
+} // namespace uiiit